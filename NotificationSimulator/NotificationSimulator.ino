@@ -28,6 +28,19 @@ const unsigned long TOTAL_TIME = CYCLE_TIME * 4;
 unsigned long testStart = 0;
 
 
+// ==========================================
+// MODO PUSH ("STREAM ON <period_ms> [alvo]")
+// ==========================================
+
+const unsigned long STREAM_MIN_PERIOD = 100;
+const unsigned long STREAM_MAX_PERIOD = 60000;
+
+bool streamActive = false;
+unsigned long streamPeriod = 1000;
+unsigned long lastStreamTime = 0;
+String streamTarget = "ALL";
+
+
 // ==========================================
 // SETUP
 // ==========================================
@@ -64,6 +77,13 @@ void loop() {
       inputBuffer += c;
     }
   }
+
+  // Stream: a amostra sai no timer da estação, sem esperar "GET DATA"
+  if (streamActive && millis() - lastStreamTime >= streamPeriod) {
+
+    lastStreamTime = millis();
+    sendSensorData(streamTarget);
+  }
 }
 
 
@@ -112,6 +132,68 @@ void processCommand(String cmd) {
   else if (cmd == "GET METADATA") {
     sendMetadata();
   }
+
+  else if (cmd == "STREAM OFF" || cmd.startsWith("STREAM ON")) {
+    handleStream(cmd);
+  }
+}
+
+
+// ==========================================
+// STREAM
+// ==========================================
+
+void handleStream(String cmd) {
+
+  if (cmd == "STREAM OFF") {
+
+    streamActive = false;
+
+  } else {
+
+    String args = cmd.substring(String("STREAM ON").length());
+    args.trim();
+
+    int space = args.indexOf(' ');
+
+    String periodStr = (space == -1) ? args : args.substring(0, space);
+    String target = (space == -1) ? "ALL" : args.substring(space + 1);
+    target.trim();
+
+    if (target != "ALL" && target != "SDS011" && target != "MQ2" &&
+        target != "MQ7" && target != "DHT")
+      return;
+
+    long period = periodStr.length() > 0 ? periodStr.toInt() : 1000;
+
+    if (period < (long)STREAM_MIN_PERIOD) period = STREAM_MIN_PERIOD;
+    if (period > (long)STREAM_MAX_PERIOD) period = STREAM_MAX_PERIOD;
+
+    streamActive = true;
+    streamPeriod = period;
+    streamTarget = target;
+    lastStreamTime = 0; // primeira amostra já no próximo loop()
+  }
+
+
+  JsonDocument doc;
+
+  doc["type"] = "ack";
+  doc["cmd"]  = "stream";
+  doc["status"] = streamActive ? "on" : "off";
+
+  if (streamActive) {
+
+    String target = streamTarget;
+    target.toLowerCase();
+
+    doc["period_ms"] = streamPeriod;
+    doc["target"] = target;
+  }
+
+
+  serializeJson(doc, Serial);
+  Serial.println();
 }
 
 
@@ -151,6 +233,7 @@ void sendSensorData(String target) {
 
   doc["type"] = "data";
   doc["src"] = "serial";
+  doc["ms"] = millis();  // a HAL usa para corrigir o atraso do fio
 
   if (target != "ALL") {
     target.toLowerCase();
@@ -120,6 +120,7 @@ void sendJson(T &out, String src) {
   JsonDocument doc;
   doc["type"] = "data";
   doc["src"] = src; 
+  doc["ms"] = millis();
   
   JsonObject payload = doc["payload"].to<JsonObject>();
   // Gera valores aleatórios para teste
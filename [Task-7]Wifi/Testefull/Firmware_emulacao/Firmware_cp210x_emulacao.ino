@@ -59,6 +59,7 @@ void sendJson(T &out, String src) {
   JsonDocument doc;
   doc["type"] = "data";
   doc["src"] = src; 
+  doc["ms"] = millis();
   
   JsonObject payload = doc["payload"].to<JsonObject>();
   
@@ -3,9 +3,15 @@
 #include "AirQualitySubHal.h"
 #include <log/log.h>
 #include <hardware/sensors.h>
+#include <utils/SystemClock.h>  // Para android::elapsedRealtimeNano()
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>  // dprintf
+#include <utility>
 
 using android::hardware::sensors::V1_0::MetaDataEventType;
 using android::hardware::sensors::V1_0::SensorType;
+using android::hardware::sensors::V1_0::SharedMemType;
 
 /** @name Identificadores Internos de Sensores (Handles)
  * @{ */
@@ -16,27 +22,89 @@ static const int32_t HANDLE_LPG   = 5004; ///< Gás Liquefeito de Petróleo
 static const int32_t HANDLE_TEMP  = 5005; ///< Temperatura Ambiente
 static const int32_t HANDLE_HUMID = 5006; ///< Humidade Relativa
 static const int32_t HANDLE_SRC   = 5099; ///< Serial ou Wifi
+static const int32_t HANDLE_HIST  = 5011; ///< Históricos: 5011 (PM2.5) .. 5016 (umidade)
+static const int32_t HANDLE_AQI   = 5021; ///< Índices: 5021 (US EPA), 5022 (IQAr)
 /** @} */ 
 
+// Tabela de uma estação; as estações a mais somam estação * kStationStride
+static const struct {
+    int32_t handle;
+    AirQualitySensor::Type type;
+} kStationSensors[] = {
+    {HANDLE_PM25,  AirQualitySensor::SENSOR_PM25},
+    {HANDLE_PM10,  AirQualitySensor::SENSOR_PM10},
+    {HANDLE_CO,    AirQualitySensor::SENSOR_CO},
+    {HANDLE_LPG,   AirQualitySensor::SENSOR_LPG},
+    {HANDLE_TEMP,  AirQualitySensor::SENSOR_TEMP},
+    {HANDLE_HUMID, AirQualitySensor::SENSOR_HUMID},
+    {HANDLE_SRC,   AirQualitySensor::SENSOR_SOURCE},
+};
+
 /**
  * @brief Construtor: Inicializa leitores e mapeia sensores virtuais.
  */
 AirQualitySubHal::AirQualitySubHal() 
-    : mSerialReader("/dev/ttyACM0"),      // Mantive a serial que funcionou no Emulador
-      mWifiReader("192.168.1.219", 8080) { // <-- ADICIONADO: IP do ESP32
-    
-    mSensors.emplace_back(HANDLE_PM25,  AirQualitySensor::SENSOR_PM25);
-    mSensors.emplace_back(HANDLE_PM10,  AirQualitySensor::SENSOR_PM10);
-    mSensors.emplace_back(HANDLE_CO,    AirQualitySensor::SENSOR_CO);
-    mSensors.emplace_back(HANDLE_LPG,   AirQualitySensor::SENSOR_LPG);
-    mSensors.emplace_back(HANDLE_TEMP,  AirQualitySensor::SENSOR_TEMP);
-    mSensors.emplace_back(HANDLE_HUMID, AirQualitySensor::SENSOR_HUMID);
-    mSensors.emplace_back(HANDLE_SRC,   AirQualitySensor::SENSOR_SOURCE);
+    : AirQualitySubHal("/dev/ttyACM0",      // Mantive a serial que funcionou no Emulador
+                       "192.168.1.219", 8080, // <-- ADICIONADO: IP do ESP32
+                       true) {
+    if (!openJournal(kJournalDir)) ALOGW("Diário de telemetria desligado (%s)", kJournalDir);
+}
+
+AirQualitySubHal::AirQualitySubHal(const std::string& serialPort, const std::string& wifiIp, int wifiPort,
+                                   bool discoverPorts)
+    : mNextStation(1),
+      mDirectMask(0),
+      mNextChannelHandle(1),
+      mFlushRunning(false),
+      mNextTicket(0),
+      mDispatcher(this),
+      // Com a descoberta as outras portas são outras estações, não a reserva desta
+      mSerialReader(serialPort, !discoverPorts),
+      mWifiReader(wifiIp, wifiPort),
+      mDiscoverPorts(discoverPorts),
+      mPrimaryPort(serialPort),
+      mTurn(0),
+      mInitializedAtNs(0) {
+
+    addStationSensors(0, "");
+    mStations[0].reader = &mArbiter;
+    // Históricos e índices só da principal: não cabe uma cópia por estação no mask
+    for (int channel = 0; channel < static_cast<int>(AirHistory::kChannels); channel++) {
+        mSensors.add(HANDLE_HIST + channel,
+                     static_cast<AirQualitySensor::Type>(AirQualitySensor::SENSOR_PM25_HISTORY + channel));
+    }
+    for (int scale = 0; scale < AirQualityIndex::kScales; scale++) {
+        mSensors.add(HANDLE_AQI + scale,
+                     static_cast<AirQualitySensor::Type>(AirQualitySensor::SENSOR_AQI_US_EPA + scale));
+    }
+    mSensors.setHistory(&mHistory);
+
+    mPendingEvents.reserve(AirQualitySensor::kFifoCapacity + SensorRegistry::kMaxSensors);
+
+    // Serial preferida, Wi-Fi de reserva com a conexão aberta para a troca ser
+    // rápida. O árbitro serializa as entregas numa única fila SPSC.
+    mWifiReader.setWarmStandby(true);
+    mArbiter.addSource("serial", &mSerialReader);
+    mArbiter.addSource("wifi", &mWifiReader);
+    mProducer = mDispatcher.addProducer("estacoes");
+    mArbiter.setListener(mProducer);
 }
 
 AirQualitySubHal::~AirQualitySubHal() {
-    mSerialReader.stop();
-    mWifiReader.stop(); // <-- ADICIONADO
+    if (mDiscoverPorts) HotplugMonitor::instance().removeListener(this);
+    {
+        std::lock_guard<std::mutex> lock(mExtraLock);
+        for (auto& extra : mExtraStations) extra.reader->stop();
+    }
+    mArbiter.stop();
+    mDispatcher.stop();
+
+    {
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        mFlushRunning = false;
+    }
+    mFlushCv.notify_all();
+    if (mFlushThread.joinable()) mFlushThread.join();
 }
 
 Return<Result> AirQualitySubHal::initialize(const sp<IHalProxyCallback>& halProxyCallback) {
@@ -45,91 +113,558 @@ Return<Result> AirQualitySubHal::initialize(const sp<IHalProxyCallback>& halProx
         std::lock_guard<std::mutex> lock(mCallbackLock);
         mCallback = halProxyCallback;
     }
-    mSerialReader.setListener(this);
-    mWifiReader.setListener(this); // <-- ADICIONADO
+    {
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        mInitializedAtNs = android::elapsedRealtimeNano();
+        if (!mFlushRunning) {
+            mFlushRunning = true;
+            mFlushThread = std::thread(&AirQualitySubHal::flushThread, this);
+        }
+    }
 
-    mSerialReader.start();
-    mWifiReader.start(); // <-- ADICIONADO
+    mDispatcher.start();
+    mArbiter.start();
+    if (mDiscoverPorts) {
+        // Primeiro o aviso, depois a varredura: uma porta no meio dos dois não se perde
+        HotplugMonitor::instance().addListener(this);
+        rescanStations();
+    }
     
     return Result::OK;
 }
 
+void AirQualitySubHal::addStationSensors(int station, const std::string& deviceId) {
+    for (const auto& entry : kStationSensors) {
+        int index = mSensors.add(entry.handle + station * SensorRegistry::kStationStride, entry.type);
+        if (index >= 0 && station != 0) mSensors[index].setDynamic(deviceId);
+    }
+    mStations[station].deviceId = deviceId;
+}
+
+void AirQualitySubHal::addSerialStation(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mExtraLock);
+    if (path == mPrimaryPort) return;
+    for (const auto& extra : mExtraStations) {
+        if (extra.port->path() == path) return;
+    }
+
+    ALOGI("Estação a mais em %s", path.c_str());
+    ExtraStation extra;
+    extra.reader = std::make_unique<SerialReader>(path, false);
+    extra.port = std::make_unique<StationPort>(this, path, extra.reader.get(), mProducer);
+    // Aberta desde já: os sensores só são anunciados depois do device_id
+    extra.reader->setStayConnected(true);
+    extra.reader->setListener(extra.port.get());
+    extra.reader->start();
+    mExtraStations.push_back(std::move(extra));
+}
+
+void AirQualitySubHal::removeSerialStation(const std::string& path) {
+    ExtraStation removed;
+    {
+        std::lock_guard<std::mutex> lock(mExtraLock);
+        auto it = std::find_if(mExtraStations.begin(), mExtraStations.end(),
+                               [&](const ExtraStation& extra) { return extra.port->path() == path; });
+        if (it == mExtraStations.end()) return;
+        removed = std::move(*it);
+        mExtraStations.erase(it);
+    }
+
+    ALOGI("Porta %s removida", path.c_str());
+    // Parado, o leitor não avisa mais nada: a desconexão sai daqui (se o
+    // hangup ainda não a anunciou). A mensagem fica com a estação, que só é
+    // destruída depois das mensagens anteriores que apontam para a porta.
+    removed.reader->stop();
+    auto owned = std::make_shared<ExtraStation>(std::move(removed));
+    mDispatcher.post([this, owned] { stationLost(owned->port.get()); });
+}
+
+void AirQualitySubHal::rescanStations() {
+    for (const auto& path : HotplugMonitor::instance().ports()) addSerialStation(path);
+}
+
+void AirQualitySubHal::StationPort::onDataReceived(const AirData& data) {
+    // Antes do device_id a amostra não tem faixa de handles
+    int station = mStation;
+    if (station < 0) return;
+    AirData stamped = data;
+    stamped.station = station;
+    mTarget->onDataReceived(stamped);
+}
+
+void AirQualitySubHal::StationPort::onStationIdentified(const std::string& deviceId) {
+    // Até a thread de despacho ligar a faixa do device_id novo
+    mStation = -1;
+    AirQualitySubHal* subHal = mSubHal;
+    mSubHal->mDispatcher.post([subHal, this, deviceId] { subHal->stationIdentified(this, deviceId); });
+}
+
+void AirQualitySubHal::StationPort::onStationLost() {
+    mStation = -1;
+    AirQualitySubHal* subHal = mSubHal;
+    mSubHal->mDispatcher.post([subHal, this] { subHal->stationLost(this); });
+}
+
+void AirQualitySubHal::stationIdentified(StationPort* port, const std::string& deviceId) {
+    std::vector<int32_t> lost;
+    std::vector<SensorInfo> found;
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        int station;
+        auto it = mStationById.find(deviceId);
+        if (it != mStationById.end()) {
+            station = it->second;
+        } else if (static_cast<size_t>(mNextStation) < SensorRegistry::kMaxStations) {
+            station = mNextStation++;
+            mStationById[deviceId] = station;
+            addStationSensors(station, deviceId);
+        } else {
+            ALOGE("Sem faixa de handles para a estação %s em %s", deviceId.c_str(), port->path().c_str());
+            port->bind(port->station());  // Segue na faixa que tinha
+            return;
+        }
+        if (port->station() == station) {
+            port->bind(station);  // O carimbo parou no aviso
+            return;
+        }
+
+        // Outra estação na mesma porta (trocaram o cabo sem hangup)
+        int previous = port->station();
+        if (previous > 0) {
+            mStations[previous].reader = nullptr;
+            for (uint64_t mask = mSensors.stationMask(previous); mask != 0; mask &= mask - 1) {
+                size_t index = __builtin_ctzll(mask);
+                mSensors.setActive(index, false);
+                lost.push_back(mSensors[index].getSensorInfo().sensorHandle);
+            }
+        }
+        port->bind(-1);
+
+        if (mStations[station].reader != nullptr) {
+            ALOGW("Estação %s já conectada; ignorando %s", deviceId.c_str(), port->path().c_str());
+        } else {
+            ALOGI("Estação %s (%s) nos handles %d..%d", deviceId.c_str(), port->path().c_str(),
+                  SensorRegistry::kHandleBase + station * SensorRegistry::kStationStride + 1,
+                  SensorRegistry::kHandleBase + station * SensorRegistry::kStationStride + 99);
+            mStations[station].reader = port->reader();
+            port->bind(station);
+            for (uint64_t mask = mSensors.stationMask(station); mask != 0; mask &= mask - 1) {
+                found.push_back(mSensors[__builtin_ctzll(mask)].getSensorInfo());
+            }
+        }
+        updateReaders();
+        ticket = mNextTicket++;
+    }
+
+    std::unique_lock<std::mutex> lock(mCallbackLock);
+    waitTurn(lock, ticket);
+    if (mCallback != nullptr) {
+        if (!lost.empty()) mCallback->onDynamicSensorsDisconnected(lost);
+        if (!found.empty()) mCallback->onDynamicSensorsConnected(found);
+    }
+    endTurn(lock);
+}
+
+void AirQualitySubHal::stationLost(StationPort* port) {
+    std::vector<int32_t> lost;
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        int station = port->station();
+        if (station <= 0) return;
+        ALOGI("Estação %s (%s) desconectada", mStations[station].deviceId.c_str(), port->path().c_str());
+        port->bind(-1);
+        // Ninguém mais pede dados a ela; a porta segue aberta esperando a volta
+        port->reader()->setPollingActive(false);
+        mStations[station].reader = nullptr;
+        // Sensor retirado não fica ativo: na volta o framework ativa de novo
+        for (uint64_t mask = mSensors.stationMask(station); mask != 0; mask &= mask - 1) {
+            size_t index = __builtin_ctzll(mask);
+            mSensors.setActive(index, false);
+            lost.push_back(mSensors[index].getSensorInfo().sensorHandle);
+        }
+        updateReaders();
+        ticket = mNextTicket++;
+    }
+
+    std::unique_lock<std::mutex> lock(mCallbackLock);
+    waitTurn(lock, ticket);
+    if (mCallback != nullptr) mCallback->onDynamicSensorsDisconnected(lost);
+    endTurn(lock);
+}
+
 Return<void> AirQualitySubHal::getSensorsList(getSensorsList_cb _hidl_cb) {
+    // Só os estáticos: os das estações a mais chegam por onDynamicSensorsConnected
     std::vector<SensorInfo> sensors;
-    for (const auto& sensor : mSensors) {
-        sensors.push_back(sensor.getSensorInfo());
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    for (uint64_t mask = mSensors.stationMask(0); mask != 0; mask &= mask - 1) {
+        sensors.push_back(mSensors[__builtin_ctzll(mask)].getSensorInfo());
     }
     _hidl_cb(sensors);
     return Void();
 }
 
-Return<Result> AirQualitySubHal::activate(int32_t sensorHandle, bool enabled) {
-    bool anyActive = false;
-    for (auto& sensor : mSensors) {
-        if (sensor.getSensorInfo().sensorHandle == sensorHandle) {
-            sensor.setActive(enabled);
+void AirQualitySubHal::updateReaders() {
+    mDirectMask = 0;
+    for (const auto& entry : mDirectChannels) {
+        for (const auto& rate : entry.second->rates()) {
+            // Handle fora do registro: o -1 viraria um shift indefinido
+            int index = mSensors.indexOf(rate.first);
+            if (index >= 0) mDirectMask |= uint64_t(1) << index;
+        }
+    }
+
+    for (size_t station = 0; station < SensorRegistry::kMaxStations; station++) {
+        IDataReader* reader = mStations[station].reader;
+        if (reader == nullptr) continue;
+
+        uint64_t stationMask = mSensors.stationMask(station);
+        uint64_t active = mSensors.activeMask() & stationMask;
+        uint64_t direct = mDirectMask & stationMask;
+        bool anyActive = (active | direct) != 0;
+        int64_t periodNs = INT64_MAX;
+        // Cada sub-sensor da estação no menor período de quem depende dele
+        TargetPeriodsNs targetsNs;
+        targetsNs.fill(INT64_MAX);
+        auto need = [&](const AirQualitySensor& sensor, int64_t sensorNs) {
+            periodNs = std::min(periodNs, sensorNs);
+            for (int t = 0; t < kStationTargets; t++) {
+                if (sensor.getStationTargets() & (1 << t)) targetsNs[t] = std::min(targetsNs[t], sensorNs);
+            }
+        };
+        for (uint64_t mask = active; mask != 0; mask &= mask - 1) {
+            const AirQualitySensor& sensor = mSensors[__builtin_ctzll(mask)];
+            need(sensor, sensor.getSamplingPeriodNs());
+        }
+        for (uint64_t mask = direct; mask != 0; mask &= mask - 1) {
+            const AirQualitySensor& sensor = mSensors[__builtin_ctzll(mask)];
+            need(sensor, sensor.getSensorInfo().minDelay * 1000LL);
+        }
+        // Sensor sem alvo próprio (a fonte) vai no ritmo do mais rápido; sozinho, pede o MQ7
+        int fastest = TARGET_MQ7;
+        for (int t = 0; t < kStationTargets; t++) {
+            if (targetsNs[t] < targetsNs[fastest]) fastest = t;
+        }
+        targetsNs[fastest] = std::min(targetsNs[fastest], periodNs);
+        for (auto& targetNs : targetsNs) {
+            if (targetNs == INT64_MAX) targetNs = 0;
+        }
+
+        // O período vai antes do polling para o primeiro STREAM ON já sair com ele
+        if (anyActive) {
+            reader->setTargetPeriodsNs(targetsNs);
+            reader->setSamplingPeriodNs(periodNs);
         }
-        if (sensor.isActive()) anyActive = true;
+        reader->setPollingActive(anyActive);
     }
-    mSerialReader.setPollingActive(anyActive);
-    mWifiReader.setPollingActive(anyActive); // <-- ADICIONADO
+}
+
+Return<Result> AirQualitySubHal::activate(int32_t sensorHandle, bool enabled) {
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    int index = mSensors.indexOf(sensorHandle);
+    if (index < 0) return Result::BAD_VALUE;
+    mSensors.setActive(index, enabled);
+    updateReaders();
     
     return Result::OK;
 }
 
 Return<Result> AirQualitySubHal::batch(int32_t sensorHandle, int64_t samplingPeriodNs, int64_t maxReportLatencyNs) {
-    for (auto& sensor : mSensors) {
-        if (sensor.getSensorInfo().sensorHandle == sensorHandle) {
-            sensor.batch(samplingPeriodNs, maxReportLatencyNs);
-            return Result::OK;
-        }
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    int index = mSensors.indexOf(sensorHandle);
+    if (index < 0) return Result::BAD_VALUE;
+    mSensors.batch(index, samplingPeriodNs, maxReportLatencyNs);
+    updateReaders();
+    mFlushCv.notify_one(); // Latência menor pode antecipar o prazo
+    return Result::OK;
+}
+
+std::vector<Event>& AirQualitySubHal::eventBuffer() {
+    thread_local std::vector<Event> tEvents;
+    if (tEvents.capacity() == 0) tEvents.reserve(kEventBufferReserve);
+    tEvents.clear();
+    return tEvents;
+}
+
+void AirQualitySubHal::waitTurn(std::unique_lock<std::mutex>& lock, uint64_t ticket) {
+    mTurnCv.wait(lock, [&] { return mTurn == ticket; });
+}
+
+void AirQualitySubHal::endTurn(std::unique_lock<std::mutex>& lock) {
+    mTurn++;
+    lock.unlock();
+    mTurnCv.notify_all();
+}
+
+void AirQualitySubHal::postEvents(const std::vector<Event>& events, bool wakeUp, uint64_t ticket) {
+    // Toda alocação do buffer aparece como mudança de capacidade
+    thread_local size_t tCapacity = 0;
+    if (events.capacity() != tCapacity) {
+        tCapacity = events.capacity();
+        mCounters.allocations++;
     }
-    return Result::BAD_VALUE;
+
+    std::unique_lock<std::mutex> lock(mCallbackLock);
+    waitTurn(lock, ticket);
+    if (mCallback != nullptr && !events.empty()) {
+        mCallback->postEvents(events, mCallback->createScopedWakelock(wakeUp));
+        mCounters.posts++;
+        mCounters.events += events.size();
+        if (wakeUp) mCounters.wakelocks++;
+    }
+    endTurn(lock);
 }
 
 void AirQualitySubHal::onDataReceived(const AirData& data) {
-    std::vector<Event> events;
-    for (auto& sensor : mSensors) {
-        if (sensor.isActive()) {
-            Event event;
-            if (sensor.processInput(data, &event)) {
-                events.push_back(event);
-            }
+    bool fifoFull = false;
+    bool newDeadline = false;
+    std::vector<Event>& events = eventBuffer();
+
+    std::unique_lock<std::mutex> lock(mSensorsLock);
+    if (data.station == 0) mHistory.add(data);
+    if (mJournal.isOpen()) mJournal.append(data);
+    Event fresh[SensorRegistry::kMaxSensors];
+    size_t count = mSensors.fanOut(data, fresh);
+    size_t immediate = 0;
+    for (size_t i = 0; i < count; i++) {
+        AirQualitySensor& sensor = *mSensors.find(fresh[i].sensorHandle);
+        if (sensor.getMaxReportLatencyNs() == 0) {
+            fresh[immediate++] = fresh[i];
+        } else {
+            newDeadline |= sensor.fifoSize() == 0;
+            sensor.pushEvent(fresh[i]);
+            fifoFull |= sensor.fifoFull();
         }
     }
-    if (!events.empty()) {
-        std::lock_guard<std::mutex> lock(mCallbackLock);
-        if (mCallback != nullptr) {
-            ScopedWakelock wakelock = mCallback->createScopedWakelock(false); // Ajustado para false
-            mCallback->postEvents(events, std::move(wakelock));
+
+    if (mDirectMask != 0) writeDirectReports(data);
+
+    // Ordem de entrega: flushes pendentes, FIFOs (se alguma encheu), amostra nova
+    events.insert(events.end(), mPendingEvents.begin(), mPendingEvents.end());
+    mPendingEvents.clear();
+
+    // Uma FIFO cheia esvazia todas: o framework já vai acordar de qualquer jeito
+    if (fifoFull) {
+        for (auto& sensor : mSensors) sensor.drainFifo(&events);
+    } else if (newDeadline) {
+        mFlushCv.notify_one();
+    }
+    events.insert(events.end(), fresh, fresh + immediate);
+    if (events.empty()) return;
+    // Sensores não-wake-up não podem segurar o AP acordado
+    bool wakeUp = (mSensors.activeMask() & mSensors.wakeUpMask()) != 0;
+    uint64_t ticket = mNextTicket++;
+    lock.unlock();
+
+    postEvents(events, wakeUp, ticket);
+}
+
+void AirQualitySubHal::writeDirectReports(const AirData& data) {
+    Event events[SensorRegistry::kMaxSensors];
+    size_t count = mSensors.read(data, mDirectMask, events);
+    for (size_t i = 0; i < count; i++) {
+        for (auto& entry : mDirectChannels) {
+            if (entry.second->isReporting(events[i].sensorHandle)) entry.second->write(events[i]);
         }
     }
 }
 
+void AirQualitySubHal::flushThread() {
+    std::unique_lock<std::mutex> lock(mSensorsLock);
+    while (mFlushRunning) {
+        // flush() pendente vence na hora
+        int64_t deadlineNs = mPendingEvents.empty() ? INT64_MAX : 0;
+        for (const auto& sensor : mSensors) {
+            deadlineNs = std::min(deadlineNs, sensor.fifoDeadlineNs());
+        }
+
+        if (deadlineNs == INT64_MAX) {
+            mFlushCv.wait(lock);
+            continue;
+        }
+        int64_t nowNs = android::elapsedRealtimeNano();
+        if (nowNs < deadlineNs) {
+            mFlushCv.wait_for(lock, std::chrono::nanoseconds(deadlineNs - nowNs));
+            continue;
+        }
+
+        // Prazo vencido: leva junto o que as outras FIFOs já acumularam,
+        // um único postEvents por janela de latência
+        std::vector<Event>& events = eventBuffer();
+        events.insert(events.end(), mPendingEvents.begin(), mPendingEvents.end());
+        mPendingEvents.clear();
+        for (auto& sensor : mSensors) sensor.drainFifo(&events);
+        bool wakeUp = (mSensors.activeMask() & mSensors.wakeUpMask()) != 0;
+        uint64_t ticket = mNextTicket++;
+        lock.unlock();
+        postEvents(events, wakeUp, ticket);
+        lock.lock();
+    }
+}
+
 Return<Result> AirQualitySubHal::injectSensorData(const Event& /*event*/) { return Result::INVALID_OPERATION; }
 
 Return<Result> AirQualitySubHal::flush(int32_t sensorHandle) {
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    AirQualitySensor* sensor = mSensors.find(sensorHandle);
+    if (sensor == nullptr) return Result::BAD_VALUE;
+
+    // Pendentes primeiro: o FLUSH_COMPLETE marca o fim da FIFO deste sensor.
+    // Quem entrega é a próxima amostra ou a flushThread, o que vier antes,
+    // então vários flush() seguidos saem num postEvents só.
+    size_t capacity = mPendingEvents.capacity();
+    sensor->drainFifo(&mPendingEvents);
+
     Event event;
     event.sensorHandle = sensorHandle;
     event.sensorType   = SensorType::META_DATA;
     event.u.meta.what  = MetaDataEventType::META_DATA_FLUSH_COMPLETE;
-    std::vector<Event> events;
-    events.push_back(event);
+    mPendingEvents.push_back(event);
+    if (mPendingEvents.capacity() != capacity) mCounters.allocations++;
+
+    mFlushCv.notify_one();
+    return Result::OK;
+}
+
+Return<Result> AirQualitySubHal::setOperationMode(OperationMode) { return Result::OK; }
+
+Return<void> AirQualitySubHal::debug(const hidl_handle& fd, const hidl_vec<hidl_string>&) {
+    const native_handle_t* handle = fd.getNativeHandle();
+    if (handle == nullptr || handle->numFds < 1) return Void();
+
+    uint64_t posts = mCounters.posts, events = mCounters.events;
+    uint64_t allocations = mCounters.allocations, wakelocks = mCounters.wakelocks;
+    double seconds = mInitializedAtNs == 0 ? 0.0
+            : (android::elapsedRealtimeNano() - mInitializedAtNs) / 1e9;
+    double perSecond = seconds > 0.0 ? 1.0 / seconds : 0.0;
+    dprintf(handle->data[0],
+            "postEvents: %llu (%.2f/s), eventos: %llu, alocações: %llu (%.4f/s), wakelocks: %llu (%.4f/s)\n",
+            static_cast<unsigned long long>(posts), posts * perSecond,
+            static_cast<unsigned long long>(events),
+            static_cast<unsigned long long>(allocations), allocations * perSecond,
+            static_cast<unsigned long long>(wakelocks), wakelocks * perSecond);
+
+    for (const auto& s : mDispatcher.stats()) {
+        dprintf(handle->data[0], "Fila %s: %llu entregues, %llu descartadas, pico %zu/%zu\n",
+                s.name.c_str(), static_cast<unsigned long long>(s.delivered),
+                static_cast<unsigned long long>(s.drops), s.highWater, DataDispatcher::kQueueCapacity);
+    }
+    for (const auto& s : mArbiter.stats()) {
+        dprintf(handle->data[0], "Enlace %s%s: %llu entregues, %llu repetidas, %llu ignoradas, %llu trocas\n",
+                s.name.c_str(), s.primary ? " (primário)" : s.active ? " (candidato)" : "",
+                static_cast<unsigned long long>(s.delivered),
+                static_cast<unsigned long long>(s.duplicates),
+                static_cast<unsigned long long>(s.ignored),
+                static_cast<unsigned long long>(s.promotions));
+    }
     {
-        std::lock_guard<std::mutex> lock(mCallbackLock);
-        if (mCallback != nullptr) {
-            ScopedWakelock wakelock = mCallback->createScopedWakelock(false); // Ajustado para false
-            mCallback->postEvents(events, std::move(wakelock));
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        for (size_t station = 1; station < static_cast<size_t>(mNextStation); station++) {
+            int32_t first = SensorRegistry::kHandleBase + station * SensorRegistry::kStationStride;
+            dprintf(handle->data[0], "Estação %s: handles %d..%d, %s\n",
+                    mStations[station].deviceId.c_str(), first + 1, first + 99,
+                    mStations[station].reader != nullptr ? "conectada" : "desconectada");
         }
     }
+    uint64_t ioWakeups = IoReactor::instance().wakeups();
+    dprintf(handle->data[0], "Reator de I/O: %llu despertares (%.4f/s)\n",
+            static_cast<unsigned long long>(ioWakeups), ioWakeups * perSecond);
+    WifiReader::Stats wifi = mWifiReader.stats();
+    dprintf(handle->data[0], "Wi-Fi: %s, %llu conexões, %llu falhas, %llu quedas, reconexão %lld ms (pior %lld ms)\n",
+            wifi.connected ? "conectado" : "desconectado",
+            static_cast<unsigned long long>(wifi.connects),
+            static_cast<unsigned long long>(wifi.connectFailures),
+            static_cast<unsigned long long>(wifi.disconnects),
+            static_cast<long long>(wifi.lastReconnectMs), static_cast<long long>(wifi.maxReconnectMs));
+    const std::pair<const char*, AdaptiveRate::Stats> rates[] = {
+        {"serial", mSerialReader.rateStats()},
+        {"wifi", mWifiReader.rateStats()},
+    };
+    for (const auto& rate : rates) {
+        dprintf(handle->data[0], "Taxa %s: período %d ms, %llu aumentos, %llu reduções\n",
+                rate.first, rate.second.periodMs,
+                static_cast<unsigned long long>(rate.second.boosts),
+                static_cast<unsigned long long>(rate.second.backoffs));
+    }
+    TelemetryJournal::Stats journal = mJournal.stats();
+    dprintf(handle->data[0], "Diário: %llu registros, %llu segmentos (%llu sem reserva), "
+            "%llu msync, %llu apagados, %llu perdidos\n",
+            static_cast<unsigned long long>(journal.appended),
+            static_cast<unsigned long long>(journal.segments),
+            static_cast<unsigned long long>(journal.stalls),
+            static_cast<unsigned long long>(journal.syncs),
+            static_cast<unsigned long long>(journal.removed),
+            static_cast<unsigned long long>(journal.drops));
+    return Void();
+}
+
+Return<void> AirQualitySubHal::registerDirectChannel(const SharedMemInfo& mem, registerDirectChannel_cb _hidl_cb) {
+    if (mem.type != SharedMemType::ASHMEM) {
+        _hidl_cb(Result::INVALID_OPERATION, -1); // Gralloc não anunciado nos flags
+        return Void();
+    }
+
+    auto channel = std::make_unique<DirectChannel>(mem);
+    if (!channel->isValid()) {
+        _hidl_cb(Result::BAD_VALUE, -1);
+        return Void();
+    }
+
+    int32_t channelHandle;
+    {
+        std::lock_guard<std::mutex> lock(mSensorsLock);
+        channelHandle = mNextChannelHandle++;
+        mDirectChannels[channelHandle] = std::move(channel);
+    }
+    ALOGI("Canal direto %d registrado (%u bytes)", channelHandle, mem.size);
+    _hidl_cb(Result::OK, channelHandle);
+    return Void();
+}
+
+Return<Result> AirQualitySubHal::unregisterDirectChannel(int32_t channelHandle) {
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    if (mDirectChannels.erase(channelHandle) == 0) return Result::BAD_VALUE;
+    updateReaders();
     return Result::OK;
 }
 
-Return<Result> AirQualitySubHal::setOperationMode(OperationMode) { return Result::OK; }
-Return<void>   AirQualitySubHal::debug(const hidl_handle&, const hidl_vec<hidl_string>&) { return Void(); }
-Return<void>   AirQualitySubHal::registerDirectChannel(const SharedMemInfo&, registerDirectChannel_cb _hidl_cb) { _hidl_cb(Result::INVALID_OPERATION, -1); return Void(); }
-Return<Result> AirQualitySubHal::unregisterDirectChannel(int32_t) { return Result::INVALID_OPERATION; }
-Return<void>   AirQualitySubHal::configDirectReport(int32_t, int32_t, RateLevel, configDirectReport_cb _hidl_cb) { _hidl_cb(Result::INVALID_OPERATION, 0); return Void(); }
+Return<void> AirQualitySubHal::configDirectReport(int32_t sensorHandle, int32_t channelHandle, RateLevel rate, configDirectReport_cb _hidl_cb) {
+    std::lock_guard<std::mutex> lock(mSensorsLock);
+    auto it = mDirectChannels.find(channelHandle);
+    if (it == mDirectChannels.end()) {
+        _hidl_cb(Result::BAD_VALUE, 0);
+        return Void();
+    }
+    DirectChannel& channel = *it->second;
+
+    // -1 só vale para parar todos os sensores do canal
+    if (sensorHandle == -1) {
+        if (rate != RateLevel::STOP) {
+            _hidl_cb(Result::BAD_VALUE, 0);
+            return Void();
+        }
+        channel.stopAll();
+        updateReaders();
+        _hidl_cb(Result::OK, 0);
+        return Void();
+    }
+
+    // Até a taxa anunciada nos flags: NORMAL (a estação não passa de 10Hz),
+    // ou nenhuma para os índices on-change
+    AirQualitySensor* sensor = mSensors.find(sensorHandle);
+    uint32_t maxRate = sensor == nullptr ? 0
+            : (sensor->getSensorInfo().flags & static_cast<uint32_t>(SensorFlagBits::MASK_DIRECT_REPORT)) >>
+              static_cast<uint8_t>(SensorFlagShift::DIRECT_REPORT);
+    if (sensor == nullptr || static_cast<uint32_t>(rate) > maxRate) {
+        _hidl_cb(Result::BAD_VALUE, 0);
+        return Void();
+    }
+    channel.setRate(sensorHandle, rate);
+    updateReaders();
+    _hidl_cb(Result::OK, rate == RateLevel::STOP ? 0 : sensorHandle);
+    return Void();
+}
 
 extern "C" {
     __attribute__((visibility("default")))
@@ -2,13 +2,25 @@
 
 #include <V2_0/SubHal.h>
 #include <hardware/sensors.h>
+#include <map>
+#include <memory>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
 #include <string>
 
+#include "io/DataDispatcher.h"
+#include "io/HotplugMonitor.h"
 #include "io/SerialReader.h"
 #include "io/WifiReader.h" // <-- ADICIONADO
+#include "io/ReaderArbiter.h"
+#include "io/TelemetryJournal.h"
 #include "sensors/AirQualitySensor.h"
+#include "sensors/DirectChannel.h"
+#include "sensors/SensorRegistry.h"
+#include "utils/AirHistory.h"
 
 /** * @name Namespaces de Implementação (Wrapper)
  * @{ 
@@ -38,10 +50,38 @@ using android::hardware::sensors::V1_0::Event;
  * @brief Implementação da Sub-HAL de Sensores para monitoramento de qualidade do ar.
  * * Esta classe estende a interface ISensorsSubHal (V2.0) e atua como um listener
  * para dados brutos vindos da camada de hardware via SerialReader e WifiReader.
+ * Os leitores entregam ao DataDispatcher: onDataReceived() roda na thread de
+ * despacho, nunca na thread de I/O.
+ *
+ * Várias estações: a principal (serial configurada + Wi-Fi, no árbitro) fica
+ * com a faixa 0 de handles, estática. Cada estação a mais numa porta serial
+ * ganha uma faixa própria (SensorRegistry::kStationStride) pelo device_id que
+ * ela informa, e os sensores dela são anunciados e retirados como sensores
+ * dinâmicos conforme ela aparece e some. Em standby o leitor dela só manda
+ * GET SETTINGS: a estação precisa responder com "device_id" (ou mandar o
+ * boot com "device"), senão nunca é anunciada. A faixa de um device_id não muda
+ * enquanto o processo viver. Com a descoberta ligada, as portas que o
+ * HotplugMonitor avisa viram estações a mais e as removidas são fechadas.
+ *
+ * A estação principal também tem sensores virtuais de histórico (5011..5016):
+ * cada amostra dela entra no AirHistory e eles entregam média, mínimo, máximo
+ * e EWMA de 1 min, 1 h e 24 h do canal, e sensores on-change de índice de
+ * qualidade do ar (5021 US EPA, 5022 IQAr) calculados das mesmas janelas. O
+ * histórico só cresce enquanto a estação é lida, ou seja, enquanto algum
+ * sensor dela está ativo.
+ *
+ * Com o diário aberto (openJournal; o construtor padrão abre kJournalDir),
+ * toda amostra de qualquer estação também vai para o TelemetryJournal, que
+ * quem estava desligado lê depois direto dos segmentos.
  */
-class AirQualitySubHal : public ISensorsSubHal, public IAirDataListener {
+class AirQualitySubHal : public ISensorsSubHal, public IAirDataListener,
+                         private HotplugMonitor::Listener {
 public:
     AirQualitySubHal();
+    /// Estação em outra porta/endereço (testes e bancadas)
+    /// discoverPorts: as outras portas ttyUSB*/ttyACM* viram estações a mais
+    AirQualitySubHal(const std::string& serialPort, const std::string& wifiIp, int wifiPort,
+                     bool discoverPorts = false);
     ~AirQualitySubHal();
 
     virtual Return<Result> initialize(const sp<IHalProxyCallback>& halProxyCallback) override;
@@ -62,12 +102,151 @@ public:
 
     void onDataReceived(const AirData& data) override;
 
+    static constexpr const char* kJournalDir = "/data/vendor/sensors/airquality/journal";
+
+    /// Liga o diário de telemetria (antes do initialize). false = segue sem ele.
+    bool openJournal(const std::string& dir,
+                     const TelemetryJournal::Options& options = TelemetryJournal::Options()) {
+        return mJournal.open(dir, options);
+    }
+    const TelemetryJournal& journal() const { return mJournal; }
+
+    /// Abre uma estação a mais na porta (sem efeito se a porta já tem leitor).
+    void addSerialStation(const std::string& path);
+    /// Fecha o leitor da porta (a estação dela é desconectada).
+    void removeSerialStation(const std::string& path);
+    /// Abre as portas ttyUSB*/ttyACM* que ainda não têm leitor.
+    void rescanStations();
+
+    /// Contadores do caminho de entrega (também no dumpsys via debug()).
+    struct DispatchCounters {
+        std::atomic<uint64_t> posts{0};        // Chamadas de postEvents
+        std::atomic<uint64_t> events{0};
+        std::atomic<uint64_t> allocations{0};  // Crescimentos dos buffers de eventos
+        std::atomic<uint64_t> wakelocks{0};    // postEvents com wakelock
+    };
+    const DispatchCounters& counters() const { return mCounters; }
+
 private:
+    /**
+     * Listener de uma estação a mais: carimba AirData::station com a faixa
+     * dela e repassa ao produtor comum. Na thread de I/O (o IoReactor).
+     *
+     * Identificação e queda só param o carimbo ali; o resto (mSensorsLock e
+     * as chamadas de sensores dinâmicos ao framework) vai como mensagem para
+     * a thread de despacho, que liga a porta à faixa com bind().
+     */
+    class StationPort : public IAirDataListener {
+    public:
+        StationPort(AirQualitySubHal* subHal, const std::string& path, IDataReader* reader,
+                    IAirDataListener* target)
+            : mSubHal(subHal), mPath(path), mReader(reader), mTarget(target), mBound(-1) {}
+
+        void onDataReceived(const AirData& data) override;
+        void onStationIdentified(const std::string& deviceId) override;
+        void onStationLost() override;
+
+        const std::string& path() const { return mPath; }
+        IDataReader* reader() const { return mReader; }
+        // Da thread de despacho, com mSensorsLock
+        int station() const { return mBound; }
+        void bind(int station) {
+            mBound = station;
+            mStation = station;
+        }
+
+    private:
+        AirQualitySubHal* mSubHal;
+        std::string mPath;
+        IDataReader* mReader;
+        IAirDataListener* mTarget;
+        std::atomic<int> mStation{-1};  // Carimbo; -1 = nenhuma faixa (não identificada ou caiu)
+        int mBound;                     // Faixa ligada pela thread de despacho
+    };
+
+    struct ExtraStation {
+        std::unique_ptr<SerialReader> reader;
+        std::unique_ptr<StationPort> port;
+    };
+
+    // Faixa de handles de cada estação (índice = estação do SensorRegistry)
+    struct Station {
+        std::string deviceId;
+        IDataReader* reader = nullptr;  // nullptr = desconectada
+    };
+
+    // Hotplug (thread do reator): porta nova vira estação, porta removida é fechada
+    void onPortAdded(const std::string& path) override { addSerialStation(path); }
+    void onPortRemoved(const std::string& path) override { removeSerialStation(path); }
+
+    // Eventos por post reservados em cada buffer (cresce se uma FIFO cheia pedir mais)
+    static constexpr size_t kEventBufferReserve = 256;
+
+    // Buffer de eventos da thread atual, vazio e com capacidade reservada
+    std::vector<Event>& eventBuffer();
+
+    // Repassa aos leitores o estado agregado dos sensores de cada estação (algum
+    // ativo? menor período?). Um sensor num canal direto conta como ativo na sua taxa máxima.
+    void updateReaders();
+
+    // Com mSensorsLock: cria os sensores da faixa de uma estação nova
+    void addStationSensors(int station, const std::string& deviceId);
+    // Estação a mais identificada/perdida (thread de despacho): liga a porta à
+    // faixa do device_id e anuncia/retira os sensores dinâmicos
+    void stationIdentified(StationPort* port, const std::string& deviceId);
+    void stationLost(StationPort* port);
+
+    // Grava a amostra nos canais diretos que a reportam
+    void writeDirectReports(const AirData& data);
+
+    // Entrega ao framework sem mSensorsLock: activate/batch/flush não esperam
+    // o binder. Quem monta o lote pega o ticket (mNextTicket) ainda com
+    // mSensorsLock, e os lotes saem na ordem dos tickets, com mCallbackLock.
+    // events é sempre o eventBuffer() da thread (as realocações são contadas aqui).
+    void postEvents(const std::vector<Event>& events, bool wakeUp, uint64_t ticket);
+    // Com mCallbackLock: espera a vez do ticket / passa a vez ao próximo
+    void waitTurn(std::unique_lock<std::mutex>& lock, uint64_t ticket);
+    void endTurn(std::unique_lock<std::mutex>& lock);
+
+    // Esvazia as FIFOs quando o maxReportLatency do evento mais antigo vence
+    // e entrega os FLUSH_COMPLETE pendentes
+    void flushThread();
+
     sp<IHalProxyCallback> mCallback;
-    std::vector<AirQualitySensor> mSensors;
+
+    // Estado dos sensores (ativo, batch, FIFOs): leitores, framework e flushThread
+    std::mutex mSensorsLock;
+    SensorRegistry mSensors;
+    AirHistory mHistory;  // Da estação principal; lido pelo mSensors
+    Station mStations[SensorRegistry::kMaxStations];
+    std::map<std::string, int> mStationById;  // device_id -> faixa (só estações a mais)
+    int mNextStation;
+    std::map<int32_t, std::unique_ptr<DirectChannel>> mDirectChannels;
+    uint64_t mDirectMask; // Sensores em algum canal direto (bits do SensorRegistry)
+    int32_t mNextChannelHandle;
+    // Resultado de flush() (FIFO do sensor + FLUSH_COMPLETE) esperando a
+    // próxima entrega, que sai num único postEvents junto com os dados
+    std::vector<Event> mPendingEvents;
+    std::condition_variable mFlushCv;
+    std::thread mFlushThread;
+    bool mFlushRunning;
+    uint64_t mNextTicket;  // Próxima vez de falar com o framework
     
+    TelemetryJournal mJournal;  // Escrito na thread de despacho, com mSensorsLock
+    DataDispatcher mDispatcher; // Declarado antes dos leitores: é destruído depois deles
     SerialReader mSerialReader;
     WifiReader mWifiReader; // <-- ADICIONADO: O Leitor de Rede
+    ReaderArbiter mArbiter; // Depois dos leitores: para tudo antes de eles serem destruídos
+    IAirDataListener* mProducer; // Único produtor: todos os leitores rodam no IoReactor
+    bool mDiscoverPorts;
+    std::string mPrimaryPort;
+
+    std::mutex mExtraLock;
+    std::vector<ExtraStation> mExtraStations;
 
     std::mutex mCallbackLock;
+    std::condition_variable mTurnCv;
+    uint64_t mTurn;  // Ticket da vez (com mCallbackLock)
+    DispatchCounters mCounters;
+    int64_t mInitializedAtNs;
 };
\ No newline at end of file
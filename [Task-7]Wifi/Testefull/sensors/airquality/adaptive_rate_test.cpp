@@ -0,0 +1,120 @@
+// Testes do AdaptiveRate: ar estável fica no período pedido, um degrau ou
+// rampa leva ao limite da estação, e o período volta dobrando até o pedido.
+
+#include "io/AdaptiveRate.h"
+#include "io/StreamSession.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+AirData sample(float pm25, float temp = 25.0f) {
+    AirData data;
+    data.pm25 = pm25;
+    data.temp_c = temp;
+    data.valid = true;
+    return data;
+}
+
+// Alimenta amostras no período que o próprio AdaptiveRate devolve, como o
+// leitor em stream; retorna o instante final
+int64_t run(AdaptiveRate& rate, int requestedMs, int64_t nowMs, int64_t untilMs,
+            float (*pm25)(int64_t)) {
+    while (nowMs < untilMs) {
+        nowMs += rate.periodMs(requestedMs, nowMs);
+        rate.onSample(sample(pm25(nowMs)), nowMs);
+    }
+    return nowMs;
+}
+
+}  // namespace
+
+TEST(AdaptiveRateTest, NoisyButFlatStaysAtTheRequestedPeriod) {
+    AdaptiveRate rate;
+    std::mt19937 rng(42);
+    int64_t now = 0;
+    for (int i = 0; i < 600; i++) {  // 10 min a 1Hz, ruído de +-1 ug/m3
+        now += rate.periodMs(1000, now);
+        rate.onSample(sample(20.0f + static_cast<float>(rng() % 21) / 10.0f - 1.0f), now);
+    }
+    EXPECT_EQ(1000, rate.periodMs(1000, now));
+    AdaptiveRate::Stats stats = rate.stats();
+    EXPECT_EQ(0u, stats.boosts);
+    EXPECT_EQ(0u, stats.backoffs);
+}
+
+TEST(AdaptiveRateTest, StepBoostsThenBacksOffByDoubling) {
+    AdaptiveRate rate;
+    int64_t now = run(rate, 2000, 0, 60000, [](int64_t) { return 10.0f; });
+    EXPECT_EQ(2000, rate.stats().periodMs);
+
+    // Fumaça: PM2.5 salta de 10 para 80
+    now += rate.periodMs(2000, now);
+    rate.onSample(sample(80.0f), now);
+    EXPECT_EQ(StreamSession::kMinPeriodMs, rate.periodMs(2000, now));
+    EXPECT_EQ(1u, rate.stats().boosts);
+
+    // Parado em 80: 100 -> 200 -> ... -> 2000, um degrau por kHoldMs sem transiente
+    std::vector<int> periods;
+    int last = StreamSession::kMinPeriodMs;
+    while (now < 300000) {
+        now += rate.periodMs(2000, now);
+        rate.onSample(sample(80.0f), now);
+        int period = rate.periodMs(2000, now);
+        if (period != last) periods.push_back(period);
+        last = period;
+    }
+    EXPECT_EQ((std::vector<int>{200, 400, 800, 1600, 2000}), periods);
+    AdaptiveRate::Stats stats = rate.stats();
+    EXPECT_EQ(1u, stats.boosts);
+    EXPECT_EQ(5u, stats.backoffs);
+    EXPECT_EQ(2000, stats.periodMs);
+}
+
+TEST(AdaptiveRateTest, SteadyRampKeepsTheFastRate) {
+    AdaptiveRate rate;
+    // Temperatura subindo 1 C/s (limiar 0,5 C/s): segue no limite enquanto sobe
+    int64_t now = 0;
+    for (int i = 0; i < 300; i++) {
+        now += rate.periodMs(1000, now);
+        rate.onSample(sample(10.0f, 20.0f + now / 1000.0f), now);
+    }
+    EXPECT_EQ(StreamSession::kMinPeriodMs, rate.periodMs(1000, now));
+    EXPECT_EQ(1u, rate.stats().boosts);
+}
+
+TEST(AdaptiveRateTest, MissingChannelsAndInvalidSamplesAreIgnored) {
+    AdaptiveRate rate;
+    int64_t now = 0;
+    for (int i = 0; i < 20; i++) {
+        now += 1000;
+        // Sem leitura de PM (-1) alternando com leitura: não é transiente
+        rate.onSample(sample(i % 2 ? -1.0f : 15.0f), now);
+        AirData invalid = sample(500.0f);
+        invalid.valid = false;
+        rate.onSample(invalid, now);
+    }
+    EXPECT_EQ(1000, rate.periodMs(1000, now));
+}
+
+TEST(AdaptiveRateTest, RequestedPeriodIsTheFloorAndNotCounted) {
+    AdaptiveRate rate;
+    EXPECT_EQ(1000, rate.periodMs(1000, 0));
+    // A HAL pede mais rápido que o aumento: vale o pedido
+    EXPECT_EQ(50, rate.periodMs(50, 10));
+    EXPECT_EQ(5000, rate.periodMs(5000, 20));
+    EXPECT_EQ(0u, rate.stats().boosts);
+    EXPECT_EQ(0u, rate.stats().backoffs);
+
+    rate.onSample(sample(10.0f), 1000);
+    rate.onSample(sample(90.0f), 2000);
+    EXPECT_EQ(StreamSession::kMinPeriodMs, rate.periodMs(5000, 2000));
+
+    // Reconexão: volta ao pedido sem contar redução
+    rate.reset();
+    EXPECT_EQ(5000, rate.periodMs(5000, 2100));
+    EXPECT_EQ(0u, rate.stats().backoffs);
+}
@@ -0,0 +1,142 @@
+// Testes do AirHistory: as janelas deslizantes contra uma varredura ingênua
+// das amostras (com buracos maiores que a janela), a EWMA e o layout que os
+// sensores de histórico entregam.
+
+#include "utils/AirHistory.h"
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+namespace {
+
+const int64_t kSecondNs = 1000000000LL;
+
+struct Sample {
+    int64_t timestamp;
+    float value;
+};
+
+}  // namespace
+
+TEST(AirHistoryTest, WindowMatchesBruteForce) {
+    const int64_t kBucket = 1000;
+    const size_t kBuckets = 8;
+    SlidingWindow window(kBucket, kBuckets);
+    std::deque<Sample> samples;
+    std::mt19937 rng(0xA1257A7u);
+
+    int64_t now = 5 * kBucket;
+    for (int i = 0; i < 20000; i++) {
+        // Quase sempre amostras próximas; às vezes um buraco de várias janelas
+        now += (rng() % 50 == 0) ? rng() % (3 * kBucket * kBuckets) : rng() % (kBucket / 2);
+        float value = static_cast<float>(static_cast<int>(rng() % 2000) - 1000) / 10.0f;
+        window.add(now, value);
+        samples.push_back({now, value});
+
+        int64_t oldest = now / kBucket - static_cast<int64_t>(kBuckets) + 1;
+        while (samples.front().timestamp / kBucket < oldest) samples.pop_front();
+
+        double sum = 0.0;
+        float lo = samples.front().value, hi = lo;
+        for (const auto& s : samples) {
+            sum += s.value;
+            lo = std::min(lo, s.value);
+            hi = std::max(hi, s.value);
+        }
+        ASSERT_EQ(samples.size(), window.count()) << "amostra " << i;
+        ASSERT_NEAR(sum / samples.size(), window.mean(), 1e-3) << "amostra " << i;
+        ASSERT_EQ(lo, window.min()) << "amostra " << i;
+        ASSERT_EQ(hi, window.max()) << "amostra " << i;
+    }
+}
+
+TEST(AirHistoryTest, EmptyWindowIsNan) {
+    SlidingWindow window(kSecondNs, 60);
+    EXPECT_EQ(0u, window.count());
+    EXPECT_TRUE(isnan(window.mean()));
+    EXPECT_TRUE(isnan(window.min()));
+    EXPECT_TRUE(isnan(window.ewma()));
+}
+
+TEST(AirHistoryTest, EwmaUsesTheWindowAsTimeConstant) {
+    SlidingWindow window(kSecondNs, 60);
+    int64_t t = kSecondNs;
+    window.add(t, 10.0f);
+    EXPECT_EQ(10.0f, window.ewma());
+
+    // Degrau de 10 para 20 por uma janela inteira, a 1Hz: 1 - 1/e do caminho
+    for (int i = 1; i <= 60; i++) window.add(t + i * kSecondNs, 20.0f);
+    EXPECT_NEAR(20.0f - 10.0f * exp(-1.0), window.ewma(), 1e-3);
+
+    // A média já esqueceu o 10 (fora da janela), a EWMA não
+    EXPECT_EQ(20.0f, window.mean());
+    EXPECT_EQ(20.0f, window.min());
+}
+
+TEST(AirHistoryTest, SummarizesEachWindow) {
+    AirHistory history;
+    int64_t t = 1000 * kSecondNs;
+    for (int i = 0; i < 120; i++) {  // 2 min a 1Hz: a janela de 1 min só vê o fim
+        AirData data;
+        data.timestamp = t + i * kSecondNs;
+        data.pm25 = static_cast<float>(i);
+        // temp_c fica no padrão do AirData (-273, sem DHT): não entra
+        data.valid = true;
+        history.add(data);
+    }
+
+    float out[AirHistory::kValues];
+    history.summarize(0, out);
+    // 1 min: 60..119 (baldes de 1 s)
+    EXPECT_FLOAT_EQ(89.5f, out[0]);
+    EXPECT_EQ(60.0f, out[1]);
+    EXPECT_EQ(119.0f, out[2]);
+    // 1 h e 24 h: tudo
+    for (int w = 1; w < AirHistory::kWindows; w++) {
+        EXPECT_FLOAT_EQ(59.5f, out[w * AirHistory::kValuesPerWindow]);
+        EXPECT_EQ(0.0f, out[w * AirHistory::kValuesPerWindow + 1]);
+        EXPECT_EQ(119.0f, out[w * AirHistory::kValuesPerWindow + 2]);
+    }
+    // EWMA mais curta acompanha mais de perto
+    EXPECT_GT(out[3], out[7]);
+    EXPECT_GT(out[7], out[11]);
+
+    EXPECT_EQ(0u, history.window(4, AirHistory::WINDOW_1H).count());
+
+    AirData invalid;
+    invalid.timestamp = t + 200 * kSecondNs;
+    invalid.pm25 = 1000.0f;
+    history.add(invalid);
+    EXPECT_EQ(120u, history.window(0, AirHistory::WINDOW_24H).count());
+}
+
+TEST(AirHistoryTest, PartialSamplesKeepTheOtherChannels) {
+    // Polling seletivo: DHT a cada 2 s, SDS011 a cada 1 s, cada resposta só com o seu alvo
+    AirHistory history;
+    int64_t t = 1000 * kSecondNs;
+    for (int i = 0; i < 60; i++) {
+        AirData data;
+        data.timestamp = t + i * kSecondNs;
+        if (i % 2 == 0) {
+            data.temp_c = 25.0f;
+            data.humid_p = 50.0f;
+        } else {
+            data.pm25 = 10.0f;
+        }
+        data.valid = true;
+        history.add(data);
+    }
+
+    const SlidingWindow& temp = history.window(4, AirHistory::WINDOW_1MIN);
+    EXPECT_EQ(30u, temp.count());
+    EXPECT_EQ(25.0f, temp.mean());
+    EXPECT_EQ(25.0f, temp.min());
+    EXPECT_EQ(25.0f, temp.max());
+    EXPECT_EQ(50.0f, history.window(5, AirHistory::WINDOW_1MIN).min());
+    EXPECT_EQ(10.0f, history.window(0, AirHistory::WINDOW_1MIN).min());
+}
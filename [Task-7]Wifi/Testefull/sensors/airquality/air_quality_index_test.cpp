@@ -0,0 +1,63 @@
+// Testes do AirQualityIndex: pontos das tabelas US EPA e IQAr, o truncamento
+// da EPA nas bordas entre faixas, saturação e o poluente dominante.
+
+#include "utils/AirQualityIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+namespace {
+
+int epa(float pm25, float pm10, float co) {
+    return AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, pm25, pm10, co).index;
+}
+
+int iqar(float pm25, float pm10, float co) {
+    return AirQualityIndex::compute(AirQualityIndex::SCALE_BR_IQAR, pm25, pm10, co).index;
+}
+
+}  // namespace
+
+TEST(AirQualityIndexTest, UsEpaBreakpoints) {
+    // PM2.5 (24 h): bordas de cada faixa
+    const float pm25[][2] = {{0.0f, 0}, {9.0f, 50}, {9.1f, 51}, {35.4f, 100}, {35.5f, 101},
+                             {55.4f, 150}, {55.5f, 151}, {125.4f, 200}, {125.5f, 201},
+                             {225.4f, 300}, {225.5f, 301}, {325.4f, 500}};
+    for (const auto& point : pm25) EXPECT_EQ(point[1], epa(point[0], NAN, NAN)) << point[0];
+
+    // Valores do meio conferidos com a fórmula da EPA
+    EXPECT_EQ(56, epa(12.0f, NAN, NAN));
+    EXPECT_EQ(75, epa(NAN, 104.0f, NAN));
+    EXPECT_EQ(84, epa(NAN, NAN, 7.8f));
+
+    // Truncado antes da busca: 9,05 é 9,0 (não cai no buraco entre 9,0 e 9,1)
+    EXPECT_EQ(50, epa(9.05f, NAN, NAN));
+    EXPECT_EQ(50, epa(NAN, 54.9f, NAN));
+    EXPECT_EQ(50, epa(NAN, NAN, 4.49f));
+
+    // Acima da tabela satura
+    EXPECT_EQ(500, epa(900.0f, NAN, NAN));
+}
+
+TEST(AirQualityIndexTest, BrazilianIqarBreakpoints) {
+    EXPECT_EQ(0, iqar(0.0f, NAN, NAN));
+    EXPECT_EQ(40, iqar(25.0f, NAN, NAN));
+    EXPECT_EQ(61, iqar(37.5f, NAN, NAN));
+    EXPECT_EQ(80, iqar(NAN, 100.0f, NAN));
+    EXPECT_EQ(120, iqar(NAN, NAN, 13.0f));
+    EXPECT_EQ(200, iqar(NAN, 250.0f, NAN));
+    EXPECT_EQ(400, iqar(NAN, NAN, 80.0f));
+}
+
+TEST(AirQualityIndexTest, WorstPollutantWins) {
+    auto result = AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, 12.0f, 104.0f, 7.8f);
+    EXPECT_EQ(84, result.index);
+    EXPECT_EQ(AirQualityIndex::POLLUTANT_CO, result.dominant);
+
+    // Sem dado (NaN) ou leitura inválida (negativa) não conta
+    result = AirQualityIndex::compute(AirQualityIndex::SCALE_BR_IQAR, NAN, 60.0f, -1.0f);
+    EXPECT_EQ(49, result.index);
+    EXPECT_EQ(AirQualityIndex::POLLUTANT_PM10, result.dominant);
+    EXPECT_EQ(-1, epa(NAN, -1.0f, NAN));
+}
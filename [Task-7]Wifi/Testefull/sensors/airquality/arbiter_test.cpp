@@ -0,0 +1,226 @@
+// Testes do ReaderArbiter com enlaces falsos: quem fica ligado, failover por
+// primário quieto, volta ao enlace preferido e deduplicação na troca.
+
+#include "io/ReaderArbiter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int64_t kMsNs = 1000000LL;
+const int64_t kPeriodMs = 100;  // menor período aceito pelo StreamSession
+
+// Enlace sem thread: o teste decide quando ele entrega
+class FakeLink : public IDataReader {
+public:
+    void start() override { mStarted = true; }
+    void stop() override { mStarted = false; }
+    void setPollingActive(bool enabled) override {
+        if (enabled && !mActive) mActivations++;
+        mActive = enabled;
+    }
+    void setSamplingPeriodNs(int64_t periodNs) override { mPeriodNs = periodNs; }
+    void setListener(IAirDataListener* listener) override { mListener = listener; }
+
+    bool started() const { return mStarted; }
+    bool active() const { return mActive; }
+    int activations() const { return mActivations; }
+    int64_t periodNs() const { return mPeriodNs; }
+
+    void deliver(int64_t deviceMs, int64_t timestamp = 0) {
+        AirData data;
+        data.co_ppm = static_cast<float>(deviceMs);
+        data.source = "serial";  // o que vier no payload é sobrescrito pelo árbitro
+        data.deviceMs = deviceMs;
+        data.timestamp = timestamp;
+        data.valid = true;
+        mListener->onDataReceived(data);
+    }
+
+private:
+    std::atomic<bool> mStarted{false};
+    std::atomic<bool> mActive{false};
+    std::atomic<int> mActivations{0};
+    std::atomic<int64_t> mPeriodNs{0};
+    IAirDataListener* mListener = nullptr;
+};
+
+class Collector : public IAirDataListener {
+public:
+    void onDataReceived(const AirData& data) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mReadings.push_back(data);
+    }
+
+    std::vector<AirData> readings() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mReadings;
+    }
+
+private:
+    std::mutex mLock;
+    std::vector<AirData> mReadings;
+};
+
+template <typename Pred>
+bool waitFor(Pred pred, int timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (Clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return pred();
+}
+
+void sleepMs(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+class ReaderArbiterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mArbiter.addSource("serial", &mSerial);
+        mArbiter.addSource("wifi", &mWifi);
+        mArbiter.setListener(&mCollector);
+        mArbiter.setSamplingPeriodNs(kPeriodMs * kMsNs);
+        mArbiter.start();
+        mArbiter.setPollingActive(true);
+    }
+
+    void TearDown() override { mArbiter.stop(); }
+
+    // Serial entregando no ritmo pedido: o árbitro aprende o intervalo
+    void serialStream(int64_t fromDeviceMs, int count) {
+        for (int i = 0; i < count; i++) {
+            mSerial.deliver(fromDeviceMs + i * kPeriodMs);
+            sleepMs(kPeriodMs);
+        }
+    }
+
+    ReaderArbiter::SourceStats statsOf(const std::string& name) {
+        for (const auto& s : mArbiter.stats()) {
+            if (s.name == name) return s;
+        }
+        return {};
+    }
+
+    FakeLink mSerial;
+    FakeLink mWifi;
+    Collector mCollector;
+    ReaderArbiter mArbiter;
+};
+
+}  // namespace
+
+TEST_F(ReaderArbiterTest, OnlyThePreferredLinkPolls) {
+    EXPECT_TRUE(mSerial.started());
+    EXPECT_TRUE(mWifi.started());
+    EXPECT_EQ(kPeriodMs * kMsNs, mWifi.periodNs());  // reserva já sabe o período
+    EXPECT_TRUE(mSerial.active());
+    EXPECT_FALSE(mWifi.active());
+
+    serialStream(1000, 3);
+    mWifi.deliver(5000);  // em trânsito de uma ativação anterior
+
+    std::vector<AirData> readings = mCollector.readings();
+    ASSERT_EQ(3u, readings.size());
+    for (const auto& data : readings) EXPECT_EQ("serial", data.source);
+    EXPECT_EQ(1u, statsOf("wifi").ignored);
+    EXPECT_FALSE(mWifi.active());
+
+    mArbiter.setPollingActive(false);
+    EXPECT_FALSE(mSerial.active());
+    EXPECT_FALSE(mWifi.active());
+}
+
+TEST_F(ReaderArbiterTest, FailsOverWhenThePrimaryGoesQuiet) {
+    serialStream(1000, 3);
+    EXPECT_FALSE(mWifi.active());
+
+    // Primário quieto por 1,5 período: a reserva é ligada, o primário continua
+    auto quietSince = Clock::now();
+    ASSERT_TRUE(waitFor([&] { return mWifi.active(); }, 1000));
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - quietSince).count(), 500);
+    EXPECT_TRUE(mSerial.active());
+
+    // A reserva repete a última medição (mesmo millis) antes de trazer a nova
+    mWifi.deliver(1200);
+    mWifi.deliver(1300);
+    EXPECT_FALSE(mSerial.active());
+
+    std::vector<AirData> readings = mCollector.readings();
+    ASSERT_EQ(4u, readings.size());
+    EXPECT_EQ(1300, readings.back().deviceMs);
+    EXPECT_EQ("wifi", readings.back().source);
+
+    ReaderArbiter::SourceStats wifi = statsOf("wifi");
+    EXPECT_TRUE(wifi.primary);
+    EXPECT_EQ(1u, wifi.promotions);
+    EXPECT_EQ(1u, wifi.duplicates);
+    EXPECT_EQ(1u, wifi.delivered);
+}
+
+TEST_F(ReaderArbiterTest, PrimaryComingBackCancelsTheCandidate) {
+    serialStream(1000, 3);
+    ASSERT_TRUE(waitFor([&] { return mWifi.active(); }, 1000));
+
+    mSerial.deliver(1300);
+    EXPECT_FALSE(mWifi.active());
+    EXPECT_TRUE(mSerial.active());
+    EXPECT_TRUE(statsOf("serial").primary);
+    EXPECT_EQ(0u, statsOf("wifi").promotions);
+}
+
+TEST_F(ReaderArbiterTest, CandidateThatNeverDeliversIsDropped) {
+    serialStream(1000, 2);
+    ASSERT_TRUE(waitFor([&] { return mWifi.active(); }, 1000));
+    ASSERT_TRUE(waitFor([&] { return !mWifi.active(); }, ReaderArbiter::kCandidateTimeoutMs + 500));
+    EXPECT_TRUE(mSerial.active());
+    EXPECT_TRUE(statsOf("serial").primary);
+
+    // Com o primário ainda quieto, tenta de novo depois de um prazo
+    ASSERT_TRUE(waitFor([&] { return mWifi.activations() == 2; }, ReaderArbiter::kCandidateTimeoutMs + 500));
+}
+
+TEST_F(ReaderArbiterTest, ReactivationProbesThePreferredLink) {
+    serialStream(1000, 2);
+    ASSERT_TRUE(waitFor([&] { return mWifi.active(); }, 1000));
+    mWifi.deliver(1200);
+    ASSERT_TRUE(statsOf("wifi").primary);
+
+    // Religado com o Wi-Fi como primário: a serial é sondada na hora, sem
+    // esperar o Wi-Fi ficar quieto (kCandidateTimeoutMs sem a primeira amostra)
+    mArbiter.setPollingActive(false);
+    mArbiter.setPollingActive(true);
+    EXPECT_TRUE(mWifi.active());
+    ASSERT_TRUE(waitFor([&] { return mSerial.active(); }, 200));
+
+    mSerial.deliver(1300);
+    EXPECT_FALSE(mWifi.active());
+    ReaderArbiter::SourceStats serial = statsOf("serial");
+    EXPECT_TRUE(serial.primary);
+    EXPECT_EQ(1u, serial.promotions);
+    EXPECT_EQ("serial", mCollector.readings().back().source);
+}
+
+TEST_F(ReaderArbiterTest, DedupsByTimestampWithoutStationMillis) {
+    mSerial.deliver(-1, 1000 * kMsNs);
+    ASSERT_TRUE(waitFor([&] { return mWifi.active(); }, 1000));
+
+    // Sem "ms" (firmware antigo): a menos de meio período é a mesma medição
+    mWifi.deliver(-1, 1000 * kMsNs + kPeriodMs * kMsNs / 4);
+    mWifi.deliver(-1, 1000 * kMsNs + kPeriodMs * kMsNs);
+
+    std::vector<AirData> readings = mCollector.readings();
+    ASSERT_EQ(2u, readings.size());
+    EXPECT_EQ(1000 * kMsNs + kPeriodMs * kMsNs, readings.back().timestamp);
+    EXPECT_EQ(1u, statsOf("wifi").duplicates);
+}
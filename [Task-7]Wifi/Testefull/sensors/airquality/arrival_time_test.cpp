@@ -0,0 +1,224 @@
+// Testes do carimbo de tempo das amostras: chegada do primeiro byte no
+// LineFramer e no BinaryFrameDecoder, conversão do millis() da estação pelo
+// DeviceClock e o SerialReader de ponta a ponta contra o ESP32 falso.
+
+#include "fake_station.h"
+#include "io/DeviceClock.h"
+#include "io/LineFramer.h"
+#include "io/SerialReader.h"
+#include "utils/BinaryFrame.h"
+
+#include <gtest/gtest.h>
+
+#include <utils/SystemClock.h>
+
+#include <atomic>
+#include <fcntl.h>
+#include <pty.h>
+#include <unistd.h>
+
+namespace {
+
+const int64_t kMs = 1000000;
+
+}  // namespace
+
+TEST(ArrivalTimeTest, LineCarriesFirstByteArrival) {
+    LineFramer<256> framer;
+    std::string_view line;
+    int64_t arrivalNs = -1;
+
+    // Linha partida em dois reads: vale o primeiro
+    framer.feed("{\"a\":", 5, 100);
+    EXPECT_FALSE(framer.nextLine(&line, &arrivalNs));
+    const char kRest[] = "1}\n{\"b\":2}\n{\"c\":";
+    framer.feed(kRest, sizeof(kRest) - 1, 200);
+
+    ASSERT_TRUE(framer.nextLine(&line, &arrivalNs));
+    EXPECT_EQ("{\"a\":1}", line);
+    EXPECT_EQ(100, arrivalNs);
+    ASSERT_TRUE(framer.nextLine(&line, &arrivalNs));
+    EXPECT_EQ("{\"b\":2}", line);
+    EXPECT_EQ(200, arrivalNs);
+    EXPECT_FALSE(framer.nextLine(&line, &arrivalNs));
+
+    // A linha parcial mantém o carimbo do read em que começou
+    framer.feed("3}\n", 3, 300);
+    ASSERT_TRUE(framer.nextLine(&line, &arrivalNs));
+    EXPECT_EQ("{\"c\":3}", line);
+    EXPECT_EQ(200, arrivalNs);
+    EXPECT_FALSE(framer.nextLine(&line, &arrivalNs));
+
+    // takePending entrega o carimbo junto com os bytes
+    framer.feed("xy", 2, 400);
+    framer.feed("z", 1, 500);
+    EXPECT_FALSE(framer.nextLine(&line, &arrivalNs));
+    int64_t pendingNs = -1;
+    EXPECT_EQ("xyz", framer.takePending(&pendingNs));
+    EXPECT_EQ(400, pendingNs);
+}
+
+TEST(ArrivalTimeTest, FrameCarriesFirstByteArrival) {
+    AirData reading;
+    reading.pm25 = 12.5f;
+    reading.source = "serial";
+    uint8_t frames[2][BinaryFrame::kFrameSize];
+    BinaryFrame::encode(reading, 1, frames[0]);
+    BinaryFrame::encode(reading, 2, frames[1]);
+    const char* bytes = reinterpret_cast<const char*>(frames);
+
+    BinaryFrameDecoder decoder;
+    AirData data;
+    std::string_view text;
+    int64_t arrivalNs = -1;
+
+    decoder.feed(bytes, 10, 1000);
+    EXPECT_EQ(BinaryFrameDecoder::kNeedMore, decoder.next(&data, &text, &arrivalNs));
+    decoder.feed(bytes + 10, sizeof(frames) - 10, 2000);
+
+    ASSERT_EQ(BinaryFrameDecoder::kFrame, decoder.next(&data, &text, &arrivalNs));
+    EXPECT_EQ(1000, data.timestamp);
+    EXPECT_EQ(1000, arrivalNs);
+    ASSERT_EQ(BinaryFrameDecoder::kFrame, decoder.next(&data, &text, &arrivalNs));
+    EXPECT_EQ(2000, data.timestamp);
+    EXPECT_EQ(-1, data.deviceMs);  // Quadro sem millis()
+    EXPECT_EQ(BinaryFrameDecoder::kNeedMore, decoder.next(&data, &text, &arrivalNs));
+
+    decoder.feed("ok\n", 3, 3000);
+    ASSERT_EQ(BinaryFrameDecoder::kText, decoder.next(&data, &text, &arrivalNs));
+    EXPECT_EQ("ok\n", text);
+    EXPECT_EQ(3000, arrivalNs);
+}
+
+TEST(ArrivalTimeTest, FrameCarriesDeviceMillis) {
+    AirData reading;
+    reading.pm25 = 12.5f;
+    reading.deviceMs = 4000000123LL;  // Perto do estouro do uint32
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(reading, 1, frame);
+
+    BinaryFrameDecoder decoder;
+    AirData data;
+    std::string_view text;
+    decoder.feed(reinterpret_cast<const char*>(frame), sizeof(frame), 1000);
+    ASSERT_EQ(BinaryFrameDecoder::kFrame, decoder.next(&data, &text));
+    EXPECT_EQ(4000000123LL, data.deviceMs);
+    EXPECT_EQ(1000, data.timestamp);  // O decoder só carimba a chegada
+}
+
+TEST(ArrivalTimeTest, DeviceClockRemovesTransportJitter) {
+    DeviceClock clock;
+    EXPECT_FALSE(clock.synced());
+
+    // Amostras a cada 100 ms na estação; o fio atrasa de 2 a 40 ms
+    const int64_t kBaseNs = 5000 * kMs;
+    const int64_t kDelaysMs[] = {40, 2, 25, 7, 33, 2, 18, 9};
+    int64_t lastNs = 0;
+    for (int i = 0; i < 8; i++) {
+        int64_t deviceMs = 1000 + 100 * i;
+        int64_t arrivalNs = kBaseNs + deviceMs * kMs + kDelaysMs[i] * kMs;
+        int64_t localNs = clock.toLocalNs(deviceMs, arrivalNs);
+
+        EXPECT_LE(localNs, arrivalNs);
+        EXPECT_GE(localNs, lastNs);
+        lastNs = localNs;
+        // Depois da amostra com 2 ms de atraso o offset fica no mínimo real
+        if (i >= 1) {
+            EXPECT_EQ(kBaseNs + (deviceMs + 2) * kMs, localNs) << "amostra " << i;
+        }
+    }
+    EXPECT_TRUE(clock.synced());
+    EXPECT_EQ(kBaseNs + 2 * kMs, clock.offsetNs());
+}
+
+TEST(ArrivalTimeTest, DeviceClockRestartsWhenMillisGoesBack) {
+    DeviceClock clock;
+    EXPECT_EQ(100 * kMs, clock.toLocalNs(50, 100 * kMs));
+    EXPECT_EQ(150 * kMs, clock.toLocalNs(100, 160 * kMs));
+
+    // Reboot: millis() recomeça, o offset antigo não vale mais
+    EXPECT_EQ(300 * kMs, clock.toLocalNs(5, 300 * kMs));
+    EXPECT_EQ(300 * kMs - 5 * kMs + 105 * kMs, clock.toLocalNs(105, 420 * kMs));
+
+    // Sem "ms" (ou inválido) fica a chegada
+    EXPECT_EQ(500 * kMs, clock.toLocalNs(-1, 500 * kMs));
+}
+
+namespace {
+
+class SerialArrivalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char name[128];
+        ASSERT_EQ(0, openpty(&mMaster, &mSlave, name, nullptr, nullptr));
+        fcntl(mMaster, F_SETFL, fcntl(mMaster, F_GETFL) | O_NONBLOCK);
+        mSlaveName = name;
+    }
+
+    void TearDown() override {
+        close(mMaster);
+        close(mSlave);
+    }
+
+    int mMaster = -1;
+    int mSlave = -1;
+    std::string mSlaveName;
+};
+
+}  // namespace
+
+TEST_F(SerialArrivalTest, JsonStreamIsStampedAtTheStation) {
+    FakeStation station(mMaster, {false, true});  // JSON com "ms", em stream
+    std::atomic<int64_t> sentNs[256];
+    for (auto& ns : sentNs) ns = 0;
+    station.setSampleHook([&](uint16_t seq) { sentNs[seq % 256] = android::elapsedRealtimeNano(); });
+
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(100 * kMs);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 12; }, &station, 5000));
+    reader.stop();
+
+    int64_t lastNs = 0;
+    for (const AirData& data : listener.readings()) {
+        ASSERT_GE(data.deviceMs, 0);
+        int64_t sent = sentNs[static_cast<int>(data.pm25) % 256];
+        // millis() trunca para ms; o carimbo cai entre a escrita e a chegada
+        EXPECT_GE(data.timestamp, sent - 2 * kMs);
+        EXPECT_LE(data.timestamp, android::elapsedRealtimeNano());
+        EXPECT_GE(data.timestamp, lastNs);
+        lastNs = data.timestamp;
+    }
+}
+
+TEST_F(SerialArrivalTest, BinaryStreamIsStampedAtTheStation) {
+    FakeStation station(mMaster, {true, true});  // Quadros v2, em stream
+    std::atomic<int64_t> sentNs[256];
+    for (auto& ns : sentNs) ns = 0;
+    station.setSampleHook([&](uint16_t seq) { sentNs[seq % 256] = android::elapsedRealtimeNano(); });
+
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(100 * kMs);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 12; }, &station, 5000));
+    reader.stop();
+    EXPECT_TRUE(station.binary());
+
+    int64_t lastNs = 0;
+    for (const AirData& data : listener.readings()) {
+        ASSERT_GE(data.deviceMs, 0);
+        int64_t sent = sentNs[static_cast<int>(data.pm25) % 256];
+        EXPECT_GE(data.timestamp, sent - 2 * kMs);
+        EXPECT_LE(data.timestamp, android::elapsedRealtimeNano());
+        EXPECT_GE(data.timestamp, lastNs);
+        lastNs = data.timestamp;
+    }
+}
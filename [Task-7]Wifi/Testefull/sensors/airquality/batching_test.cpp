@@ -0,0 +1,351 @@
+// Testes do batching da SubHAL: FIFO por sensor, decimação pelo samplingPeriod
+// e agrupamento pelo maxReportLatency. Um IHalProxyCallback falso conta as
+// chamadas de postEvents e os wakelocks pedidos ao framework.
+
+#include "AirQualitySubHal.h"
+
+#include <HalProxyCallback.h>
+#include <gtest/gtest.h>
+#include <utils/SystemClock.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+using android::hardware::sensors::V1_0::MetaDataEventType;
+using android::hardware::sensors::V1_0::SensorType;
+using android::hardware::sensors::V2_0::implementation::IScopedWakelockRefCounter;
+using android::hardware::sensors::V2_1::implementation::HalProxyCallbackBase;
+
+namespace {
+
+const int64_t kMsNs = 1000000LL;
+
+class FakeRefCounter : public IScopedWakelockRefCounter {
+public:
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t delta, int64_t* /*timeoutStart*/) override {
+        mAcquired += delta;
+        return true;
+    }
+    void decrementRefCount(size_t /*delta*/) override {}
+
+    size_t acquired() const { return mAcquired; }
+
+private:
+    std::atomic<size_t> mAcquired{0};
+};
+
+// Só o ScopedWakelock precisa do HalProxyCallbackBase (construtor privado)
+class FakeProxyCallback : public IHalProxyCallback {
+public:
+    FakeProxyCallback() : mBase(nullptr, &mRefCounter, 0) {}
+
+    Return<void> onDynamicSensorsConnected(const hidl_vec<SensorInfo>&) override { return Void(); }
+    Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>&) override { return Void(); }
+
+    ScopedWakelock createScopedWakelock(bool lock) override {
+        return mBase.createScopedWakelock(lock);
+    }
+
+    void postEvents(const std::vector<Event>& events, ScopedWakelock /*wakelock*/) override {
+        std::unique_lock<std::mutex> lock(mLock);
+        mPosts.push_back(events);
+        // Framework lento: o binder só volta quando o teste soltar
+        mBlocked = mHold;
+        mHoldCv.wait(lock, [&] { return !mHold; });
+        mBlocked = false;
+    }
+
+    void hold(bool enabled) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mHold = enabled;
+        }
+        mHoldCv.notify_all();
+    }
+
+    bool blocked() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mBlocked;
+    }
+
+    size_t postCount() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mPosts.size();
+    }
+
+    std::vector<std::vector<Event>> posts() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mPosts;
+    }
+
+    size_t wakelocks() const { return mRefCounter.acquired(); }
+
+private:
+    FakeRefCounter mRefCounter;
+    HalProxyCallbackBase mBase;
+    std::mutex mLock;
+    std::condition_variable mHoldCv;
+    bool mHold = false;
+    bool mBlocked = false;
+    std::vector<std::vector<Event>> mPosts;
+};
+
+AirData sample(int64_t timestamp, float value) {
+    AirData data;
+    data.timestamp = timestamp;
+    data.co_ppm = value;
+    data.temp_c = 25.0f + value;  // Muda junto: a temperatura é on-change
+    data.source = "serial";
+    data.valid = true;
+    return data;
+}
+
+class BatchingTest : public ::testing::Test {
+protected:
+    // Estação inexistente: só os eventos injetados via onDataReceived chegam
+    BatchingTest() : mSubHal("/dev/airquality-test-missing", "127.0.0.1", 1) {}
+
+    void SetUp() override {
+        mCallback = new FakeProxyCallback();
+        ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.initialize(mCallback)));
+        mCo = handleOf("com.airstation.sensor.co");
+        mTemp = handleOf("android.sensor.ambient_temperature");
+    }
+
+    int32_t handleOf(const char* type) {
+        int32_t handle = -1;
+        mSubHal.getSensorsList([&](const hidl_vec<SensorInfo>& list) {
+            for (const auto& info : list) {
+                if (std::string(info.typeAsString) == type) handle = info.sensorHandle;
+            }
+        });
+        return handle;
+    }
+
+    bool waitForPosts(size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (mCallback->postCount() < count) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return true;
+    }
+
+    void enable(int32_t handle, int64_t periodNs, int64_t latencyNs) {
+        ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.batch(handle, periodNs, latencyNs)));
+        ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.activate(handle, true)));
+    }
+
+    AirQualitySubHal mSubHal;
+    sp<FakeProxyCallback> mCallback;
+    int32_t mCo = -1;
+    int32_t mTemp = -1;
+};
+
+}  // namespace
+
+TEST_F(BatchingTest, AdvertisesFifo) {
+    mSubHal.getSensorsList([](const hidl_vec<SensorInfo>& list) {
+        ASSERT_GT(list.size(), 0u);
+        for (const auto& info : list) {
+            EXPECT_EQ(AirQualitySensor::kFifoCapacity, info.fifoMaxEventCount);
+            EXPECT_EQ(AirQualitySensor::kFifoCapacity, info.fifoReservedEventCount);
+        }
+    });
+}
+
+TEST_F(BatchingTest, WithoutLatencyPostsEverySample) {
+    enable(mCo, 100 * kMsNs, 0);
+
+    int64_t base = android::elapsedRealtimeNano();
+    for (int i = 0; i < 5; i++) mSubHal.onDataReceived(sample(base + i * 100 * kMsNs, i));
+
+    EXPECT_EQ(5u, mCallback->postCount());
+    EXPECT_EQ(0u, mCallback->wakelocks());  // Sensores não são wake-up
+}
+
+TEST_F(BatchingTest, DecimatesToSamplingPeriod) {
+    enable(mCo, 500 * kMsNs, 0);   // Pede 2Hz...
+    enable(mTemp, 100 * kMsNs, 0); // ...a temperatura não passa de 1Hz (minDelay)
+
+    // Leitor a 10Hz por 1,5 s (outro cliente pediu o stream mais rápido)
+    int64_t base = android::elapsedRealtimeNano();
+    for (int i = 0; i < 15; i++) mSubHal.onDataReceived(sample(base + i * 100 * kMsNs, i));
+
+    size_t co = 0, temp = 0;
+    for (const auto& post : mCallback->posts()) {
+        for (const auto& event : post) {
+            if (event.sensorHandle == mCo) co++;
+            if (event.sensorHandle == mTemp) temp++;
+        }
+    }
+    EXPECT_EQ(3u, co);  // 0, 500 e 1000 ms
+    EXPECT_EQ(2u, temp);
+}
+
+TEST_F(BatchingTest, CoalescesWithinReportLatency) {
+    enable(mCo, 100 * kMsNs, 500 * kMsNs);
+
+    int64_t base = android::elapsedRealtimeNano();
+    for (int i = 0; i < 4; i++) mSubHal.onDataReceived(sample(base + i * 100 * kMsNs, i));
+    EXPECT_EQ(0u, mCallback->postCount());  // Tudo na FIFO
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    auto posts = mCallback->posts();
+    ASSERT_EQ(1u, posts.size());
+    ASSERT_EQ(4u, posts[0].size());
+    for (int i = 0; i < 4; i++) EXPECT_EQ(static_cast<float>(i), posts[0][i].u.scalar);
+    EXPECT_EQ(0u, mCallback->wakelocks());
+}
+
+TEST_F(BatchingTest, FullFifoFlushesEarly) {
+    enable(mCo, 100 * kMsNs, 3600 * 1000 * kMsNs);
+
+    int64_t base = android::elapsedRealtimeNano();
+    for (uint32_t i = 0; i < AirQualitySensor::kFifoCapacity + 10; i++) {
+        mSubHal.onDataReceived(sample(base + i * 100 * kMsNs, i));
+    }
+
+    auto posts = mCallback->posts();
+    ASSERT_EQ(1u, posts.size());
+    EXPECT_EQ(AirQualitySensor::kFifoCapacity, posts[0].size());
+    EXPECT_EQ(0.0f, posts[0].front().u.scalar);  // Nada perdido
+}
+
+TEST_F(BatchingTest, FlushDrainsBeforeFlushComplete) {
+    enable(mCo, 100 * kMsNs, 10000 * kMsNs);
+
+    int64_t base = android::elapsedRealtimeNano();
+    for (int i = 0; i < 3; i++) mSubHal.onDataReceived(sample(base + i * 100 * kMsNs, i));
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.flush(mCo)));
+    EXPECT_EQ(Result::BAD_VALUE, static_cast<Result>(mSubHal.flush(-1)));
+
+    // Entregue pela flushThread (ou pela próxima amostra)
+    ASSERT_TRUE(waitForPosts(1));
+    auto posts = mCallback->posts();
+    ASSERT_EQ(1u, posts.size());
+    ASSERT_EQ(4u, posts[0].size());
+    EXPECT_EQ(SensorType::META_DATA, posts[0][3].sensorType);
+    EXPECT_EQ(MetaDataEventType::META_DATA_FLUSH_COMPLETE, posts[0][3].u.meta.what);
+    EXPECT_EQ(mCo, posts[0][3].sensorHandle);
+}
+
+TEST_F(BatchingTest, FlushCompletesMergeWithData) {
+    int32_t pm25 = handleOf("com.airstation.sensor.pm25");
+    enable(mCo, 100 * kMsNs, 10000 * kMsNs);
+    enable(pm25, 1000 * kMsNs, 10000 * kMsNs);
+
+    int64_t base = android::elapsedRealtimeNano();
+    AirData data = sample(base, 1.0f);
+    data.pm25 = 7.0f;
+    mSubHal.onDataReceived(data);
+    mSubHal.flush(mCo);
+    mSubHal.flush(pm25);
+    ASSERT_TRUE(waitForPosts(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Dados de cada sensor seguidos do seu FLUSH_COMPLETE, em no máximo um post por flush
+    std::vector<Event> all;
+    auto posts = mCallback->posts();
+    EXPECT_LE(posts.size(), 2u);
+    for (const auto& post : posts) all.insert(all.end(), post.begin(), post.end());
+    ASSERT_EQ(4u, all.size());
+    EXPECT_EQ(mCo, all[0].sensorHandle);
+    EXPECT_EQ(SensorType::META_DATA, all[1].sensorType);
+    EXPECT_EQ(mCo, all[1].sensorHandle);
+    EXPECT_EQ(pm25, all[2].sensorHandle);
+    EXPECT_EQ(SensorType::META_DATA, all[3].sensorType);
+    EXPECT_EQ(pm25, all[3].sensorHandle);
+}
+
+TEST_F(BatchingTest, SlowFrameworkDoesNotBlockControl) {
+    enable(mCo, 100 * kMsNs, 0);
+    mCallback->hold(true);
+
+    int64_t base = android::elapsedRealtimeNano();
+    std::thread dispatch([&] { mSubHal.onDataReceived(sample(base, 1.0f)); });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!mCallback->blocked() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(mCallback->blocked());
+
+    // Com o postEvents preso no binder, o framework ainda configura os sensores
+    std::atomic<bool> done{false};
+    std::thread control([&] {
+        enable(mTemp, 100 * kMsNs, 0);
+        mSubHal.flush(mCo);
+        done = true;
+    });
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(mCallback->blocked());
+
+    mCallback->hold(false);
+    control.join();
+    dispatch.join();
+
+    // A ordem segue a das amostras: o FLUSH_COMPLETE vem depois do lote preso
+    ASSERT_TRUE(waitForPosts(2));
+    auto posts = mCallback->posts();
+    ASSERT_EQ(2u, posts.size());
+    EXPECT_EQ(mCo, posts[0][0].sensorHandle);
+    EXPECT_EQ(SensorType::META_DATA, posts[1].back().sensorType);
+    EXPECT_EQ(mCo, posts[1].back().sensorHandle);
+}
+
+TEST_F(BatchingTest, SteadyStateDoesNotAllocate) {
+    for (int32_t handle : {mCo, mTemp}) enable(handle, 100 * kMsNs, 0);
+
+    int64_t base = android::elapsedRealtimeNano();
+    mSubHal.onDataReceived(sample(base, 0));
+    uint64_t allocations = mSubHal.counters().allocations;
+    for (int i = 1; i <= 1000; i++) mSubHal.onDataReceived(sample(base + i * 1000 * kMsNs, i));
+
+    EXPECT_EQ(allocations, mSubHal.counters().allocations);
+    EXPECT_EQ(1001u, mSubHal.counters().posts);
+    EXPECT_EQ(2002u, mSubHal.counters().events);
+    EXPECT_EQ(0u, mSubHal.counters().wakelocks);
+    EXPECT_EQ(0u, mCallback->wakelocks());
+}
+
+TEST_F(BatchingTest, UnchangedReadingsStayInTheHal) {
+    int32_t source = handleOf("com.airstation.sensor.source");
+    for (int32_t handle : {mTemp, source}) enable(handle, 1000 * kMsNs, 0);
+
+    // Temperatura do DHT a 1Hz: repetida, abaixo da resolução, e mudando de fato
+    const float temps[] = {25.0f, 25.0f, 25.04f, 25.1f, 25.1f, 25.1f, 25.2f, 25.2f};
+    int64_t base = android::elapsedRealtimeNano();
+    for (size_t i = 0; i < sizeof(temps) / sizeof(temps[0]); i++) {
+        AirData data = sample(base + i * 1000 * kMsNs, 0);
+        data.temp_c = temps[i];
+        if (i >= 5) data.source = "wifi";  // Troca de enlace
+        mSubHal.onDataReceived(data);
+    }
+
+    std::vector<float> temp, sources;
+    for (const auto& post : mCallback->posts()) {
+        for (const auto& event : post) {
+            if (event.sensorHandle == mTemp) temp.push_back(event.u.scalar);
+            if (event.sensorHandle == source) sources.push_back(event.u.scalar);
+        }
+    }
+    EXPECT_EQ((std::vector<float>{25.0f, 25.1f, 25.2f}), temp);
+    EXPECT_EQ((std::vector<float>{0.0f, 1.0f}), sources);
+    // Amostras sem nada novo não chegam ao framework
+    EXPECT_EQ(4u, mCallback->postCount());
+
+    // Religado, o valor atual sai de novo mesmo sem mudar
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.activate(mTemp, false)));
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal.activate(mTemp, true)));
+    AirData data = sample(base + 10 * 1000 * kMsNs, 0);
+    data.temp_c = 25.2f;
+    data.source = "wifi";
+    mSubHal.onDataReceived(data);
+    EXPECT_EQ(5u, mCallback->postCount());
+}
@@ -0,0 +1,346 @@
+// Testes do protocolo binário (utils/BinaryFrame.h): CRC igual ao do firmware,
+// ida e volta do quadro, separação texto/quadro no decoder e a negociação
+// "SET FORMAT BIN" do SerialReader contra um PTY fazendo o papel do ESP32.
+
+#include "fake_station.h"
+#include "io/SerialReader.h"
+#include "utils/BinaryFrame.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+
+// Mesma implementação bit a bit do firmware_oficial.ino
+uint16_t firmwareCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i] << 8);
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                 : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+AirData fullReading() {
+    AirData data;
+    data.pm25 = 12.3f;
+    data.pm10 = 18.5f;
+    data.co_ppm = 812.0f;
+    data.lpg_ppm = 1456.0f;
+    data.temp_c = -1.5f;
+    data.humid_p = 60.2f;
+    data.source = "serial";
+    return data;
+}
+
+std::string frameBytes(const AirData& data, uint16_t seq) {
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(data, seq, frame);
+    return std::string(reinterpret_cast<const char*>(frame), sizeof(frame));
+}
+
+// Quadro da versão 1 (firmware antigo): o mesmo até o byte 31, CRC em [32-33]
+std::string frameBytesV1(const AirData& data, uint16_t seq) {
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(data, seq, frame);
+    frame[2] = BinaryFrame::kVersionV1;
+    frame[6] &= static_cast<uint8_t>(~BinaryFrame::kHasDeviceMs);
+    uint16_t crc = firmwareCrc16(frame + 2, 30);
+    frame[32] = static_cast<uint8_t>(crc & 0xFF);
+    frame[33] = static_cast<uint8_t>(crc >> 8);
+    return std::string(reinterpret_cast<const char*>(frame), BinaryFrame::kFrameSizeV1);
+}
+
+// Alimenta o decoder em pedaços de `chunk` bytes e coleta quadros e linhas de texto
+struct Collected {
+    std::vector<AirData> frames;
+    std::string text;
+};
+
+Collected decodeInChunks(const std::string& stream, size_t chunk, BinaryFrameDecoder* decoder) {
+    Collected out;
+    for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+        size_t len = std::min(chunk, stream.size() - pos);
+        EXPECT_EQ(len, decoder->feed(stream.data() + pos, len));
+
+        AirData data;
+        std::string_view text;
+        BinaryFrameDecoder::Result result;
+        while ((result = decoder->next(&data, &text)) != BinaryFrameDecoder::kNeedMore) {
+            if (result == BinaryFrameDecoder::kFrame) {
+                out.frames.push_back(data);
+            } else {
+                out.text.append(text);
+            }
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST(BinaryFrameTest, Crc16MatchesFirmware) {
+    const char* check = "123456789";
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(check);
+    EXPECT_EQ(0x29B1, BinaryFrame::crc16(bytes, 9));  // valor de verificação do CCITT-FALSE
+
+    uint8_t noise[256];
+    for (size_t i = 0; i < sizeof(noise); i++) noise[i] = static_cast<uint8_t>(i * 37 + 11);
+    for (size_t len = 0; len <= sizeof(noise); len += 17) {
+        EXPECT_EQ(firmwareCrc16(noise, len), BinaryFrame::crc16(noise, len)) << "len " << len;
+    }
+}
+
+TEST(BinaryFrameTest, RoundTrip) {
+    AirData sent = fullReading();
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(sent, 0xBEEF, frame);
+
+    AirData got;
+    uint16_t seq = 0;
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    EXPECT_EQ(0xBEEF, seq);
+    EXPECT_TRUE(got.valid);
+    EXPECT_EQ(sent.pm25, got.pm25);
+    EXPECT_EQ(sent.pm10, got.pm10);
+    EXPECT_EQ(sent.co_ppm, got.co_ppm);
+    EXPECT_EQ(sent.lpg_ppm, got.lpg_ppm);
+    EXPECT_EQ(sent.temp_c, got.temp_c);
+    EXPECT_EQ(sent.humid_p, got.humid_p);
+    EXPECT_EQ("serial", got.source);
+}
+
+TEST(BinaryFrameTest, CarriesDeviceMillis) {
+    AirData sent = fullReading();
+    sent.deviceMs = 123456;
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(sent, 1, frame);
+    EXPECT_EQ(BinaryFrame::kVersion, frame[2]);
+    EXPECT_TRUE(frame[6] & BinaryFrame::kHasDeviceMs);
+
+    AirData got;
+    uint16_t seq;
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    EXPECT_EQ(123456, got.deviceMs);
+    EXPECT_EQ(sent.pm25, got.pm25);
+
+    // Sem millis() (ou fora do uint32 do ESP32) o bit fica desligado
+    sent.deviceMs = -1;
+    BinaryFrame::encode(sent, 2, frame);
+    EXPECT_FALSE(frame[6] & BinaryFrame::kHasDeviceMs);
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    EXPECT_EQ(-1, got.deviceMs);
+}
+
+TEST(BinaryFrameTest, DecodesVersion1) {
+    AirData sent = fullReading();
+    sent.deviceMs = 99;  // Não cabe no v1
+    std::string frame = frameBytesV1(sent, 0x1234);
+    ASSERT_EQ(BinaryFrame::kFrameSizeV1, frame.size());
+
+    AirData got;
+    uint16_t seq = 0;
+    ASSERT_TRUE(BinaryFrame::decode(reinterpret_cast<const uint8_t*>(frame.data()), &got, &seq));
+    EXPECT_EQ(0x1234, seq);
+    EXPECT_EQ(sent.pm25, got.pm25);
+    EXPECT_EQ(sent.humid_p, got.humid_p);
+    EXPECT_EQ(-1, got.deviceMs);
+}
+
+TEST(BinaryFrameTest, MissingFieldsKeepDefaults) {
+    // Equivalente a "GET DATA MQ7" vindo do Wi-Fi
+    AirData sent;
+    sent.co_ppm = 18.0f;
+    sent.source = "wifi";
+
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(sent, 1, frame);
+
+    AirData got;
+    uint16_t seq;
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    AirData empty;
+    EXPECT_EQ(18.0f, got.co_ppm);
+    EXPECT_EQ(empty.pm25, got.pm25);
+    EXPECT_EQ(empty.temp_c, got.temp_c);
+    EXPECT_EQ("wifi", got.source);
+}
+
+TEST(BinaryFrameTest, RawCountsUseThePpmSlots) {
+    // Firmware oficial: contagens do ADC no lugar do ppm, marcadas no byte [7]
+    AirData sent;
+    sent.mq2_raw = 1234.0f;
+    sent.mq7_raw = 567.0f;
+    sent.temp_c = 25.0f;
+
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(sent, 2, frame);
+    EXPECT_EQ(BinaryFrame::kRawMq2 | BinaryFrame::kRawMq7, frame[7]);
+
+    AirData got;
+    uint16_t seq;
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    AirData empty;
+    EXPECT_EQ(1234.0f, got.mq2_raw);
+    EXPECT_EQ(567.0f, got.mq7_raw);
+    EXPECT_EQ(empty.lpg_ppm, got.lpg_ppm);
+    EXPECT_EQ(empty.co_ppm, got.co_ppm);
+    EXPECT_EQ(25.0f, got.temp_c);
+
+    // O ppm pronto tem prioridade sobre a contagem crua
+    sent.co_ppm = 3.5f;
+    BinaryFrame::encode(sent, 3, frame);
+    EXPECT_EQ(BinaryFrame::kRawMq2, frame[7]);
+    ASSERT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+    EXPECT_EQ(3.5f, got.co_ppm);
+    EXPECT_EQ(empty.mq7_raw, got.mq7_raw);
+}
+
+TEST(BinaryFrameTest, RejectsCorruption) {
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(fullReading(), 7, frame);
+
+    AirData got;
+    uint16_t seq;
+    for (size_t byte = 0; byte < sizeof(frame); byte++) {
+        for (int bit = 0; bit < 8; bit++) {
+            frame[byte] ^= static_cast<uint8_t>(1 << bit);
+            EXPECT_FALSE(BinaryFrame::decode(frame, &got, &seq)) << "byte " << byte << " bit " << bit;
+            frame[byte] ^= static_cast<uint8_t>(1 << bit);
+        }
+    }
+    EXPECT_TRUE(BinaryFrame::decode(frame, &got, &seq));
+}
+
+TEST(BinaryFrameDecoderTest, SplitsTextAndFramesAtAnyChunkSize) {
+    const std::string ack = "{\"type\":\"ack\",\"cmd\":\"set_format\",\"format\":\"bin\"}\r\n";
+    const std::string boot = "{\"type\":\"boot\",\"device\":\"AIR_STATION_REAL\"}\r\n";
+    std::string stream = ack;
+    for (uint16_t seq = 0; seq < 40; seq++) {
+        AirData data = fullReading();
+        data.pm25 = seq;
+        stream += frameBytes(data, seq);
+        if (seq == 20) stream += boot;
+    }
+
+    for (size_t chunk : {1u, 2u, 7u, 37u, 38u, 39u, 500u, 1000u}) {
+        BinaryFrameDecoder decoder;
+        Collected got = decodeInChunks(stream, chunk, &decoder);
+        ASSERT_EQ(40u, got.frames.size()) << "chunk " << chunk;
+        for (size_t i = 0; i < got.frames.size(); i++) EXPECT_EQ(static_cast<float>(i), got.frames[i].pm25);
+        EXPECT_EQ(ack + boot, got.text) << "chunk " << chunk;
+        EXPECT_EQ(0u, decoder.badFrameCount());
+        EXPECT_EQ(0u, decoder.lostFrameCount());
+    }
+}
+
+TEST(BinaryFrameDecoderTest, MixesFrameVersions) {
+    // Estação trocada a quente por uma com firmware antigo
+    std::string stream;
+    for (uint16_t seq = 0; seq < 20; seq++) {
+        AirData data = fullReading();
+        data.pm25 = seq;
+        data.deviceMs = 1000 + seq;
+        stream += seq % 3 ? frameBytes(data, seq) : frameBytesV1(data, seq);
+    }
+
+    for (size_t chunk : {1u, 3u, 34u, 38u, 500u}) {
+        BinaryFrameDecoder decoder;
+        Collected got = decodeInChunks(stream, chunk, &decoder);
+        ASSERT_EQ(20u, got.frames.size()) << "chunk " << chunk;
+        for (size_t i = 0; i < got.frames.size(); i++) {
+            EXPECT_EQ(static_cast<float>(i), got.frames[i].pm25);
+            EXPECT_EQ(i % 3 ? static_cast<int64_t>(1000 + i) : -1, got.frames[i].deviceMs);
+        }
+        EXPECT_TRUE(got.text.empty());
+        EXPECT_EQ(0u, decoder.badFrameCount());
+        EXPECT_EQ(0u, decoder.lostFrameCount());
+    }
+}
+
+TEST(BinaryFrameDecoderTest, ResyncsAfterCorruptionAndCountsGaps) {
+    std::string stream = frameBytes(fullReading(), 1);
+    std::string bad = frameBytes(fullReading(), 2);
+    bad[10] ^= 0x40;
+    stream += bad;
+    stream += frameBytes(fullReading(), 3);
+    stream += frameBytes(fullReading(), 6);  // 4 e 5 nunca chegaram
+
+    BinaryFrameDecoder decoder;
+    Collected got = decodeInChunks(stream, 5, &decoder);
+    EXPECT_EQ(3u, got.frames.size());
+    EXPECT_EQ(1u, decoder.badFrameCount());
+    EXPECT_EQ(3u, decoder.lostFrameCount());  // 2 (corrompido), 4 e 5
+}
+
+// ---- Negociação ponta a ponta com o SerialReader ----
+
+namespace {
+
+class SerialNegotiationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char name[128];
+        ASSERT_EQ(0, openpty(&mMaster, &mSlave, name, nullptr, nullptr));
+        fcntl(mMaster, F_SETFL, fcntl(mMaster, F_GETFL) | O_NONBLOCK);
+        mSlaveName = name;
+    }
+
+    void TearDown() override {
+        close(mMaster);
+        close(mSlave);
+    }
+
+    int mMaster = -1;
+    int mSlave = -1;
+    std::string mSlaveName;
+};
+
+}  // namespace
+
+TEST_F(SerialNegotiationTest, SwitchesToBinaryAndBackAfterReboot) {
+    FakeStation station(mMaster, {true, false});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 2; }, &station, 5000));
+    EXPECT_TRUE(station.binary());
+
+    // Após o reboot o leitor precisa pedir o modo binário de novo
+    station.reboot();
+    size_t before = listener.count();
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= before + 2; }, &station, 5000));
+    EXPECT_TRUE(station.binary());
+
+    reader.stop();
+    for (const AirData& data : listener.readings()) {
+        EXPECT_TRUE(data.valid);
+        EXPECT_EQ("serial", data.source);
+    }
+}
+
+TEST_F(SerialNegotiationTest, OldFirmwareStaysOnJson) {
+    FakeStation station(mMaster, {false, false});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 2; }, &station, 5000));
+    EXPECT_FALSE(station.binary());
+    reader.stop();
+}
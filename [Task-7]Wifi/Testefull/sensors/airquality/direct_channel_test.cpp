@@ -0,0 +1,219 @@
+// Testes do canal direto: um memfd faz o papel do ashmem do cliente e o teste
+// lê o anel de sensors_event_t como um daemon de log leria.
+
+#include "AirQualitySubHal.h"
+#include "sensors/DirectChannel.h"
+
+#include <cutils/native_handle.h>
+#include <gtest/gtest.h>
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using android::hardware::sensors::V1_0::SensorFlagBits;
+using android::hardware::sensors::V1_0::SensorsEventFormatOffset;
+using android::hardware::sensors::V1_0::SharedMemFormat;
+using android::hardware::sensors::V1_0::SharedMemType;
+using android::hardware::sensors::V1_0::SensorType;
+
+namespace {
+
+const size_t kRecordSize = static_cast<size_t>(SensorsEventFormatOffset::TOTAL_LENGTH);
+
+// Registro lido da memória compartilhada
+struct Record {
+    int32_t size;
+    int32_t token;
+    int32_t type;
+    uint32_t counter;
+    int64_t timestamp;
+    float value;
+};
+
+class SharedMemory {
+public:
+    explicit SharedMemory(size_t slots) : mSize(slots * kRecordSize) {
+        mFd = memfd_create("airquality-direct", MFD_CLOEXEC);
+        if (mFd < 0 || ftruncate(mFd, mSize) != 0) abort();
+        mHandle = native_handle_create(1, 0);
+        mHandle->data[0] = mFd;
+        mView = static_cast<uint8_t*>(mmap(nullptr, mSize, PROT_READ, MAP_SHARED, mFd, 0));
+    }
+
+    ~SharedMemory() {
+        munmap(mView, mSize);
+        native_handle_close(mHandle);
+        native_handle_delete(mHandle);
+    }
+
+    SharedMemInfo info(SharedMemType type = SharedMemType::ASHMEM) const {
+        SharedMemInfo mem;
+        mem.type = type;
+        mem.format = SharedMemFormat::SENSORS_EVENT;
+        mem.size = static_cast<uint32_t>(mSize);
+        mem.memoryHandle = mHandle;
+        return mem;
+    }
+
+    Record read(size_t slot) const {
+        const uint8_t* p = mView + slot * kRecordSize;
+        auto at = [p](SensorsEventFormatOffset field) { return p + static_cast<size_t>(field); };
+        Record r;
+        memcpy(&r.size, at(SensorsEventFormatOffset::SIZE_FIELD), sizeof(r.size));
+        memcpy(&r.token, at(SensorsEventFormatOffset::REPORT_TOKEN), sizeof(r.token));
+        memcpy(&r.type, at(SensorsEventFormatOffset::SENSOR_TYPE), sizeof(r.type));
+        r.counter = __atomic_load_n(reinterpret_cast<const uint32_t*>(at(SensorsEventFormatOffset::ATOMIC_COUNTER)),
+                                    __ATOMIC_ACQUIRE);
+        memcpy(&r.timestamp, at(SensorsEventFormatOffset::TIMESTAMP), sizeof(r.timestamp));
+        memcpy(&r.value, at(SensorsEventFormatOffset::DATA), sizeof(r.value));
+        return r;
+    }
+
+    // Fecha o nosso fd como o framework faz depois do registro
+    void closeFd() { native_handle_close(mHandle); mHandle->numFds = 0; }
+
+private:
+    size_t mSize;
+    int mFd;
+    native_handle_t* mHandle;
+    uint8_t* mView;
+};
+
+Event scalarEvent(int32_t handle, int64_t timestamp, float value) {
+    Event event;
+    event.sensorHandle = handle;
+    event.sensorType = SensorType::AMBIENT_TEMPERATURE;
+    event.timestamp = timestamp;
+    event.u.scalar = value;
+    return event;
+}
+
+AirData sample(int64_t timestamp, float co) {
+    AirData data;
+    data.timestamp = timestamp;
+    data.co_ppm = co;
+    data.source = "serial";
+    data.valid = true;
+    return data;
+}
+
+int32_t handleOf(AirQualitySubHal& subHal, const char* type, uint32_t* flags = nullptr) {
+    int32_t handle = -1;
+    subHal.getSensorsList([&](const hidl_vec<SensorInfo>& list) {
+        for (const auto& info : list) {
+            if (std::string(info.typeAsString) != type) continue;
+            handle = info.sensorHandle;
+            if (flags) *flags = info.flags;
+        }
+    });
+    return handle;
+}
+
+}  // namespace
+
+TEST(DirectChannelTest, WritesRingWithCounter) {
+    SharedMemory shm(4);
+    DirectChannel channel(shm.info());
+    ASSERT_TRUE(channel.isValid());
+    shm.closeFd();  // O mapeamento sobrevive ao fd
+
+    for (int i = 0; i < 6; i++) channel.write(scalarEvent(5005, 1000 + i, 20.0f + i));
+
+    // 6 eventos em 4 posições: as duas primeiras foram sobrescritas
+    const uint32_t expected[4] = {5, 6, 3, 4};
+    for (size_t slot = 0; slot < 4; slot++) {
+        Record r = shm.read(slot);
+        EXPECT_EQ(static_cast<int32_t>(kRecordSize), r.size);
+        EXPECT_EQ(5005, r.token);
+        EXPECT_EQ(static_cast<int32_t>(SensorType::AMBIENT_TEMPERATURE), r.type);
+        EXPECT_EQ(expected[slot], r.counter);
+        EXPECT_EQ(1000 + expected[slot] - 1, r.timestamp);
+        EXPECT_EQ(20.0f + expected[slot] - 1, r.value);
+    }
+}
+
+TEST(DirectChannelTest, RejectsBadMemory) {
+    SharedMemory shm(1);
+    SharedMemInfo mem = shm.info();
+    mem.size = kRecordSize - 1;
+    EXPECT_FALSE(DirectChannel(mem).isValid());
+
+    mem = shm.info();
+    mem.format = static_cast<SharedMemFormat>(0);
+    EXPECT_FALSE(DirectChannel(mem).isValid());
+
+    mem = shm.info();
+    mem.memoryHandle = hidl_handle();
+    EXPECT_FALSE(DirectChannel(mem).isValid());
+}
+
+TEST(DirectChannelTest, SubHalReportsWithoutActivate) {
+    AirQualitySubHal subHal("/dev/airquality-test-missing", "127.0.0.1", 1);
+    uint32_t flags = 0;
+    int32_t co = handleOf(subHal, "com.airstation.sensor.co", &flags);
+    EXPECT_TRUE(flags & static_cast<uint32_t>(SensorFlagBits::DIRECT_CHANNEL_ASHMEM));
+    EXPECT_EQ(static_cast<uint32_t>(RateLevel::NORMAL),
+              (flags & static_cast<uint32_t>(SensorFlagBits::MASK_DIRECT_REPORT)) >>
+                  static_cast<uint8_t>(SensorFlagShift::DIRECT_REPORT));
+
+    SharedMemory shm(8);
+    int32_t channelHandle = -1;
+    subHal.registerDirectChannel(shm.info(), [&](Result result, int32_t handle) {
+        ASSERT_EQ(Result::OK, result);
+        channelHandle = handle;
+    });
+    ASSERT_GT(channelHandle, 0);
+
+    int32_t token = 0;
+    subHal.configDirectReport(co, channelHandle, RateLevel::NORMAL, [&](Result result, int32_t t) {
+        EXPECT_EQ(Result::OK, result);
+        token = t;
+    });
+    EXPECT_EQ(co, token);
+
+    // Sem activate(): o postEvents não recebe nada, o canal recebe tudo
+    for (int i = 0; i < 3; i++) subHal.onDataReceived(sample(100 + i, 1.5f * i));
+    for (size_t slot = 0; slot < 3; slot++) {
+        Record r = shm.read(slot);
+        EXPECT_EQ(slot + 1, r.counter);
+        EXPECT_EQ(token, r.token);
+        EXPECT_EQ(1.5f * slot, r.value);
+    }
+    EXPECT_EQ(0u, shm.read(3).counter);
+
+    // STOP geral e desregistro
+    subHal.configDirectReport(-1, channelHandle, RateLevel::STOP,
+                              [](Result result, int32_t) { EXPECT_EQ(Result::OK, result); });
+    subHal.onDataReceived(sample(200, 9.0f));
+    EXPECT_EQ(0u, shm.read(3).counter);
+    EXPECT_EQ(Result::OK, static_cast<Result>(subHal.unregisterDirectChannel(channelHandle)));
+    EXPECT_EQ(Result::BAD_VALUE, static_cast<Result>(subHal.unregisterDirectChannel(channelHandle)));
+}
+
+TEST(DirectChannelTest, SubHalRejectsUnsupportedRequests) {
+    AirQualitySubHal subHal("/dev/airquality-test-missing", "127.0.0.1", 1);
+    SharedMemory shm(2);
+
+    subHal.registerDirectChannel(shm.info(SharedMemType::GRALLOC), [](Result result, int32_t) {
+        EXPECT_EQ(Result::INVALID_OPERATION, result);
+    });
+
+    int32_t channelHandle = -1;
+    subHal.registerDirectChannel(shm.info(), [&](Result, int32_t handle) { channelHandle = handle; });
+    int32_t co = handleOf(subHal, "com.airstation.sensor.co");
+
+    // Acima de NORMAL, sensor desconhecido, canal desconhecido
+    subHal.configDirectReport(co, channelHandle, RateLevel::FAST,
+                              [](Result result, int32_t) { EXPECT_EQ(Result::BAD_VALUE, result); });
+    subHal.configDirectReport(-5, channelHandle, RateLevel::NORMAL,
+                              [](Result result, int32_t) { EXPECT_EQ(Result::BAD_VALUE, result); });
+    subHal.configDirectReport(co, channelHandle + 1, RateLevel::NORMAL,
+                              [](Result result, int32_t) { EXPECT_EQ(Result::BAD_VALUE, result); });
+
+    // Índice on-change: sem canal direto nos flags
+    int32_t aqi = handleOf(subHal, "com.airstation.sensor.aqi.us_epa");
+    ASSERT_GT(aqi, 0);
+    subHal.configDirectReport(aqi, channelHandle, RateLevel::NORMAL,
+                              [](Result result, int32_t) { EXPECT_EQ(Result::BAD_VALUE, result); });
+}
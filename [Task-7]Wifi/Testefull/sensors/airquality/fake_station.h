@@ -0,0 +1,298 @@
+#pragma once
+
+// ESP32 falso para os testes e benchmarks dos leitores: roda no lado master de
+// um PTY e responde os comandos como o NotificationSimulator.ino (GET DATA
+// [alvo], GET STATUS/SETTINGS/METADATA, SET CALIB, STREAM ON/OFF) mais o
+// SET FORMAT BIN do firmware_oficial.
+// Não tem thread própria: quem usa chama serve() em laço (ver waitFor() e o
+// airquality_fake_station).
+
+#include "io/IDataReader.h"
+#include "utils/BinaryFrame.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Guarda tudo o que o leitor entregou
+class CollectingListener : public IAirDataListener {
+public:
+    void onDataReceived(const AirData& data) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mReadings.push_back(data);
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mReadings.size();
+    }
+
+    std::vector<AirData> readings() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mReadings;
+    }
+
+private:
+    std::mutex mLock;
+    std::vector<AirData> mReadings;
+};
+
+class FakeStation {
+public:
+    struct Features {
+        bool binary = true;  // entende "SET FORMAT BIN"
+        bool stream = true;  // entende "STREAM ON/OFF"
+        // Piso do período do STREAM ON (o simulador usa 100 ms; 0 = sem piso)
+        int minStreamPeriodMs = 0;
+        // "device_id" do GET SETTINGS e "device" do boot
+        std::string deviceId = "AIR_STATION_SIMULATOR";
+    };
+
+    // Amostras empurradas por chamada de serve(): limita a rajada de quem
+    // atrasou e dá o ritmo do modo inundação (período 0)
+    static constexpr int kMaxBurst = 64;
+
+    FakeStation(int master, Features features)
+        : mMaster(master), mFeatures(features), mBinary(false), mStreaming(false),
+          mStreamPeriodUs(0), mNextPushUs(0), mStreamTarget("ALL"), mSeq(0), mDataRequests(0),
+          mSamplesSent(0), mWriteStalls(0), mBootUs(nowUs()) {}
+
+    // Processa os comandos pendentes do leitor e, em stream, empurra amostras
+    void serve() {
+        char buf[256];
+        ssize_t n;
+        while ((n = read(mMaster, buf, sizeof(buf))) > 0) mInput.append(buf, n);
+
+        size_t nl;
+        while ((nl = mInput.find('\n')) != std::string::npos) {
+            std::string cmd = mInput.substr(0, nl);
+            mInput.erase(0, nl + 1);
+            handle(normalize(cmd));
+        }
+
+        if (!mStreaming) return;
+        int64_t now = nowUs();
+        for (int burst = 0; burst < kMaxBurst && now >= mNextPushUs; burst++) {
+            sendSample(mStreamTarget);
+            // Atrasado demais (ou primeira amostra): recomeça a grade a partir de agora
+            bool late = mNextPushUs == 0 || now - mNextPushUs > 1000000;
+            mNextPushUs = (late ? now : mNextPushUs) + mStreamPeriodUs;
+        }
+    }
+
+    /**
+     * Liga o stream pelo lado da estação, sem ack e sem o piso do STREAM ON:
+     * serve para medir o leitor a taxas que o firmware não aceita (até
+     * periodUs = 0, que inunda a serial).
+     */
+    void startStream(int64_t periodUs, const std::string& target = "ALL") {
+        mStreaming = true;
+        mStreamPeriodUs = std::max<int64_t>(periodUs, 0);
+        mStreamTarget = target;
+        mNextPushUs = 0;
+    }
+
+    // Chamado com o número de sequência logo antes de cada amostra ir para o
+    // PTY (bancadas de latência)
+    void setSampleHook(std::function<void(uint16_t seq)> hook) { mSampleHook = std::move(hook); }
+
+    // Reset do ESP32: volta ao JSON, sem stream
+    void reboot() {
+        mBinary = false;
+        mStreaming = false;
+        mBootUs = nowUs();
+        writeAll("{\"type\":\"boot\",\"device\":\"" + mFeatures.deviceId + "\"}\r\n");
+    }
+
+    bool binary() const { return mBinary; }
+    bool streaming() const { return mStreaming; }
+    int streamPeriodMs() const { return static_cast<int>(mStreamPeriodUs / 1000); }
+    const std::string& streamTarget() const { return mStreamTarget; }
+    int dataRequests() const { return mDataRequests; }
+    // Alvo de cada GET DATA recebido, em ordem ("ALL" para o pedido sem alvo)
+    const std::vector<std::string>& dataTargets() const { return mDataTargets; }
+    uint64_t samplesSent() const { return mSamplesSent; }
+    // Escritas abandonadas porque o leitor não esvaziou o PTY a tempo
+    uint64_t writeStalls() const { return mWriteStalls; }
+
+private:
+    static int64_t nowUs() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Igual ao processCommand() do simulador: sem espaços nas pontas e em maiúsculas
+    static std::string normalize(std::string cmd) {
+        size_t begin = cmd.find_first_not_of(" \t\r");
+        size_t end = cmd.find_last_not_of(" \t\r");
+        cmd = begin == std::string::npos ? std::string() : cmd.substr(begin, end - begin + 1);
+        for (char& c : cmd) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        return cmd;
+    }
+
+    static std::string lower(std::string s) {
+        for (char& c : s) c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    static bool validTarget(const std::string& target) {
+        return target == "ALL" || target == "SDS011" || target == "MQ2" || target == "MQ7" ||
+               target == "DHT";
+    }
+
+    void handle(const std::string& cmd) {
+        if (cmd == "SET FORMAT BIN" && mFeatures.binary) {
+            mBinary = true;
+            writeAll("{\"type\":\"ack\",\"cmd\":\"set_format\",\"format\":\"bin\"}\r\n");
+        } else if (cmd.rfind("STREAM ON", 0) == 0 && mFeatures.stream) {
+            handleStreamOn(cmd.substr(9));
+        } else if (cmd == "STREAM OFF" && mFeatures.stream) {
+            mStreaming = false;
+            writeAll("{\"type\":\"ack\",\"cmd\":\"stream\",\"status\":\"off\"}\r\n");
+        } else if (cmd == "GET DATA" || cmd == "GET DATA ALL") {
+            mDataRequests++;
+            mDataTargets.push_back("ALL");
+            sendSample("ALL");
+        } else if (cmd.rfind("GET DATA ", 0) == 0 && validTarget(cmd.substr(9))) {
+            mDataRequests++;
+            mDataTargets.push_back(cmd.substr(9));
+            sendSample(cmd.substr(9));
+        } else if (cmd == "GET STATUS") {
+            int64_t uptimeSec = (nowUs() - mBootUs) / 1000000;
+            writeAll("{\"type\":\"status\",\"uptime_sec\":" + std::to_string(uptimeSec) +
+                     ",\"wifi_status\":\"disconnected\",\"sensors\":{\"sds011\":\"ok\","
+                     "\"mq2\":\"ok\",\"mq7\":\"ok\",\"dht11\":\"ok\"}}\r\n");
+        } else if (cmd == "GET SETTINGS") {
+            writeAll("{\"type\":\"settings\",\"device_id\":\"" + mFeatures.deviceId + "\","
+                     "\"wifi\":{\"ssid\":\"AndroidAP_Sim\",\"ip\":\"0.0.0.0\"},"
+                     "\"calib\":{\"sds_factor\":1,\"mq2_ro\":9.8,\"mq7_ro\":15.2,"
+                     "\"temp_offset\":-1,\"hum_offset\":2}}\r\n");
+        } else if (cmd == "GET METADATA") {
+            writeAll("{\"type\":\"metadata\",\"sensors\":[{\"id\":\"pm25\"},{\"id\":\"pm10\"},"
+                     "{\"id\":\"lpg_ppm\"},{\"id\":\"co_ppm\"},{\"id\":\"temp_c\"},"
+                     "{\"id\":\"humid_p\"}]}\r\n");
+        } else if (cmd.rfind("SET CALIB ", 0) == 0) {
+            size_t space = cmd.find(' ', 10);
+            if (space == std::string::npos) return;
+            writeAll("{\"type\":\"ack\",\"cmd\":\"set_calib\",\"target\":\"" +
+                     lower(cmd.substr(10, space - 10)) + "\",\"new_val\":" +
+                     std::to_string(atof(cmd.c_str() + space + 1)) + ",\"status\":\"saved\"}\r\n");
+        }
+    }
+
+    // "STREAM ON [periodo_ms] [alvo]", com o piso configurado
+    void handleStreamOn(const std::string& args) {
+        size_t begin = args.find_first_not_of(' ');
+        std::string rest = begin == std::string::npos ? std::string() : args.substr(begin);
+        size_t space = rest.find(' ');
+        std::string period = rest.substr(0, space);
+        std::string target = space == std::string::npos ? "ALL" : normalize(rest.substr(space + 1));
+        if (!validTarget(target)) return;  // O simulador ignora sem responder
+
+        long periodMs = period.empty() ? 1000 : atol(period.c_str());
+        periodMs = std::max<long>(periodMs, mFeatures.minStreamPeriodMs);
+        startStream(periodMs * 1000, target);
+        writeAll("{\"type\":\"ack\",\"cmd\":\"stream\",\"status\":\"on\",\"period_ms\":" +
+                 std::to_string(periodMs) + ",\"target\":\"" + lower(target) + "\"}\r\n");
+    }
+
+    // pm25 carrega o número de sequência da amostra; o resto é fixo
+    void sendSample(const std::string& target) {
+        bool all = target == "ALL";
+        if (mBinary) {
+            // Como o firmware: só os campos do alvo entram na máscara
+            AirData data;
+            if (all || target == "SDS011") {
+                data.pm25 = static_cast<float>(mSeq);
+                data.pm10 = 18.5f;
+            }
+            if (all || target == "MQ2") data.lpg_ppm = 200.0f;
+            if (all || target == "MQ7") data.co_ppm = 1.02f;
+            if (all || target == "DHT") {
+                data.temp_c = 26.1f;
+                data.humid_p = 60.2f;
+            }
+            data.source = "serial";
+            data.deviceMs = (nowUs() - mBootUs) / 1000;
+            uint8_t frame[BinaryFrame::kFrameSize];
+            BinaryFrame::encode(data, mSeq, frame);
+            if (mSampleHook) mSampleHook(mSeq);
+            writeAll(std::string(reinterpret_cast<const char*>(frame), sizeof(frame)));
+        } else {
+            std::string line = "{\"type\":\"data\",\"src\":\"serial\",";
+            if (!all) line += "\"sensor\":\"" + lower(target) + "\",";
+            line += "\"payload\":{";
+            if (all || target == "SDS011") {
+                line += "\"pm25\":" + std::to_string(mSeq) + ",\"pm10\":18.5,";
+            }
+            if (all || target == "MQ2") line += "\"lpg_ppm\":200,";
+            if (target == "MQ2") line += "\"raw_val\":1450,";
+            if (all || target == "MQ7") line += "\"co_ppm\":1.02,";
+            if (target == "MQ7") line += "\"raw_val\":800,";
+            if (all || target == "DHT") line += "\"temp_c\":26.1,\"humid_p\":60.2,";
+            line.back() = '}';
+            // millis() do firmware: "ms" é o uptime da estação quando mediu
+            line += ",\"ms\":" + std::to_string((nowUs() - mBootUs) / 1000) + "}\r\n";
+            if (mSampleHook) mSampleHook(mSeq);
+            writeAll(line);
+        }
+        mSeq++;
+        mSamplesSent++;
+    }
+
+    // O master é não bloqueante: com o PTY cheio espera um pouco pelo leitor
+    // e, se ele não drenar, abandona o resto (o framer ressincroniza)
+    void writeAll(const std::string& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            ssize_t n = write(mMaster, bytes.data() + done, bytes.size() - done);
+            if (n > 0) {
+                done += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            struct pollfd pfd = { mMaster, POLLOUT, 0 };
+            if (n < 0 && errno == EAGAIN && poll(&pfd, 1, 100) > 0) continue;
+            mWriteStalls++;
+            return;
+        }
+    }
+
+    int mMaster;
+    Features mFeatures;
+    bool mBinary;
+    bool mStreaming;
+    int64_t mStreamPeriodUs;
+    int64_t mNextPushUs;
+    std::string mStreamTarget;
+    uint16_t mSeq;
+    int mDataRequests;
+    std::vector<std::string> mDataTargets;
+    uint64_t mSamplesSent;
+    uint64_t mWriteStalls;
+    int64_t mBootUs;
+    std::function<void(uint16_t)> mSampleHook;
+    std::string mInput;
+};
+
+// Roda a estação até pred() ser verdadeiro ou o tempo acabar
+template <typename Pred>
+bool waitFor(Pred pred, FakeStation* station, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (std::chrono::steady_clock::now() < deadline) {
+        station->serve();
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+}
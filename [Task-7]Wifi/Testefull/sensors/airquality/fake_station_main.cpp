@@ -0,0 +1,148 @@
+// Estação falsa num pseudo-terminal, para medir os leitores sem o ESP32.
+// Abre um PTY, imprime o caminho do lado slave (é o que vai no SerialReader)
+// e responde o protocolo do NotificationSimulator.ino (ver fake_station.h).
+//
+// Sem --rate, só responde: GET DATA a pedido e STREAM ON no período pedido
+// pelo leitor (com o piso de 100 ms do simulador). Com --rate a estação já
+// começa em stream na taxa dada, sem piso; "--rate flood" escreve o mais
+// rápido que o PTY aceitar.
+//
+// Uso: airquality_fake_station [--rate HZ|flood] [--target ALL|SDS011|MQ2|MQ7|DHT]
+//                              [--json] [--no-stream] [--min-period MS]
+//                              [--duration S] [--link CAMINHO]
+
+#include "fake_station.h"
+
+#include <chrono>
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t gStop = 0;
+
+static void onSignal(int) {
+    gStop = 1;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Uso: %s [--rate HZ|flood] [--target ALVO] [--json] [--no-stream]\n"
+            "          [--min-period MS] [--duration S] [--link CAMINHO]\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    static const struct option kOptions[] = {
+        {"rate", required_argument, nullptr, 'r'},
+        {"target", required_argument, nullptr, 't'},
+        {"json", no_argument, nullptr, 'j'},
+        {"no-stream", no_argument, nullptr, 's'},
+        {"min-period", required_argument, nullptr, 'm'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"link", required_argument, nullptr, 'l'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    FakeStation::Features features;
+    features.minStreamPeriodMs = 100;  // STREAM_MIN_PERIOD do simulador
+    int64_t pushPeriodUs = -1;         // -1: sem stream próprio
+    std::string target = "ALL";
+    double durationSec = 0;            // 0: até Ctrl+C
+    std::string link;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:t:jsm:d:l:", kOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'r':
+                if (strcmp(optarg, "flood") == 0) {
+                    pushPeriodUs = 0;
+                } else {
+                    double hz = atof(optarg);
+                    if (hz <= 0) {
+                        usage(argv[0]);
+                        return 2;
+                    }
+                    pushPeriodUs = static_cast<int64_t>(1e6 / hz);
+                }
+                break;
+            case 't': target = optarg; break;
+            case 'j': features.binary = false; break;
+            case 's': features.stream = false; break;
+            case 'm': features.minStreamPeriodMs = atoi(optarg); break;
+            case 'd': durationSec = atof(optarg); break;
+            case 'l': link = optarg; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    int master = -1, slave = -1;
+    char slaveName[128];
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) < 0) {
+        fprintf(stderr, "ERRO: openpty falhou: %s\n", strerror(errno));
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    // O slave fica aberto aqui: sem ele o master dá EIO entre um open() e
+    // outro do leitor
+
+    if (!link.empty()) {
+        unlink(link.c_str());
+        if (symlink(slaveName, link.c_str()) < 0) {
+            fprintf(stderr, "ERRO: symlink %s: %s\n", link.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    FakeStation station(master, features);
+    if (pushPeriodUs >= 0) station.startStream(pushPeriodUs, target);
+
+    printf("%s\n", link.empty() ? slaveName : link.c_str());
+    fflush(stdout);
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto lastReport = start;
+    uint64_t lastSent = 0;
+    while (!gStop) {
+        station.serve();
+
+        // Em inundação ou abaixo de 1 ms não dorme; senão acorda com comando
+        // novo ou a cada 1 ms para o próximo push
+        bool busy = station.streaming() && pushPeriodUs >= 0 && pushPeriodUs < 1000;
+        struct pollfd pfd = { master, POLLIN, 0 };
+        poll(&pfd, 1, busy ? 0 : 1);
+
+        auto now = Clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            double dt = std::chrono::duration<double>(now - lastReport).count();
+            fprintf(stderr, "amostras/s: %.0f  pedidos: %d  stream: %s  travadas: %llu\n",
+                    (station.samplesSent() - lastSent) / dt, station.dataRequests(),
+                    station.streaming() ? "on" : "off",
+                    static_cast<unsigned long long>(station.writeStalls()));
+            lastSent = station.samplesSent();
+            lastReport = now;
+        }
+        if (durationSec > 0 && std::chrono::duration<double>(now - start).count() >= durationSec) {
+            break;
+        }
+    }
+
+    if (!link.empty()) unlink(link.c_str());
+    close(slave);
+    close(master);
+    return 0;
+}
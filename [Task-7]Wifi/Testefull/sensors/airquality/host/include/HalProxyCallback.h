@@ -0,0 +1,24 @@
+#pragma once
+
+// HalProxyCallbackBase do multihal reduzido ao createScopedWakelock(): o
+// construtor do ScopedWakelock é privado e só ele pode chamá-lo.
+
+#include <V2_0/SubHal.h>
+namespace android { namespace hardware { namespace sensors { namespace V2_1 { namespace implementation {
+class ISensorsEventCallback {
+public:
+    virtual ~ISensorsEventCallback() {}
+};
+class HalProxyCallbackBase : public VirtualLightRefBase {
+public:
+    HalProxyCallbackBase(ISensorsEventCallback* callback, V2_0::implementation::IScopedWakelockRefCounter* refCounter, int32_t subHalIndex)
+        : mCallback(callback), mRefCounter(refCounter), mSubHalIndex(subHalIndex) {}
+    V2_0::implementation::ScopedWakelock createScopedWakelock(bool lock) {
+        return V2_0::implementation::ScopedWakelock(mRefCounter, lock);
+    }
+private:
+    ISensorsEventCallback* mCallback;
+    V2_0::implementation::IScopedWakelockRefCounter* mRefCounter;
+    int32_t mSubHalIndex;
+};
+}}}}}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Contrato de SubHAL do multihal 2.0 (hardware/interfaces/sensors/common/default/2.X/multihal)
+// para o build CMake: ISensorsSubHal, IHalProxyCallback e ScopedWakelock.
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <android/hardware/sensors/1.0/types.h>
+#include <android/hardware/sensors/2.0/ISensorsCallback.h>
+#define SUB_HAL_2_0_VERSION 1
+namespace android { namespace hardware { namespace sensors { namespace V2_1 { namespace implementation { class HalProxyCallbackBase; } } } } }
+namespace android { namespace hardware { namespace sensors { namespace V2_0 { namespace implementation {
+using V1_0::Event; using V1_0::OperationMode; using V1_0::RateLevel; using V1_0::Result;
+using V1_0::SensorInfo; using V1_0::SharedMemInfo;
+class IScopedWakelockRefCounter : public RefBase {
+public:
+    virtual bool incrementRefCountAndMaybeAcquireWakelock(size_t delta, int64_t* timeoutStart = nullptr) = 0;
+    virtual void decrementRefCount(size_t delta) = 0;
+};
+class ScopedWakelock {
+public:
+    ScopedWakelock(ScopedWakelock&& o) : mRefCounter(o.mRefCounter), mCreatedAtTimeNs(o.mCreatedAtTimeNs), mLocked(o.mLocked) { o.mLocked = false; }
+    ScopedWakelock& operator=(ScopedWakelock&& o) { release(); mRefCounter = o.mRefCounter; mLocked = o.mLocked; o.mLocked = false; return *this; }
+    virtual ~ScopedWakelock() { release(); }
+    bool isLocked() const { return mLocked; }
+private:
+    friend class ::android::hardware::sensors::V2_1::implementation::HalProxyCallbackBase;
+    ScopedWakelock(IScopedWakelockRefCounter* refCounter, bool locked) : mRefCounter(refCounter), mCreatedAtTimeNs(0), mLocked(false) {
+        if (locked) mLocked = mRefCounter->incrementRefCountAndMaybeAcquireWakelock(1, &mCreatedAtTimeNs);
+    }
+    void release() { if (mLocked) { mRefCounter->decrementRefCount(1); mLocked = false; } }
+    ScopedWakelock(const ScopedWakelock&) = delete;
+    ScopedWakelock& operator=(const ScopedWakelock&) = delete;
+    IScopedWakelockRefCounter* mRefCounter;
+    int64_t mCreatedAtTimeNs;
+    bool mLocked;
+};
+class IHalProxyCallback : public ISensorsCallback {
+public:
+    virtual ScopedWakelock createScopedWakelock(bool lock) = 0;
+    virtual void postEvents(const std::vector<Event>& events, ScopedWakelock wakelock) = 0;
+};
+class ISensorsSubHal : public virtual RefBase {
+public:
+    using getSensorsList_cb = std::function<void(const hidl_vec<SensorInfo>&)>;
+    using registerDirectChannel_cb = std::function<void(Result, int32_t)>;
+    using configDirectReport_cb = std::function<void(Result, int32_t)>;
+    virtual ~ISensorsSubHal() = default;
+    virtual Return<void> getSensorsList(getSensorsList_cb _hidl_cb) = 0;
+    virtual Return<Result> setOperationMode(OperationMode mode) = 0;
+    virtual Return<Result> activate(int32_t sensorHandle, bool enabled) = 0;
+    virtual Return<Result> batch(int32_t sensorHandle, int64_t samplingPeriodNs, int64_t maxReportLatencyNs) = 0;
+    virtual Return<Result> flush(int32_t sensorHandle) = 0;
+    virtual Return<Result> injectSensorData(const Event& event) = 0;
+    virtual Return<void> registerDirectChannel(const SharedMemInfo& mem, registerDirectChannel_cb _hidl_cb) = 0;
+    virtual Return<Result> unregisterDirectChannel(int32_t channelHandle) = 0;
+    virtual Return<void> configDirectReport(int32_t sensorHandle, int32_t channelHandle, RateLevel rate, configDirectReport_cb _hidl_cb) = 0;
+    virtual Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& args) = 0;
+    virtual const std::string getName() = 0;
+    virtual Return<Result> initialize(const sp<IHalProxyCallback>& halProxyCallback) = 0;
+};
+}}}}}
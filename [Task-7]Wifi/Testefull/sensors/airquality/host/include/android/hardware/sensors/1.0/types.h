@@ -0,0 +1,69 @@
+#pragma once
+
+// Tipos gerados do android.hardware.sensors@1.0 que a SubHAL usa (build CMake).
+
+#include <stdint.h>
+#include <hidl/HidlSupport.h>
+namespace android { namespace hardware { namespace sensors { namespace V1_0 {
+enum class Result : int32_t { OK = 0, PERMISSION_DENIED = -1, NO_MEMORY = -12, BAD_VALUE = -22, INVALID_OPERATION = -38 };
+enum class OperationMode : int32_t { NORMAL = 0, DATA_INJECTION = 1 };
+enum class SensorType : int32_t {
+    META_DATA = 0, ACCELEROMETER = 1, MAGNETIC_FIELD = 2, ORIENTATION = 3, GYROSCOPE = 4, LIGHT = 5,
+    PRESSURE = 6, TEMPERATURE = 7, PROXIMITY = 8, GRAVITY = 9, LINEAR_ACCELERATION = 10,
+    ROTATION_VECTOR = 11, RELATIVE_HUMIDITY = 12, AMBIENT_TEMPERATURE = 13,
+    ADDITIONAL_INFO = 33, DEVICE_PRIVATE_BASE = 0x10000,
+};
+enum class SensorFlagBits : uint32_t {
+    WAKE_UP = 1, CONTINUOUS_MODE = 0, ON_CHANGE_MODE = 2, ONE_SHOT_MODE = 4, SPECIAL_REPORTING_MODE = 6,
+    DATA_INJECTION = 0x10, DYNAMIC_SENSOR = 0x20, ADDITIONAL_INFO = 0x40,
+    DIRECT_CHANNEL_ASHMEM = 0x400, DIRECT_CHANNEL_GRALLOC = 0x800,
+    MASK_REPORTING_MODE = 0xE, MASK_DIRECT_REPORT = 0x380, MASK_DIRECT_CHANNEL = 0xC00,
+};
+enum class SensorFlagShift : uint8_t { REPORTING_MODE = 1, DATA_INJECTION = 4, DYNAMIC_SENSOR = 5, ADDITIONAL_INFO = 6, DIRECT_REPORT = 7, DIRECT_CHANNEL = 10 };
+enum class MetaDataEventType : uint32_t { META_DATA_FLUSH_COMPLETE = 1 };
+enum class RateLevel : int32_t { STOP = 0, NORMAL = 1, FAST = 2, VERY_FAST = 3 };
+enum class SharedMemType : int32_t { ASHMEM = 1, GRALLOC = 2 };
+enum class SharedMemFormat : int32_t { SENSORS_EVENT = 1 };
+enum class SensorsEventFormatOffset : uint16_t {
+    SIZE_FIELD = 0, REPORT_TOKEN = 4, SENSOR_TYPE = 8, ATOMIC_COUNTER = 12, TIMESTAMP = 16, DATA = 24,
+    RESERVED = 88, TOTAL_LENGTH = 104,
+};
+struct SensorInfo {
+    int32_t sensorHandle = 0;
+    hidl_string name;
+    hidl_string vendor;
+    int32_t version = 0;
+    SensorType type = SensorType::META_DATA;
+    hidl_string typeAsString;
+    float maxRange = 0;
+    float resolution = 0;
+    float power = 0;
+    int32_t minDelay = 0;
+    uint32_t fifoReservedEventCount = 0;
+    uint32_t fifoMaxEventCount = 0;
+    hidl_string requiredPermission;
+    int32_t maxDelay = 0;
+    uint32_t flags = 0;
+};
+struct Vec3 { float x, y, z; uint8_t status; };
+struct MetaData { MetaDataEventType what; };
+union EventPayload {
+    Vec3 vec3;
+    MetaData meta;
+    float scalar;
+    int64_t stepCount;
+    float data[16];
+};
+struct Event {
+    int64_t timestamp = 0;
+    int32_t sensorHandle = 0;
+    SensorType sensorType = SensorType::META_DATA;
+    EventPayload u = {};
+};
+struct SharedMemInfo {
+    SharedMemType type;
+    SharedMemFormat format;
+    uint32_t size;
+    hidl_handle memoryHandle;
+};
+}}}}  // namespace android::hardware::sensors::V1_0
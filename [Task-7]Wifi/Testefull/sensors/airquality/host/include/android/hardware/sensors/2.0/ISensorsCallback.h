@@ -0,0 +1,12 @@
+#pragma once
+
+// Interface gerada do android.hardware.sensors@2.0 (build CMake).
+
+#include <android/hardware/sensors/1.0/types.h>
+namespace android { namespace hardware { namespace sensors { namespace V2_0 {
+class ISensorsCallback : public virtual RefBase {
+public:
+    virtual Return<void> onDynamicSensorsConnected(const hidl_vec<V1_0::SensorInfo>& sensorInfos) = 0;
+    virtual Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>& sensorHandles) = 0;
+};
+}}}}
@@ -0,0 +1,17 @@
+#pragma once
+
+// native_handle da libcutils para o build CMake (canais diretos e testes).
+
+#include <stdlib.h>
+#include <unistd.h>
+typedef struct native_handle { int version; int numFds; int numInts; int data[0]; } native_handle_t;
+static inline native_handle_t* native_handle_create(int numFds, int numInts) {
+    native_handle_t* h = (native_handle_t*)malloc(sizeof(native_handle_t) + sizeof(int) * (numFds + numInts));
+    h->version = sizeof(native_handle_t); h->numFds = numFds; h->numInts = numInts;
+    return h;
+}
+static inline int native_handle_close(const native_handle_t* h) {
+    for (int i = 0; i < h->numFds; i++) close(h->data[i]);
+    return 0;
+}
+static inline int native_handle_delete(native_handle_t* h) { free(h); return 0; }
@@ -0,0 +1,3 @@
+#pragma once
+
+// <hardware/sensors.h> do libhardware_headers: a SubHAL só inclui, não usa nada.
@@ -0,0 +1,68 @@
+#pragma once
+
+// libhidlbase mínima para o build CMake: só o que a SubHAL e os testes usam
+// (hidl_string/vec/handle, Return e Void), sem transporte.
+
+#include <string>
+#include <vector>
+#include <utils/RefBase.h>
+#include <cutils/native_handle.h>
+namespace android {
+namespace hardware {
+class hidl_string {
+public:
+    hidl_string() = default;
+    hidl_string(const char* s) : mStr(s) {}
+    hidl_string(const std::string& s) : mStr(s) {}
+    const char* c_str() const { return mStr.c_str(); }
+    size_t size() const { return mStr.size(); }
+    operator std::string() const { return mStr; }
+    bool operator==(const char* s) const { return mStr == s; }
+private:
+    std::string mStr;
+};
+template <typename T>
+class hidl_vec {
+public:
+    hidl_vec() = default;
+    hidl_vec(const std::vector<T>& v) : mVec(v) {}
+    hidl_vec(std::initializer_list<T> l) : mVec(l) {}
+    size_t size() const { return mVec.size(); }
+    void resize(size_t n) { mVec.resize(n); }
+    T& operator[](size_t i) { return mVec[i]; }
+    const T& operator[](size_t i) const { return mVec[i]; }
+    T* data() { return mVec.data(); }
+    const T* data() const { return mVec.data(); }
+    typename std::vector<T>::const_iterator begin() const { return mVec.begin(); }
+    typename std::vector<T>::const_iterator end() const { return mVec.end(); }
+    operator std::vector<T>() const { return mVec; }
+private:
+    std::vector<T> mVec;
+};
+class hidl_handle {
+public:
+    hidl_handle() : mHandle(nullptr) {}
+    hidl_handle(const native_handle_t* h) : mHandle(h) {}
+    const native_handle_t* getNativeHandle() const { return mHandle; }
+    operator const native_handle_t*() const { return mHandle; }
+private:
+    const native_handle_t* mHandle;
+};
+template <typename T>
+class Return {
+public:
+    Return(T v) : mVal(v) {}
+    bool isOk() const { return true; }
+    operator T() const { return mVal; }
+private:
+    T mVal;
+};
+template <>
+class Return<void> {
+public:
+    Return() = default;
+    bool isOk() const { return true; }
+};
+inline Return<void> Void() { return Return<void>(); }
+}  // namespace hardware
+}  // namespace android
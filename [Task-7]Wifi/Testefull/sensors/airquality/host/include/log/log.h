@@ -0,0 +1,57 @@
+#pragma once
+
+// liblog mínimo para compilar fora do Android (só o build CMake usa
+// host/include). Mesma semântica do <log/log.h>: ALOGV some a menos que o
+// arquivo defina LOG_NDEBUG 0; o resto vai para o stderr com a tag, filtrado
+// pelo nível de ANDROID_LOG_TAGS ("*:w" deixa só avisos e erros), como na
+// liblog de host.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef LOG_TAG
+#define LOG_TAG "airquality"
+#endif
+
+#ifndef LOG_NDEBUG
+#define LOG_NDEBUG 1
+#endif
+
+static inline int airquality_host_log_rank(char prio) {
+    const char* const kLevels = "vdiwefs";
+    const char* p = strchr(kLevels, prio | 0x20);
+    return p ? static_cast<int>(p - kLevels) : 0;
+}
+
+static inline int airquality_host_log_min_rank() {
+    static const int rank = [] {
+        const char* tags = getenv("ANDROID_LOG_TAGS");
+        const char* all = tags ? strstr(tags, "*:") : nullptr;
+        return all ? airquality_host_log_rank(all[2]) : 0;
+    }();
+    return rank;
+}
+
+__attribute__((format(printf, 3, 4)))
+static inline void airquality_host_log(char prio, const char* tag, const char* fmt, ...) {
+    if (airquality_host_log_rank(prio) < airquality_host_log_min_rank()) return;
+    char msg[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    // Uma chamada só: linhas de threads diferentes não se misturam
+    fprintf(stderr, "%c %s: %s\n", prio, tag, msg);
+}
+
+#if LOG_NDEBUG
+#define ALOGV(...) ((void)0)
+#else
+#define ALOGV(...) airquality_host_log('V', LOG_TAG, __VA_ARGS__)
+#endif
+#define ALOGD(...) airquality_host_log('D', LOG_TAG, __VA_ARGS__)
+#define ALOGI(...) airquality_host_log('I', LOG_TAG, __VA_ARGS__)
+#define ALOGW(...) airquality_host_log('W', LOG_TAG, __VA_ARGS__)
+#define ALOGE(...) airquality_host_log('E', LOG_TAG, __VA_ARGS__)
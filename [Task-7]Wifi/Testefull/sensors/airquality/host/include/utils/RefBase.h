@@ -0,0 +1,40 @@
+#pragma once
+
+// RefBase/sp da libutils para o build CMake: contagem forte só, sem weak.
+
+#include <atomic>
+#include <utility>
+namespace android {
+class RefBase {
+public:
+    void incStrong(const void* = nullptr) const { mCount.fetch_add(1); }
+    void decStrong(const void* = nullptr) const { if (mCount.fetch_sub(1) == 1) delete this; }
+protected:
+    RefBase() : mCount(0) {}
+    virtual ~RefBase() = default;
+private:
+    mutable std::atomic<int> mCount;
+};
+class VirtualLightRefBase : public RefBase {};
+template <typename T>
+class sp {
+public:
+    sp() : mPtr(nullptr) {}
+    sp(T* p) : mPtr(p) { if (mPtr) mPtr->incStrong(this); }
+    sp(const sp& o) : sp(o.mPtr) {}
+    template <typename U> sp(const sp<U>& o) : sp(o.get()) {}
+    sp(sp&& o) noexcept : mPtr(o.mPtr) { o.mPtr = nullptr; }
+    ~sp() { if (mPtr) mPtr->decStrong(this); }
+    sp& operator=(sp o) { std::swap(mPtr, o.mPtr); return *this; }
+    sp& operator=(std::nullptr_t) { sp().swapWith(*this); return *this; }
+    T* get() const { return mPtr; }
+    T* operator->() const { return mPtr; }
+    T& operator*() const { return *mPtr; }
+    bool operator==(std::nullptr_t) const { return mPtr == nullptr; }
+    bool operator!=(std::nullptr_t) const { return mPtr != nullptr; }
+    void clear() { sp().swapWith(*this); }
+private:
+    void swapWith(sp& o) { std::swap(mPtr, o.mPtr); }
+    T* mPtr;
+};
+}  // namespace android
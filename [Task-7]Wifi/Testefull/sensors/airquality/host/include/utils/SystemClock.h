@@ -0,0 +1,21 @@
+#pragma once
+
+// libutils mínima para o build CMake: o relógio dos timestamps dos eventos.
+// No Android é o CLOCK_BOOTTIME (conta o tempo em suspensão); aqui também.
+
+#include <stdint.h>
+#include <time.h>
+
+namespace android {
+
+inline int64_t elapsedRealtimeNano() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline int64_t elapsedRealtime() {
+    return elapsedRealtimeNano() / 1000000LL;
+}
+
+}  // namespace android
@@ -0,0 +1,171 @@
+// Testes do HotplugMonitor num diretório temporário no lugar do /dev: portas
+// aparecendo e sumindo, e o SerialReader dormindo sem porta e conectando assim
+// que um link para o PTY da estação falsa aparece.
+
+#include "fake_station.h"
+#include "io/HotplugMonitor.h"
+#include "io/IoReactor.h"
+#include "io/SerialReader.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class Recorder : public HotplugMonitor::Listener {
+public:
+    void onPortAdded(const std::string& path) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mEvents.push_back("+" + path);
+    }
+    void onPortRemoved(const std::string& path) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        mEvents.push_back("-" + path);
+    }
+
+    std::vector<std::string> events() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mEvents;
+    }
+
+private:
+    std::mutex mLock;
+    std::vector<std::string> mEvents;
+};
+
+template <typename Pred>
+bool waitUntil(Pred pred, int timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (Clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return pred();
+}
+
+void touch(const std::string& path) {
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0660);
+    ASSERT_GE(fd, 0);
+    close(fd);
+}
+
+class HotplugTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char dir[] = "/tmp/airquality-dev-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir));
+        mDir = dir;
+    }
+
+    void TearDown() override {
+        for (const char* name : {"ttyUSB0", "ttyUSB1", "ttyACM3", "ttyS0", "ttyUSB10"}) {
+            unlink((mDir + "/" + name).c_str());
+        }
+        rmdir(mDir.c_str());
+    }
+
+    std::string mDir;
+};
+
+// Estação falsa num PTY novo ("cabo" que pode ser plugado no diretório)
+struct Station {
+    Station() {
+        char name[128];
+        if (openpty(&master, &slave, name, nullptr, nullptr) != 0) abort();
+        fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+        path = name;
+        fake = std::make_unique<FakeStation>(master, FakeStation::Features());
+    }
+    ~Station() {
+        close(master);
+        close(slave);
+    }
+
+    int master = -1;
+    int slave = -1;
+    std::string path;
+    std::unique_ptr<FakeStation> fake;
+};
+
+}  // namespace
+
+TEST_F(HotplugTest, ReportsPortsComingAndGoing) {
+    touch(mDir + "/ttyUSB1");  // Já estava lá: não é avisada, mas está em ports()
+
+    HotplugMonitor monitor(mDir);
+    Recorder recorder;
+    monitor.addListener(&recorder);
+
+    EXPECT_TRUE(monitor.covers(mDir + "/ttyACM3"));
+    EXPECT_FALSE(monitor.covers(mDir + "/ttyS0"));
+    EXPECT_FALSE(monitor.covers("/elsewhere/ttyUSB0"));
+
+    touch(mDir + "/ttyS0");     // Não é porta USB
+    touch(mDir + "/ttyUSB10");  // Fora da faixa da varredura
+    touch(mDir + "/ttyACM3");
+    touch(mDir + "/ttyUSB0");
+    ASSERT_TRUE(waitUntil([&] { return recorder.events().size() == 2; }, 1000));
+    EXPECT_EQ("+" + mDir + "/ttyACM3", recorder.events()[0]);
+    EXPECT_EQ("+" + mDir + "/ttyUSB0", recorder.events()[1]);
+
+    std::vector<std::string> expected = {mDir + "/ttyUSB0", mDir + "/ttyUSB1", mDir + "/ttyACM3"};
+    EXPECT_EQ(expected, monitor.ports());
+
+    // chmod do ueventd depois de criar: a porta não é avisada de novo
+    chmod((mDir + "/ttyACM3").c_str(), 0600);
+    unlink((mDir + "/ttyACM3").c_str());
+    ASSERT_TRUE(waitUntil([&] { return recorder.events().size() == 3; }, 1000));
+    EXPECT_EQ("-" + mDir + "/ttyACM3", recorder.events()[2]);
+
+    // Depois de sair, não recebe mais nada
+    monitor.removeListener(&recorder);
+    unlink((mDir + "/ttyUSB0").c_str());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(3u, recorder.events().size());
+}
+
+TEST_F(HotplugTest, ReaderSleepsUntilThePortIsPlugged) {
+    HotplugMonitor monitor(mDir);
+    const std::string port = mDir + "/ttyUSB0";
+
+    CollectingListener listener;
+    SerialReader reader(port, true, &monitor);
+    reader.setListener(&listener);
+    reader.setPollingActive(true);
+    reader.start();
+
+    // Sem porta: nem prazo nem fd, o reator não volta do epoll_wait
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t wakeups = IoReactor::instance().wakeups();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_EQ(wakeups, IoReactor::instance().wakeups());
+
+    for (int plug = 0; plug < 2; plug++) {
+        Station station;
+        auto plugged = Clock::now();
+        ASSERT_EQ(0, symlink(station.path.c_str(), port.c_str()));
+        // Conecta no aviso do inotify, não no prazo de kReconnectDelayMs
+        size_t before = listener.count();
+        ASSERT_TRUE(waitFor([&] { return listener.count() > before; }, station.fake.get(), 1500));
+        EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - plugged).count(), 500);
+
+        // Cabo puxado: o nó some e o PTY desliga
+        unlink(port.c_str());
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    wakeups = IoReactor::instance().wakeups();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_EQ(wakeups, IoReactor::instance().wakeups());
+    reader.stop();
+}
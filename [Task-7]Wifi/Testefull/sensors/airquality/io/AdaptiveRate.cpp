@@ -0,0 +1,106 @@
+#define LOG_TAG "AirQualityRate"
+
+#include "AdaptiveRate.h"
+#include "StreamSession.h"
+#include "../utils/AirHistory.h"
+
+#include <log/log.h>
+#include <math.h>
+
+#include <algorithm>
+
+// Variação que já é evento, não ruído: perto da resolução útil de cada sensor
+// (SDS011, MQ-7/MQ-2 e DHT)
+static const float kThresholds[AdaptiveRate::kChannels] = {
+    5.0f,   // PM2.5 (ug/m3)
+    10.0f,  // PM10 (ug/m3)
+    3.0f,   // CO (ppm)
+    30.0f,  // GLP (ppm)
+    0.5f,   // Temperatura (C)
+    3.0f,   // Umidade (%)
+};
+
+static_assert(AdaptiveRate::kChannels == AirHistory::kChannels, "mesmos canais do AirHistory");
+
+AdaptiveRate::AdaptiveRate()
+    : mBoostMs(0), mLastTransientMs(0), mLastRequestedMs(0), mBoosts(0), mBackoffs(0), mPeriodMs(0) {
+    reset();
+}
+
+void AdaptiveRate::reset() {
+    for (auto& channel : mChannels) channel = {false, 0.0f, 0.0f, 0};
+    mBoostMs = 0;
+    // A conexão nova começa no pedido sem contar como redução
+    mPeriodMs.store(0, std::memory_order_relaxed);
+}
+
+float AdaptiveRate::threshold(size_t channel) {
+    return kThresholds[channel];
+}
+
+void AdaptiveRate::onSample(const AirData& data, int64_t nowMs) {
+    if (!data.valid) return;
+    bool transient = false;
+    for (size_t c = 0; c < kChannels; c++) {
+        float value = data.*AirHistory::field(c);
+        if (!AirData::hasReading(AirHistory::field(c), value)) continue;
+
+        Channel& channel = mChannels[c];
+        if (!channel.seeded) {
+            channel = {true, value, 0.0f, nowMs};
+            continue;
+        }
+        int64_t dtMs = nowMs - channel.lastMs;
+        if (dtMs <= 0) dtMs = 1;
+
+        // Média/variância exponenciais com peso pelo intervalo real
+        float alpha = 1.0f - expf(-static_cast<float>(dtMs) / kTauMs);
+        float diff = value - channel.mean;
+        channel.mean += alpha * diff;
+        channel.var = (1.0f - alpha) * (channel.var + alpha * diff * diff);
+        channel.lastMs = nowMs;
+
+        // Inclinação da média, por segundo: a da amostra crua cresceria com a
+        // taxa e o ruído sozinho seguraria o período curto
+        float slope = fabsf(alpha * diff) * 1000.0f / dtMs;
+
+        transient |= slope > kThresholds[c] || sqrtf(channel.var) > kThresholds[c];
+    }
+
+    if (transient) {
+        mBoostMs = StreamSession::kMinPeriodMs;
+        mLastTransientMs = nowMs;
+    }
+}
+
+int AdaptiveRate::periodMs(int requestedMs, int64_t nowMs) {
+    // Estável por kHoldMs: um degrau de volta (o relógio do degrau recomeça)
+    while (mBoostMs != 0 && nowMs - mLastTransientMs >= kHoldMs) {
+        mBoostMs *= 2;
+        mLastTransientMs += kHoldMs;
+        if (mBoostMs >= requestedMs) mBoostMs = 0;
+    }
+
+    int periodMs = mBoostMs != 0 ? std::min(mBoostMs, requestedMs) : requestedMs;
+    int previousMs = mPeriodMs.exchange(periodMs, std::memory_order_relaxed);
+    // Só conta mudanças da adaptação, não as do período pedido
+    if (previousMs != 0 && periodMs != previousMs && requestedMs == mLastRequestedMs) {
+        if (periodMs < previousMs) {
+            mBoosts.fetch_add(1, std::memory_order_relaxed);
+            ALOGI("Transiente: período %d -> %d ms", previousMs, periodMs);
+        } else {
+            mBackoffs.fetch_add(1, std::memory_order_relaxed);
+            ALOGD("Estável: período %d -> %d ms", previousMs, periodMs);
+        }
+    }
+    mLastRequestedMs = requestedMs;
+    return periodMs;
+}
+
+AdaptiveRate::Stats AdaptiveRate::stats() const {
+    Stats stats;
+    stats.boosts = mBoosts.load(std::memory_order_relaxed);
+    stats.backoffs = mBackoffs.load(std::memory_order_relaxed);
+    stats.periodMs = mPeriodMs.load(std::memory_order_relaxed);
+    return stats;
+}
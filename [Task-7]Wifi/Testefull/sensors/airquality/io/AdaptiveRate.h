@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../utils/AirData.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Período adaptativo do stream, compartilhado por SerialReader e WifiReader.
+ *
+ * O período pedido pela HAL é o piso de taxa: com o ar estável a estação
+ * transmite nele. Cada amostra atualiza, por canal, uma média e variância
+ * exponenciais (constante kTauMs, pesadas pelo intervalo real); quando o
+ * desvio padrão ou a inclinação da média (por segundo) de algum canal passa
+ * do limiar dele, o período cai direto para o limite da estação
+ * (StreamSession::kMinPeriodMs). A cada kHoldMs sem transiente o período
+ * dobra, até voltar ao pedido.
+ *
+ * Não faz I/O nem acorda ninguém: o leitor chama onSample() a cada amostra
+ * e periodMs() a cada volta do loop, e como em stream as amostras chegam no
+ * próprio período, a volta ao pedido não precisa de prazo no reator.
+ * Só a thread do leitor chama onSample()/periodMs()/reset(); stats() de qualquer uma.
+ */
+class AdaptiveRate {
+public:
+    static constexpr int64_t kHoldMs = 10000;
+    static constexpr int64_t kTauMs = 5000;
+    static constexpr size_t kChannels = 6;  // Os do AirData, na ordem do AirHistory
+
+    struct Stats {
+        uint64_t boosts;    // Período encurtado por transiente
+        uint64_t backoffs;  // Degraus de volta ao pedido
+        int periodMs;       // Último período devolvido (0 = nenhum ainda)
+    };
+
+    AdaptiveRate();
+
+    /// Nova conexão: volta ao período pedido e esquece as médias.
+    void reset();
+
+    void onSample(const AirData& data, int64_t nowMs);
+
+    /// Período a pedir agora, entre o limite da estação e requestedMs.
+    int periodMs(int requestedMs, int64_t nowMs);
+
+    Stats stats() const;
+
+    /// Desvio padrão ou inclinação (unidade do canal, por segundo) que conta como transiente.
+    static float threshold(size_t channel);
+
+private:
+    struct Channel {
+        bool seeded;
+        float mean;
+        float var;
+        int64_t lastMs;
+    };
+
+    Channel mChannels[kChannels];
+    int mBoostMs;  // 0 = sem transiente recente: o pedido vale
+    int64_t mLastTransientMs;
+    int mLastRequestedMs;
+
+    std::atomic<uint64_t> mBoosts;
+    std::atomic<uint64_t> mBackoffs;
+    std::atomic<int> mPeriodMs;
+};
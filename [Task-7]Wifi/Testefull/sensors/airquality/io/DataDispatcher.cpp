@@ -0,0 +1,112 @@
+#define LOG_TAG "AirQualityDispatch"
+
+#include "DataDispatcher.h"
+#include <log/log.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+DataDispatcher::DataDispatcher(IAirDataListener* target)
+    : mTarget(target), mWakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), mRunThread(false) {
+    if (mWakeFd < 0) {
+        ALOGE("Erro eventfd: %s", strerror(errno));
+    }
+}
+
+DataDispatcher::~DataDispatcher() {
+    stop();
+    if (mWakeFd >= 0) close(mWakeFd);
+}
+
+IAirDataListener* DataDispatcher::addProducer(const std::string& name) {
+    mProducers.push_back(std::make_unique<Producer>(name, mWakeFd));
+    return mProducers.back().get();
+}
+
+void DataDispatcher::start() {
+    if (mRunThread) return;
+    mRunThread = true;
+    mThread = std::thread(&DataDispatcher::dispatchThread, this);
+}
+
+void DataDispatcher::stop() {
+    mRunThread = false;
+    if (mWakeFd >= 0) {
+        uint64_t one = 1;
+        (void)!write(mWakeFd, &one, sizeof(one));
+    }
+    if (mThread.joinable()) mThread.join();
+
+    std::vector<std::function<void()>> dropped;
+    std::lock_guard<std::mutex> lock(mTasksLock);
+    dropped.swap(mTasks);
+}
+
+void DataDispatcher::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mTasksLock);
+        mTasks.push_back(std::move(task));
+    }
+    uint64_t one = 1;
+    if (mWakeFd >= 0) (void)!write(mWakeFd, &one, sizeof(one));
+}
+
+std::vector<DataDispatcher::Stats> DataDispatcher::stats() const {
+    std::vector<Stats> result;
+    for (const auto& producer : mProducers) {
+        result.push_back({producer->mName, producer->mDelivered.load(), producer->mQueue.drops(),
+                          producer->mQueue.highWater()});
+    }
+    return result;
+}
+
+// Roda na thread do leitor: sem lock e sem chamar ninguém
+void DataDispatcher::Producer::onDataReceived(const AirData& data) {
+    if (!mQueue.push(data)) {
+        ALOGV("Fila %s cheia: amostra descartada", mName.c_str());
+        return;
+    }
+    uint64_t one = 1;
+    // EAGAIN (contador saturado) é inofensivo: o despacho já vai acordar
+    if (mWakeFd >= 0) (void)!write(mWakeFd, &one, sizeof(one));
+}
+
+void DataDispatcher::dispatchThread() {
+    AirData data;
+    std::vector<std::function<void()>> tasks;
+    while (mRunThread) {
+        struct pollfd pfd = { mWakeFd, POLLIN, 0 };
+        // Sem eventfd (improvável) cai numa varredura a cada 100 ms
+        if (mWakeFd < 0 || poll(&pfd, 1, -1) <= 0) {
+            if (mWakeFd < 0) usleep(100000);
+        } else {
+            uint64_t count;
+            (void)!read(mWakeFd, &count, sizeof(count));
+        }
+
+        for (auto& producer : mProducers) {
+            while (producer->mQueue.pop(&data)) {
+                mTarget->onDataReceived(data);
+                producer->mDelivered.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Depois das amostras: o que foi enfileirado antes do post já saiu
+        {
+            std::lock_guard<std::mutex> lock(mTasksLock);
+            tasks.swap(mTasks);
+        }
+        for (auto& task : tasks) task();
+        tasks.clear();
+    }
+
+    for (const auto& s : stats()) {
+        if (s.drops > 0) {
+            ALOGW("Fila %s: %llu amostras descartadas (pico %zu/%zu)", s.name.c_str(),
+                  static_cast<unsigned long long>(s.drops), s.highWater, kQueueCapacity);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "IDataReader.h"
+#include "../utils/SpscRing.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Desacopla a thread de I/O dos leitores (IoReactor) da entrega ao framework.
+ *
+ * Cada leitor recebe o seu próprio produtor (addProducer) como listener: o
+ * onDataReceived() dele só copia o AirData para uma SpscRing e acorda a
+ * thread de despacho por um eventfd. É a thread de despacho que chama o
+ * listener final (a SubHAL, que faz o postEvents), então um framework lento
+ * enche a fila e descarta amostras, mas nunca segura o read() da serial.
+ *
+ * Mensagens de controle (post) vão numa fila à parte, com mutex, e rodam na
+ * mesma thread depois das amostras que já estavam nas filas quando chegaram.
+ */
+class DataDispatcher {
+public:
+    static constexpr size_t kQueueCapacity = 64;
+
+    struct Stats {
+        std::string name;
+        uint64_t delivered;
+        uint64_t drops;
+        size_t highWater;
+    };
+
+    explicit DataDispatcher(IAirDataListener* target);
+    ~DataDispatcher();
+
+    /// Um produtor por thread de leitura. Só antes do start().
+    IAirDataListener* addProducer(const std::string& name);
+
+    void start();
+    /// As mensagens de controle que não rodaram são descartadas.
+    void stop();
+
+    /// Roda task na thread de despacho. De qualquer thread.
+    void post(std::function<void()> task);
+
+    std::vector<Stats> stats() const;
+
+private:
+    class Producer : public IAirDataListener {
+    public:
+        Producer(const std::string& name, int wakeFd) : mName(name), mWakeFd(wakeFd), mDelivered(0) {}
+        void onDataReceived(const AirData& data) override;
+
+        std::string mName;
+        int mWakeFd;
+        std::atomic<uint64_t> mDelivered;  // Escrito só pelo consumidor
+        SpscRing<AirData, kQueueCapacity> mQueue;
+    };
+
+    void dispatchThread();
+
+    IAirDataListener* mTarget;
+    int mWakeFd;
+    std::atomic<bool> mRunThread;
+    std::thread mThread;
+    std::vector<std::unique_ptr<Producer>> mProducers;
+
+    std::mutex mTasksLock;
+    std::vector<std::function<void()>> mTasks;
+};
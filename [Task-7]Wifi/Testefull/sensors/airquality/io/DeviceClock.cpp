@@ -0,0 +1,43 @@
+#define LOG_TAG "AirQualityClock"
+
+#include "DeviceClock.h"
+#include <log/log.h>
+
+#include <algorithm>
+
+// millis() acima disso estouraria em ns (~146 anos): trata como ausente
+static const int64_t kMaxDeviceMs = INT64_MAX / 2000000;
+
+DeviceClock::DeviceClock() {
+    reset();
+}
+
+void DeviceClock::reset() {
+    mNext = 0;
+    mCount = 0;
+    mMinOffsetNs = 0;
+    mLastDeviceMs = -1;
+    mLastLocalNs = 0;
+}
+
+int64_t DeviceClock::toLocalNs(int64_t deviceMs, int64_t arrivalNs) {
+    if (deviceMs < 0 || deviceMs > kMaxDeviceMs) return arrivalNs;
+
+    if (deviceMs < mLastDeviceMs) {
+        ALOGD("millis() da estação voltou (%lld -> %lld): recomeçando o offset",
+              static_cast<long long>(mLastDeviceMs), static_cast<long long>(deviceMs));
+        reset();
+    }
+    mLastDeviceMs = deviceMs;
+
+    int64_t deviceNs = deviceMs * 1000000;
+    mOffsets[mNext] = arrivalNs - deviceNs;
+    mNext = (mNext + 1) % kWindow;
+    if (mCount < kWindow) mCount++;
+    mMinOffsetNs = *std::min_element(mOffsets, mOffsets + mCount);
+
+    // O próprio candidato entra no mínimo, então local <= arrivalNs
+    int64_t localNs = std::max(deviceNs + mMinOffsetNs, mLastLocalNs);
+    mLastLocalNs = localNs;
+    return localNs;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Converte o millis() da estação ("ms" nas amostras) para a base de tempo do
+ * Android, compartilhado por SerialReader e WifiReader.
+ *
+ * Cada amostra dá um candidato a offset: chegada - millis(). Como o atraso
+ * do fio (USB, VTIME, fila do Wi-Fi) só soma, o menor candidato de uma
+ * janela curta é a melhor estimativa; a janela deslizante acompanha o drift
+ * do cristal do ESP32. A amostra volta para millis() + offset, o que tira o
+ * atraso variável e deixa o espaçamento entre amostras igual ao da estação.
+ *
+ * O resultado nunca passa da chegada nem volta para trás. millis() menor que
+ * o anterior (reboot ou estouro do contador) recomeça a estimativa.
+ */
+class DeviceClock {
+public:
+    static constexpr size_t kWindow = 16;
+
+    DeviceClock();
+
+    /// Nova conexão ou firmware reiniciado: os offsets antigos não valem mais.
+    void reset();
+
+    /// Instante (ns, elapsedRealtimeNano) em que a estação mediu deviceMs.
+    int64_t toLocalNs(int64_t deviceMs, int64_t arrivalNs);
+
+    bool synced() const { return mCount > 0; }
+    /// Offset atual (ns): local = deviceMs * 1e6 + offsetNs(). Só vale com synced().
+    int64_t offsetNs() const { return mMinOffsetNs; }
+
+private:
+    int64_t mOffsets[kWindow];
+    size_t mNext;
+    size_t mCount;
+    int64_t mMinOffsetNs;
+    int64_t mLastDeviceMs;
+    int64_t mLastLocalNs;
+};
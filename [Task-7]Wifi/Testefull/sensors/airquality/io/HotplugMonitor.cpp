@@ -0,0 +1,157 @@
+#define LOG_TAG "AirQualityHotplug"
+
+#include "HotplugMonitor.h"
+
+#include <log/log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+// Eventos que podem tornar um nó acessível (criação, chmod/chown do ueventd,
+// rename) ou fazê-lo sumir
+static const uint32_t kAddMask = IN_CREATE | IN_ATTRIB | IN_MOVED_TO;
+static const uint32_t kRemoveMask = IN_DELETE | IN_MOVED_FROM;
+
+HotplugMonitor& HotplugMonitor::instance() {
+    static HotplugMonitor monitor("/dev");
+    return monitor;
+}
+
+HotplugMonitor::HotplugMonitor(const std::string& dir)
+    : mDir(dir), mReactor(IoReactor::instance()), mDispatching(nullptr), mInotifyFd(-1),
+      mAttached(false) {}
+
+HotplugMonitor::~HotplugMonitor() {
+    mReactor.detach(this);
+    if (mInotifyFd >= 0) close(mInotifyFd);
+}
+
+bool HotplugMonitor::isPortName(const std::string& name) {
+    // ttyUSB0..9 e ttyACM0..9, como a varredura dos leitores
+    return name.size() == 7 && (name.compare(0, 6, "ttyUSB") == 0 || name.compare(0, 6, "ttyACM") == 0) &&
+           name[6] >= '0' && name[6] <= '9';
+}
+
+std::vector<std::string> HotplugMonitor::ports() const {
+    std::vector<std::string> ports;
+    for (const char* prefix : {"/ttyUSB", "/ttyACM"}) {
+        for (int i = 0; i < 10; i++) {
+            std::string path = mDir + prefix + std::to_string(i);
+            if (access(path.c_str(), R_OK | W_OK) == 0) ports.push_back(path);
+        }
+    }
+    return ports;
+}
+
+bool HotplugMonitor::covers(const std::string& path) const {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos || path.compare(0, slash, mDir) != 0 || slash != mDir.size()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    return mInotifyFd >= 0 && isPortName(path.substr(slash + 1));
+}
+
+void HotplugMonitor::addListener(Listener* listener) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (std::find(mListeners.begin(), mListeners.end(), listener) == mListeners.end()) {
+        mListeners.push_back(listener);
+    }
+    if (mAttached) return;
+    mAttached = true;
+
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFd >= 0 && inotify_add_watch(mInotifyFd, mDir.c_str(), kAddMask | kRemoveMask) < 0) {
+        ALOGE("Erro inotify_add_watch(%s): %s", mDir.c_str(), strerror(errno));
+        close(mInotifyFd);
+        mInotifyFd = -1;
+    } else if (mInotifyFd < 0) {
+        ALOGE("Erro inotify_init1: %s", strerror(errno));
+    }
+    if (mInotifyFd < 0) return;  // covers() = false: os leitores voltam a varrer
+
+    // O que já estava lá não é avisado, só o que mudar daqui em diante
+    for (const auto& path : ports()) mPresent.insert(path);
+    mReactor.attach(this);
+}
+
+void HotplugMonitor::removeListener(Listener* listener) {
+    std::unique_lock<std::mutex> lock(mLock);
+    mListeners.erase(std::remove(mListeners.begin(), mListeners.end(), listener), mListeners.end());
+    // Do próprio callback (um leitor parando ao saber que a porta sumiu) não há o que esperar
+    if (std::this_thread::get_id() != mDispatchThread) {
+        mIdleCv.wait(lock, [&] { return mDispatching != listener; });
+    }
+}
+
+void HotplugMonitor::notify(const std::string& path, bool added) {
+    ALOGI("Porta %s %s", path.c_str(), added ? "conectada" : "removida");
+    std::unique_lock<std::mutex> lock(mLock);
+    std::vector<Listener*> listeners = mListeners;
+    mDispatchThread = std::this_thread::get_id();
+    for (Listener* listener : listeners) {
+        // Pode ter saído enquanto outro era avisado
+        if (std::find(mListeners.begin(), mListeners.end(), listener) == mListeners.end()) continue;
+        mDispatching = listener;
+        lock.unlock();
+        if (added) {
+            listener->onPortAdded(path);
+        } else {
+            listener->onPortRemoved(path);
+        }
+        lock.lock();
+        mDispatching = nullptr;
+        mIdleCv.notify_all();
+    }
+}
+
+void HotplugMonitor::resync() {
+    // Eventos perdidos: o estado de cada porta é relido do disco
+    ALOGW("Fila do inotify estourou; relendo as portas");
+    std::vector<std::string> now = ports();
+    std::set<std::string> present(now.begin(), now.end());
+    for (const auto& path : std::set<std::string>(mPresent)) {
+        if (!present.count(path)) {
+            mPresent.erase(path);
+            notify(path, false);
+        }
+    }
+    for (const auto& path : now) {
+        if (mPresent.insert(path).second) notify(path, true);
+    }
+}
+
+void HotplugMonitor::onIoEvent(uint32_t events) {
+    if (events & EPOLLIN) {
+        alignas(struct inotify_event) char buf[4096];
+        ssize_t n;
+        while ((n = read(mInotifyFd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+                p += sizeof(struct inotify_event) + ev->len;
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    resync();
+                    continue;
+                }
+                if (ev->len == 0 || !isPortName(ev->name)) continue;
+
+                std::string path = mDir + "/" + ev->name;
+                if (ev->mask & kRemoveMask) {
+                    if (mPresent.erase(path)) notify(path, false);
+                } else if (!mPresent.count(path) && access(path.c_str(), R_OK | W_OK) == 0) {
+                    mPresent.insert(path);
+                    notify(path, true);
+                }
+            }
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            ALOGE("Erro lendo o inotify: %s", strerror(errno));
+        }
+    }
+    mReactor.watch(this, mInotifyFd, EPOLLIN);
+}
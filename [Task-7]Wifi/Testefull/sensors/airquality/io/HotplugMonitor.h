@@ -0,0 +1,72 @@
+#pragma once
+
+#include "IoReactor.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Avisa quando uma porta serial (ttyUSB0..9, ttyACM0..9) aparece ou some,
+ * sem varrer o /dev.
+ *
+ * Vigia o diretório com inotify no IoReactor: o nó é criado pelo ueventd e
+ * só fica acessível depois do chmod/chown das regras do ueventd.rc
+ * (0660 system para as portas USB), então uma porta conta como presente no
+ * primeiro IN_CREATE/IN_ATTRIB em que access(R|W) passa. Com o netlink o
+ * aviso chegaria antes de o nó existir.
+ *
+ * Sem porta nenhuma, nem o monitor nem os leitores acordam.
+ */
+class HotplugMonitor : private IoReactor::Client {
+public:
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+        // Na thread do reator
+        virtual void onPortAdded(const std::string& path) = 0;
+        virtual void onPortRemoved(const std::string& path) {}
+    };
+
+    /// Monitor do /dev, compartilhado pelos leitores.
+    static HotplugMonitor& instance();
+
+    /// dir: onde aparecem os nós (um diretório qualquer nos testes)
+    explicit HotplugMonitor(const std::string& dir);
+    ~HotplugMonitor();
+
+    /// O primeiro listener liga o inotify (que fica ligado até o destrutor).
+    void addListener(Listener* listener);
+    /// Síncrono como o IoReactor::detach(): ao voltar, o listener não está sendo chamado.
+    void removeListener(Listener* listener);
+
+    /// Portas acessíveis agora, na ordem da varredura antiga (ttyUSB0..9, ttyACM0..9)
+    std::vector<std::string> ports() const;
+    /// O inotify está de pé e path é uma porta que ele avisaria
+    bool covers(const std::string& path) const;
+
+    static bool isPortName(const std::string& name);
+
+private:
+    void onIoEvent(uint32_t events) override;
+    void notify(const std::string& path, bool added);
+    // Depois de IN_Q_OVERFLOW: compara o disco com mPresent e avisa a diferença
+    void resync();
+
+    std::string mDir;
+    IoReactor& mReactor;
+
+    mutable std::mutex mLock;
+    std::condition_variable mIdleCv;  // removeListener() esperando o callback em curso
+    std::vector<Listener*> mListeners;
+    Listener* mDispatching;
+    std::thread::id mDispatchThread;
+    int mInotifyFd;  // -1 = ainda sem listeners (ou inotify indisponível)
+    bool mAttached;
+
+    // Só no onIoEvent(): portas já avisadas como presentes
+    std::set<std::string> mPresent;
+};
@@ -1,11 +1,21 @@
 #pragma once
 #include "../utils/AirData.h"
+#include <array>
+#include <string>
+
+// Período de cada sub-sensor da estação (índice StationTarget); <= 0 = nenhum
+// sensor ativo precisa dele
+using TargetPeriodsNs = std::array<int64_t, kStationTargets>;
 
 // Interface de Callback (Quem recebe os dados)
 class IAirDataListener {
 public:
     virtual ~IAirDataListener() = default;
     virtual void onDataReceived(const AirData& data) = 0;
+    // A estação do outro lado se identificou ("device_id" do GET SETTINGS ou
+    // "device" do boot) / a conexão com ela caiu. Na thread de I/O do leitor.
+    virtual void onStationIdentified(const std::string& deviceId) {}
+    virtual void onStationLost() {}
 };
 
 // Interface Genérica de Leitura
@@ -15,5 +25,11 @@ public:
     virtual void start() = 0;
     virtual void stop() = 0;
     virtual void setPollingActive(bool enabled) = 0; // Liga/Desliga envio de "GET DATA"
+    // Período desejado entre amostras (o menor entre os sensores ativos).
+    // Com firmware que suporta "STREAM ON" o leitor passa a só escutar.
+    virtual void setSamplingPeriodNs(int64_t periodNs) = 0;
+    // Quais sub-sensores pedir e a cada quanto ("GET DATA <alvo>"). Sem essa
+    // chamada o leitor pede tudo no período do setSamplingPeriodNs.
+    virtual void setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) {}
     virtual void setListener(IAirDataListener* listener) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,234 @@
+#define LOG_TAG "AirQualityReactor"
+
+#include "IoReactor.h"
+
+#include <log/log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <utility>
+
+// data.u64 reservado para o eventfd do próprio reator
+static const uint64_t kWakeId = 0;
+static const int kMaxEvents = 16;
+
+static int64_t monotonicMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+IoReactor& IoReactor::instance() {
+    static IoReactor reactor;
+    return reactor;
+}
+
+IoReactor::IoReactor()
+    : mEpollFd(epoll_create1(EPOLL_CLOEXEC)), mWakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      mNextId(kWakeId + 1), mDispatching(nullptr), mRunning(false), mWakeups(0) {
+    if (mEpollFd < 0 || mWakeFd < 0) {
+        ALOGE("Erro epoll/eventfd: %s", strerror(errno));
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = kWakeId;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev) < 0) {
+        ALOGE("Erro epoll_ctl (eventfd): %s", strerror(errno));
+    }
+}
+
+IoReactor::~IoReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = false;
+    }
+    signal();
+    if (mThread.joinable()) mThread.join();
+    if (mWakeFd >= 0) close(mWakeFd);
+    if (mEpollFd >= 0) close(mEpollFd);
+}
+
+void IoReactor::ensureThread() {
+    if (mRunning) return;
+    mRunning = true;
+    mThread = std::thread(&IoReactor::loop, this);
+}
+
+void IoReactor::signal() {
+    if (mWakeFd < 0) return;
+    uint64_t one = 1;
+    // EAGAIN (contador saturado) é inofensivo: a thread já vai acordar
+    (void)!write(mWakeFd, &one, sizeof(one));
+}
+
+void IoReactor::attach(Client* client) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mClients.count(client)) return;
+        ensureThread();
+        Entry& entry = mClients[client];
+        entry.id = mNextId++;
+        entry.woken = true;
+        mById[entry.id] = client;
+    }
+    signal();
+}
+
+void IoReactor::detach(Client* client) {
+    std::unique_lock<std::mutex> lock(mLock);
+    auto it = mClients.find(client);
+    if (it == mClients.end()) return;
+    if (it->second.fd >= 0) epoll_ctl(mEpollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    mById.erase(it->second.id);
+    mClients.erase(it);
+    // Da própria thread (um client se desligando no callback) não há o que esperar
+    if (std::this_thread::get_id() != mThread.get_id()) {
+        mIdleCv.wait(lock, [&] { return mDispatching != client; });
+    }
+}
+
+void IoReactor::watch(Client* client, int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mClients.find(client);
+    if (it == mClients.end()) return;
+    Entry& entry = it->second;
+    if (fd == entry.fd && events == entry.events) return;
+
+    if (entry.fd >= 0 && entry.fd != fd) {
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, entry.fd, nullptr);
+    }
+    if (fd >= 0) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = entry.id;
+        int op = fd == entry.fd ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if (epoll_ctl(mEpollFd, op, fd, &ev) < 0) {
+            ALOGE("Erro epoll_ctl (fd %d): %s", fd, strerror(errno));
+            fd = -1;
+        }
+    }
+    entry.fd = fd;
+    entry.events = events;
+}
+
+void IoReactor::schedule(Client* client, int64_t deadlineMs) {
+    bool foreign;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mClients.find(client);
+        if (it == mClients.end() || it->second.deadlineMs == deadlineMs) return;
+        it->second.deadlineMs = deadlineMs;
+        foreign = std::this_thread::get_id() != mThread.get_id();
+    }
+    // Na thread do reator o prazo entra na conta antes do próximo epoll_wait
+    if (foreign) signal();
+}
+
+void IoReactor::wake(Client* client) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mClients.find(client);
+        if (it == mClients.end() || it->second.woken) return;
+        it->second.woken = true;
+    }
+    signal();
+}
+
+uint64_t IoReactor::wakeups() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    return mWakeups;
+}
+
+void IoReactor::loop() {
+    struct epoll_event events[kMaxEvents];
+    std::vector<std::pair<Client*, uint32_t>> ready;
+    ready.reserve(kMaxEvents);
+
+    auto addReady = [&ready](Client* client, uint32_t revents) {
+        for (auto& r : ready) {
+            if (r.first == client) {
+                r.second |= revents;
+                return;
+            }
+        }
+        ready.emplace_back(client, revents);
+    };
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (mRunning) {
+        // Timeout até o prazo mais próximo; nenhum prazo = dorme até um evento
+        int64_t nextMs = -1;
+        bool woken = false;
+        for (const auto& c : mClients) {
+            woken |= c.second.woken;
+            if (c.second.deadlineMs >= 0 && (nextMs < 0 || c.second.deadlineMs < nextMs)) {
+                nextMs = c.second.deadlineMs;
+            }
+        }
+        int timeoutMs = -1;
+        if (woken) {
+            timeoutMs = 0;
+        } else if (nextMs >= 0) {
+            timeoutMs = static_cast<int>(std::min<int64_t>(std::max<int64_t>(0, nextMs - monotonicMs()), INT_MAX));
+        }
+
+        lock.unlock();
+        int n = epoll_wait(mEpollFd, events, kMaxEvents, timeoutMs);
+        int err = errno;
+        lock.lock();
+        mWakeups++;
+
+        if (n < 0) {
+            if (err != EINTR) {
+                ALOGE("Erro epoll_wait: %s", strerror(err));
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                lock.lock();
+            }
+            continue;
+        }
+
+        ready.clear();
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == kWakeId) {
+                uint64_t count;
+                (void)!read(mWakeFd, &count, sizeof(count));
+                continue;
+            }
+            // Evento de um client que saiu (ou trocou de fd) nesta mesma volta
+            auto it = mById.find(events[i].data.u64);
+            if (it != mById.end()) addReady(it->second, events[i].events);
+        }
+        int64_t now = monotonicMs();
+        for (auto& c : mClients) {
+            if (c.second.woken) {
+                c.second.woken = false;
+                addReady(c.first, 0);
+            }
+            if (c.second.deadlineMs >= 0 && c.second.deadlineMs <= now) {
+                c.second.deadlineMs = -1;
+                addReady(c.first, 0);
+            }
+        }
+
+        for (const auto& r : ready) {
+            // Pode ter saído enquanto outro client era atendido
+            if (!mRunning || !mClients.count(r.first)) continue;
+            mDispatching = r.first;
+            lock.unlock();
+            r.first->onIoEvent(r.second);
+            lock.lock();
+            mDispatching = nullptr;
+            mIdleCv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Uma thread e um epoll para todos os leitores do processo.
+ *
+ * Cada leitor é um Client: registra no máximo um fd (watch) e um prazo
+ * (schedule) e recebe onIoEvent() na thread do reator quando o fd fica pronto,
+ * o prazo vence ou alguém chama wake(). Cada onIoEvent() faz o trabalho
+ * vencido, diz pelo que esperar e retorna, sem bloquear.
+ *
+ * Sem fd pronto e sem prazo o reator dorme no epoll_wait sem timeout: com
+ * todos os leitores em standby o processo não acorda.
+ */
+class IoReactor {
+public:
+    class Client {
+    public:
+        virtual ~Client() = default;
+        // Na thread do reator. events: os do epoll para o fd vigiado; 0 quando
+        // foi o prazo ou um wake(). Vários motivos juntos viram uma chamada só.
+        virtual void onIoEvent(uint32_t events) = 0;
+    };
+
+    /// Reator compartilhado pelos leitores (a thread nasce no primeiro attach).
+    static IoReactor& instance();
+
+    IoReactor();
+    ~IoReactor();
+
+    /// Registra o client e agenda um onIoEvent(0) logo em seguida.
+    void attach(Client* client);
+    /// Síncrono: ao voltar, o client não está e não vai mais estar em onIoEvent().
+    void detach(Client* client);
+
+    // Só de dentro de onIoEvent() (ou com o client fora do reator).
+    // Um fd por client; -1 para de vigiar. Pare de vigiar antes de fechar o fd:
+    // o número pode voltar num open() seguinte e o epoll já o esqueceu.
+    void watch(Client* client, int fd, uint32_t events);
+    /// Prazo em ms do steady_clock (só um por client, vale uma vez); -1 = nenhum.
+    void schedule(Client* client, int64_t deadlineMs);
+
+    /// De qualquer thread: pede um onIoEvent(0). Pedidos repetidos se juntam.
+    void wake(Client* client);
+
+    /// Quantas vezes a thread voltou do epoll_wait.
+    uint64_t wakeups() const;
+
+private:
+    struct Entry {
+        uint64_t id;
+        int fd = -1;
+        uint32_t events = 0;
+        int64_t deadlineMs = -1;
+        bool woken = false;
+    };
+
+    void ensureThread();  // com mLock
+    void signal();
+    void loop();
+
+    int mEpollFd;
+    int mWakeFd;  // eventfd: wake(), attach() e detach() interrompem o epoll_wait
+
+    mutable std::mutex mLock;
+    std::condition_variable mIdleCv;  // detach() esperando o callback em curso
+    std::map<Client*, Entry> mClients;
+    std::map<uint64_t, Client*> mById;  // data.u64 do epoll -> client
+    uint64_t mNextId;
+    Client* mDispatching;  // client em onIoEvent() agora
+    std::thread mThread;
+    bool mRunning;
+    uint64_t mWakeups;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+
+/**
+ * Enquadrador de linhas de capacidade fixa, compartilhado por SerialReader e WifiReader.
+ *
+ * O read()/recv() escreve direto em writePtr() e nextLine() devolve views que
+ * apontam para o próprio buffer de recepção: nenhuma cópia ou alocação por linha.
+ * O buffer é reaproveitado em anel: quando o fim enche, só a linha parcial
+ * pendente é movida para o início.
+ *
+ * Uma linha maior que kMaxLineLength é descartada até o próximo '\n', então um
+ * emissor descontrolado nunca faz a memória crescer.
+ *
+ * Cada linha sai com o instante de chegada do seu primeiro byte: o commit()
+ * que o trouxe. Com o buffer drenado a cada commit (o uso abaixo), só a linha
+ * parcial sobra de um commit para o outro e o carimbo é exato; linhas
+ * inteiras que ficaram para trás levam o carimbo do último commit.
+ *
+ * Uso:
+ *   ssize_t n = read(fd, framer.writePtr(), framer.writable());
+ *   framer.commit(n, android::elapsedRealtimeNano());
+ *   while (framer.nextLine(&line, &arrivalNs)) { ... }   // drenar até false antes do próximo read
+ *
+ * As views só valem até a chamada de nextLine() que devolve false.
+ */
+template <size_t Capacity>
+class LineFramer {
+public:
+    static_assert(Capacity >= 2, "LineFramer precisa de pelo menos 2 bytes");
+
+    /// Maior linha aceita, contando um eventual '\r' final (o '\n' ocupa o último byte).
+    static constexpr size_t kMaxLineLength = Capacity - 1;
+
+    LineFramer()
+        : mHead(0), mScan(0), mTail(0), mDiscarding(false), mOverflows(0),
+          mHeadNs(0), mCommitNs(0) {}
+
+    char* writePtr() { return mBuf + mTail; }
+    size_t writable() const { return Capacity - mTail; }
+
+    /// arrivalNs: quando os n bytes chegaram (elapsedRealtimeNano logo após o read).
+    void commit(size_t n, int64_t arrivalNs = 0) {
+        if (mHead == mTail) mHeadNs = arrivalNs;
+        mCommitNs = arrivalNs;
+        mTail += n;
+    }
+
+    /// Copia bytes que já estão em outro buffer; retorna quantos couberam.
+    size_t feed(const char* data, size_t len, int64_t arrivalNs = 0) {
+        size_t n = len < writable() ? len : writable();
+        memcpy(writePtr(), data, n);
+        commit(n, arrivalNs);
+        return n;
+    }
+
+    /**
+     * Extrai a próxima linha completa (sem '\n' e sem '\r' final) e, se
+     * arrivalNs não for nulo, o instante de chegada do seu primeiro byte.
+     * Linhas vazias são ignoradas. Retorna false quando não há linha completa.
+     */
+    bool nextLine(std::string_view* line, int64_t* arrivalNs = nullptr) {
+        while (mScan < mTail) {
+            const char* nl = static_cast<const char*>(memchr(mBuf + mScan, '\n', mTail - mScan));
+            if (nl == nullptr) break;
+
+            size_t begin = mHead;
+            int64_t beginNs = mHeadNs;
+            size_t end = static_cast<size_t>(nl - mBuf);
+            mHead = mScan = end + 1;
+            mHeadNs = mCommitNs;  // o que vem depois chegou (no máximo) no último commit
+
+            if (mDiscarding) {
+                // Fim da linha longa demais: volta ao normal a partir daqui
+                mDiscarding = false;
+                continue;
+            }
+
+            if (end > begin && mBuf[end - 1] == '\r') end--;
+            if (end == begin) continue;
+
+            *line = std::string_view(mBuf + begin, end - begin);
+            if (arrivalNs) *arrivalNs = beginNs;
+            return true;
+        }
+
+        mScan = mTail;
+        reclaim();
+        return false;
+    }
+
+    void reset() {
+        mHead = mScan = mTail = 0;
+        mDiscarding = false;
+        mHeadNs = mCommitNs = 0;
+    }
+
+    /**
+     * Entrega os bytes ainda não consumidos (linha parcial e o que vier depois)
+     * e esvazia o framer. Usado quando o fluxo muda de formato no meio do buffer.
+     * *arrivalNs recebe a chegada do primeiro desses bytes, para o próximo feed().
+     * A view só vale até o próximo commit()/feed().
+     */
+    std::string_view takePending(int64_t* arrivalNs = nullptr) {
+        std::string_view pending = mDiscarding ? std::string_view()
+                                               : std::string_view(mBuf + mHead, mTail - mHead);
+        if (arrivalNs) *arrivalNs = mHeadNs;
+        reset();
+        return pending;
+    }
+
+    /// true se sobrou uma linha incompleta (ou o resto de uma longa demais) após nextLine().
+    bool hasPartialLine() const { return mHead != mTail || mDiscarding; }
+
+    /// Quantas linhas foram descartadas por exceder kMaxLineLength.
+    size_t overflowCount() const { return mOverflows; }
+
+private:
+    // Chamado só quando não há mais linhas completas (views já consumidas)
+    void reclaim() {
+        if (mHead == mTail) {
+            mHead = mScan = mTail = 0;
+            return;
+        }
+
+        if (mTail - mHead == Capacity) {
+            // Buffer inteiro sem '\n': linha grande demais, descarta
+            if (!mDiscarding) mOverflows++;
+            mDiscarding = true;
+            mHead = mScan = mTail = 0;
+            return;
+        }
+
+        // Pouco espaço no fim: move a linha parcial para o início do anel
+        if (mHead > 0 && writable() < Capacity / 4) {
+            size_t pending = mTail - mHead;
+            memmove(mBuf, mBuf + mHead, pending);
+            mHead = 0;
+            mScan = mTail = pending;
+        }
+    }
+
+    char mBuf[Capacity];
+    size_t mHead;      // início da linha ainda não entregue
+    size_t mScan;      // até onde já procuramos '\n'
+    size_t mTail;      // fim dos bytes recebidos
+    bool mDiscarding;  // dentro de uma linha longa demais
+    size_t mOverflows;
+    int64_t mHeadNs;    // chegada do byte em mHead
+    int64_t mCommitNs;  // chegada do último commit
+};
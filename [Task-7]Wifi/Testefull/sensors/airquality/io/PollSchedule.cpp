@@ -0,0 +1,71 @@
+#include "PollSchedule.h"
+
+#include <algorithm>
+#include <limits>
+
+static const char* const kTargetNames[kStationTargets] = {"SDS011", "MQ2", "MQ7", "DHT"};
+static const int kMinPeriodsMs[kStationTargets] = {1000, 1000, 1000, 2000};
+
+PollSchedule::PollSchedule() {
+    reset();
+}
+
+void PollSchedule::reset() {
+    std::fill(mLastMs, mLastMs + kStationTargets, -1);
+    mWakeupMs = std::numeric_limits<int64_t>::max();
+}
+
+const char* PollSchedule::name(int target) {
+    return kTargetNames[target];
+}
+
+int PollSchedule::minPeriodMs(int target) {
+    return kMinPeriodsMs[target];
+}
+
+const char* PollSchedule::streamTarget(const int (&periodsMs)[kStationTargets]) {
+    int only = -1;
+    for (int t = 0; t < kStationTargets; t++) {
+        if (periodsMs[t] <= 0) continue;
+        if (only >= 0) return nullptr;
+        only = t;
+    }
+    return only >= 0 ? kTargetNames[only] : nullptr;
+}
+
+bool PollSchedule::nextRequest(const int (&periodsMs)[kStationTargets], int64_t nowMs,
+                               std::string* cmd) {
+    // O período pode ter mudado desde o último pedido: o vencimento sai do
+    // último atendimento, não de um prazo guardado
+    auto dueMs = [&](int t) {
+        if (mLastMs[t] < 0) return nowMs;
+        return mLastMs[t] + std::max(periodsMs[t], kMinPeriodsMs[t]);
+    };
+
+    unsigned used = 0, due = 0;
+    for (int t = 0; t < kStationTargets; t++) {
+        if (periodsMs[t] <= 0) continue;
+        used |= 1u << t;
+        if (dueMs(t) <= nowMs) due |= 1u << t;
+    }
+
+    bool request = due != 0;
+    if (request) {
+        unsigned served = due;
+        if (due & (due - 1)) {
+            *cmd = "GET DATA\n";
+            served = used;
+        } else {
+            *cmd = std::string("GET DATA ") + kTargetNames[__builtin_ctz(due)] + "\n";
+        }
+        for (int t = 0; t < kStationTargets; t++) {
+            if (served & (1u << t)) mLastMs[t] = nowMs;
+        }
+    }
+
+    mWakeupMs = std::numeric_limits<int64_t>::max();
+    for (int t = 0; t < kStationTargets; t++) {
+        if (used & (1u << t)) mWakeupMs = std::min(mWakeupMs, dueMs(t));
+    }
+    return request;
+}
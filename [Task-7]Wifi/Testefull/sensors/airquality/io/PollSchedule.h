@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../utils/AirData.h"
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Agenda dos pedidos de dados por sub-sensor da estação ("GET DATA <alvo>"),
+ * compartilhada por SerialReader e WifiReader enquanto não há stream.
+ *
+ * Cada alvo em uso é pedido no seu período, nunca abaixo do refresh do
+ * sub-sensor (minPeriodMs): um sensor de umidade a 10 s não faz a estação
+ * serializar o SDS011 junto. Um alvo vencido sozinho sai como
+ * "GET DATA <alvo>"; dois ou mais saem num "GET DATA" só e contam como
+ * atendidos todos os alvos em uso, porque o quadro binário tem tamanho fixo e
+ * cada resposta JSON repete o cabeçalho: uma resposta cheia custa menos que
+ * duas parciais.
+ *
+ * Como o StreamSession, não faz I/O: o leitor chama nextRequest() em laço a
+ * cada volta e dorme até wakeupMs().
+ */
+class PollSchedule {
+public:
+    PollSchedule();
+
+    /// Nova conexão: todo alvo em uso vence já.
+    void reset();
+
+    /**
+     * Próximo pedido vencido em nowMs, com o período de cada alvo (<= 0 = fora
+     * de uso). Retorna true e preenche *cmd (já com '\n'); um pedido por chamada.
+     */
+    bool nextRequest(const int (&periodsMs)[kStationTargets], int64_t nowMs, std::string* cmd);
+
+    /// Quando o próximo alvo vence, para os períodos do último nextRequest() (INT64_MAX = nenhum).
+    int64_t wakeupMs() const { return mWakeupMs; }
+
+    /// Alvo do "STREAM ON": o único em uso, ou nullptr (todos).
+    static const char* streamTarget(const int (&periodsMs)[kStationTargets]);
+
+    /// Nome do alvo no protocolo ("SDS011", "MQ2", "MQ7", "DHT").
+    static const char* name(int target);
+
+    /// Menor intervalo entre pedidos do alvo: o firmware relê os sensores a
+    /// 1 Hz e a biblioteca do DHT devolve a leitura anterior por 2 s.
+    static int minPeriodMs(int target);
+
+private:
+    int64_t mLastMs[kStationTargets];  // último pedido que atendeu o alvo (-1 = nenhum)
+    int64_t mWakeupMs;
+};
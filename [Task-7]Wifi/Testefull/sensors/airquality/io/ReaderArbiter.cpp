@@ -0,0 +1,234 @@
+#define LOG_TAG "AirQualityArbiter"
+
+#include "ReaderArbiter.h"
+#include "StreamSession.h"
+#include <log/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+static int64_t monotonicMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+ReaderArbiter::ReaderArbiter()
+    : mListener(nullptr), mRunning(false), mWatchdogDeadlineMs(std::numeric_limits<int64_t>::max()),
+      mActive(false), mPeriodMs(1000), mPrimary(0), mPrimarySinceMs(0), mCandidate(-1),
+      mCandidateIsFailover(false), mCandidateDeadlineMs(0), mNextProbeMs(0), mLastSource(-1), mLastDeviceMs(-1), mLastTimestampNs(0) {}
+
+ReaderArbiter::~ReaderArbiter() {
+    stop();
+}
+
+void ReaderArbiter::addSource(const std::string& name, IDataReader* reader) {
+    size_t index = mSources.size();
+    mSources.push_back(std::make_unique<Source>(this, index, name, reader));
+    reader->setListener(&mSources.back()->port);
+}
+
+void ReaderArbiter::setListener(IAirDataListener* listener) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mListener = listener;
+}
+
+void ReaderArbiter::start() {
+    for (auto& source : mSources) source->reader->start();
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mRunning) return;
+    mRunning = true;
+    mThread = std::thread(&ReaderArbiter::watchdogThread, this);
+}
+
+void ReaderArbiter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = false;
+    }
+    mCv.notify_all();
+    if (mThread.joinable()) mThread.join();
+    for (auto& source : mSources) source->reader->stop();
+}
+
+void ReaderArbiter::setPollingActive(bool enabled) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mSources.empty() || mActive == enabled) return;
+    mActive = enabled;
+    int64_t now = monotonicMs();
+    if (enabled) {
+        setSourceActive(mPrimary, true);
+        mPrimarySinceMs = now;
+        // Se o primário não é o preferido, o preferido já é sondado agora
+        mNextProbeMs = now;
+    } else {
+        for (size_t i = 0; i < mSources.size(); i++) setSourceActive(i, false);
+        mCandidate = -1;
+    }
+    mCv.notify_all();
+}
+
+void ReaderArbiter::setSamplingPeriodNs(int64_t periodNs) {
+    // Todos recebem o período: o candidato já sai negociando o stream certo
+    for (auto& source : mSources) source->reader->setSamplingPeriodNs(periodNs);
+    std::lock_guard<std::mutex> lock(mLock);
+    mPeriodMs = StreamSession::clampPeriodMs(periodNs / 1000000);
+    mCv.notify_all();
+}
+
+void ReaderArbiter::setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) {
+    for (auto& source : mSources) source->reader->setTargetPeriodsNs(periodsNs);
+}
+
+std::vector<ReaderArbiter::SourceStats> ReaderArbiter::stats() const {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::vector<SourceStats> stats;
+    for (size_t i = 0; i < mSources.size(); i++) {
+        const Source& s = *mSources[i];
+        stats.push_back({s.name, static_cast<int>(i) == mPrimary, s.active, s.delivered,
+                         s.duplicates, s.ignored, s.promotions});
+    }
+    return stats;
+}
+
+void ReaderArbiter::setSourceActive(int index, bool active) {
+    Source& s = *mSources[index];
+    if (active) {
+        s.lastDataMs = 0;
+        s.lastGapMs = 0;
+    }
+    s.active = active;
+    s.reader->setPollingActive(active);
+}
+
+bool ReaderArbiter::isDuplicate(const AirData& data) const {
+    if (mLastSource < 0) return false;
+    if (data.deviceMs >= 0 && mLastDeviceMs >= 0) {
+        return data.deviceMs <= mLastDeviceMs && mLastDeviceMs - data.deviceMs < kDedupWindowMs;
+    }
+    return data.timestamp < mLastTimestampNs + mPeriodMs * 1000000 / 2;
+}
+
+void ReaderArbiter::onIdentity(size_t index, const std::string& deviceId) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mSources[index]->deviceId = deviceId;
+    if (mListener == nullptr) return;
+    if (!deviceId.empty()) {
+        mListener->onStationIdentified(deviceId);
+        return;
+    }
+    for (const auto& source : mSources) {
+        if (!source->deviceId.empty()) return;  // ainda alcançável pelo outro enlace
+    }
+    mListener->onStationLost();
+}
+
+void ReaderArbiter::onSample(size_t index, const AirData& data) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Source& s = *mSources[index];
+    int i = static_cast<int>(index);
+    if (!s.active) {
+        // Em trânsito quando o enlace foi desligado
+        s.ignored++;
+        return;
+    }
+
+    int64_t now = monotonicMs();
+    if (s.lastDataMs != 0) s.lastGapMs = now - s.lastDataMs;
+    s.lastDataMs = now;
+
+    if (i == mCandidate) {
+        int old = mPrimary;
+        ALOGW("Enlace primário: %s -> %s (%s)", mSources[old]->name.c_str(), s.name.c_str(),
+              mCandidateIsFailover ? "primário quieto" : "preferido de volta");
+        mCandidate = -1;
+        mPrimary = i;
+        mPrimarySinceMs = now;
+        s.promotions++;
+        setSourceActive(old, false);
+        mNextProbeMs = now + kProbeIntervalMs;
+        mCv.notify_all();
+    } else if (i != mPrimary) {
+        s.ignored++;
+        return;
+    } else if (mCandidate >= 0 && mCandidateIsFailover) {
+        // O primário voltou antes do candidato: desfaz a troca
+        ALOGI("Enlace %s voltou; desligando %s", s.name.c_str(), mSources[mCandidate]->name.c_str());
+        setSourceActive(mCandidate, false);
+        mCandidate = -1;
+        mNextProbeMs = mPrimary == 0 ? now : now + kProbeIntervalMs;
+        mCv.notify_all();
+    } else if (quietDeadlineMs() < mWatchdogDeadlineMs) {
+        // Primeira amostra (o prazo cai de kCandidateTimeoutMs para 1,5 período)
+        // ou ritmo mais rápido: o watchdog precisa acordar antes do previsto
+        mCv.notify_all();
+    }
+
+    if (i != mLastSource && isDuplicate(data)) {
+        s.duplicates++;
+        return;
+    }
+
+    AirData out = data;
+    out.source = s.name;
+    mLastSource = i;
+    mLastDeviceMs = data.deviceMs;
+    mLastTimestampNs = data.timestamp;
+    s.delivered++;
+    if (mListener) mListener->onDataReceived(out);
+}
+
+int64_t ReaderArbiter::quietDeadlineMs() const {
+    const Source& primary = *mSources[mPrimary];
+    if (primary.lastDataMs == 0) return mPrimarySinceMs + kCandidateTimeoutMs;
+    int64_t expectedMs = std::max(mPeriodMs, primary.lastGapMs);
+    return primary.lastDataMs + expectedMs + expectedMs / 2;
+}
+
+int64_t ReaderArbiter::evaluate(int64_t nowMs) {
+    const int64_t kNever = std::numeric_limits<int64_t>::max();
+    if (!mActive || mSources.size() < 2) return kNever;
+
+    if (mCandidate >= 0 && nowMs >= mCandidateDeadlineMs) {
+        ALOGW("Enlace %s não entregou nada; desligando", mSources[mCandidate]->name.c_str());
+        setSourceActive(mCandidate, false);
+        // Failover: tenta o próximo enlace depois de um prazo; sondagem: só no próximo ciclo
+        mNextProbeMs = nowMs + (mCandidateIsFailover ? kCandidateTimeoutMs : kProbeIntervalMs);
+        mCandidate = -1;
+    }
+
+    int64_t quietAtMs = quietDeadlineMs();
+    bool quiet = nowMs >= quietAtMs;
+    if (mCandidate < 0 && nowMs >= mNextProbeMs && (quiet || mPrimary != 0)) {
+        // Quieto: o próximo depois do primário. Saudável mas fora do preferido: sonda o preferido.
+        mCandidateIsFailover = quiet;
+        mCandidate = quiet ? (mPrimary + 1) % static_cast<int>(mSources.size()) : 0;
+        mCandidateDeadlineMs = nowMs + kCandidateTimeoutMs;
+        if (quiet) {
+            ALOGW("Enlace %s quieto; ligando %s", mSources[mPrimary]->name.c_str(),
+                  mSources[mCandidate]->name.c_str());
+        } else {
+            ALOGI("Sondando o enlace preferido %s", mSources[mCandidate]->name.c_str());
+        }
+        setSourceActive(mCandidate, true);
+    }
+
+    if (mCandidate >= 0) return mCandidateDeadlineMs;
+    int64_t next = quiet ? kNever : quietAtMs;
+    if (quiet || mPrimary != 0) next = std::min(next, mNextProbeMs);
+    return next;
+}
+
+void ReaderArbiter::watchdogThread() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (mRunning) {
+        int64_t now = monotonicMs();
+        int64_t next = evaluate(now);
+        mWatchdogDeadlineMs = next;
+        if (next == std::numeric_limits<int64_t>::max()) {
+            mCv.wait(lock);
+        } else {
+            mCv.wait_for(lock, std::chrono::milliseconds(std::max<int64_t>(next - now, 1)));
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "IDataReader.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Um IDataReader sobre vários enlaces para a mesma estação (serial e Wi-Fi):
+ * só um deles, o primário, fica ativo e entrega amostras, então a HAL paga o
+ * tráfego de um enlace só e o framework nunca recebe a mesma amostra duas vezes.
+ *
+ * A ordem de addSource() é a preferência. Quando o primário fica quieto por
+ * mais de 1,5 intervalo esperado (o período pedido ou o último intervalo
+ * observado, o que for maior), o próximo enlace é ligado como candidato; o
+ * primeiro dos dois a entregar fica, o outro é desligado. Um candidato que não
+ * entrega em kCandidateTimeoutMs é desligado e tentado de novo mais tarde.
+ * Enquanto o primário não for o preferido, o preferido é sondado a cada
+ * kProbeIntervalMs (e a cada ativação) do mesmo jeito, para voltar a ele.
+ *
+ * Na troca os dois enlaces podem entregar a mesma medição: amostras de um
+ * enlace diferente do último entregue são descartadas se o millis() da
+ * estação ("ms") não avançou, ou, sem ele, se chegaram a menos de meio
+ * período da última. AirData::source passa a ser o nome do enlace que entregou.
+ *
+ * onDataReceived() dos enlaces roda na thread de I/O deles (o IoReactor) e
+ * chama o listener com o lock do árbitro: as entregas ficam serializadas,
+ * então o listener pode ser um único produtor do DataDispatcher.
+ *
+ * A identificação da estação passa adiante por qualquer enlace; a perda só
+ * quando nenhum enlace conhece mais a estação.
+ */
+class ReaderArbiter : public IDataReader {
+public:
+    // Espera pela primeira amostra de um enlace recém-ligado (conexão + negociação)
+    static constexpr int64_t kCandidateTimeoutMs = 3000;
+    // Intervalo entre sondagens do enlace preferido enquanto outro é o primário
+    static constexpr int64_t kProbeIntervalMs = 30000;
+    // Janela do millis() em que uma amostra de outro enlace conta como repetida
+    // (além dela é um reboot da estação)
+    static constexpr int64_t kDedupWindowMs = 10000;
+
+    struct SourceStats {
+        std::string name;
+        bool primary;
+        bool active;
+        uint64_t delivered;
+        uint64_t duplicates;  // mesma medição já entregue pelo outro enlace
+        uint64_t ignored;     // chegaram com o enlace fora do papel de primário
+        uint64_t promotions;  // vezes que virou primário numa troca
+    };
+
+    ReaderArbiter();
+    ~ReaderArbiter();
+
+    /// Ordem de preferência. Só antes do start(); o árbitro não é dono do leitor.
+    void addSource(const std::string& name, IDataReader* reader);
+
+    void start() override;
+    void stop() override;
+    void setPollingActive(bool enabled) override;
+    void setSamplingPeriodNs(int64_t periodNs) override;
+    void setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) override;
+    void setListener(IAirDataListener* listener) override;
+
+    std::vector<SourceStats> stats() const;
+
+private:
+    class Port : public IAirDataListener {
+    public:
+        Port(ReaderArbiter* arbiter, size_t index) : mArbiter(arbiter), mIndex(index) {}
+        void onDataReceived(const AirData& data) override { mArbiter->onSample(mIndex, data); }
+        void onStationIdentified(const std::string& deviceId) override {
+            mArbiter->onIdentity(mIndex, deviceId);
+        }
+        void onStationLost() override { mArbiter->onIdentity(mIndex, ""); }
+
+    private:
+        ReaderArbiter* mArbiter;
+        size_t mIndex;
+    };
+
+    struct Source {
+        Source(ReaderArbiter* arbiter, size_t index, const std::string& sourceName, IDataReader* r)
+            : name(sourceName), reader(r), port(arbiter, index) {}
+
+        std::string name;
+        IDataReader* reader;
+        Port port;
+        bool active = false;
+        std::string deviceId;    // "" = enlace sem estação identificada
+        int64_t lastDataMs = 0;  // 0 = nada desde que foi ligado
+        int64_t lastGapMs = 0;   // intervalo entre as duas últimas amostras
+        uint64_t delivered = 0;
+        uint64_t duplicates = 0;
+        uint64_t ignored = 0;
+        uint64_t promotions = 0;
+    };
+
+    void onSample(size_t index, const AirData& data);
+    void onIdentity(size_t index, const std::string& deviceId);
+    bool isDuplicate(const AirData& data) const;
+
+    // Com mLock: liga/desliga o polling de um enlace
+    void setSourceActive(int index, bool active);
+    // Com mLock: primário quieto desde quando? (INT64_MAX = ainda não)
+    int64_t quietDeadlineMs() const;
+    // Com mLock: toma as decisões vencidas e devolve o próximo prazo
+    int64_t evaluate(int64_t nowMs);
+    void watchdogThread();
+
+    std::vector<std::unique_ptr<Source>> mSources;
+    IAirDataListener* mListener;
+
+    mutable std::mutex mLock;
+    std::condition_variable mCv;
+    std::thread mThread;
+    bool mRunning;
+    int64_t mWatchdogDeadlineMs;  // até quando o watchdog está dormindo
+
+    bool mActive;
+    int64_t mPeriodMs;
+    int mPrimary;
+    int64_t mPrimarySinceMs;  // ligado como primário (ativação ou troca)
+    int mCandidate;           // -1 = nenhum
+    bool mCandidateIsFailover;  // candidato por primário quieto (não sondagem)
+    int64_t mCandidateDeadlineMs;
+    int64_t mNextProbeMs;
+
+    // Última amostra entregue (deduplicação entre enlaces)
+    int mLastSource;
+    int64_t mLastDeviceMs;
+    int64_t mLastTimestampNs;
+};
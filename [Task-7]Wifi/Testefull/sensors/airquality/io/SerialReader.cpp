@@ -4,16 +4,39 @@
 #include "../utils/JsonParser.h" 
 
 #include <log/log.h>
+#include <utils/SystemClock.h>  // Para android::elapsedRealtimeNano()
 #include <fcntl.h>      
 #include <errno.h>      
 #include <termios.h>    
 #include <unistd.h>     
 #include <string.h>
+#include <stdint.h>
+#include <sys/epoll.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 
-SerialReader::SerialReader(const std::string& /*devicePathIgnored*/)
-    : mDevicePath(""), mRunThread(false), mPollingActive(false), mListener(nullptr) {
+// Período padrão dos pedidos "GET DATA" sem stream (1Hz)
+static const int kPollPeriodMs = 1000;
+// Espera entre tentativas de abrir o dispositivo quando o hotplug não cobre a
+// porta (caminho fora do /dev, inotify indisponível) e depois de uma queda
+static const int kReconnectDelayMs = 2000;
+
+static int64_t monotonicMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+SerialReader::SerialReader(const std::string& devicePath, bool scanFallback, HotplugMonitor* hotplug)
+    : mPreferredPath(devicePath), mScanFallback(scanFallback), mDevicePath(""),
+      mReactor(IoReactor::instance()),
+      mHotplug(hotplug != nullptr ? *hotplug : HotplugMonitor::instance()),
+      mStarted(false), mPortAdded(false), mPollingActive(false),
+      mStayConnected(false), mPeriodMs(kPollPeriodMs), mListener(nullptr),
+      mFd(-1), mNextOpenMs(0), mWasStandby(true),
+      mFormat(WireFormat::kJson), mFormatRequested(false), mSettingsRequested(false) {
+    for (auto& periodMs : mTargetPeriodMs) periodMs = -1;
 }
 
 SerialReader::~SerialReader() {
@@ -30,35 +53,71 @@ void SerialReader::setPollingActive(bool enabled) {
     bool wasEnabled = mPollingActive.exchange(enabled);
     if (wasEnabled != enabled) {
         ALOGI("Status do Polling alterado: %s", enabled ? "ATIVO (Enviando GET DATA)" : "STANDBY (Silencioso)");
+        mReactor.wake(this);
+    }
+}
+
+void SerialReader::setStayConnected(bool enabled) {
+    if (mStayConnected.exchange(enabled) != enabled) mReactor.wake(this);
+}
+
+void SerialReader::setSamplingPeriodNs(int64_t periodNs) {
+    int periodMs = StreamSession::clampPeriodMs(periodNs / 1000000);
+    if (mPeriodMs.exchange(periodMs) != periodMs) {
+        ALOGI("Período de amostragem: %d ms", periodMs);
+        mReactor.wake(this);
+    }
+}
+
+void SerialReader::setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) {
+    bool changed = false;
+    for (int t = 0; t < kStationTargets; t++) {
+        int periodMs = periodsNs[t] <= 0 ? 0 : StreamSession::clampPeriodMs(periodsNs[t] / 1000000);
+        changed |= mTargetPeriodMs[t].exchange(periodMs) != periodMs;
     }
+    if (changed) mReactor.wake(this);
 }
 
 void SerialReader::start() {
-    if (mRunThread) return;
-    mRunThread = true;
-    mThread = std::thread(&SerialReader::workerThread, this);
+    if (mStarted.exchange(true)) return;
+    ALOGI("Leitor Serial Iniciado. Aguardando ativação de sensores...");
+    mHotplug.addListener(this);
+    mReactor.attach(this);
+}
+
+void SerialReader::onPortAdded(const std::string& path) {
+    // Varrendo, qualquer porta serve; preso a uma, só ela
+    if (!mScanFallback && path != mPreferredPath) return;
+    mPortAdded = true;
+    mReactor.wake(this);
 }
 
 void SerialReader::stop() {
-    mRunThread = false;
-    if (mThread.joinable()) {
-        mThread.join();
+    if (!mStarted.exchange(false)) return;
+    // Depois do detach() nenhum onIoEvent() está rodando: o estado é nosso
+    mHotplug.removeListener(this);
+    mReactor.detach(this);
+    if (mDecoder.badFrameCount() > 0 || mDecoder.lostFrameCount() > 0) {
+        ALOGW("Quadros binários: %zu corrompidos, %zu perdidos",
+              mDecoder.badFrameCount(), mDecoder.lostFrameCount());
     }
+    if (mFd >= 0) close(mFd);
+    mFd = -1;
+    mDeviceId.clear();
+    mWasStandby = true;
+    ALOGI("Leitor Serial Finalizado.");
 }
 
 // Procura a porta USB automaticamente
 std::string SerialReader::findSerialDevice() {
-    // Tenta ttyUSB0 a ttyUSB9
-    for (int i = 0; i < 10; i++) {
-        std::string path = "/dev/ttyUSB" + std::to_string(i);
-        if (access(path.c_str(), R_OK | W_OK) == 0) return path;
+    // Caminho configurado tem prioridade (também permite apontar para um PTY)
+    if (!mPreferredPath.empty() && access(mPreferredPath.c_str(), R_OK | W_OK) == 0) {
+        return mPreferredPath;
     }
-    // Tenta ttyACM0 a ttyACM9 (Melhoria)
-    for (int i = 0; i < 10; i++) {
-        std::string path = "/dev/ttyACM" + std::to_string(i);
-        if (access(path.c_str(), R_OK | W_OK) == 0) return path;
-    }
-    return "";
+    if (!mScanFallback) return "";
+    // ttyUSB0..9, depois ttyACM0..9
+    std::vector<std::string> ports = mHotplug.ports();
+    return ports.empty() ? "" : ports.front();
 }
 
 bool SerialReader::configureSerial(int fd) {
@@ -91,10 +150,11 @@ bool SerialReader::configureSerial(int fd) {
     tty.c_iflag &= ~(IGNBRK|BRKINT|PARMRK|ISTRIP|INLCR|IGNCR|ICRNL);
     tty.c_oflag &= ~OPOST;
 
-    // --- 4. TIMEOUT DE LEITURA ---
-    // Espera até 0.5 segundos (5 * 0.1s) por dados após enviar o comando
-    tty.c_cc[VTIME] = 5; 
-    tty.c_cc[VMIN] = 0;
+    // --- 4. LEITURA ORIENTADA A EVENTOS ---
+    // O fd é aberto com O_NONBLOCK e a espera é feita no poll(); VMIN=1 faz o
+    // read() devolver EAGAIN quando não há bytes (e 0 só em hangup).
+    tty.c_cc[VTIME] = 0;
+    tty.c_cc[VMIN] = 1;
 
     if (tcsetattr(fd, TCSANOW, &tty) != 0) {
         ALOGE("Erro tcsetattr: %s", strerror(errno));
@@ -103,119 +163,338 @@ bool SerialReader::configureSerial(int fd) {
     return true;
 }
 
-void SerialReader::workerThread() {
-    int fd = -1;
-    std::string lineBuffer;
-    char rxBuffer[512];
+bool SerialReader::writeCommand(int fd, const std::string& cmd) {
+    ssize_t written = write(fd, cmd.data(), cmd.size());
+    if (written < 0 && errno != EAGAIN) {
+        // Erro: Cabo desconectado durante a escrita
+        ALOGE("Erro de escrita (Cabo desconectado?): %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void SerialReader::deliver(AirData& data) {
+    mMq.apply(&data);
+    int64_t now = monotonicMs();
+    mStream.onData(now);
+    mRate.onSample(data, now);
+    std::lock_guard<std::mutex> lock(mListenerLock);
+    if (mListener) mListener->onDataReceived(data);
+}
+
+void SerialReader::identify(const std::string& deviceId) {
+    if (deviceId.empty() || deviceId == mDeviceId) return;
+    ALOGI("Estação em %s: %s", mDevicePath.c_str(), deviceId.c_str());
+    mDeviceId = deviceId;
+    std::lock_guard<std::mutex> lock(mListenerLock);
+    if (mListener) mListener->onStationIdentified(deviceId);
+}
+
+void SerialReader::processLines(LineFramer<kRxBufferSize>& framer, BinaryFrameDecoder& decoder) {
+    // Views direto no buffer de recepção
+    std::string_view line;
+    int64_t arrivalNs;
+    while (framer.nextLine(&line, &arrivalNs)) {
+        ALOGV("[JSON] %.*s", (int)line.size(), line.data());
+        AirData data = JsonParser::parse(line, arrivalNs);
+
+        if (data.valid) {
+            // Com "ms" a amostra volta para o instante da medição na estação
+            if (data.deviceMs >= 0) data.timestamp = mClock.toLocalNs(data.deviceMs, arrivalNs);
+            deliver(data);
+            continue;
+        }
+
+        std::string deviceId;
+        JsonParser::Control control = JsonParser::parseControl(line, &deviceId);
+        switch (control) {
+            case JsonParser::Control::kFormatBinary:
+                if (mFormat == WireFormat::kBinary) break;
+                ALOGI("Firmware confirmou o formato binário");
+                mFormat = WireFormat::kBinary;
+                // O que chegou depois do ack já pode ser quadro binário
+                {
+                    int64_t restNs;
+                    std::string_view rest = framer.takePending(&restNs);
+                    decoder.feed(rest.data(), rest.size(), restNs);
+                }
+                return;
+
+            case JsonParser::Control::kFormatJson:
+                mFormat = WireFormat::kJson;
+                break;
+
+            case JsonParser::Control::kStreamOn:
+            case JsonParser::Control::kStreamOff:
+                mStream.onAck(control == JsonParser::Control::kStreamOn, monotonicMs());
+                break;
+
+            case JsonParser::Control::kBoot:
+                // Firmware reiniciou (JSON, sem stream): renegocia no próximo ciclo
+                ALOGI("Firmware reiniciou. Renegociando formato e stream...");
+                mFormat = WireFormat::kJson;
+                mFormatRequested = false;
+                mStream.reset();
+                mClock.reset();
+                identify(deviceId);
+                break;
+
+            case JsonParser::Control::kSettings:
+                identify(deviceId);
+                break;
+
+            case JsonParser::Control::kNone:
+                break;
+        }
+    }
+}
+
+void SerialReader::processFrames(BinaryFrameDecoder& decoder, LineFramer<kRxBufferSize>& framer) {
+    AirData data;
+    std::string_view text;
+    int64_t arrivalNs;
+    BinaryFrameDecoder::Result result;
+    while ((result = decoder.next(&data, &text, &arrivalNs)) != BinaryFrameDecoder::kNeedMore) {
+        if (result == BinaryFrameDecoder::kFrame) {
+            // Quadro v2 traz o millis() da medição, como o "ms" do JSON
+            if (data.deviceMs >= 0) data.timestamp = mClock.toLocalNs(data.deviceMs, arrivalNs);
+            deliver(data);
+            continue;
+        }
+        // Texto no meio do fluxo binário (acks, boot...)
+        while (!text.empty()) {
+            text.remove_prefix(framer.feed(text.data(), text.size(), arrivalNs));
+            processLines(framer, decoder);
+        }
+    }
+}
 
-    ALOGI("Thread Serial Iniciada. Aguardando ativação de sensores...");
+bool SerialReader::openDevice(int* retryMs) {
+    bool portAdded = mPortAdded.exchange(false);
+    std::string path = findSerialDevice();
+    if (path.empty()) {
+        ALOGV("Nenhum dispositivo serial encontrado.");
+        // Com o hotplug cobrindo a porta, dorme até ela aparecer
+        *retryMs = mHotplug.covers(mPreferredPath) ? -1 : kReconnectDelayMs;
+        return false;
+    }
+
+    // Porta que acabou de cair e continua lá (hangup em laço de um PTY
+    // fechado, nó do USB ainda não removido); um aviso do hotplug é um
+    // dispositivo novo e passa na frente
+    int64_t now = monotonicMs();
+    if (now < mNextOpenMs && !portAdded) {
+        *retryMs = static_cast<int>(mNextOpenMs - now);
+        return false;
+    }
+
+    ALOGI("Dispositivo encontrado: %s. Tentando abrir...", path.c_str());
+    int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGE("Falha ao abrir %s: %s", path.c_str(), strerror(errno));
+        *retryMs = kReconnectDelayMs;
+        return false;
+    }
+
+    if (!configureSerial(fd)) {
+        close(fd);
+        *retryMs = kPollPeriodMs;
+        return false;
+    }
+
+    mFd = fd;
+    mDevicePath = path;
+    mSettingsRequested = false;
+    ALOGI(">>> CONECTADO A %s (115200 baud) <<<", mDevicePath.c_str());
+    return true;
+}
+
+void SerialReader::closeDevice() {
+    mReactor.watch(this, -1, 0);
+    close(mFd);
+    mFd = -1;
+    mNextOpenMs = monotonicMs() + kReconnectDelayMs;
+    if (mDeviceId.empty()) return;
+    // A próxima abertura pode achar outra estação (ou outra porta na varredura)
+    mDeviceId.clear();
+    std::lock_guard<std::mutex> lock(mListenerLock);
+    if (mListener) mListener->onStationLost();
+}
+
+void SerialReader::onIoEvent(uint32_t events) {
+    if (mFd >= 0 && (events & (EPOLLERR | EPOLLHUP))) {
+        ALOGE("Dispositivo desconectado (events=0x%x). Reiniciando conexão...", events);
+        closeDevice();
+    } else if (mFd >= 0 && (events & EPOLLIN)) {
+        readAvailable();
+    }
+    service();
+}
+
+void SerialReader::service() {
+    // Cada "continue" é uma nova volta imediata (ex.: reabrir depois de uma
+    // escrita falhar); as esperas viram watch()/schedule() e um return
+    while (mStarted) {
 
-    while (mRunThread) {
-        
         // --- ESTADO 1: STANDBY ---
         // Se nenhum app pediu dados, não gastamos CPU nem USB.
+        // Sem fd vigiado e sem prazo: só setPollingActive() ou stop() chamam de volta.
         if (!mPollingActive) {
-            // Se estiver conectado, mantemos aberto para resposta rápida
-            sleep(1); 
-            continue; 
+            // Se estiver conectado, mantemos aberto para resposta rápida,
+            // mas a estação para de empurrar amostras
+            std::string streamCmd;
+            if (mFd >= 0 && mStream.nextCommand(0, monotonicMs(), &streamCmd)) {
+                writeCommand(mFd, streamCmd);
+            }
+            mWasStandby = true;
+            if (!mStayConnected) {
+                mReactor.watch(this, -1, 0);
+                mReactor.schedule(this, -1);
+                return;
+            }
+            // Porta aberta e vigiada só para a identificação e um hangup
+            if (mFd < 0) {
+                int retryMs;
+                if (!openDevice(&retryMs)) {
+                    mReactor.schedule(this, retryMs < 0 ? -1 : monotonicMs() + retryMs);
+                    return;
+                }
+            }
+            if (!mSettingsRequested) {
+                if (!writeCommand(mFd, "GET SETTINGS\n")) {
+                    closeDevice();
+                    continue;
+                }
+                mSettingsRequested = true;
+            }
+            mReactor.watch(this, mFd, EPOLLIN);
+            mReactor.schedule(this, -1);
+            return;
         }
 
         // --- ESTADO 2: CONEXÃO ---
-        if (fd < 0) {
-            std::string path = findSerialDevice();
-            
-            if (path.empty()) {
-                ALOGV("Nenhum dispositivo serial encontrado.");
-                sleep(2);
-                continue;
+        if (mFd < 0) {
+            int retryMs;
+            if (!openDevice(&retryMs)) {
+                mReactor.schedule(this, retryMs < 0 ? -1 : monotonicMs() + retryMs);
+                return;
             }
+            mWasStandby = true;
+        }
 
-            ALOGI("Dispositivo encontrado: %s. Tentando abrir...", path.c_str());
-            fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_SYNC);
-            
-            if (fd < 0) {
-                ALOGE("Falha ao abrir %s: %s", path.c_str(), strerror(errno));
-                sleep(2);
+        if (mWasStandby) {
+            // Descarta respostas antigas acumuladas enquanto estávamos parados
+            tcflush(mFd, TCIOFLUSH);
+            mFramer.reset();
+            mDecoder.reset();
+            mFormat = WireFormat::kJson;
+            mFormatRequested = false;
+            mStream.reset();
+            mRate.reset();
+            mClock.reset();
+            mMq.reset();
+            mPoll.reset();
+            // A resposta do GET SETTINGS pode ter ido embora no flush
+            if (mDeviceId.empty()) mSettingsRequested = false;
+            mWasStandby = false;
+        }
+
+        // --- ESTADO 3: COMUNICAÇÃO ---
+        // O ESP32 espera '\n' para processar (inputBuffer.trim no Arduino)
+        // Se mandar sem \n, o ESP32 vai ficar esperando para sempre.
+
+        // A. NEGOCIAÇÃO (formato binário e modo push)
+        // Firmware antigo ignora os dois comandos e seguimos no JSON + polling
+        if (!mFormatRequested) {
+            if (!writeCommand(mFd, "SET FORMAT BIN\n")) {
+                closeDevice();
                 continue;
             }
-
-            if (!configureSerial(fd)) {
-                close(fd);
-                fd = -1;
-                sleep(1);
+            mFormatRequested = true;
+        }
+        // Quem é a estação (device_id); o boot também traz, mas só num reset
+        if (!mSettingsRequested) {
+            if (!writeCommand(mFd, "GET SETTINGS\n")) {
+                closeDevice();
                 continue;
             }
+            mSettingsRequested = true;
+        }
 
-            mDevicePath = path;
-            ALOGI(">>> CONECTADO A %s (115200 baud) <<<", mDevicePath.c_str());
-            
-            tcflush(fd, TCIOFLUSH);
-            lineBuffer.clear();
+        int64_t now = monotonicMs();
+        int periodMs = mRate.periodMs(mPeriodMs, now);
+        int targetsMs[kStationTargets];
+        for (int t = 0; t < kStationTargets; t++) {
+            int targetMs = mTargetPeriodMs[t];
+            targetsMs[t] = targetMs < 0 ? periodMs : targetMs;
+        }
+        std::string streamCmd;
+        if (mStream.nextCommand(periodMs, now, &streamCmd, PollSchedule::streamTarget(targetsMs)) &&
+            !writeCommand(mFd, streamCmd)) {
+            closeDevice();
+            continue;
         }
 
-        // --- ESTADO 3: COMUNICAÇÃO (POLLING) ---
-
-        // Verificar se devemos pedir dados
-        if (mPollingActive) {
-            // A. ESCREVER O COMANDO (Enviar o Pedido "GET DATA")
-            // O ESP32 espera '\n' para processar (inputBuffer.trim no Arduino)
-            // Se mandar sem \n, o ESP32 vai ficar esperando para sempre.
-            const char* cmd = "GET DATA\n"; 
-            ssize_t written = write(fd, cmd, strlen(cmd));
-            
-            if (written < 0) {
-                // Erro: Cabo desconectado durante a escrita
-                ALOGE("Erro de escrita (Cabo desconectado?): %s", strerror(errno));
-                close(fd); 
-                fd = -1;
-                continue; // Volta para o loop de busca
+        // B. POLLING ("GET DATA [alvo]") enquanto a estação não estiver em stream:
+        // só os sub-sensores em uso, cada um no seu ritmo (no máximo 1Hz,
+        // o firmware só atualiza os sensores nesse ritmo)
+        bool lost = false;
+        std::string pollCmd;
+        while (!mStream.streaming() && mPoll.nextRequest(targetsMs, now, &pollCmd)) {
+            if (!writeCommand(mFd, pollCmd)) {
+                lost = true;
+                break;
             }
         }
+        if (lost) {
+            closeDevice();
+            continue; // Volta para a busca do dispositivo
+        }
 
-        // B. LER A RESPOSTA (Loop de leitura com timeout)
-        // O read() vai esperar até 0.5s (VTIME) pelos dados
-        // Mesmo que mPollingActive seja false, podemos ler para limpar o buffer
-        memset(rxBuffer, 0, sizeof(rxBuffer));
-        int n = read(fd, rxBuffer, sizeof(rxBuffer) - 1);
+        // C. ESPERAR EVENTOS
+        // O reator chama de volta quando chegam bytes, quando é hora do próximo
+        // pedido, no timeout do ack/watchdog do stream ou num wake() de
+        // stop()/setPollingActive()/setSamplingPeriodNs(). Em stream sem
+        // pendência só os bytes da estação acordam o leitor.
+        int64_t wakeupMs = mStream.wakeupMs();
+        if (!mStream.streaming()) wakeupMs = std::min(wakeupMs, mPoll.wakeupMs());
+        mReactor.watch(this, mFd, EPOLLIN);
+        mReactor.schedule(this, wakeupMs == INT64_MAX ? -1 : wakeupMs);
+        return;
+    }
+}
+
+void SerialReader::readAvailable() {
+    // D. LER A RESPOSTA
+    // Drena tudo o que está disponível; cada linha/quadro é processado
+    // assim que chega, sem esperar o próximo ciclo. O carimbo de chegada
+    // é tirado logo após o read(), antes de qualquer parse.
+    while (true) {
+        bool binary = mFormat == WireFormat::kBinary;
+        ssize_t n = binary ? read(mFd, mDecoder.writePtr(), mDecoder.writable())
+                           : read(mFd, mFramer.writePtr(), mFramer.writable());
 
         if (n > 0) {
-            rxBuffer[n] = 0;
-            lineBuffer += rxBuffer;
-
-            // Debug Opcional: ver o que chegou cru
-            ALOGD("[RAW] %s", rxBuffer);
-
-            // Processar linhas completas
-            size_t pos;
-            while ((pos = lineBuffer.find('\n')) != std::string::npos) {
-                std::string line = lineBuffer.substr(0, pos);
-                lineBuffer.erase(0, pos + 1);
-
-                // Limpeza de caracteres
-                if (!line.empty() && line.back() == '\r') line.pop_back();
-
-                if (!line.empty()) {
-                    ALOGD("[JSON] %s", line.c_str());
-                    AirData data = JsonParser::parse(line);
-                    
-                    if (data.valid) {
-                        std::lock_guard<std::mutex> lock(mListenerLock);
-                        if (mListener) mListener->onDataReceived(data);
-                    }
-                }
+            int64_t arrivalNs = android::elapsedRealtimeNano();
+            if (binary) {
+                mDecoder.commit(n, arrivalNs);
+            } else {
+                mFramer.commit(n, arrivalNs);
+                processLines(mFramer, mDecoder);
             }
-        } 
-        else if (n < 0) {
-             ALOGE("Erro fatal de leitura. Reiniciando conexão...");
-             close(fd);
-             fd = -1;
+            // Também cobre o resto do buffer logo após o ack do modo binário
+            if (mFormat == WireFormat::kBinary) processFrames(mDecoder, mFramer);
+            continue;
         }
 
-        // --- ESTADO 4: RITMO ---
-        // Espera 1 segundo antes de pedir dados de novo (1Hz)
-        sleep(1);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) break;
+
+        // n == 0 (hangup) ou erro real
+        ALOGE("Erro fatal de leitura. Reiniciando conexão...");
+        closeDevice();
+        break;
     }
 
-    if (fd >= 0) close(fd);
-    ALOGI("Thread Serial Finalizada.");
-}
\ No newline at end of file
+    // Voltou ao JSON (boot): sobra no máximo um quadro parcial, inútil agora
+    if (mFormat == WireFormat::kJson) mDecoder.reset();
+}
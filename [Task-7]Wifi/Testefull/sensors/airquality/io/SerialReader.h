@@ -1,31 +1,105 @@
 #pragma once
 #include "IDataReader.h" // <--- Mudança Principal
+#include "AdaptiveRate.h"
+#include "DeviceClock.h"
+#include "HotplugMonitor.h"
+#include "IoReactor.h"
+#include "LineFramer.h"
+#include "PollSchedule.h"
+#include "StreamSession.h"
+#include "../utils/BinaryFrame.h"
+#include "../utils/MqConverter.h"
 #include <string>
-#include <thread>
 #include <atomic>
 #include <mutex>
 
-// Herda de IDataReader
-class SerialReader : public IDataReader {
+// Herda de IDataReader. O I/O roda no IoReactor compartilhado: start()/stop()
+// só registram o leitor, e cada onIoEvent() é uma volta da máquina de estados.
+// Sem dispositivo o leitor dorme até o HotplugMonitor avisar de uma porta nova.
+class SerialReader : public IDataReader, private IoReactor::Client, private HotplugMonitor::Listener {
 public:
-    SerialReader(const std::string& devicePath);
+    // devicePath é tentado primeiro; se não existir (e scanFallback), cai na
+    // varredura ttyUSB*/ttyACM*. Sem scanFallback o leitor fica preso à porta.
+    // hotplug: quem avisa das portas (nullptr = o do /dev)
+    SerialReader(const std::string& devicePath, bool scanFallback = true,
+                 HotplugMonitor* hotplug = nullptr);
     ~SerialReader();
 
     // Overrides obrigatórios
     void start() override;
     void stop() override;
     void setPollingActive(bool enabled) override;
+    void setSamplingPeriodNs(int64_t periodNs) override;
+    void setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) override;
     void setListener(IAirDataListener* listener) override;
 
+    // Mantém a porta aberta também em standby (stream desligado), para a
+    // estação se identificar antes de algum sensor dela ser ativado
+    void setStayConnected(bool enabled);
+
+    // Aumentos/reduções do período adaptativo e o período em uso
+    AdaptiveRate::Stats rateStats() const { return mRate.stats(); }
+
 private:
-    void workerThread();
+    // Buffer de recepção/enquadramento (maior linha aceita: kRxBufferSize - 1)
+    static constexpr size_t kRxBufferSize = 1024;
+
+    // Formato atual do fio. Começa em JSON; "SET FORMAT BIN" é pedido a cada
+    // conexão e o ack do firmware troca para quadros binários.
+    enum class WireFormat { kJson, kBinary };
+
+    // Lê o que chegou (events do epoll) e segue a máquina de estados
+    void onIoEvent(uint32_t events) override;
+    // Porta nova (thread do reator): tenta abrir agora, sem esperar prazo nenhum
+    void onPortAdded(const std::string& path) override;
+    // Standby/conexão/negociação/pedidos; termina dizendo ao reator pelo que esperar
+    void service();
+    // Acha, abre e configura o dispositivo; false = tentar de novo em *retryMs
+    // (-1 = só quando o hotplug avisar)
+    bool openDevice(int* retryMs);
+    void closeDevice();
+    // Drena o fd: cada linha/quadro é processado assim que chega
+    void readAvailable();
+    // Consome as linhas completas do framer (dados JSON e mensagens de controle)
+    void processLines(LineFramer<kRxBufferSize>& framer, BinaryFrameDecoder& decoder);
+    // Consome quadros do decoder; texto intercalado segue para o framer
+    void processFrames(BinaryFrameDecoder& decoder, LineFramer<kRxBufferSize>& framer);
+    // Converte os MQ crus e entrega ao listener
+    void deliver(AirData& data);
+    // device_id recebido (settings/boot); avisa o listener se mudou
+    void identify(const std::string& deviceId);
+    // Escreve um comando de texto; false se o dispositivo sumiu
+    bool writeCommand(int fd, const std::string& cmd);
     bool configureSerial(int fd);
     std::string findSerialDevice();
 
+    std::string mPreferredPath;
+    bool mScanFallback;
     std::string mDevicePath;
-    std::atomic<bool> mRunThread;
+    IoReactor& mReactor;
+    HotplugMonitor& mHotplug;
+    std::atomic<bool> mStarted;
+    std::atomic<bool> mPortAdded;  // aviso do hotplug ainda não visto pelo openDevice()
     std::atomic<bool> mPollingActive;
-    std::thread mThread;
+    std::atomic<bool> mStayConnected;
+    std::atomic<int> mPeriodMs; // período pedido pela HAL (já limitado)
+    std::atomic<int> mTargetPeriodMs[kStationTargets]; // 0 = fora de uso, -1 = segue mPeriodMs
     IAirDataListener* mListener;
     std::mutex mListenerLock;
-};
\ No newline at end of file
+
+    // Só acessados no onIoEvent() (ou com o leitor parado)
+    int mFd;
+    int64_t mNextOpenMs;  // depois de uma queda, a porta só é reaberta a partir daqui
+    LineFramer<kRxBufferSize> mFramer;
+    BinaryFrameDecoder mDecoder;
+    PollSchedule mPoll;
+    bool mWasStandby;
+    WireFormat mFormat;
+    bool mFormatRequested;
+    bool mSettingsRequested;
+    std::string mDeviceId;  // "" = a estação ainda não se identificou
+    StreamSession mStream;
+    AdaptiveRate mRate;  // mPeriodMs é o piso; transientes pedem mais rápido
+    DeviceClock mClock; // millis() da estação -> elapsedRealtimeNano
+    MqConversionStage mMq;  // mq2_raw/mq7_raw -> lpg_ppm/co_ppm
+};
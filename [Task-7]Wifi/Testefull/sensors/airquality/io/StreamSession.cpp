@@ -0,0 +1,88 @@
+#define LOG_TAG "AirQualityStream"
+
+#include "StreamSession.h"
+#include <log/log.h>
+
+#include <limits>
+
+StreamSession::StreamSession()
+    : mState(State::kIdle), mPeriodMs(0), mRequestedAtMs(0), mLastDataMs(0) {}
+
+void StreamSession::reset() {
+    mState = State::kIdle;
+    mPeriodMs = 0;
+    mTarget.clear();
+}
+
+int StreamSession::clampPeriodMs(int64_t periodMs) {
+    if (periodMs < kMinPeriodMs) return kMinPeriodMs;
+    if (periodMs > kMaxPeriodMs) return kMaxPeriodMs;
+    return static_cast<int>(periodMs);
+}
+
+bool StreamSession::nextCommand(int periodMs, int64_t nowMs, std::string* cmd, const char* target) {
+    if (periodMs <= 0) {
+        // HAL em standby: desliga o stream para a estação não transmitir à toa
+        if (mState == State::kRequested || mState == State::kStreaming) {
+            mState = State::kIdle;
+            *cmd = "STREAM OFF\n";
+            return true;
+        }
+        return false;
+    }
+
+    switch (mState) {
+        case State::kStreaming:
+            if (nowMs - mLastDataMs > watchdogMs()) {
+                ALOGW("Stream sem dados há %lld ms. Pedindo novamente...",
+                      static_cast<long long>(nowMs - mLastDataMs));
+                break;
+            }
+            if (periodMs == mPeriodMs && mTarget == (target ? target : "")) return false;
+            break;  // Novo período ou alvo: pede de novo
+
+        case State::kRequested:
+            if (nowMs - mRequestedAtMs < kAckTimeoutMs) return false;
+            ALOGI("Firmware não confirmou STREAM ON. Mantendo polling (GET DATA).");
+            mState = State::kUnsupported;
+            return false;
+
+        case State::kUnsupported:
+            return false;
+
+        case State::kIdle:
+            break;
+    }
+
+    mState = State::kRequested;
+    mPeriodMs = periodMs;
+    mTarget = target ? target : "";
+    mRequestedAtMs = nowMs;
+    *cmd = "STREAM ON " + std::to_string(periodMs) + (mTarget.empty() ? "" : " " + mTarget) + "\n";
+    return true;
+}
+
+void StreamSession::onAck(bool streaming, int64_t nowMs) {
+    if (!streaming) {
+        if (mState == State::kStreaming) mState = State::kIdle;
+        return;
+    }
+    // Ack atrasado (já em kUnsupported) também vale
+    if (mState == State::kRequested || mState == State::kUnsupported) {
+        ALOGI("Stream ativo (%d ms). Leitor em modo escuta.", mPeriodMs);
+        mState = State::kStreaming;
+        mLastDataMs = nowMs;
+    }
+}
+
+void StreamSession::onData(int64_t nowMs) {
+    mLastDataMs = nowMs;
+}
+
+int64_t StreamSession::wakeupMs() const {
+    switch (mState) {
+        case State::kRequested: return mRequestedAtMs + kAckTimeoutMs;
+        case State::kStreaming: return mLastDataMs + watchdogMs() + 1;
+        default:                return std::numeric_limits<int64_t>::max();
+    }
+}
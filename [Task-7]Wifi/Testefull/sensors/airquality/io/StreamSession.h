@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Negociação do modo push ("STREAM ON <period_ms> [alvo]") com fallback para polling
+ * ("GET DATA"), compartilhada por SerialReader e WifiReader.
+ *
+ * Não faz I/O: o leitor pergunta a cada volta do loop se há comando a enviar
+ * (nextCommand) e avisa acks e dados recebidos. Enquanto streaming() for
+ * false o leitor continua no polling, então um firmware sem STREAM (que
+ * ignora o comando) nunca deixa a HAL sem dados.
+ */
+class StreamSession {
+public:
+    // Limites aceitos pelo firmware (firmware_oficial / NotificationSimulator)
+    static constexpr int kMinPeriodMs = 100;
+    static constexpr int kMaxPeriodMs = 60000;
+
+    StreamSession();
+
+    /// Nova conexão ou firmware reiniciado: a estação não está transmitindo.
+    void reset();
+
+    /**
+     * Decide o próximo comando para o período desejado (0 = parar o stream).
+     * target: sub-sensor a transmitir (PollSchedule::streamTarget; nullptr = todos).
+     * Retorna true e preenche *cmd (já com '\n') se algo precisa ser enviado.
+     */
+    bool nextCommand(int periodMs, int64_t nowMs, std::string* cmd, const char* target = nullptr);
+
+    void onAck(bool streaming, int64_t nowMs);
+    void onData(int64_t nowMs);
+
+    /// true quando a estação confirmou o stream: o leitor não envia GET DATA.
+    bool streaming() const { return mState == State::kStreaming; }
+
+    /// Próximo instante (ms) em que nextCommand() pode mudar de ideia (INT64_MAX = nunca).
+    int64_t wakeupMs() const;
+
+    static int clampPeriodMs(int64_t periodMs);
+
+private:
+    enum class State {
+        kIdle,         // nada pedido
+        kRequested,    // STREAM ON enviado, esperando o ack
+        kStreaming,    // estação empurrando amostras
+        kUnsupported,  // sem ack: firmware antigo, fica no polling
+    };
+
+    // Tempo máximo pelo ack do STREAM ON
+    static constexpr int64_t kAckTimeoutMs = 2000;
+
+    int64_t watchdogMs() const { return 3 * static_cast<int64_t>(mPeriodMs) + kAckTimeoutMs; }
+
+    State mState;
+    int mPeriodMs;
+    std::string mTarget;  // "" = todos
+    int64_t mRequestedAtMs;
+    int64_t mLastDataMs;
+};
@@ -0,0 +1,514 @@
+#define LOG_TAG "AirQualityJournal"
+
+#include "TelemetryJournal.h"
+#include "../utils/BinaryFrame.h"
+
+#include <log/log.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Cabeçalho de cada segmento; os registros começam logo depois
+struct SegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t capacity;       // Registros
+    uint32_t reserved0;
+    uint64_t index;          // O <n> do nome
+    uint64_t firstSequence;  // 0 = reserva; gravado com release ao entrar em uso
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(SegmentHeader) == sizeof(JournalRecord), "cabeçalho = um registro");
+
+const size_t kHeaderSize = sizeof(SegmentHeader);
+const size_t kCrcBytes = offsetof(JournalRecord, commit);
+
+const char kNamePrefix[] = "telemetry-";
+const char kNameSuffix[] = ".jnl";
+
+std::string segmentName(uint64_t index) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s%016llx%s", kNamePrefix, static_cast<unsigned long long>(index),
+             kNameSuffix);
+    return name;
+}
+
+// false se o nome não é de segmento
+bool parseIndex(const char* name, uint64_t* index) {
+    unsigned long long value;
+    int end = 0;
+    if (sscanf(name, "telemetry-%16llx.jnl%n", &value, &end) != 1 || name[end] != '\0' ||
+        strlen(name) != segmentName(0).size()) {
+        return false;
+    }
+    *index = value;
+    return true;
+}
+
+bool validHeader(const SegmentHeader* header, size_t size) {
+    return size >= kHeaderSize && header->magic == TelemetryJournal::kMagic &&
+           header->version == TelemetryJournal::kVersion &&
+           header->recordSize == sizeof(JournalRecord) &&
+           size >= kHeaderSize + static_cast<size_t>(header->capacity) * sizeof(JournalRecord);
+}
+
+uint64_t loadFirstSequence(const uint8_t* base) {
+    return __atomic_load_n(&reinterpret_cast<const SegmentHeader*>(base)->firstSequence,
+                           __ATOMIC_ACQUIRE);
+}
+
+uint32_t commitWord(const JournalRecord& record) {
+    uint16_t crc = BinaryFrame::crc16(reinterpret_cast<const uint8_t*>(&record), kCrcBytes);
+    return (JournalRecord::kCommitMarker << 16) | crc;
+}
+
+// Registros válidos e em sequência no início do segmento
+size_t validRecords(const uint8_t* base) {
+    const SegmentHeader* header = reinterpret_cast<const SegmentHeader*>(base);
+    uint64_t first = loadFirstSequence(base);
+    if (first == 0) return 0;
+    const JournalRecord* records = reinterpret_cast<const JournalRecord*>(base + kHeaderSize);
+    for (size_t i = 0; i < header->capacity; i++) {
+        uint32_t commit = __atomic_load_n(&records[i].commit, __ATOMIC_ACQUIRE);
+        if (commit == 0 || commit != commitWord(records[i]) || records[i].sequence != first + i) {
+            return i;
+        }
+    }
+    return header->capacity;
+}
+
+// msync das páginas que cobrem [offset, offset + len)
+void syncRange(uint8_t* base, size_t offset, size_t len) {
+    static const size_t kPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / kPage * kPage;
+    if (msync(base + begin, offset + len - begin, MS_SYNC) != 0) {
+        ALOGW("msync do diário falhou: %s", strerror(errno));
+    }
+}
+
+}  // namespace
+
+AirData JournalRecord::toAirData() const {
+    AirData data;
+    data.timestamp = timestamp;
+    data.deviceMs = deviceMs;
+    data.pm25 = pm25;
+    data.pm10 = pm10;
+    data.co_ppm = co_ppm;
+    data.lpg_ppm = lpg_ppm;
+    data.temp_c = temp_c;
+    data.humid_p = humid_p;
+    data.mq2_raw = mq2_raw;
+    data.mq7_raw = mq7_raw;
+    data.source = source == kSourceWifi ? "wifi" : "serial";
+    data.station = station;
+    data.valid = true;
+    return data;
+}
+
+// ---- JournalSegment ----
+
+JournalSegment::~JournalSegment() {
+    if (mBase != nullptr) munmap(const_cast<uint8_t*>(mBase), mSize);
+}
+
+bool JournalSegment::open(const std::string& path) {
+    if (mBase != nullptr) munmap(const_cast<uint8_t*>(mBase), mSize);
+    mBase = nullptr;
+    mSize = 0;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderSize) {
+        base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);  // O mapeamento continua valendo
+    if (base == MAP_FAILED) return false;
+
+    if (!validHeader(static_cast<const SegmentHeader*>(base), st.st_size)) {
+        munmap(base, st.st_size);
+        return false;
+    }
+    mBase = static_cast<const uint8_t*>(base);
+    mSize = st.st_size;
+    return true;
+}
+
+uint64_t JournalSegment::firstSequence() const {
+    return mBase != nullptr ? loadFirstSequence(mBase) : 0;
+}
+
+size_t JournalSegment::capacity() const {
+    return mBase != nullptr ? reinterpret_cast<const SegmentHeader*>(mBase)->capacity : 0;
+}
+
+size_t JournalSegment::count() const {
+    return mBase != nullptr ? validRecords(mBase) : 0;
+}
+
+const JournalRecord* JournalSegment::records() const {
+    return mBase != nullptr ? reinterpret_cast<const JournalRecord*>(mBase + kHeaderSize) : nullptr;
+}
+
+// ---- TelemetryJournal ----
+
+TelemetryJournal::TelemetryJournal()
+    : mWritten(0), mNextSequence(1), mNextIndex(0), mRunning(false), mRotated(false), mCommitted(0),
+      mSyncedIndex(0), mSynced(0), mAppended(0), mSegments(0), mStalls(0), mSyncs(0),
+      mRemoved(0), mDrops(0) {}
+
+TelemetryJournal::~TelemetryJournal() {
+    close();
+}
+
+std::vector<std::string> TelemetryJournal::listSegments(const std::string& dir) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) return names;
+    while (struct dirent* entry = readdir(d)) {
+        uint64_t index;
+        if (parseIndex(entry->d_name, &index)) names.push_back(entry->d_name);
+    }
+    closedir(d);
+    // Índice em hexa de largura fixa: a ordem do nome é a de criação
+    std::sort(names.begin(), names.end());
+    for (auto& name : names) name = dir + "/" + name;
+    return names;
+}
+
+bool TelemetryJournal::mapSegment(const std::string& path, uint64_t index, bool create, Segment* out) {
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    int fd = ::open(path.c_str(), flags, 0660);
+    if (fd < 0) {
+        ALOGE("Diário: não abriu %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    size_t size;
+    if (create) {
+        size = kHeaderSize + mOptions.segmentRecords * sizeof(JournalRecord);
+        // Pré-aloca: o append nunca estende o arquivo nem esbarra em disco cheio
+        int err = ftruncate(fd, size) == 0 ? posix_fallocate(fd, 0, size) : errno;
+        if (err != 0 && err != EOPNOTSUPP && err != EINVAL) {
+            ALOGE("Diário: sem espaço para %s: %s", path.c_str(), strerror(err));
+            ::close(fd);
+            unlink(path.c_str());
+            return false;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = st.st_size;
+    }
+
+    // MAP_POPULATE: nenhum page fault depois, no append
+    void* base = size >= kHeaderSize
+            ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0)
+            : MAP_FAILED;
+    if (base == MAP_FAILED) {
+        ALOGE("Diário: mmap de %s falhou: %s", path.c_str(), strerror(errno));
+        ::close(fd);
+        if (create) unlink(path.c_str());
+        return false;
+    }
+
+    SegmentHeader* header = static_cast<SegmentHeader*>(base);
+    if (create) {
+        header->magic = kMagic;
+        header->version = kVersion;
+        header->recordSize = sizeof(JournalRecord);
+        header->capacity = static_cast<uint32_t>(mOptions.segmentRecords);
+        header->index = index;
+        header->firstSequence = 0;
+    } else if (!validHeader(header, size)) {
+        ALOGW("Diário: %s não é um segmento válido", path.c_str());
+        munmap(base, size);
+        ::close(fd);
+        return false;
+    }
+
+    out->fd = fd;
+    out->base = static_cast<uint8_t*>(base);
+    out->size = size;
+    out->capacity = header->capacity;
+    out->index = index;
+    out->path = path;
+    return true;
+}
+
+bool TelemetryJournal::createSegment(uint64_t index, Segment* out) {
+    return mapSegment(mDir + "/" + segmentName(index), index, true, out);
+}
+
+void TelemetryJournal::release(Segment* segment, bool syncFirst) {
+    if (segment->base == nullptr) return;
+    if (syncFirst) syncRange(segment->base, 0, segment->size);
+    munmap(segment->base, segment->size);
+    ::close(segment->fd);
+    *segment = Segment();
+}
+
+bool TelemetryJournal::open(const std::string& dir, const Options& options) {
+    close();
+    mDir = dir;
+    mOptions = options;
+    mOptions.segmentRecords = std::max<size_t>(1, std::min<size_t>(mOptions.segmentRecords, UINT32_MAX));
+    if (mkdir(dir.c_str(), 0770) != 0 && errno != EEXIST) {
+        ALOGE("Diário: não criou %s: %s", dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    // O mais novo em uso continua; reservas nunca usadas (queda antes da
+    // rotação) e segmentos sem cabeçalho (queda ao criar) saem
+    std::vector<std::string> segments = listSegments(dir);
+    mNextIndex = 0;
+    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+        uint64_t index;
+        parseIndex(it->c_str() + dir.size() + 1, &index);
+        mNextIndex = std::max(mNextIndex, index + 1);
+        if (mCurrent.base != nullptr) continue;
+
+        Segment segment;
+        if (!mapSegment(*it, index, false, &segment)) {
+            unlink(it->c_str());
+            continue;
+        }
+        if (loadFirstSequence(segment.base) == 0) {
+            release(&segment, false);
+            unlink(it->c_str());
+            continue;
+        }
+        mCurrent = segment;
+    }
+
+    if (mCurrent.base != nullptr) {
+        // Cauda: o primeiro registro inválido e o que vier depois dele são zerados
+        mWritten = validRecords(mCurrent.base);
+        size_t tail = kHeaderSize + mWritten * sizeof(JournalRecord);
+        memset(mCurrent.base + tail, 0, mCurrent.size - tail);
+        syncRange(mCurrent.base, tail, mCurrent.size - tail);
+        mNextSequence = loadFirstSequence(mCurrent.base) + mWritten;
+    } else {
+        if (!createSegment(mNextIndex++, &mCurrent)) return false;
+        mWritten = 0;
+        mNextSequence = 1;
+        __atomic_store_n(&reinterpret_cast<SegmentHeader*>(mCurrent.base)->firstSequence,
+                         mNextSequence, __ATOMIC_RELEASE);
+    }
+    mCommitted.store(mWritten, std::memory_order_relaxed);
+    mSyncedIndex = mCurrent.index;
+    mSynced = mWritten;
+    ALOGI("Diário em %s: segmento %llu, %zu registros, próxima sequência %llu", dir.c_str(),
+          static_cast<unsigned long long>(mCurrent.index), mWritten,
+          static_cast<unsigned long long>(mNextSequence));
+
+    mRunning = true;
+    if (mOptions.syncIntervalMs > 0) {
+        mThread = std::thread(&TelemetryJournal::syncThread, this);
+    }
+    return true;
+}
+
+void TelemetryJournal::close() {
+    if (!isOpen()) return;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = false;
+    }
+    mCv.notify_all();
+    if (mThread.joinable()) mThread.join();
+
+    sync();
+    release(&mCurrent, true);
+    if (mSpare.base != nullptr) {
+        std::string path = mSpare.path;
+        release(&mSpare, false);
+        unlink(path.c_str());
+    }
+    mSynced = 0;
+}
+
+void TelemetryJournal::append(const AirData& data) {
+    if (mWritten == mCurrent.capacity && !rotate()) {
+        mDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    JournalRecord* record = reinterpret_cast<JournalRecord*>(mCurrent.base + kHeaderSize) + mWritten;
+    record->sequence = mNextSequence;
+    record->timestamp = data.timestamp;
+    record->deviceMs = data.deviceMs;
+    record->pm25 = data.pm25;
+    record->pm10 = data.pm10;
+    record->co_ppm = data.co_ppm;
+    record->lpg_ppm = data.lpg_ppm;
+    record->temp_c = data.temp_c;
+    record->humid_p = data.humid_p;
+    record->mq2_raw = data.mq2_raw;
+    record->mq7_raw = data.mq7_raw;
+    record->station = static_cast<int16_t>(data.station);
+    record->source = data.source == "wifi" ? JournalRecord::kSourceWifi : JournalRecord::kSourceSerial;
+    record->reserved = 0;
+    // Commit por último: quem lê só confia no registro depois de vê-lo
+    __atomic_store_n(&record->commit, commitWord(*record), __ATOMIC_RELEASE);
+
+    mWritten++;
+    mNextSequence++;
+    mCommitted.store(mWritten, std::memory_order_release);
+    mAppended.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TelemetryJournal::rotate() {
+    Segment next;
+    uint64_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mSpare.base != nullptr) {
+            next = mSpare;
+            mSpare = Segment();
+        } else {
+            index = mNextIndex++;
+        }
+    }
+    if (next.base == nullptr) {
+        mStalls.fetch_add(1, std::memory_order_relaxed);
+        ALOGW("Diário: reserva não estava pronta, criando o segmento %llu no append",
+              static_cast<unsigned long long>(index));
+        if (!createSegment(index, &next)) return false;
+    }
+    __atomic_store_n(&reinterpret_cast<SegmentHeader*>(next.base)->firstSequence, mNextSequence,
+                     __ATOMIC_RELEASE);
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mSealed.push_back(mCurrent);
+        mCurrent = next;
+        mWritten = 0;
+        mCommitted.store(0, std::memory_order_relaxed);
+        mRotated = true;
+    }
+    mCv.notify_one();
+    mSegments.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TelemetryJournal::sync() {
+    std::vector<Segment> sealed;
+    uint8_t* base;
+    uint64_t index;
+    size_t committed;
+    bool needSpare;
+    uint64_t spareIndex = 0;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        sealed.swap(mSealed);
+        base = mCurrent.base;
+        index = mCurrent.index;
+        committed = mCommitted.load(std::memory_order_acquire);
+        // Ao fechar não precisa de reserva
+        needSpare = mSpare.base == nullptr && mRunning;
+        if (needSpare) spareIndex = mNextIndex++;
+    }
+
+    // Só esta thread desmapeia: o mCurrent lido acima continua mapeado
+    for (Segment& segment : sealed) release(&segment, true);
+    if (base != nullptr) {
+        if (index != mSyncedIndex) {
+            mSyncedIndex = index;
+            mSynced = 0;
+        }
+        if (committed > mSynced) {
+            syncRange(base, kHeaderSize + mSynced * sizeof(JournalRecord),
+                      (committed - mSynced) * sizeof(JournalRecord));
+            mSynced = committed;
+        }
+    }
+
+    if (needSpare) {
+        Segment spare;
+        if (createSegment(spareIndex, &spare)) {
+            std::lock_guard<std::mutex> lock(mLock);
+            // Um stall no meio já criou um segmento mais novo: esta ficou para trás
+            if (mSpare.base == nullptr && spare.index > mCurrent.index) {
+                mSpare = spare;
+            } else {
+                std::string path = spare.path;
+                release(&spare, false);
+                unlink(path.c_str());
+            }
+        }
+    }
+
+    enforceCap();
+    mSyncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TelemetryJournal::enforceCap() {
+    uint64_t currentIndex;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        currentIndex = mCurrent.index;
+    }
+
+    std::vector<std::string> segments = listSegments(mDir);
+    std::vector<size_t> sizes;
+    size_t total = 0;
+    for (const auto& path : segments) {
+        struct stat st;
+        sizes.push_back(stat(path.c_str(), &st) == 0 ? st.st_size : 0);
+        total += sizes.back();
+    }
+    // Dos mais velhos para os mais novos; o atual e a reserva nunca saem
+    for (size_t i = 0; i < segments.size() && total > mOptions.maxBytes; i++) {
+        uint64_t index;
+        parseIndex(segments[i].c_str() + mDir.size() + 1, &index);
+        if (index >= currentIndex) break;
+        if (unlink(segments[i].c_str()) == 0) {
+            total -= sizes[i];
+            mRemoved.fetch_add(1, std::memory_order_relaxed);
+            ALOGD("Diário: %s apagado pelo teto", segments[i].c_str());
+        }
+    }
+}
+
+void TelemetryJournal::syncThread() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (mRunning) {
+        mCv.wait_for(lock, std::chrono::milliseconds(mOptions.syncIntervalMs),
+                     [this] { return !mRunning || mRotated; });
+        if (!mRunning) break;
+        mRotated = false;
+        lock.unlock();
+        sync();
+        lock.lock();
+    }
+}
+
+TelemetryJournal::Stats TelemetryJournal::stats() const {
+    Stats stats;
+    stats.appended = mAppended.load(std::memory_order_relaxed);
+    stats.segments = mSegments.load(std::memory_order_relaxed);
+    stats.stalls = mStalls.load(std::memory_order_relaxed);
+    stats.syncs = mSyncs.load(std::memory_order_relaxed);
+    stats.removed = mRemoved.load(std::memory_order_relaxed);
+    stats.drops = mDrops.load(std::memory_order_relaxed);
+    return stats;
+}
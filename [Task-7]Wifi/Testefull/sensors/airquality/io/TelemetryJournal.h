@@ -0,0 +1,191 @@
+#pragma once
+
+#include "../utils/AirData.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Um registro do diário: uma amostra do AirData, 64 bytes (uma linha de cache).
+struct JournalRecord {
+    uint64_t sequence;  // 1, 2, ... contínua entre os segmentos
+    int64_t timestamp;  // AirData::timestamp (ns, elapsedRealtimeNano)
+    int64_t deviceMs;
+    float pm25;
+    float pm10;
+    float co_ppm;
+    float lpg_ppm;
+    float temp_c;
+    float humid_p;
+    float mq2_raw;
+    float mq7_raw;
+    int16_t station;
+    uint8_t source;     // JournalRecord::kSourceSerial / kSourceWifi
+    uint8_t reserved;
+    // Por último: (kCommitMarker << 16) | CRC16 dos bytes anteriores.
+    // Zero (arquivo pré-alocado) ou CRC errado = registro não escrito
+    uint32_t commit;
+
+    static constexpr uint8_t kSourceSerial = 0;
+    static constexpr uint8_t kSourceWifi = 1;
+    static constexpr uint32_t kCommitMarker = 0x5AA5;
+
+    AirData toAirData() const;
+};
+
+static_assert(sizeof(JournalRecord) == 64, "JournalRecord mudou de tamanho");
+
+/**
+ * Leitura zero-cópia de um segmento do diário: o arquivo é mapeado só para
+ * leitura e os registros são lidos direto do mapeamento. Pode ser aberto
+ * enquanto o TelemetryJournal escreve nele (também de outro processo): o
+ * commit de cada registro é gravado por último, com release.
+ */
+class JournalSegment {
+public:
+    JournalSegment() : mBase(nullptr), mSize(0) {}
+    ~JournalSegment();
+
+    JournalSegment(const JournalSegment&) = delete;
+    JournalSegment& operator=(const JournalSegment&) = delete;
+
+    /// false se o arquivo não existe, não mapeia ou não é um segmento.
+    bool open(const std::string& path);
+
+    uint64_t firstSequence() const;  // 0 = segmento reserva ainda não usado
+    size_t capacity() const;
+
+    /**
+     * Registros válidos no início do segmento: param no primeiro sem commit,
+     * com CRC errado ou fora de sequência (a cauda de uma queda).
+     */
+    size_t count() const;
+    const JournalRecord* records() const;
+
+private:
+    const uint8_t* mBase;
+    size_t mSize;
+};
+
+/**
+ * Diário de telemetria da SubHAL: toda amostra entregue vira um registro de
+ * tamanho fixo, para quem estava desligado ler depois o que perdeu.
+ *
+ * Os registros ficam em segmentos (arquivos "telemetry-<n>.jnl" no
+ * diretório), pré-alocados e mapeados com MAP_SHARED: append() só copia 64
+ * bytes para o mapeamento, sem syscall nem page fault (MAP_POPULATE). Uma
+ * queda do processo não perde nada (as páginas já estão no page cache); para
+ * uma queda do aparelho, a thread do diário faz msync a cada syncIntervalMs.
+ *
+ * A mesma thread deixa pronto o segmento seguinte (criado, pré-alocado e
+ * mapeado), então a rotação no append() é só trocar ponteiros; ela também
+ * fecha os segmentos cheios e apaga os mais velhos quando o total passa de
+ * maxBytes. Só se a reserva não estiver pronta o append() cria o segmento
+ * ele mesmo (contado em Stats::stalls).
+ *
+ * Na abertura, o segmento mais novo é varrido até o primeiro registro
+ * inválido; a escrita continua dali e o resto dele é zerado.
+ *
+ * Um escritor só (a thread de despacho, com mSensorsLock da SubHAL);
+ * stats() de qualquer thread.
+ */
+class TelemetryJournal {
+public:
+    struct Options {
+        size_t segmentRecords = 16384;  // 1 MiB de registros por segmento
+        size_t maxBytes = 64 << 20;     // Teto dos segmentos no diretório
+        int syncIntervalMs = 5000;      // 0 = sem thread: quem usa chama sync()
+    };
+
+    struct Stats {
+        uint64_t appended;
+        uint64_t segments;  // Rotações
+        uint64_t stalls;    // Rotações sem reserva pronta (syscalls no append)
+        uint64_t syncs;
+        uint64_t removed;   // Segmentos apagados pelo teto
+        uint64_t drops;     // Amostras perdidas sem segmento (disco cheio)
+    };
+
+    static constexpr uint32_t kMagic = 0x314A5141;  // "AQJ1"
+    static constexpr uint16_t kVersion = 1;
+
+    TelemetryJournal();
+    ~TelemetryJournal();
+
+    TelemetryJournal(const TelemetryJournal&) = delete;
+    TelemetryJournal& operator=(const TelemetryJournal&) = delete;
+
+    /// Cria o diretório se preciso e recupera a cauda. false = diário desligado.
+    bool open(const std::string& dir, const Options& options);
+    bool open(const std::string& dir) { return open(dir, Options()); }
+    /// Sincroniza tudo e desmapeia.
+    void close();
+    bool isOpen() const { return mCurrent.base != nullptr; }
+
+    /// Sem syscall (salvo um stall na rotação).
+    void append(const AirData& data);
+
+    /// msync do que foi escrito, fecha os segmentos cheios, prepara a
+    /// reserva e aplica o teto. Na thread do diário; sem ela, de quem usa.
+    void sync();
+
+    /// Próxima sequência a escrever (a última escrita + 1).
+    uint64_t nextSequence() const { return mNextSequence; }
+    Stats stats() const;
+
+    /// Segmentos do diretório, do mais velho para o mais novo.
+    static std::vector<std::string> listSegments(const std::string& dir);
+
+private:
+    struct Segment {
+        int fd = -1;
+        uint8_t* base = nullptr;
+        size_t size = 0;
+        size_t capacity = 0;
+        uint64_t index = 0;
+        std::string path;
+    };
+
+    bool createSegment(uint64_t index, Segment* out);
+    bool mapSegment(const std::string& path, uint64_t index, bool create, Segment* out);
+    static void release(Segment* segment, bool syncFirst);
+    // Passa a escrever na reserva (ou num segmento novo); false = sem espaço
+    bool rotate();
+    void enforceCap();
+    void syncThread();
+
+    std::string mDir;
+    Options mOptions;
+
+    // Do escritor
+    Segment mCurrent;
+    size_t mWritten;  // Registros no mCurrent
+    uint64_t mNextSequence;
+
+    // Entre o escritor e a thread do diário
+    std::mutex mLock;
+    std::condition_variable mCv;
+    Segment mSpare;                // base == nullptr: ainda não pronta
+    std::vector<Segment> mSealed;  // Cheios, esperando o último msync
+    uint64_t mNextIndex;           // Índice do próximo segmento a criar
+    bool mRunning;                 // Aberto (com ou sem thread)
+    bool mRotated;                 // Acorda a thread do diário antes do prazo
+    std::thread mThread;
+
+    // Da thread do diário: até onde o mCurrent já foi sincronizado
+    std::atomic<size_t> mCommitted;
+    uint64_t mSyncedIndex;
+    size_t mSynced;
+
+    std::atomic<uint64_t> mAppended;
+    std::atomic<uint64_t> mSegments;
+    std::atomic<uint64_t> mStalls;
+    std::atomic<uint64_t> mSyncs;
+    std::atomic<uint64_t> mRemoved;
+    std::atomic<uint64_t> mDrops;
+};
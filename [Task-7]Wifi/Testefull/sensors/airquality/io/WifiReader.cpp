@@ -2,16 +2,50 @@
 #include "WifiReader.h"
 #include "../utils/JsonParser.h"
 #include <log/log.h>
+#include <utils/SystemClock.h>  // Para android::elapsedRealtimeNano()
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <algorithm>
+#include <chrono>
+
+// Período padrão dos pedidos "GET DATA" sem stream (1Hz)
+static const int kPollPeriodMs = 1000;
+// Prazo do connect(): o ESP32 na mesma rede responde em poucos ms
+static const int kConnectTimeoutMs = 3000;
+// Keepalive: conexão ociosa sondada após 10s, 3 sondas a cada 5s (~25s até cair)
+static const int kKeepIdleSec = 10;
+static const int kKeepIntvlSec = 5;
+static const int kKeepCount = 3;
+// Menor mensagem da estação: com o framer vazio não adianta acordar antes
+// disso (o ESP32 costuma mandar o JSON picado em vários segmentos)
+static const int kMinMessageBytes = 24;
+
+static int64_t monotonicMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
 
 WifiReader::WifiReader(const std::string& ip, int port)
-    : mTargetIp(ip), mTargetPort(port), mRunThread(false), mActive(false), mListener(nullptr) {}
+    : mTargetIp(ip), mTargetPort(port), mReactor(IoReactor::instance()), mStarted(false),
+      mActive(false), mWarmStandby(false), mPeriodMs(kPollPeriodMs), mListener(nullptr),
+      mConnected(false), mConnects(0), mConnectFailures(0), mDisconnects(0),
+      mLastReconnectMs(-1), mMaxReconnectMs(-1),
+      mSockFd(-1), mConnecting(false), mConnectDeadlineMs(0),
+      mRng(static_cast<uint32_t>(android::elapsedRealtimeNano())), mFailures(0), mGotData(false),
+      mNextConnectMs(0), mDownSinceMs(-1), mWasStandby(true), mSettingsRequested(false),
+      mRcvLowat(1) {
+    for (auto& periodMs : mTargetPeriodMs) periodMs = -1;
+}
 
-WifiReader::~WifiReader() { stop(); }
+WifiReader::~WifiReader() {
+    stop();
+}
 
 void WifiReader::setListener(IAirDataListener* listener) {
     std::lock_guard<std::mutex> lock(mListenerLock);
@@ -19,92 +53,373 @@ void WifiReader::setListener(IAirDataListener* listener) {
 }
 
 void WifiReader::setPollingActive(bool enabled) {
-    mActive = enabled;
-    ALOGD("WifiReader: Status %s", enabled ? "ATIVO" : "STANDBY");
+    if (mActive.exchange(enabled) != enabled) {
+        ALOGD("WifiReader: Status %s", enabled ? "ATIVO" : "STANDBY");
+        mReactor.wake(this);
+    }
+}
+
+void WifiReader::setSamplingPeriodNs(int64_t periodNs) {
+    int periodMs = StreamSession::clampPeriodMs(periodNs / 1000000);
+    if (mPeriodMs.exchange(periodMs) != periodMs) mReactor.wake(this);
+}
+
+void WifiReader::setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) {
+    bool changed = false;
+    for (int t = 0; t < kStationTargets; t++) {
+        int periodMs = periodsNs[t] <= 0 ? 0 : StreamSession::clampPeriodMs(periodsNs[t] / 1000000);
+        changed |= mTargetPeriodMs[t].exchange(periodMs) != periodMs;
+    }
+    if (changed) mReactor.wake(this);
+}
+
+void WifiReader::setWarmStandby(bool enabled) {
+    if (mWarmStandby.exchange(enabled) != enabled) mReactor.wake(this);
+}
+
+WifiReader::Stats WifiReader::stats() const {
+    Stats stats;
+    stats.connected = mConnected;
+    stats.connects = mConnects;
+    stats.connectFailures = mConnectFailures;
+    stats.disconnects = mDisconnects;
+    stats.lastReconnectMs = mLastReconnectMs;
+    stats.maxReconnectMs = mMaxReconnectMs;
+    return stats;
+}
+
+int64_t WifiReader::reconnectDelayMs(int failures, uint32_t random) {
+    if (failures <= 0) return 0;
+    int64_t ceiling = kBackoffBaseMs << std::min(failures - 1, 20);
+    ceiling = std::min(ceiling, kBackoffMaxMs);
+    // "Equal jitter": nunca menos que a metade, e estações reiniciadas juntas
+    // não voltam todas no mesmo instante
+    int64_t half = ceiling / 2;
+    return half + static_cast<int64_t>(random % static_cast<uint32_t>(half + 1));
 }
 
 void WifiReader::start() {
-    if (mRunThread) return;
-    mRunThread = true;
-    mThread = std::thread(&WifiReader::workerThread, this);
+    if (mStarted.exchange(true)) return;
+    mReactor.attach(this);
 }
 
 void WifiReader::stop() {
-    mRunThread = false;
-    if (mThread.joinable()) mThread.join();
+    if (!mStarted.exchange(false)) return;
+    // Depois do detach() nenhum onIoEvent() está rodando: o estado é nosso.
+    // Um connect() pendente é só fechado (interrompido, não é falha).
+    mReactor.detach(this);
+    if (mSockFd >= 0) closeConnection();
+    mConnecting = false;
+    mDownSinceMs = -1;
+    mWasStandby = true;
 }
 
-bool WifiReader::connectToServer(int& sockFd) {
-    sockFd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockFd < 0) return false;
-
+bool WifiReader::startConnect() {
     struct sockaddr_in serv_addr;
     memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
     serv_addr.sin_port = htons(mTargetPort);
-    inet_pton(AF_INET, mTargetIp.c_str(), &serv_addr.sin_addr);
+    if (inet_pton(AF_INET, mTargetIp.c_str(), &serv_addr.sin_addr) != 1) {
+        ALOGE("IP inválido: %s", mTargetIp.c_str());
+        return false;
+    }
 
-    // Timeout de 2s
-    struct timeval tv; tv.tv_sec = 2; tv.tv_usec = 0;
-    setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(sockFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    mSockFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mSockFd < 0) {
+        ALOGE("Erro socket: %s", strerror(errno));
+        return false;
+    }
 
     ALOGI("Conectando a %s:%d...", mTargetIp.c_str(), mTargetPort);
-    if (connect(sockFd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+    if (connect(mSockFd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) == 0) {
+        finishConnect(0);
+        return true;
+    }
+    if (errno != EINPROGRESS && errno != EINTR) {
         ALOGE("Erro conexao: %s", strerror(errno));
-        close(sockFd);
+        close(mSockFd);
+        mSockFd = -1;
         return false;
     }
+
+    // Handshake em andamento: o reator chama de volta quando o socket ficar
+    // gravável; o prazo vence no service() e stop()/standby interrompem
+    mConnecting = true;
+    mConnectDeadlineMs = monotonicMs() + kConnectTimeoutMs;
+    mReactor.watch(this, mSockFd, EPOLLOUT);
+    return true;
+}
+
+void WifiReader::finishConnect(int err) {
+    mConnecting = false;
+    if (err != 0) {
+        ALOGE("Erro conexao: %s", strerror(err));
+        mReactor.watch(this, -1, 0);
+        close(mSockFd);
+        mSockFd = -1;
+        connectFailed();
+        return;
+    }
+
+    configureSocket(mSockFd);
     ALOGI(">>> CONECTADO VIA WI-FI <<<");
+    int64_t latencyMs = monotonicMs() - mDownSinceMs;
+    mLastReconnectMs = latencyMs;
+    if (latencyMs > mMaxReconnectMs) mMaxReconnectMs = latencyMs;
+    mConnects++;
+    mConnected = true;
+    mDownSinceMs = -1;
+    mGotData = false;
+    mSettingsRequested = false;
+    mWasStandby = true;
+}
+
+void WifiReader::connectFailed() {
+    mConnectFailures++;
+    mFailures++;
+    mNextConnectMs = monotonicMs() + reconnectDelayMs(mFailures, mRng());
+}
+
+void WifiReader::connectionLost() {
+    ALOGW("Conexão Wi-Fi perdida. Reconectando...");
+    closeConnection();
+    mDisconnects++;
+    // Conexão que caiu sem entregar nada conta como falha (estação que
+    // aceita e derruba não vira um laço de reconexões)
+    if (mGotData) {
+        mFailures = 0;
+    } else {
+        mFailures++;
+    }
+    mNextConnectMs = monotonicMs() + reconnectDelayMs(mFailures, mRng());
+}
+
+void WifiReader::configureSocket(int sockFd) {
+    // Comandos são linhas curtas: sem Nagle o "GET DATA" não espera o ACK anterior
+    int one = 1;
+    setsockopt(sockFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // Keepalive: sem ele uma estação desligada (sem FIN) só seria notada no
+    // próximo send, e em stream o leitor só escuta
+    setsockopt(sockFd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    int idle = kKeepIdleSec, intvl = kKeepIntvlSec, count = kKeepCount;
+    setsockopt(sockFd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(sockFd, IPPROTO_TCP, TCP_KEEPINTVL, &intvl, sizeof(intvl));
+    setsockopt(sockFd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+
+    mRcvLowat = 1;
+    tuneRcvLowat(sockFd, false);
+}
+
+void WifiReader::tuneRcvLowat(int sockFd, bool partialLine) {
+    // Com uma linha pela metade qualquer byte pode completá-la; sem ela, o
+    // poll() só acorda quando chegou pelo menos uma mensagem mínima
+    int lowat = partialLine ? 1 : kMinMessageBytes;
+    if (lowat == mRcvLowat) return;
+    if (setsockopt(sockFd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat)) == 0) {
+        mRcvLowat = lowat;
+    }
+}
+
+bool WifiReader::sendCommand(int sockFd, const std::string& cmd) {
+    ssize_t sent = send(sockFd, cmd.data(), cmd.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno != EAGAIN && errno != EINTR) {
+        ALOGE("Erro de envio (conexão caiu?): %s", strerror(errno));
+        return false;
+    }
     return true;
 }
 
-void WifiReader::workerThread() {
-    int sockFd = -1;
-    char rxBuffer[1024];
-    std::string lineBuffer;
+void WifiReader::closeConnection() {
+    mReactor.watch(this, -1, 0);
+    close(mSockFd);
+    mSockFd = -1;
+    mConnected = false;
+    if (mDeviceId.empty()) return;
+    mDeviceId.clear();
+    std::lock_guard<std::mutex> lock(mListenerLock);
+    if (mListener) mListener->onStationLost();
+}
 
-    while (mRunThread) {
+void WifiReader::identify(const std::string& deviceId) {
+    if (deviceId.empty() || deviceId == mDeviceId) return;
+    ALOGI("Estação em %s:%d: %s", mTargetIp.c_str(), mTargetPort, deviceId.c_str());
+    mDeviceId = deviceId;
+    std::lock_guard<std::mutex> lock(mListenerLock);
+    if (mListener) mListener->onStationIdentified(deviceId);
+}
+
+bool WifiReader::handleLine(std::string_view line, int64_t arrivalNs) {
+    AirData data = JsonParser::parse(line, arrivalNs);
+    if (data.valid) {
+        if (data.deviceMs >= 0) data.timestamp = mClock.toLocalNs(data.deviceMs, arrivalNs);
+        mMq.apply(&data);
+        int64_t now = monotonicMs();
+        mStream.onData(now);
+        mRate.onSample(data, now);
+        std::lock_guard<std::mutex> lock(mListenerLock);
+        if (mListener) mListener->onDataReceived(data);
+        return true;
+    }
+
+    std::string deviceId;
+    switch (JsonParser::parseControl(line, &deviceId)) {
+        case JsonParser::Control::kStreamOn:  mStream.onAck(true, monotonicMs()); break;
+        case JsonParser::Control::kStreamOff: mStream.onAck(false, monotonicMs()); break;
+        case JsonParser::Control::kBoot:      mStream.reset(); mClock.reset(); identify(deviceId); break;
+        case JsonParser::Control::kSettings:  identify(deviceId); break;
+        default: break;
+    }
+    return false;
+}
+
+void WifiReader::onIoEvent(uint32_t events) {
+    if (mConnecting && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(mSockFd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+        finishConnect(err);
+    } else if (!mConnecting && mSockFd >= 0 && (events & (EPOLLIN | EPOLLERR | EPOLLHUP))) {
+        readAvailable();
+    }
+    service();
+}
+
+void WifiReader::readAvailable() {
+    // Drena o socket; cada linha é processada assim que chega
+    while (true) {
+        ssize_t n = recv(mSockFd, mFramer.writePtr(), mFramer.writable(), 0);
+        if (n > 0) {
+            mFramer.commit(n, android::elapsedRealtimeNano());
+            std::string_view line;
+            int64_t arrivalNs;
+            while (mFramer.nextLine(&line, &arrivalNs)) {
+                if (handleLine(line, arrivalNs)) {
+                    mGotData = true;
+                    mFailures = 0;
+                }
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            tuneRcvLowat(mSockFd, mFramer.hasPartialLine());
+            return;
+        }
+        // n == 0 (estação fechou) ou erro real (RST, keepalive esgotado)
+        if (n < 0) ALOGE("Erro recv: %s", strerror(errno));
+        connectionLost();
+        return;
+    }
+}
+
+void WifiReader::service() {
+    // Cada "continue" é uma nova volta imediata; as esperas viram
+    // watch()/schedule() e um return
+    while (mStarted) {
+        // --- STANDBY ---
+        // Desliga o stream da estação; a conexão só continua aberta em warm standby.
+        // Sem fd vigiado e sem prazo: setPollingActive()/setWarmStandby()/stop() chamam de volta.
         if (!mActive) {
-            if (sockFd >= 0) { close(sockFd); sockFd = -1; }
-            sleep(1); continue;
+            if (mConnecting) {
+                // Interrompido, não é falha
+                mConnecting = false;
+                closeConnection();
+            }
+            if (mSockFd >= 0) {
+                std::string cmd;
+                if (mStream.nextCommand(0, monotonicMs(), &cmd)) sendCommand(mSockFd, cmd);
+                if (!mWarmStandby) {
+                    ALOGI("Standby: fechando a conexão");
+                    closeConnection();
+                }
+            }
+            mDownSinceMs = -1;
+            mWasStandby = true;
+            mReactor.watch(this, -1, 0);
+            mReactor.schedule(this, -1);
+            return;
         }
 
-        if (sockFd < 0) {
-            if (!connectToServer(sockFd)) { sleep(2); continue; }
+        int64_t now = monotonicMs();
+
+        // --- CONEXÃO ---
+        if (mConnecting) {
+            if (now >= mConnectDeadlineMs) {
+                finishConnect(ETIMEDOUT);
+                continue;
+            }
+            mReactor.schedule(this, mConnectDeadlineMs);
+            return;
+        }
+        if (mSockFd < 0) {
+            if (mDownSinceMs < 0) mDownSinceMs = now;
+            if (now < mNextConnectMs) {
+                mReactor.schedule(this, mNextConnectMs);
+                return;
+            }
+            if (!startConnect()) connectFailed();
+            continue;
         }
 
-        // Envia Polling
-        const char* cmd = "GET DATA\n";
-        if (send(sockFd, cmd, strlen(cmd), MSG_NOSIGNAL) < 0) {
-            close(sockFd); sockFd = -1; continue;
+        if (mWasStandby) {
+            // Descarta o que chegou enquanto estávamos parados; um hangup
+            // durante o standby aparece aqui e já reconecta
+            char scratch[256];
+            ssize_t n;
+            while ((n = recv(mSockFd, scratch, sizeof(scratch), 0)) > 0) {}
+            if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                ALOGW("Conexão perdida durante o standby. Reconectando...");
+                closeConnection();
+                mDisconnects++;
+                mNextConnectMs = 0;
+                continue;
+            }
+            mFramer.reset();
+            mStream.reset();
+            mRate.reset();
+            mClock.reset();
+            mMq.reset();
+            tuneRcvLowat(mSockFd, false);
+            mPoll.reset();
+            mWasStandby = false;
         }
 
-        // Lê Resposta
-        memset(rxBuffer, 0, sizeof(rxBuffer));
-        int n = recv(sockFd, rxBuffer, sizeof(rxBuffer)-1, 0);
+        // --- COMUNICAÇÃO ---
+        // A. Identificação (uma vez por conexão) e o modo push; firmware sem
+        // suporte ao stream ignora e seguimos no polling
+        int periodMs = mRate.periodMs(mPeriodMs, now);
+        int targetsMs[kStationTargets];
+        for (int t = 0; t < kStationTargets; t++) {
+            int targetMs = mTargetPeriodMs[t];
+            targetsMs[t] = targetMs < 0 ? periodMs : targetMs;
+        }
+        std::string streamCmd;
+        bool ok = true;
+        if (!mSettingsRequested) {
+            ok = sendCommand(mSockFd, "GET SETTINGS\n");
+            mSettingsRequested = true;
+        }
+        if (ok && mStream.nextCommand(periodMs, now, &streamCmd, PollSchedule::streamTarget(targetsMs))) {
+            ok = sendCommand(mSockFd, streamCmd);
+        }
 
-        if (n > 0) {
-            rxBuffer[n] = 0;
-            lineBuffer += rxBuffer;
-            size_t pos;
-            while ((pos = lineBuffer.find('\n')) != std::string::npos) {
-                std::string line = lineBuffer.substr(0, pos);
-                lineBuffer.erase(0, pos + 1);
-                if (!line.empty() && line.back() == '\r') line.pop_back();
-                
-                if (!line.empty()) {
-                    AirData data = JsonParser::parse(line);
-                    if (data.valid) {
-                        std::lock_guard<std::mutex> lock(mListenerLock);
-                        if (mListener) mListener->onDataReceived(data);
-                    }
-                }
-            }
-        } else if (n == 0) {
-            close(sockFd); sockFd = -1;
+        // B. Polling ("GET DATA [alvo]") só sem stream: os sub-sensores em uso,
+        // cada um no seu ritmo, no máximo a 1Hz
+        std::string pollCmd;
+        while (ok && !mStream.streaming() && mPoll.nextRequest(targetsMs, now, &pollCmd)) {
+            ok = sendCommand(mSockFd, pollCmd);
+        }
+        if (!ok) {
+            connectionLost();
+            continue;
         }
-        sleep(1); // 1Hz Polling
+
+        // C. Espera bytes, o próximo pedido, o timeout do stream ou um wake()
+        int64_t wakeupMs = mStream.wakeupMs();
+        if (!mStream.streaming()) wakeupMs = std::min(wakeupMs, mPoll.wakeupMs());
+        mReactor.watch(this, mSockFd, EPOLLIN);
+        mReactor.schedule(this, wakeupMs == INT64_MAX ? -1 : wakeupMs);
+        return;
     }
-    if (sockFd >= 0) close(sockFd);
-}
\ No newline at end of file
+}
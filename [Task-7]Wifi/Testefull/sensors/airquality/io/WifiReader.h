@@ -1,30 +1,122 @@
 #pragma once
 #include "IDataReader.h"
+#include "AdaptiveRate.h"
+#include "DeviceClock.h"
+#include "IoReactor.h"
+#include "LineFramer.h"
+#include "PollSchedule.h"
+#include "StreamSession.h"
+#include "../utils/MqConverter.h"
 #include <string>
-#include <thread>
 #include <atomic>
 #include <mutex>
+#include <random>
 
-class WifiReader : public IDataReader {
+// O I/O roda no IoReactor compartilhado, como o do SerialReader
+class WifiReader : public IDataReader, private IoReactor::Client {
 public:
+    // Contadores da conexão TCP (lidos de qualquer thread)
+    struct Stats {
+        bool connected;
+        uint64_t connects;         // conexões estabelecidas
+        uint64_t connectFailures;  // tentativas recusadas, sem rota ou sem resposta no prazo
+        uint64_t disconnects;      // conexões perdidas (hangup, erro, keepalive)
+        int64_t lastReconnectMs;   // da queda (ou ativação) até conectar; -1 = nunca conectou
+        int64_t maxReconnectMs;
+    };
+
     WifiReader(const std::string& ip, int port);
     ~WifiReader();
 
     void start() override;
     void stop() override;
     void setPollingActive(bool enabled) override;
+    void setSamplingPeriodNs(int64_t periodNs) override;
+    void setTargetPeriodsNs(const TargetPeriodsNs& periodsNs) override;
     void setListener(IAirDataListener* listener) override;
 
+    // Mantém a conexão aberta em standby (só desliga o stream da estação):
+    // a reativação não paga o connect. Desligado por padrão, como o serial
+    // fechado libera a estação para outro cliente.
+    void setWarmStandby(bool enabled);
+
+    Stats stats() const;
+    // Aumentos/reduções do período adaptativo e o período em uso
+    AdaptiveRate::Stats rateStats() const { return mRate.stats(); }
+
+    // Espera antes da próxima tentativa depois de `failures` falhas seguidas:
+    // 0 na primeira, depois kBackoffBaseMs dobrando até kBackoffMaxMs, sorteada
+    // entre a metade e o valor cheio (random é um número aleatório qualquer)
+    static int64_t reconnectDelayMs(int failures, uint32_t random);
+
+    static constexpr int64_t kBackoffBaseMs = 250;
+    static constexpr int64_t kBackoffMaxMs = 30000;
+
 private:
-    void workerThread();
-    bool connectToServer(int& sockFd);
+    // Buffer de recepção/enquadramento (maior linha aceita: kRxBufferSize - 1)
+    static constexpr size_t kRxBufferSize = 1024;
+
+    // Drena o socket ou conclui o connect (events do epoll) e segue a máquina de estados
+    void onIoEvent(uint32_t events) override;
+    // Standby/conexão/pedidos; termina dizendo ao reator pelo que esperar
+    void service();
+    // connect() não bloqueante: true se já conectou ou está em andamento
+    // (mConnecting, concluído por EPOLLOUT ou vencido em kConnectTimeoutMs)
+    bool startConnect();
+    // Fim do handshake: err 0 = conectado
+    void finishConnect(int err);
+    void connectFailed();
+    // Conexão estabelecida que caiu (hangup, erro, keepalive)
+    void connectionLost();
+    void readAvailable();
+    void configureSocket(int sockFd);
+    // Ajusta o SO_RCVLOWAT conforme haja linha parcial no framer
+    void tuneRcvLowat(int sockFd, bool partialLine);
+    // Processa uma linha recebida (dados ou ack do stream); arrivalNs é a
+    // chegada do seu primeiro byte. Retorna true se era uma amostra.
+    bool handleLine(std::string_view line, int64_t arrivalNs);
+    // Escreve um comando de texto; false se a conexão caiu
+    bool sendCommand(int sockFd, const std::string& cmd);
+    void closeConnection();
+    // device_id recebido (settings/boot); avisa o listener se mudou
+    void identify(const std::string& deviceId);
 
     std::string mTargetIp;
     int mTargetPort;
-    std::atomic<bool> mRunThread;
+    IoReactor& mReactor;
+    std::atomic<bool> mStarted;
     std::atomic<bool> mActive;
-    
-    std::thread mThread;
+    std::atomic<bool> mWarmStandby;
+    std::atomic<int> mPeriodMs; // período pedido pela HAL (já limitado)
+    std::atomic<int> mTargetPeriodMs[kStationTargets]; // 0 = fora de uso, -1 = segue mPeriodMs
+
     IAirDataListener* mListener;
     std::mutex mListenerLock;
-};
\ No newline at end of file
+
+    std::atomic<bool> mConnected;
+    std::atomic<uint64_t> mConnects;
+    std::atomic<uint64_t> mConnectFailures;
+    std::atomic<uint64_t> mDisconnects;
+    std::atomic<int64_t> mLastReconnectMs;
+    std::atomic<int64_t> mMaxReconnectMs;
+
+    // Só acessados no onIoEvent() (ou com o leitor parado)
+    int mSockFd;
+    bool mConnecting;           // handshake em andamento
+    int64_t mConnectDeadlineMs;
+    LineFramer<kRxBufferSize> mFramer;
+    std::minstd_rand mRng;
+    int mFailures;              // tentativas seguidas sem receber dados
+    bool mGotData;              // a conexão atual já entregou alguma amostra
+    int64_t mNextConnectMs;     // backoff
+    int64_t mDownSinceMs;       // desde quando queremos conexão e não temos
+    PollSchedule mPoll;
+    bool mWasStandby;
+    bool mSettingsRequested;    // GET SETTINGS já enviado nesta conexão
+    std::string mDeviceId;      // "" = a estação ainda não se identificou
+    StreamSession mStream;
+    AdaptiveRate mRate;         // mPeriodMs é o piso; transientes pedem mais rápido
+    DeviceClock mClock;
+    MqConversionStage mMq;      // mq2_raw/mq7_raw -> lpg_ppm/co_ppm
+    int mRcvLowat;
+};
@@ -0,0 +1,173 @@
+// Testes do IoReactor: fds, prazos e wake() entregues na thread do reator,
+// detach() síncrono e nenhuma volta do epoll_wait com todos parados.
+
+#include "io/IoReactor.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t nowMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(Clock::now().time_since_epoch()).count();
+}
+
+template <typename Pred>
+bool waitFor(Pred pred, int timeoutMs) {
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (Clock::now() < deadline) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return pred();
+}
+
+// Conta as chamadas; o que fazer em cada uma fica a cargo do teste
+class TestClient : public IoReactor::Client {
+public:
+    void onIoEvent(uint32_t events) override {
+        mThread = std::this_thread::get_id();
+        mLastEvents = events;
+        if (mHandler) mHandler(events);
+        mCalls++;
+    }
+
+    std::function<void(uint32_t)> mHandler;
+    std::atomic<int> mCalls{0};
+    std::atomic<uint32_t> mLastEvents{0};
+    std::thread::id mThread;
+};
+
+}  // namespace
+
+TEST(IoReactorTest, AttachCallsBackOnTheReactorThread) {
+    IoReactor reactor;
+    TestClient a, b;
+    reactor.attach(&a);
+    reactor.attach(&b);
+    ASSERT_TRUE(waitFor([&] { return a.mCalls == 1 && b.mCalls == 1; }, 1000));
+    EXPECT_EQ(0u, a.mLastEvents.load());
+    EXPECT_NE(std::this_thread::get_id(), a.mThread);
+    EXPECT_EQ(a.mThread, b.mThread);  // uma thread para todos
+    reactor.detach(&a);
+    reactor.detach(&b);
+}
+
+TEST(IoReactorTest, WatchedFdWakesTheClient) {
+    IoReactor reactor;
+    int fds[2];
+    ASSERT_EQ(0, pipe2(fds, O_NONBLOCK | O_CLOEXEC));
+
+    TestClient client;
+    std::atomic<int> bytes{0};
+    client.mHandler = [&](uint32_t events) {
+        if (events & EPOLLIN) {
+            char buf[16];
+            ssize_t n;
+            while ((n = read(fds[0], buf, sizeof(buf))) > 0) bytes += n;
+        }
+        reactor.watch(&client, fds[0], EPOLLIN);
+    };
+    reactor.attach(&client);
+    ASSERT_TRUE(waitFor([&] { return client.mCalls == 1; }, 1000));
+
+    ASSERT_EQ(3, write(fds[1], "abc", 3));
+    ASSERT_TRUE(waitFor([&] { return bytes == 3; }, 1000));
+    EXPECT_TRUE(client.mLastEvents & EPOLLIN);
+
+    // Nível: o que não foi lido continua acordando; sem watch() o fd é esquecido
+    client.mHandler = [&](uint32_t) { reactor.watch(&client, -1, 0); };
+    ASSERT_EQ(1, write(fds[1], "d", 1));
+    ASSERT_TRUE(waitFor([&] { return client.mCalls == 3; }, 1000));
+    int calls = client.mCalls;
+    ASSERT_EQ(1, write(fds[1], "e", 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(calls, client.mCalls);
+
+    reactor.detach(&client);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(IoReactorTest, DeadlinesFireOnceInOrder) {
+    IoReactor reactor;
+    TestClient early, late;
+    std::atomic<int64_t> earlyAt{0}, lateAt{0};
+    int64_t start = nowMs();
+    early.mHandler = [&](uint32_t) {
+        if (early.mCalls == 0) reactor.schedule(&early, start + 50);
+        else earlyAt = nowMs();
+    };
+    late.mHandler = [&](uint32_t) {
+        if (late.mCalls == 0) reactor.schedule(&late, start + 150);
+        else lateAt = nowMs();
+    };
+    reactor.attach(&late);
+    reactor.attach(&early);
+
+    ASSERT_TRUE(waitFor([&] { return lateAt != 0; }, 1000));
+    EXPECT_GE(earlyAt - start, 50);
+    EXPECT_GE(lateAt - start, 150);
+    EXPECT_LT(earlyAt, lateAt);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(2, early.mCalls);
+    EXPECT_EQ(2, late.mCalls);
+    reactor.detach(&early);
+    reactor.detach(&late);
+}
+
+TEST(IoReactorTest, IdleReactorDoesNotWakeUp) {
+    IoReactor reactor;
+    TestClient client;
+    reactor.attach(&client);
+    ASSERT_TRUE(waitFor([&] { return client.mCalls == 1; }, 1000));
+
+    uint64_t wakeups = reactor.wakeups();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(wakeups, reactor.wakeups());
+
+    // Vários wake() antes da thread atender viram uma chamada só
+    client.mHandler = [&](uint32_t) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); };
+    reactor.wake(&client);
+    ASSERT_TRUE(waitFor([&] { return reactor.wakeups() > wakeups; }, 1000));
+    for (int i = 0; i < 10; i++) reactor.wake(&client);
+    ASSERT_TRUE(waitFor([&] { return client.mCalls == 3; }, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(3, client.mCalls);
+    reactor.detach(&client);
+}
+
+TEST(IoReactorTest, DetachWaitsForTheCallbackInFlight) {
+    IoReactor reactor;
+    TestClient client;
+    std::atomic<bool> inside{false};
+    std::atomic<bool> finished{false};
+    client.mHandler = [&](uint32_t) {
+        inside = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        finished = true;
+    };
+    reactor.attach(&client);
+    ASSERT_TRUE(waitFor([&] { return inside.load(); }, 1000));
+
+    reactor.detach(&client);
+    EXPECT_TRUE(finished);
+
+    // Fora do reator: wake() não chama mais
+    int calls = client.mCalls;
+    reactor.wake(&client);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(calls, client.mCalls);
+}
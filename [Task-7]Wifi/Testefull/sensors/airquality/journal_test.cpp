@@ -0,0 +1,269 @@
+// Testes do TelemetryJournal num diretório de tmpfs: leitura zero-cópia dos
+// segmentos, rotação com reserva pronta e teto de tamanho, recuperação da
+// cauda depois de um registro rasgado e de uma queda do processo.
+
+#include "io/TelemetryJournal.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+AirData sample(int i) {
+    AirData data;
+    data.timestamp = 1000000000LL + i * 1000000LL;
+    data.deviceMs = 5000 + i;
+    data.pm25 = 10.0f + i;
+    data.co_ppm = 0.5f * i;
+    data.temp_c = 25.0f;
+    data.mq2_raw = 800.0f + i;
+    data.source = i % 2 ? "wifi" : "serial";
+    data.station = i % 3;
+    data.valid = true;
+    return data;
+}
+
+TelemetryJournal::Options manual(size_t segmentRecords, size_t maxBytes = 64 << 20) {
+    TelemetryJournal::Options options;
+    options.segmentRecords = segmentRecords;
+    options.maxBytes = maxBytes;
+    options.syncIntervalMs = 0;
+    return options;
+}
+
+size_t segmentBytes(size_t records) {
+    return (records + 1) * sizeof(JournalRecord);  // + cabeçalho
+}
+
+class JournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // tmpfs quando houver, como /data no aparelho sem o custo do disco
+        char shm[] = "/dev/shm/airquality-journal-XXXXXX";
+        char tmp[] = "/tmp/airquality-journal-XXXXXX";
+        const char* dir = mkdtemp(shm);
+        if (dir == nullptr) dir = mkdtemp(tmp);
+        ASSERT_NE(nullptr, dir);
+        mDir = dir;
+    }
+
+    void TearDown() override {
+        for (const auto& path : TelemetryJournal::listSegments(mDir)) unlink(path.c_str());
+        rmdir(mDir.c_str());
+    }
+
+    // Todos os registros válidos, em ordem, lidos direto dos mapeamentos
+    std::vector<JournalRecord> scan() {
+        std::vector<JournalRecord> records;
+        for (const auto& path : TelemetryJournal::listSegments(mDir)) {
+            JournalSegment segment;
+            EXPECT_TRUE(segment.open(path)) << path;
+            records.insert(records.end(), segment.records(), segment.records() + segment.count());
+        }
+        return records;
+    }
+
+    std::string mDir;
+};
+
+TEST_F(JournalTest, RecordsAreReadInPlace) {
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(64)));
+    for (int i = 0; i < 10; i++) journal.append(sample(i));
+    EXPECT_EQ(11u, journal.nextSequence());
+
+    std::vector<std::string> segments = TelemetryJournal::listSegments(mDir);
+    ASSERT_EQ(1u, segments.size());
+    JournalSegment segment;
+    ASSERT_TRUE(segment.open(segments[0]));
+    EXPECT_EQ(1u, segment.firstSequence());
+    EXPECT_EQ(64u, segment.capacity());
+    ASSERT_EQ(10u, segment.count());
+
+    for (int i = 0; i < 10; i++) {
+        const JournalRecord& record = segment.records()[i];
+        EXPECT_EQ(static_cast<uint64_t>(i + 1), record.sequence);
+        AirData expected = sample(i);
+        AirData got = record.toAirData();
+        EXPECT_EQ(expected.timestamp, got.timestamp);
+        EXPECT_EQ(expected.deviceMs, got.deviceMs);
+        EXPECT_EQ(expected.pm25, got.pm25);
+        EXPECT_EQ(expected.pm10, got.pm10);
+        EXPECT_EQ(expected.co_ppm, got.co_ppm);
+        EXPECT_EQ(expected.temp_c, got.temp_c);
+        EXPECT_EQ(expected.mq2_raw, got.mq2_raw);
+        EXPECT_EQ(expected.mq7_raw, got.mq7_raw);
+        EXPECT_EQ(expected.source, got.source);
+        EXPECT_EQ(expected.station, got.station);
+    }
+
+    // O leitor vê o que entra depois, no mesmo mapeamento
+    journal.append(sample(10));
+    EXPECT_EQ(11u, segment.count());
+}
+
+TEST_F(JournalTest, RotatesIntoTheSpareAndKeepsUnderTheCap) {
+    const size_t kRecords = 8;
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(kRecords, 4 * segmentBytes(kRecords))));
+    for (int i = 0; i < 100; i++) {
+        journal.append(sample(i));
+        if (i % 4 == 3) journal.sync();  // O que a thread do diário faria
+    }
+
+    TelemetryJournal::Stats stats = journal.stats();
+    EXPECT_EQ(100u, stats.appended);
+    EXPECT_EQ(12u, stats.segments);
+    EXPECT_EQ(0u, stats.stalls);  // Sempre havia reserva: nenhuma syscall no append
+    EXPECT_GT(stats.removed, 0u);
+
+    std::vector<std::string> segments = TelemetryJournal::listSegments(mDir);
+    EXPECT_LE(segments.size(), 4u);
+    size_t total = 0;
+    for (const auto& path : segments) {
+        struct stat st;
+        ASSERT_EQ(0, stat(path.c_str(), &st));
+        total += st.st_size;
+    }
+    EXPECT_LE(total, 4 * segmentBytes(kRecords));
+
+    // O que sobrou é a cauda, contínua, terminando na última amostra
+    std::vector<JournalRecord> records = scan();
+    ASSERT_FALSE(records.empty());
+    for (size_t i = 1; i < records.size(); i++) {
+        EXPECT_EQ(records[i - 1].sequence + 1, records[i].sequence);
+    }
+    EXPECT_EQ(100u, records.back().sequence);
+}
+
+TEST_F(JournalTest, RotatesWithoutSpareAsAStall) {
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(4)));
+    for (int i = 0; i < 10; i++) journal.append(sample(i));
+    EXPECT_EQ(2u, journal.stats().stalls);
+    EXPECT_EQ(0u, journal.stats().drops);
+    journal.close();
+
+    std::vector<JournalRecord> records = scan();
+    ASSERT_EQ(10u, records.size());
+    EXPECT_EQ(10u, records.back().sequence);
+}
+
+TEST_F(JournalTest, BackgroundThreadPreparesTheSpare) {
+    TelemetryJournal::Options options;
+    options.segmentRecords = 16;
+    options.syncIntervalMs = 10;
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, options));
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 16; i++) journal.append(sample(round * 16 + i));
+        // Espera a reserva aparecer e a volta da thread que a criou terminar
+        size_t files = round + 2;
+        for (int wait = 0; wait < 400 && TelemetryJournal::listSegments(mDir).size() < files; wait++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        uint64_t syncs = journal.stats().syncs;
+        for (int wait = 0; wait < 400 && journal.stats().syncs <= syncs; wait++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    journal.append(sample(48));
+    EXPECT_EQ(3u, journal.stats().segments);
+    EXPECT_EQ(0u, journal.stats().stalls);
+    journal.close();
+
+    // A reserva que sobrou ao fechar não fica no diretório
+    EXPECT_EQ(4u, TelemetryJournal::listSegments(mDir).size());
+    EXPECT_EQ(49u, scan().size());
+}
+
+TEST_F(JournalTest, RecoversFromATornRecord) {
+    {
+        TelemetryJournal journal;
+        ASSERT_TRUE(journal.open(mDir, manual(64)));
+        for (int i = 0; i < 20; i++) journal.append(sample(i));
+    }
+
+    // Queda do aparelho no meio do registro 13: só parte dele chegou ao disco
+    std::string path = TelemetryJournal::listSegments(mDir)[0];
+    int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    size_t size = segmentBytes(64);
+    uint8_t* base = static_cast<uint8_t*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    ASSERT_NE(MAP_FAILED, base);
+    JournalRecord* records = reinterpret_cast<JournalRecord*>(base + sizeof(JournalRecord));
+    records[12].pm25 += 1.0f;
+    munmap(base, size);
+    close(fd);
+
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(64)));
+    EXPECT_EQ(13u, journal.nextSequence());
+    journal.append(sample(99));
+
+    JournalSegment segment;
+    ASSERT_TRUE(segment.open(path));
+    ASSERT_EQ(13u, segment.count());
+    EXPECT_EQ(13u, segment.records()[12].sequence);
+    EXPECT_EQ(sample(99).pm25, segment.records()[12].pm25);
+    // O resto da cauda velha foi zerado
+    EXPECT_EQ(0u, segment.records()[13].commit);
+}
+
+TEST_F(JournalTest, SurvivesProcessCrash) {
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        TelemetryJournal journal;
+        if (!journal.open(mDir, manual(32))) _exit(1);
+        for (int i = 0; i < 50; i++) {
+            journal.append(sample(i));
+            if (i == 40) journal.sync();  // Deixa uma reserva sem uso para trás
+        }
+        _exit(0);  // Sem close() nem msync: só o page cache
+    }
+    int status = 0;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+    EXPECT_EQ(3u, TelemetryJournal::listSegments(mDir).size());
+
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(32)));
+    EXPECT_EQ(51u, journal.nextSequence());
+    // A reserva da queda foi apagada
+    EXPECT_EQ(2u, TelemetryJournal::listSegments(mDir).size());
+    journal.append(sample(50));
+    journal.close();
+
+    std::vector<JournalRecord> records = scan();
+    ASSERT_EQ(51u, records.size());
+    for (size_t i = 0; i < records.size(); i++) EXPECT_EQ(i + 1, records[i].sequence);
+}
+
+TEST_F(JournalTest, IgnoresForeignFiles) {
+    std::string other = mDir + "/telemetry-notes.txt";
+    int fd = open(other.c_str(), O_CREAT | O_WRONLY, 0600);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    TelemetryJournal journal;
+    ASSERT_TRUE(journal.open(mDir, manual(8)));
+    journal.append(sample(0));
+    EXPECT_EQ(1u, TelemetryJournal::listSegments(mDir).size());
+    EXPECT_EQ(0, access(other.c_str(), F_OK));
+    unlink(other.c_str());
+}
+
+}  // namespace
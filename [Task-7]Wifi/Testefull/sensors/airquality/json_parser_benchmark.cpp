@@ -0,0 +1,108 @@
+// Linhas/s do JsonParser: scanner especializado x caminho jsoncpp.
+//  - BM_JsonParserScanner:     JsonParser::parse() (caminho usado pelos leitores)
+//  - BM_JsonParserJsoncpp:     JsonParser::parseWithJsoncpp() (CharReader reaproveitado)
+//  - BM_JsonParserJsoncppLegacy: código antigo (CharReaderBuilder + new por linha,
+//                              cópia do payload)
+//  - BM_BinaryFrameDecoder:    mesma leitura completa no quadro binário (SET FORMAT BIN)
+
+#include "utils/BinaryFrame.h"
+#include "utils/JsonParser.h"
+
+#include <benchmark/benchmark.h>
+#include <json/json.h>
+
+#include <string>
+
+static const std::string kFullLine =
+    "{\"type\":\"data\",\"src\":\"serial\",\"payload\":{\"pm25\":12.3,\"pm10\":18.5,"
+    "\"lpg_ppm\":200,\"co_ppm\":1.02,\"temp_c\":26.1,\"humid_p\":60.2}}";
+
+static const std::string kPartialLine =
+    "{\"type\":\"data\",\"src\":\"serial\",\"sensor\":\"mq7\",\"payload\":{\"co_ppm\":18.41,\"raw_val\":812}}";
+
+static const std::string kAckLine =
+    "{\"type\":\"ack\",\"cmd\":\"set_calib\",\"target\":\"sds\",\"new_val\":1.1,\"status\":\"saved\"}";
+
+static const std::string& lineFor(int64_t which) {
+    switch (which) {
+        case 0: return kFullLine;
+        case 1: return kPartialLine;
+        default: return kAckLine;
+    }
+}
+
+static AirData legacyParse(const std::string& jsonLine) {
+    AirData data;
+    Json::CharReaderBuilder builder;
+    Json::CharReader* reader = builder.newCharReader();
+    Json::Value root;
+    std::string errors;
+    bool ok = reader->parse(jsonLine.c_str(), jsonLine.c_str() + jsonLine.size(), &root, &errors);
+    delete reader;
+    if (!ok || !root.isMember("type") || root["type"].asString() != "data") return data;
+    if (!root.isMember("payload")) return data;
+    Json::Value payload = root["payload"];
+    if (payload.isMember("pm25")) data.pm25 = payload["pm25"].asFloat();
+    if (payload.isMember("pm10")) data.pm10 = payload["pm10"].asFloat();
+    if (payload.isMember("co_ppm")) data.co_ppm = payload["co_ppm"].asFloat();
+    if (payload.isMember("lpg_ppm")) data.lpg_ppm = payload["lpg_ppm"].asFloat();
+    if (payload.isMember("temp_c")) data.temp_c = payload["temp_c"].asFloat();
+    if (payload.isMember("humid_p")) data.humid_p = payload["humid_p"].asFloat();
+    if (root.isMember("src")) data.source = root["src"].asString();
+    data.valid = true;
+    return data;
+}
+
+static void BM_JsonParserScanner(benchmark::State& state) {
+    const std::string& line = lineFor(state.range(0));
+    for (auto _ : state) {
+        AirData data = JsonParser::parse(line, 0);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK(BM_JsonParserScanner)->DenseRange(0, 2);
+
+static void BM_JsonParserJsoncpp(benchmark::State& state) {
+    const std::string& line = lineFor(state.range(0));
+    for (auto _ : state) {
+        AirData data = JsonParser::parseWithJsoncpp(line, 0);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK(BM_JsonParserJsoncpp)->DenseRange(0, 2);
+
+static void BM_JsonParserJsoncppLegacy(benchmark::State& state) {
+    const std::string& line = lineFor(state.range(0));
+    for (auto _ : state) {
+        AirData data = legacyParse(line);
+        benchmark::DoNotOptimize(data);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK(BM_JsonParserJsoncppLegacy)->DenseRange(0, 2);
+
+static void BM_BinaryFrameDecoder(benchmark::State& state) {
+    AirData reading = JsonParser::parse(kFullLine, 0);
+    uint8_t frame[BinaryFrame::kFrameSize];
+    BinaryFrame::encode(reading, 0, frame);
+
+    BinaryFrameDecoder decoder;
+    for (auto _ : state) {
+        decoder.feed(reinterpret_cast<const char*>(frame), sizeof(frame));
+        AirData data;
+        std::string_view text;
+        while (decoder.next(&data, &text) != BinaryFrameDecoder::kNeedMore) {
+            benchmark::DoNotOptimize(data);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(frame));
+}
+BENCHMARK(BM_BinaryFrameDecoder);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,265 @@
+// Teste diferencial do JsonParser: o scanner rápido (parse) precisa devolver
+// exatamente o mesmo AirData que o caminho jsoncpp (parseWithJsoncpp) para
+// qualquer linha - documentos do protocolo gerados aleatoriamente e versões
+// corrompidas deles. Semente fixa para o resultado ser reproduzível.
+
+#include "utils/JsonParser.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t kIterations = 100000;
+
+bool sameBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// Carimbo de chegada passado aos dois caminhos; tem que sair intacto
+const int64_t kArrivalNs = 123456789;
+
+::testing::AssertionResult sameAirData(const std::string& line, const AirData& fast, const AirData& ref) {
+    if (fast.valid == ref.valid && fast.timestamp == ref.timestamp && fast.deviceMs == ref.deviceMs &&
+        sameBits(fast.pm25, ref.pm25) && sameBits(fast.pm10, ref.pm10) &&
+        sameBits(fast.co_ppm, ref.co_ppm) && sameBits(fast.lpg_ppm, ref.lpg_ppm) &&
+        sameBits(fast.temp_c, ref.temp_c) && sameBits(fast.humid_p, ref.humid_p) &&
+        sameBits(fast.mq2_raw, ref.mq2_raw) && sameBits(fast.mq7_raw, ref.mq7_raw) &&
+        fast.source == ref.source) {
+        return ::testing::AssertionSuccess();
+    }
+    return ::testing::AssertionFailure()
+           << "linha: " << line << "\n"
+           << "  rápido:  valid=" << fast.valid << " pm25=" << fast.pm25 << " pm10=" << fast.pm10
+           << " co=" << fast.co_ppm << " lpg=" << fast.lpg_ppm << " temp=" << fast.temp_c
+           << " hum=" << fast.humid_p << " mq2=" << fast.mq2_raw << " mq7=" << fast.mq7_raw
+           << " src=" << fast.source << " ms=" << fast.deviceMs
+           << " ts=" << fast.timestamp << "\n"
+           << "  jsoncpp: valid=" << ref.valid << " pm25=" << ref.pm25 << " pm10=" << ref.pm10
+           << " co=" << ref.co_ppm << " lpg=" << ref.lpg_ppm << " temp=" << ref.temp_c
+           << " hum=" << ref.humid_p << " mq2=" << ref.mq2_raw << " mq7=" << ref.mq7_raw
+           << " src=" << ref.source << " ms=" << ref.deviceMs
+           << " ts=" << ref.timestamp;
+}
+
+// Gerador de linhas no formato da estação, com variações de tipos, ordem,
+// espaços, chaves repetidas e construções que só o jsoncpp aceita.
+class LineGenerator {
+public:
+    explicit LineGenerator(uint32_t seed) : mRng(seed) {}
+
+    std::string document() {
+        std::vector<std::string> members;
+        if (chance(95)) members.push_back(member("type", typeValue()));
+        if (chance(80)) members.push_back(member("src", srcValue()));
+        if (chance(95)) members.push_back(member("payload", payloadValue()));
+        if (chance(50)) members.push_back(member("ms", msValue()));
+        if (chance(20)) members.push_back(member("sensor", "\"sds011\""));
+        if (chance(10)) members.push_back(member("extra", anyValue(2)));
+        if (chance(8)) members.push_back(member(pick({"type", "payload", "src", "ms"}), anyValue(1)));
+        shuffle(&members);
+
+        std::string doc = ws() + object(members) + ws();
+        if (chance(3)) doc += pick({"garbage", "// fim", "}", " {\"type\":\"ack\"}"});
+        if (chance(2)) doc = "/* boot */" + doc;
+        return doc;
+    }
+
+    std::string mutate(std::string line) {
+        int edits = 1 + static_cast<int>(mRng() % 3);
+        for (int i = 0; i < edits && !line.empty(); i++) {
+            size_t pos = mRng() % line.size();
+            switch (mRng() % 4) {
+                case 0: line[pos] = kAlphabet[mRng() % (sizeof(kAlphabet) - 1)]; break;
+                case 1: line.erase(pos, 1); break;
+                case 2: line.insert(pos, 1, kAlphabet[mRng() % (sizeof(kAlphabet) - 1)]); break;
+                default: line.resize(pos); break;
+            }
+        }
+        return line;
+    }
+
+private:
+    static constexpr char kAlphabet[] = "{}[]\":,.-+eE0123456789 \\/truefalsn\tx";
+
+    bool chance(int percent) { return static_cast<int>(mRng() % 100) < percent; }
+
+    std::string pick(std::initializer_list<const char*> options) {
+        size_t i = mRng() % options.size();
+        return *(options.begin() + i);
+    }
+
+    template <typename T>
+    void shuffle(std::vector<T>* v) {
+        for (size_t i = v->size(); i > 1; i--) std::swap((*v)[i - 1], (*v)[mRng() % i]);
+    }
+
+    std::string ws() {
+        if (!chance(20)) return "";
+        return pick({" ", "\t", "  ", "\r\n", " \n "});
+    }
+
+    std::string member(const std::string& key, const std::string& value) {
+        return ws() + "\"" + key + "\"" + ws() + ":" + ws() + value + ws();
+    }
+
+    std::string object(const std::vector<std::string>& members) {
+        std::string out = "{";
+        for (size_t i = 0; i < members.size(); i++) {
+            if (i > 0) out += ",";
+            out += members[i];
+        }
+        if (!members.empty() && chance(2)) out += ",";  // vírgula final (só jsoncpp)
+        return out + "}";
+    }
+
+    std::string typeValue() {
+        if (chance(85)) return "\"data\"";
+        return pick({"\"ack\"", "\"status\"", "\"dat\"", "\"data \"", "5", "null", "true", "{}", "[]",
+                     "\"d\\u0061ta\""});
+    }
+
+    std::string srcValue() {
+        if (chance(85)) return pick({"\"serial\"", "\"wifi\""});
+        return pick({"\"\"", "1", "null", "false", "[]", "{\"a\":1}", "\"se\\nrial\"",
+                     "\"uma fonte com nome bem comprido demais para SSO\""});
+    }
+
+    std::string msValue() {
+        if (chance(80)) return std::to_string(mRng());  // millis() de 32 bits
+        if (chance(50)) return number();
+        return pick({"\"1000\"", "null", "-1", "-0", "9223372036854775807", "9223372036854775808",
+                     "922337203685477580", "1000.0", "1e3"});
+    }
+
+    std::string payloadValue() {
+        if (chance(5)) return pick({"null", "5", "\"x\"", "[]", "true"});
+        static const char* kFields[] = {"pm25",   "pm10",    "co_ppm",  "lpg_ppm",
+                                        "temp_c", "humid_p", "mq2_raw", "mq7_raw"};
+        std::vector<std::string> members;
+        for (const char* field : kFields) {
+            if (chance(80)) members.push_back(member(field, fieldValue()));
+        }
+        if (chance(15)) members.push_back(member("raw_val", number()));
+        if (chance(5)) members.push_back(member("nested", anyValue(3)));
+        if (chance(5)) members.push_back(member(kFields[mRng() % 8], fieldValue()));
+        shuffle(&members);
+        return object(members);
+    }
+
+    std::string fieldValue() {
+        if (chance(90)) return number();
+        return pick({"null", "true", "false", "\"12.5\"", "{}", "[1]"});
+    }
+
+    std::string number() {
+        char buf[64];
+        switch (mRng() % 12) {
+            case 0:  snprintf(buf, sizeof(buf), "%u", static_cast<unsigned>(mRng() % 2000)); break;
+            case 1:  snprintf(buf, sizeof(buf), "%.1f", (mRng() % 100000) / 10.0); break;
+            case 2:  snprintf(buf, sizeof(buf), "%.2f", (static_cast<int>(mRng() % 10000) - 5000) / 100.0); break;
+            case 3:  snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(mRng()) / (mRng() | 1)); break;
+            case 4:  snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(mRng()) << 32 | mRng()); break;
+            case 5:  snprintf(buf, sizeof(buf), "-%llu", static_cast<unsigned long long>(mRng()) << 32 | mRng()); break;
+            case 6:  return pick({"18446744073709551615", "18446744073709551616", "-9223372036854775808",
+                                  "-9223372036854775809", "16777217", "-0", "-0.0", "0", "9007199254740993"});
+            case 7:  return pick({"1e5", "1E-3", "2.5e+2", "1e400", "-1e400", "1e-400", "4e-320", "1e38", "3.5e38"});
+            case 8:  return pick({"01", "1.", ".5", "-", "1e", "+1", "0x10", "1.5.2"});  // não estritos
+            case 9:  snprintf(buf, sizeof(buf), "%.17g", static_cast<double>(mRng()) * 1e-7); break;
+            case 10: snprintf(buf, sizeof(buf), "%d", -static_cast<int>(mRng() % 300)); break;
+            default: snprintf(buf, sizeof(buf), "%.3e", static_cast<double>(mRng()) * 1e-3); break;
+        }
+        return buf;
+    }
+
+    std::string anyValue(int depth) {
+        switch (mRng() % (depth > 0 ? 7 : 5)) {
+            case 0: return number();
+            case 1: return pick({"true", "false", "null"});
+            case 2: return pick({"\"ok\"", "\"\"", "\"a b\"", "\"esc\\\"\"", "\"\\u00e9\""});
+            case 3: return "[]";
+            case 4: return "{}";
+            case 5: return "[" + anyValue(depth - 1) + "," + anyValue(depth - 1) + "]";
+            default: return "{" + member("k", anyValue(depth - 1)) + "}";
+        }
+    }
+
+    std::mt19937 mRng;
+};
+
+constexpr char LineGenerator::kAlphabet[];
+
+void expectSame(const std::string& line) {
+    AirData fast = JsonParser::parse(line, kArrivalNs);
+    AirData ref = JsonParser::parseWithJsoncpp(line, kArrivalNs);
+    EXPECT_TRUE(sameAirData(line, fast, ref));
+}
+
+}  // namespace
+
+TEST(JsonParserDifferentialTest, FirmwareLines) {
+    // Saídas reais do firmware_oficial, NotificationSimulator e emuladores
+    const char* lines[] = {
+        "{\"type\":\"data\",\"src\":\"serial\",\"payload\":{\"pm25\":12.3,\"pm10\":18.5,"
+        "\"lpg_ppm\":1456,\"co_ppm\":812,\"temp_c\":26.1,\"humid_p\":60.2},\"ms\":4294967295}",
+        "{\"type\":\"data\",\"src\":\"serial\",\"payload\":{\"pm25\":12.3}}",
+        "{\"type\":\"data\",\"src\":\"serial\",\"sensor\":\"mq2\",\"payload\":{\"lpg_ppm\":201,\"raw_val\":1450}}",
+        "{\"type\":\"data\",\"src\":\"wifi\",\"payload\":{\"temp_c\":-1.5,\"humid_p\":0}}",
+        "{\"type\":\"boot\",\"device\":\"AIR_STATION_REAL\"}",
+        "{\"type\":\"ack\",\"cmd\":\"set_calib\",\"target\":\"sds\",\"new_val\":1.1,\"status\":\"saved\"}",
+        "{\"type\":\"status\",\"uptime_sec\":12,\"sensors\":{\"sds011\":\"ok\",\"mq2\":\"warming_up\"}}",
+        "Conectando ao Wi-Fi......",
+        "",
+        "   ",
+        "{}",
+        "null",
+        "[{\"type\":\"data\"}]",
+    };
+    for (const char* line : lines) expectSame(line);
+
+    AirData data = JsonParser::parse(lines[0], kArrivalNs);
+    EXPECT_TRUE(data.valid);
+    EXPECT_EQ(kArrivalNs, data.timestamp);
+    EXPECT_EQ(4294967295, data.deviceMs);
+    EXPECT_EQ(-1, JsonParser::parse(lines[1], kArrivalNs).deviceMs);
+    EXPECT_FLOAT_EQ(12.3f, data.pm25);
+    EXPECT_FLOAT_EQ(1456.0f, data.lpg_ppm);
+    EXPECT_EQ("serial", data.source);
+
+    // Identificação da estação: "device" no boot, "device_id" no settings
+    std::string deviceId;
+    EXPECT_EQ(JsonParser::Control::kBoot, JsonParser::parseControl(lines[4], &deviceId));
+    EXPECT_EQ("AIR_STATION_REAL", deviceId);
+    EXPECT_EQ(JsonParser::Control::kSettings,
+              JsonParser::parseControl("{\"type\":\"settings\",\"device_id\":\"AIR_STATION_1A2B\","
+                                       "\"calib\":{\"mq2_ro\":9.8}}", &deviceId));
+    EXPECT_EQ("AIR_STATION_1A2B", deviceId);
+}
+
+TEST(JsonParserDifferentialTest, GeneratedDocuments) {
+    LineGenerator gen(0xA1257A7u);
+    size_t valid = 0;
+    for (size_t i = 0; i < kIterations; i++) {
+        std::string line = gen.document();
+        AirData fast = JsonParser::parse(line, kArrivalNs);
+        AirData ref = JsonParser::parseWithJsoncpp(line, kArrivalNs);
+        ASSERT_TRUE(sameAirData(line, fast, ref)) << "iteração " << i;
+        if (ref.valid) valid++;
+    }
+    // O gerador precisa exercitar o caminho de sucesso, não só rejeições
+    EXPECT_GT(valid, kIterations / 3);
+}
+
+TEST(JsonParserDifferentialTest, MutatedDocuments) {
+    LineGenerator gen(0x5EED0002u);
+    for (size_t i = 0; i < kIterations; i++) {
+        std::string line = gen.mutate(gen.document());
+        AirData fast = JsonParser::parse(line, kArrivalNs);
+        AirData ref = JsonParser::parseWithJsoncpp(line, kArrivalNs);
+        ASSERT_TRUE(sameAirData(line, fast, ref)) << "iteração " << i;
+    }
+}
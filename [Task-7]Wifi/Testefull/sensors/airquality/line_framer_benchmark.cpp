@@ -0,0 +1,78 @@
+// Microbenchmark do enquadramento de linhas no caminho RX.
+// Compara o código antigo dos leitores (std::string += / find / substr / erase)
+// com o LineFramer, variando quantas linhas chegam em cada read().
+
+#include "io/LineFramer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+static const char kLine[] =
+    "{\"type\":\"data\",\"src\":\"serial\",\"payload\":{\"pm25\":12.3,\"pm10\":18.5,"
+    "\"lpg_ppm\":200,\"co_ppm\":1.02,\"temp_c\":26.1,\"humid_p\":60.2}}\r\n";
+
+// Monta os "chunks" que o read() entregaria: N linhas por chunk, com a última
+// linha cortada ao meio para exercitar a linha parcial entre leituras.
+static std::vector<std::string> makeChunks(int linesPerChunk) {
+    std::string stream;
+    for (int i = 0; i < linesPerChunk * 64; i++) stream += kLine;
+
+    std::vector<std::string> chunks;
+    size_t chunkSize = (sizeof(kLine) - 1) * linesPerChunk;
+    for (size_t off = sizeof(kLine) / 2; off < stream.size(); off += chunkSize) {
+        chunks.push_back(stream.substr(off, chunkSize));
+    }
+    return chunks;
+}
+
+static void BM_LegacyStringBuffer(benchmark::State& state) {
+    std::vector<std::string> chunks = makeChunks(state.range(0));
+    std::string lineBuffer;
+    size_t lines = 0;
+
+    for (auto _ : state) {
+        for (const std::string& chunk : chunks) {
+            lineBuffer += chunk;
+            size_t pos;
+            while ((pos = lineBuffer.find('\n')) != std::string::npos) {
+                std::string line = lineBuffer.substr(0, pos);
+                lineBuffer.erase(0, pos + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) {
+                    benchmark::DoNotOptimize(line.data());
+                    lines++;
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(lines);
+}
+BENCHMARK(BM_LegacyStringBuffer)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_LineFramer(benchmark::State& state) {
+    std::vector<std::string> chunks = makeChunks(state.range(0));
+    LineFramer<4096> framer;
+    size_t lines = 0;
+
+    for (auto _ : state) {
+        for (const std::string& chunk : chunks) {
+            // Simula o read() escrevendo direto no buffer do enquadrador
+            size_t off = 0;
+            while (off < chunk.size()) {
+                off += framer.feed(chunk.data() + off, chunk.size() - off);
+                std::string_view line;
+                while (framer.nextLine(&line)) {
+                    benchmark::DoNotOptimize(line.data());
+                    lines++;
+                }
+            }
+        }
+    }
+    state.SetItemsProcessed(lines);
+    state.counters["overflows"] = framer.overflowCount();
+}
+BENCHMARK(BM_LineFramer)->Arg(1)->Arg(4)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,67 @@
+// Amostras/s da conversão ADC -> ppm dos MQ, com compensação de temperatura/umidade.
+//  - BM_MqReference: MqConverter::reference() (pow em double por amostra)
+//  - BM_MqScalar:    MqConverter::convert() de uma amostra (caminho dos leitores)
+//  - BM_MqBatch:     MqConverter::convert() em lote de state.range(0) amostras
+
+#include "utils/MqConverter.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+struct Inputs {
+    std::vector<float> raw, temp, humid;
+
+    explicit Inputs(size_t n) : raw(n), temp(n), humid(n) {
+        for (size_t i = 0; i < n; i++) {
+            raw[i] = static_cast<float>((i * 131) % (MqConverter::kAdcMax + 1));
+            temp[i] = 15.0f + (i % 200) * 0.1f;
+            humid[i] = 30.0f + (i % 500) * 0.1f;
+        }
+    }
+};
+
+const size_t kSamples = 4096;
+
+}  // namespace
+
+static void BM_MqReference(benchmark::State& state) {
+    Inputs in(kSamples);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MqConverter::reference(MqConverter::GAS_CO_MQ7, 0.0f, in.raw[i],
+                                                        in.temp[i], in.humid[i]));
+        i = (i + 1) % kSamples;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MqReference);
+
+static void BM_MqScalar(benchmark::State& state) {
+    Inputs in(kSamples);
+    MqConverter co(MqConverter::GAS_CO_MQ7);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(co.convert(in.raw[i], in.temp[i], in.humid[i]));
+        i = (i + 1) % kSamples;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MqScalar);
+
+static void BM_MqBatch(benchmark::State& state) {
+    size_t n = static_cast<size_t>(state.range(0));
+    Inputs in(n);
+    std::vector<float> ppm(n);
+    MqConverter co(MqConverter::GAS_CO_MQ7);
+    for (auto _ : state) {
+        co.convert(in.raw.data(), in.temp.data(), in.humid.data(), ppm.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MqBatch)->Arg(64)->Arg(kSamples);
+
+BENCHMARK_MAIN();
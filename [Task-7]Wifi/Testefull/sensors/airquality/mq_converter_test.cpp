@@ -0,0 +1,153 @@
+// Testes do MqConverter: as tabelas batem com a fórmula de referência (pow)
+// em toda a faixa do ADC, de temperatura e de umidade, o lote dá o mesmo que
+// a amostra avulsa, e o estágio dos leitores só preenche o ppm que faltou.
+
+#include "utils/MqConverter.h"
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+
+#include <vector>
+
+namespace {
+
+const MqConverter::Gas kGases[] = {MqConverter::GAS_LPG_MQ2, MqConverter::GAS_CO_MQ7};
+
+// Interpolação nas tabelas: erro relativo bem abaixo da resolução do sensor
+const float kMaxRelativeError = 1e-3f;
+
+::testing::AssertionResult closeTo(float expected, float got) {
+    float error = fabsf(got - expected);
+    if (error <= kMaxRelativeError * fabsf(expected) + 1e-6f) return ::testing::AssertionSuccess();
+    return ::testing::AssertionFailure() << "esperado " << expected << ", veio " << got;
+}
+
+TEST(MqConverterTest, MatchesReferenceOnEveryAdcCount) {
+    for (MqConverter::Gas gas : kGases) {
+        MqConverter converter(gas);
+        for (int raw = 0; raw <= MqConverter::kAdcMax; raw++) {
+            float expected = MqConverter::reference(gas, 0.0f, raw, MqConverter::kRefTempC,
+                                                    MqConverter::kRefHumidP);
+            ASSERT_TRUE(closeTo(expected, converter.convert(raw, MqConverter::kRefTempC,
+                                                            MqConverter::kRefHumidP)))
+                << "gás " << gas << " raw " << raw;
+        }
+    }
+}
+
+TEST(MqConverterTest, MatchesReferenceAcrossAmbient) {
+    for (MqConverter::Gas gas : kGases) {
+        MqConverter converter(gas, 7.5f);
+        // Fora da grade (passos não inteiros) e além das bordas
+        for (float temp = -15.0f; temp <= 55.0f; temp += 0.7f) {
+            for (float humid = 0.0f; humid <= 105.0f; humid += 3.3f) {
+                for (float raw = 100.25f; raw <= MqConverter::kAdcMax; raw += 397.5f) {
+                    float expected = MqConverter::reference(gas, 7.5f, raw, temp, humid);
+                    ASSERT_TRUE(closeTo(expected, converter.convert(raw, temp, humid)))
+                        << "gás " << gas << " raw " << raw << " t " << temp << " h " << humid;
+                }
+            }
+        }
+    }
+}
+
+TEST(MqConverterTest, FollowsTheDatasheetCurve) {
+    // Sem compensação: ppm = a * (Rs/R0)^b; com Rs = R0 sai o próprio a
+    // (Vout = 2.5 V no divisor de 5 V com RL = R0 = 10 kOhm)
+    float raw = 2.5f * MqConverter::kAdcMax / MqConverter::kVrefV;
+    EXPECT_NEAR(574.25f, MqConverter::reference(MqConverter::GAS_LPG_MQ2, 0.0f, raw, 20.0f, 33.0f), 0.5f);
+    EXPECT_NEAR(99.042f, MqConverter::reference(MqConverter::GAS_CO_MQ7, 0.0f, raw, 20.0f, 33.0f), 0.1f);
+
+    MqConverter co(MqConverter::GAS_CO_MQ7);
+    // Mais tensão no divisor = Rs menor = mais gás
+    EXPECT_LT(co.convert(1000.0f, 20.0f, 33.0f), co.convert(2000.0f, 20.0f, 33.0f));
+    // Ar frio e seco aumenta Rs sozinho: sem compensação o gás sairia subestimado
+    EXPECT_GT(co.convert(1000.0f, 0.0f, 10.0f), co.convert(1000.0f, 20.0f, 33.0f));
+}
+
+TEST(MqConverterTest, EdgesOfTheAdcRange) {
+    for (MqConverter::Gas gas : kGases) {
+        MqConverter converter(gas);
+        // 0 V: sem corrente no sensor, nada de gás (e nada de inf/NaN)
+        EXPECT_EQ(0.0f, converter.convert(0.0f, 25.0f, 50.0f));
+        EXPECT_EQ(0.0f, converter.convert(-5.0f, 25.0f, 50.0f));
+        EXPECT_EQ(0.0f, converter.convert(NAN, 25.0f, 50.0f));
+        EXPECT_EQ(converter.convert(MqConverter::kAdcMax, 25.0f, 50.0f),
+                  converter.convert(9999.0f, 25.0f, 50.0f));
+
+        // R0 alto: a curva passa do teto e satura no maxRange
+        MqConverter saturated(gas, 1000.0f);
+        float top = saturated.convert(MqConverter::kAdcMax, 25.0f, 50.0f);
+        EXPECT_TRUE(isfinite(top));
+        EXPECT_EQ(top, MqConverter::reference(gas, 1000.0f, MqConverter::kAdcMax, 25.0f, 50.0f));
+    }
+}
+
+TEST(MqConverterTest, BatchMatchesScalar) {
+    MqConverter lpg(MqConverter::GAS_LPG_MQ2);
+    const size_t n = 1027;  // Sobra fora de qualquer largura de vetor
+    std::vector<float> raw(n), temp(n), humid(n), ppm(n);
+    for (size_t i = 0; i < n; i++) {
+        raw[i] = static_cast<float>((i * 37) % 4200);
+        temp[i] = -12.0f + (i % 67);
+        humid[i] = static_cast<float>(i % 103);
+    }
+    lpg.convert(raw.data(), temp.data(), humid.data(), ppm.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_FLOAT_EQ(lpg.convert(raw[i], temp[i], humid[i]), ppm[i]) << i;
+    }
+}
+
+TEST(MqConversionStageTest, FillsOnlyMissingPpm) {
+    MqConversionStage stage;
+    MqConverter lpg(MqConverter::GAS_LPG_MQ2);
+    MqConverter co(MqConverter::GAS_CO_MQ7);
+
+    AirData data;
+    data.mq2_raw = 800.0f;
+    data.mq7_raw = 600.0f;
+    data.co_ppm = 4.0f;  // Estação que já converte o CO
+    data.temp_c = 30.0f;
+    data.humid_p = 70.0f;
+    stage.apply(&data);
+    EXPECT_EQ(lpg.convert(800.0f, 30.0f, 70.0f), data.lpg_ppm);
+    EXPECT_EQ(4.0f, data.co_ppm);
+
+    // Sem contagem crua não inventa leitura
+    AirData pm;
+    pm.pm25 = 10.0f;
+    stage.apply(&pm);
+    EXPECT_EQ(-1.0f, pm.lpg_ppm);
+    EXPECT_EQ(-1.0f, pm.co_ppm);
+}
+
+TEST(MqConversionStageTest, PartialSamplesUseTheLastAmbient) {
+    MqConversionStage stage;
+    MqConverter co(MqConverter::GAS_CO_MQ7);
+
+    // Antes de qualquer DHT: condição de referência
+    AirData first;
+    first.mq7_raw = 600.0f;
+    stage.apply(&first);
+    EXPECT_EQ(co.convert(600.0f, MqConverter::kRefTempC, MqConverter::kRefHumidP), first.co_ppm);
+
+    AirData dht;
+    dht.temp_c = 35.0f;
+    dht.humid_p = 80.0f;
+    stage.apply(&dht);
+
+    // "GET DATA MQ7": só a contagem, com o ambiente da amostra anterior
+    AirData mq7;
+    mq7.mq7_raw = 600.0f;
+    stage.apply(&mq7);
+    EXPECT_EQ(co.convert(600.0f, 35.0f, 80.0f), mq7.co_ppm);
+
+    stage.reset();
+    AirData fresh;
+    fresh.mq7_raw = 600.0f;
+    stage.apply(&fresh);
+    EXPECT_EQ(first.co_ppm, fresh.co_ppm);
+}
+
+}  // namespace
@@ -0,0 +1,246 @@
+// Testes de várias estações na mesma SubHAL: duas estações falsas em PTYs,
+// cada uma com o seu device_id, ganham faixas de handles próprias, anunciadas
+// como sensores dinâmicos, e somem do framework quando a porta cai.
+
+#include "AirQualitySubHal.h"
+#include "fake_station.h"
+
+#include <HalProxyCallback.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <unistd.h>
+
+#include <memory>
+#include <mutex>
+#include <set>
+
+using android::hardware::sensors::V1_0::SensorFlagBits;
+using android::hardware::sensors::V2_0::implementation::IScopedWakelockRefCounter;
+using android::hardware::sensors::V2_1::implementation::HalProxyCallbackBase;
+
+namespace {
+
+const int64_t kMsNs = 1000000LL;
+
+class NoopRefCounter : public IScopedWakelockRefCounter {
+public:
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t, int64_t*) override { return true; }
+    void decrementRefCount(size_t) override {}
+};
+
+// Guarda os anúncios de sensores dinâmicos e os eventos entregues
+class DynamicProxyCallback : public IHalProxyCallback {
+public:
+    DynamicProxyCallback() : mBase(nullptr, &mRefCounter, 0) {}
+
+    Return<void> onDynamicSensorsConnected(const hidl_vec<SensorInfo>& infos) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const auto& info : infos) mConnected.push_back(info);
+        return Void();
+    }
+
+    Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>& handles) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (int32_t handle : handles) mDisconnected.push_back(handle);
+        return Void();
+    }
+
+    ScopedWakelock createScopedWakelock(bool lock) override {
+        return mBase.createScopedWakelock(lock);
+    }
+
+    void postEvents(const std::vector<Event>& events, ScopedWakelock /*wakelock*/) override {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (const auto& event : events) mHandles.insert(event.sensorHandle);
+    }
+
+    std::vector<SensorInfo> connected() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mConnected;
+    }
+
+    std::vector<int32_t> disconnected() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mDisconnected;
+    }
+
+    // Handles que já receberam algum evento
+    std::set<int32_t> handles() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mHandles;
+    }
+
+private:
+    NoopRefCounter mRefCounter;
+    HalProxyCallbackBase mBase;
+    std::mutex mLock;
+    std::vector<SensorInfo> mConnected;
+    std::vector<int32_t> mDisconnected;
+    std::set<int32_t> mHandles;
+};
+
+struct Pty {
+    int master = -1;
+    int slave = -1;
+    std::string name;
+};
+
+class MultiStationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (Pty* pty : {&mPtyA, &mPtyB}) {
+            char name[128];
+            ASSERT_EQ(0, openpty(&pty->master, &pty->slave, name, nullptr, nullptr));
+            fcntl(pty->master, F_SETFL, fcntl(pty->master, F_GETFL) | O_NONBLOCK);
+            pty->name = name;
+        }
+        FakeStation::Features a, b;
+        a.deviceId = "AIR_STATION_A";
+        b.deviceId = "AIR_STATION_B";
+        mStationA = std::make_unique<FakeStation>(mPtyA.master, a);
+        mStationB = std::make_unique<FakeStation>(mPtyB.master, b);
+
+        // Principal inexistente: só as estações a mais falam
+        mSubHal = std::make_unique<AirQualitySubHal>("/dev/airquality-test-missing", "127.0.0.1", 1);
+        mCallback = new DynamicProxyCallback();
+        ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->initialize(mCallback)));
+        mSubHal->addSerialStation(mPtyA.name);
+        mSubHal->addSerialStation(mPtyB.name);
+        mSubHal->addSerialStation(mPtyA.name);  // Repetida: ignorada
+    }
+
+    void TearDown() override {
+        mSubHal.reset();
+        for (Pty* pty : {&mPtyA, &mPtyB}) {
+            if (pty->master >= 0) close(pty->master);
+            close(pty->slave);
+        }
+    }
+
+    // Serve as duas estações até pred() ou o tempo acabar
+    template <typename Pred>
+    bool serveUntil(Pred pred, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (mPtyA.master >= 0) mStationA->serve();
+            mStationB->serve();
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return false;
+    }
+
+    // Handles anunciados para o device_id (pelo nome do sensor)
+    std::set<int32_t> handlesOf(const std::string& deviceId) {
+        std::set<int32_t> handles;
+        for (const auto& info : mCallback->connected()) {
+            if (std::string(info.name.c_str()).find("[" + deviceId + "]") != std::string::npos) {
+                handles.insert(info.sensorHandle);
+            }
+        }
+        return handles;
+    }
+
+    int32_t coHandleOf(const std::string& deviceId) {
+        for (const auto& info : mCallback->connected()) {
+            if (std::string(info.name.c_str()).find("[" + deviceId + "]") != std::string::npos &&
+                std::string(info.typeAsString.c_str()) == "com.airstation.sensor.co") {
+                return info.sensorHandle;
+            }
+        }
+        return -1;
+    }
+
+    bool bothConnected() { return mCallback->connected().size() == 14; }
+
+    Pty mPtyA, mPtyB;
+    std::unique_ptr<FakeStation> mStationA, mStationB;
+    std::unique_ptr<AirQualitySubHal> mSubHal;
+    sp<DynamicProxyCallback> mCallback;
+};
+
+// Faixa de uma estação a mais: base + 1..6 e base + 99
+std::set<int32_t> range(int station) {
+    int32_t base = SensorRegistry::kHandleBase + station * SensorRegistry::kStationStride;
+    return {base + 1, base + 2, base + 3, base + 4, base + 5, base + 6, base + 99};
+}
+
+}  // namespace
+
+TEST_F(MultiStationTest, EachStationGetsItsOwnHandleRange) {
+    ASSERT_TRUE(serveUntil([&] { return bothConnected(); }, 3000));
+
+    std::set<int32_t> a = handlesOf("AIR_STATION_A");
+    std::set<int32_t> b = handlesOf("AIR_STATION_B");
+    ASSERT_EQ(7u, a.size());
+    ASSERT_EQ(7u, b.size());
+    // A ordem de identificação decide quem fica com a faixa 1
+    EXPECT_TRUE((a == range(1) && b == range(2)) || (a == range(2) && b == range(1)));
+    for (const auto& info : mCallback->connected()) {
+        EXPECT_TRUE(info.flags & static_cast<uint32_t>(SensorFlagBits::DYNAMIC_SENSOR));
+    }
+
+    // A lista estática continua só com a estação principal
+    mSubHal->getSensorsList([](const hidl_vec<SensorInfo>& list) {
+        ASSERT_EQ(15u, list.size());  // 7 da estação + 6 de histórico + 2 índices
+        for (const auto& info : list) {
+            EXPECT_LT(info.sensorHandle, SensorRegistry::kHandleBase + SensorRegistry::kStationStride);
+            EXPECT_FALSE(info.flags & static_cast<uint32_t>(SensorFlagBits::DYNAMIC_SENSOR));
+        }
+    });
+}
+
+TEST_F(MultiStationTest, SamplesReachOnlyTheirStation) {
+    ASSERT_TRUE(serveUntil([&] { return bothConnected(); }, 3000));
+    int32_t coB = coHandleOf("AIR_STATION_B");
+    ASSERT_GT(coB, 0);
+
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->batch(coB, 100 * kMsNs, 0)));
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->activate(coB, true)));
+    ASSERT_TRUE(serveUntil([&] { return mCallback->handles().count(coB) > 0; }, 3000));
+
+    // Só a estação B foi acordada, e só o sensor dela recebeu eventos
+    EXPECT_TRUE(mStationB->streaming());
+    EXPECT_FALSE(mStationA->streaming());
+    EXPECT_EQ(0, mStationA->dataRequests());
+    EXPECT_EQ(std::set<int32_t>{coB}, mCallback->handles());
+}
+
+TEST_F(MultiStationTest, HangupDisconnectsTheStation) {
+    ASSERT_TRUE(serveUntil([&] { return bothConnected(); }, 3000));
+    std::set<int32_t> a = handlesOf("AIR_STATION_A");
+    int32_t coA = coHandleOf("AIR_STATION_A");
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->activate(coA, true)));
+
+    // Cabo da estação A arrancado
+    close(mPtyA.master);
+    mPtyA.master = -1;
+    ASSERT_TRUE(serveUntil([&] { return mCallback->disconnected().size() == 7; }, 3000));
+    std::vector<int32_t> lost = mCallback->disconnected();
+    EXPECT_EQ(a, std::set<int32_t>(lost.begin(), lost.end()));
+
+    // A estação B segue conectada e é a única a entregar
+    int32_t coB = coHandleOf("AIR_STATION_B");
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->batch(coB, 100 * kMsNs, 0)));
+    ASSERT_EQ(Result::OK, static_cast<Result>(mSubHal->activate(coB, true)));
+    ASSERT_TRUE(serveUntil([&] { return mCallback->handles().count(coB) > 0; }, 3000));
+    EXPECT_EQ(0u, mCallback->handles().count(coA));
+}
+
+TEST_F(MultiStationTest, RemovedPortDisconnectsTheStation) {
+    ASSERT_TRUE(serveUntil([&] { return bothConnected(); }, 3000));
+    std::set<int32_t> b = handlesOf("AIR_STATION_B");
+
+    // Aviso de remoção do hotplug, com a estação ainda respondendo
+    mSubHal->removeSerialStation(mPtyB.name);
+    ASSERT_TRUE(serveUntil([&] { return mCallback->disconnected().size() == 7; }, 3000));
+    std::vector<int32_t> lost = mCallback->disconnected();
+    EXPECT_EQ(b, std::set<int32_t>(lost.begin(), lost.end()));
+
+    // De volta: mesma faixa do device_id
+    mSubHal->addSerialStation(mPtyB.name);
+    ASSERT_TRUE(serveUntil([&] { return mCallback->connected().size() == 21; }, 3000));
+    EXPECT_EQ(b, handlesOf("AIR_STATION_B"));
+}
@@ -0,0 +1,365 @@
+#define LOG_TAG "AirQualityPipelineBench"
+
+// Bancada ponta a ponta da SubHAL: FakeStation num PTY -> SerialReader ->
+// JsonParser (ou BinaryFrame com --binary) -> DataDispatcher -> SubHAL
+// (SensorRegistry, FIFOs) -> IHalProxyCallback falso que só conta os
+// postEvents. Todos os sensores ficam ativos no minDelay e sem latência de
+// batch, como um app de monitoramento.
+//
+// Para cada taxa mede, numa janela depois do aquecimento:
+//  - amostras/s que chegaram à SubHAL (e quantas se perderam no caminho);
+//  - latência p50/p99/p99.9 da escrita no PTY até o fim do onDataReceived();
+//  - alocações (operator new) e tempo de CPU por amostra, sem contar a
+//    thread da estação falsa.
+// O resumo legível vai para o stderr e o JSON para o stdout, para comparar
+// versões: airquality_pipeline_bench > pipeline.json
+//
+// Uso: airquality_pipeline_bench [--rates 1,10,100,flood] [--seconds S] [--binary]
+
+#include "AirQualitySubHal.h"
+#include "fake_station.h"
+
+#include <HalProxyCallback.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+using android::hardware::sensors::V2_0::implementation::IScopedWakelockRefCounter;
+using android::hardware::sensors::V2_1::implementation::HalProxyCallbackBase;
+
+// ---- Contagem de alocações ----
+
+static std::atomic<uint64_t> gAllocations{0};
+static thread_local bool tUntracked = false;  // Thread da estação falsa
+
+// Todas as formas substituíveis sem alinhamento, para new/delete casarem
+// (-Wmismatched-new-delete em Release)
+static void* countedAlloc(size_t size) {
+    if (!tUntracked) gAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+const int64_t kWarmupTimeoutNs = 10000000000LL;
+const size_t kMinSamplesPerRun = 20;  // 1 Hz roda pelo menos 20 s
+
+int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t cpuNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+class FakeRefCounter : public IScopedWakelockRefCounter {
+public:
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t, int64_t*) override { return true; }
+    void decrementRefCount(size_t) override {}
+};
+
+// Conta sem guardar nada: alocar aqui sujaria a medição
+class CountingCallback : public IHalProxyCallback {
+public:
+    CountingCallback() : mBase(nullptr, &mRefCounter, 0) {}
+
+    Return<void> onDynamicSensorsConnected(const hidl_vec<SensorInfo>&) override { return Void(); }
+    Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>&) override { return Void(); }
+
+    ScopedWakelock createScopedWakelock(bool lock) override {
+        return mBase.createScopedWakelock(lock);
+    }
+
+    void postEvents(const std::vector<Event>& events, ScopedWakelock) override {
+        mPosts.fetch_add(1, std::memory_order_relaxed);
+        mEvents.fetch_add(events.size(), std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> mPosts{0};
+    std::atomic<uint64_t> mEvents{0};
+
+private:
+    FakeRefCounter mRefCounter;
+    HalProxyCallbackBase mBase;
+};
+
+// Instante de envio de cada amostra, indexado pelo número de sequência que a
+// estação põe no pm25 (16 bits: dá a volta, mas muito depois de a amostra ter
+// passado pela SubHAL), e as latências na ordem de chegada
+struct Timeline {
+    explicit Timeline(size_t capacity) : latencies(capacity) {}
+
+    std::atomic<int64_t> sentNs[65536];
+    std::vector<int64_t> latencies;
+    std::atomic<size_t> count{0};
+};
+
+// Mede na saída do onDataReceived(): o fan-out e o postEvents já aconteceram
+class TimedSubHal : public AirQualitySubHal {
+public:
+    TimedSubHal(const std::string& port, Timeline* timeline)
+        : AirQualitySubHal(port, "127.0.0.1", 1), mTimeline(timeline) {}
+
+    void onDataReceived(const AirData& data) override {
+        AirQualitySubHal::onDataReceived(data);
+        int64_t t = nowNs();
+        uint16_t seq = static_cast<uint16_t>(data.pm25);
+        size_t i = mTimeline->count.load(std::memory_order_relaxed);
+        if (i >= mTimeline->latencies.size()) return;
+        mTimeline->latencies[i] = t - mTimeline->sentNs[seq].load(std::memory_order_relaxed);
+        mTimeline->count.store(i + 1, std::memory_order_release);
+    }
+
+private:
+    Timeline* mTimeline;
+};
+
+struct RunResult {
+    std::string label;
+    double targetHz;  // 0 = inundação
+    double seconds;
+    uint64_t sent;
+    uint64_t delivered;
+    uint64_t posts;
+    uint64_t events;
+    double p50Us, p99Us, p999Us, maxUs;
+    double allocsPerSample;
+    double cpuUsPerSample;
+};
+
+double percentileUs(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[idx] / 1000.0;
+}
+
+bool runRate(const std::string& label, double hz, double seconds, bool binary, RunResult* result) {
+    if (hz > 0) seconds = std::max(seconds, kMinSamplesPerRun / hz);
+    int64_t periodUs = hz > 0 ? static_cast<int64_t>(1e6 / hz) : 0;
+
+    int master = -1, slave = -1;
+    char slaveName[128];
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) < 0) {
+        fprintf(stderr, "ERRO: openpty falhou: %s\n", strerror(errno));
+        return false;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    // Inundação a dezenas de milhares de amostras/s
+    size_t capacity = static_cast<size_t>((hz > 0 ? hz : 100000) * (seconds + 15)) + 1024;
+    std::unique_ptr<Timeline> timeline(new Timeline(capacity));
+    for (auto& sent : timeline->sentNs) sent.store(0);
+
+    FakeStation::Features features;
+    features.binary = binary;
+    FakeStation station(master, features);
+    station.setSampleHook([&](uint16_t seq) {
+        timeline->sentNs[seq].store(nowNs(), std::memory_order_relaxed);
+    });
+
+    // A estação roda na própria thread, fora da contagem de alocações e de CPU
+    std::atomic<bool> stationRunning{true};
+    std::atomic<int64_t> stationCpuNs{0};
+    std::atomic<uint64_t> stationSent{0};
+    std::thread stationThread([&] {
+        tUntracked = true;
+        while (stationRunning) {
+            station.serve();
+            // O leitor negocia o próprio período (STREAM ON): a estação impõe o da bancada
+            if (station.streaming() && station.streamPeriodMs() != periodUs / 1000) {
+                station.startStream(periodUs);
+            }
+            stationSent.store(station.samplesSent(), std::memory_order_relaxed);
+            stationCpuNs.store(cpuNs(CLOCK_THREAD_CPUTIME_ID), std::memory_order_relaxed);
+            struct pollfd pfd = { master, POLLIN, 0 };
+            poll(&pfd, 1, periodUs < 1000 ? 0 : 1);
+        }
+    });
+
+    bool ok = true;
+    {
+        sp<CountingCallback> callback = new CountingCallback();
+        TimedSubHal subHal(slaveName, timeline.get());
+        subHal.initialize(callback);
+
+        std::vector<std::pair<int32_t, int64_t>> sensors;
+        subHal.getSensorsList([&](const hidl_vec<SensorInfo>& list) {
+            for (const auto& info : list) {
+                sensors.emplace_back(info.sensorHandle, static_cast<int64_t>(info.minDelay) * 1000);
+            }
+        });
+        for (const auto& sensor : sensors) {
+            subHal.batch(sensor.first, sensor.second, 0);
+            subHal.activate(sensor.first, true);
+        }
+
+        // Aquecimento: leitor conectado e amostras chegando na taxa da bancada
+        int64_t deadline = nowNs() + kWarmupTimeoutNs;
+        while (timeline->count.load() < 3 && nowNs() < deadline) usleep(1000);
+        if (timeline->count.load() < 3) {
+            fprintf(stderr, "ERRO: nenhuma amostra chegou à SubHAL (%s)\n", label.c_str());
+            ok = false;
+        }
+        usleep(200000);
+
+        int64_t startNs = nowNs();
+        size_t startIndex = timeline->count.load(std::memory_order_acquire);
+        uint64_t startSent = stationSent.load();
+        uint64_t startAllocs = gAllocations.load();
+        int64_t startCpu = cpuNs(CLOCK_PROCESS_CPUTIME_ID) - stationCpuNs.load();
+        uint64_t startPosts = callback->mPosts.load();
+        uint64_t startEvents = callback->mEvents.load();
+
+        usleep(static_cast<useconds_t>(seconds * 1e6));
+
+        int64_t endCpu = cpuNs(CLOCK_PROCESS_CPUTIME_ID) - stationCpuNs.load();
+        uint64_t endAllocs = gAllocations.load();
+        size_t endIndex = timeline->count.load(std::memory_order_acquire);
+        int64_t endNs = nowNs();
+
+        std::vector<int64_t> latencies(timeline->latencies.begin() + startIndex,
+                                       timeline->latencies.begin() + endIndex);
+        std::sort(latencies.begin(), latencies.end());
+        uint64_t delivered = endIndex - startIndex;
+        double windowSec = (endNs - startNs) / 1e9;
+
+        result->label = label;
+        result->targetHz = hz;
+        result->seconds = windowSec;
+        result->sent = stationSent.load() - startSent;
+        result->delivered = delivered;
+        result->posts = callback->mPosts.load() - startPosts;
+        result->events = callback->mEvents.load() - startEvents;
+        result->p50Us = percentileUs(latencies, 0.50);
+        result->p99Us = percentileUs(latencies, 0.99);
+        result->p999Us = percentileUs(latencies, 0.999);
+        result->maxUs = latencies.empty() ? 0.0 : latencies.back() / 1000.0;
+        result->allocsPerSample = delivered ? double(endAllocs - startAllocs) / delivered : 0.0;
+        result->cpuUsPerSample = delivered ? (endCpu - startCpu) / 1000.0 / delivered : 0.0;
+
+        // Estação muda antes de desmontar a SubHAL: nada mais entra no dispatcher
+        stationRunning = false;
+        stationThread.join();
+        for (const auto& sensor : sensors) subHal.activate(sensor.first, false);
+    }
+
+    close(slave);
+    close(master);
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    static const struct option kOptions[] = {
+        {"rates", required_argument, nullptr, 'r'},
+        {"seconds", required_argument, nullptr, 's'},
+        {"binary", no_argument, nullptr, 'b'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    std::string rates = "1,10,100,flood";
+    double seconds = 5;
+    bool binary = false;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:s:b", kOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'r': rates = optarg; break;
+            case 's': seconds = atof(optarg); break;
+            case 'b': binary = true; break;
+            default:
+                fprintf(stderr, "Uso: %s [--rates 1,10,100,flood] [--seconds S] [--binary]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    // Os logs da SubHAL (ativação, conexão) embaralhariam o resumo
+    setenv("ANDROID_LOG_TAGS", "*:w", 0);
+
+    std::vector<RunResult> results;
+    std::stringstream list(rates);
+    std::string label;
+    bool ok = true;
+    while (std::getline(list, label, ',')) {
+        double hz = label == "flood" ? 0.0 : atof(label.c_str());
+        if (label != "flood" && hz <= 0) {
+            fprintf(stderr, "Taxa inválida: %s\n", label.c_str());
+            return 2;
+        }
+        RunResult r;
+        ok &= runRate(label, hz, seconds, binary, &r);
+        results.push_back(r);
+        fprintf(stderr,
+                "%-6s %9.1f amostras/s (%llu/%llu)  p50 %8.1f us  p99 %8.1f us  "
+                "p99.9 %8.1f us  %5.2f allocs  %7.1f us CPU/amostra  %llu posts\n",
+                r.label.c_str(), r.delivered / r.seconds,
+                static_cast<unsigned long long>(r.delivered),
+                static_cast<unsigned long long>(r.sent), r.p50Us, r.p99Us, r.p999Us,
+                r.allocsPerSample, r.cpuUsPerSample, static_cast<unsigned long long>(r.posts));
+    }
+
+    printf("{\"benchmark\":\"airquality_pipeline\",\"format\":\"%s\",\"runs\":[",
+           binary ? "binary" : "json");
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& r = results[i];
+        printf("%s{\"rate\":\"%s\",\"target_hz\":%.1f,\"seconds\":%.3f,\"sent\":%llu,"
+               "\"delivered\":%llu,\"samples_per_s\":%.2f,\"posts\":%llu,\"events\":%llu,"
+               "\"latency_us\":{\"p50\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f},"
+               "\"allocs_per_sample\":%.3f,\"cpu_us_per_sample\":%.2f}",
+               i ? "," : "", r.label.c_str(), r.targetHz, r.seconds,
+               static_cast<unsigned long long>(r.sent),
+               static_cast<unsigned long long>(r.delivered), r.delivered / r.seconds,
+               static_cast<unsigned long long>(r.posts), static_cast<unsigned long long>(r.events),
+               r.p50Us, r.p99Us, r.p999Us, r.maxUs, r.allocsPerSample, r.cpuUsPerSample);
+    }
+    printf("]}\n");
+    return ok ? 0 : 1;
+}
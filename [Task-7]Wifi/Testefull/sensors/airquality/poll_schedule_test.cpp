@@ -0,0 +1,101 @@
+// Testes do PollSchedule: cada sub-sensor da estação pedido no seu ritmo, com
+// um "GET DATA" só quando mais de um vence junto.
+
+#include "io/PollSchedule.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// Todos os pedidos de [fromMs, toMs) com o leitor acordando a cada 100 ms
+std::vector<std::pair<int64_t, std::string>> drain(PollSchedule& schedule,
+                                                   const int (&periodsMs)[kStationTargets],
+                                                   int64_t fromMs, int64_t toMs) {
+    std::vector<std::pair<int64_t, std::string>> requests;
+    std::string cmd;
+    for (int64_t now = fromMs; now < toMs; now += 100) {
+        while (schedule.nextRequest(periodsMs, now, &cmd)) requests.push_back({now, cmd});
+    }
+    return requests;
+}
+
+}  // namespace
+
+TEST(PollScheduleTest, AllTargetsGoInOneRequest) {
+    PollSchedule schedule;
+    const int periods[kStationTargets] = {1000, 1000, 1000, 1000};
+    auto requests = drain(schedule, periods, 0, 5000);
+    ASSERT_EQ(5u, requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        EXPECT_EQ(static_cast<int64_t>(i) * 1000, requests[i].first);
+        EXPECT_EQ("GET DATA\n", requests[i].second);
+    }
+}
+
+TEST(PollScheduleTest, SingleTargetIsRequestedByName) {
+    PollSchedule schedule;
+    const int periods[kStationTargets] = {0, 0, 2000, 0};
+    auto requests = drain(schedule, periods, 0, 6000);
+    ASSERT_EQ(3u, requests.size());
+    EXPECT_EQ("GET DATA MQ7\n", requests[0].second);
+    EXPECT_EQ(2000, requests[1].first);
+    EXPECT_EQ(4000, requests[2].first);
+    EXPECT_EQ(6000, schedule.wakeupMs());
+}
+
+TEST(PollScheduleTest, SlowerTargetKeepsItsOwnCadence) {
+    PollSchedule schedule;
+    // PM a 1Hz, umidade a cada 10 s
+    const int periods[kStationTargets] = {1000, 0, 0, 10000};
+    auto requests = drain(schedule, periods, 0, 20000);
+    ASSERT_EQ(20u, requests.size());
+    for (const auto& request : requests) {
+        bool both = request.first % 10000 == 0;
+        EXPECT_EQ(both ? "GET DATA\n" : "GET DATA SDS011\n", request.second) << request.first;
+    }
+}
+
+TEST(PollScheduleTest, NeverFasterThanTheSubSensorRefreshes) {
+    PollSchedule schedule;
+    const int periods[kStationTargets] = {0, 0, 0, 100};
+    auto requests = drain(schedule, periods, 0, 10000);
+    ASSERT_EQ(5u, requests.size());
+    EXPECT_EQ(PollSchedule::minPeriodMs(TARGET_DHT), requests[1].first);
+    EXPECT_EQ("GET DATA DHT\n", requests[1].second);
+}
+
+TEST(PollScheduleTest, FollowsPeriodChangesAndReset) {
+    PollSchedule schedule;
+    std::string cmd;
+    const int slow[kStationTargets] = {10000, 0, 0, 0};
+    const int fast[kStationTargets] = {1000, 0, 0, 0};
+    ASSERT_TRUE(schedule.nextRequest(slow, 0, &cmd));
+    EXPECT_FALSE(schedule.nextRequest(slow, 1500, &cmd));
+    EXPECT_EQ(10000, schedule.wakeupMs());
+
+    // Período encurtado: vence pelo último pedido, sem esperar o prazo antigo
+    EXPECT_TRUE(schedule.nextRequest(fast, 1500, &cmd));
+    EXPECT_EQ(2500, schedule.wakeupMs());
+
+    // Alvo fora de uso não é pedido nem acorda o leitor
+    const int none[kStationTargets] = {0, 0, 0, 0};
+    EXPECT_FALSE(schedule.nextRequest(none, 5000, &cmd));
+    EXPECT_EQ(INT64_MAX, schedule.wakeupMs());
+
+    // Nova conexão: pede já
+    EXPECT_FALSE(schedule.nextRequest(fast, 2000, &cmd));
+    schedule.reset();
+    EXPECT_TRUE(schedule.nextRequest(fast, 2000, &cmd));
+}
+
+TEST(PollScheduleTest, StreamTargetOnlyWhenOneIsInUse) {
+    const int one[kStationTargets] = {0, 500, 0, 0};
+    const int two[kStationTargets] = {500, 500, 0, 0};
+    const int none[kStationTargets] = {0, 0, 0, 0};
+    EXPECT_STREQ("MQ2", PollSchedule::streamTarget(one));
+    EXPECT_EQ(nullptr, PollSchedule::streamTarget(two));
+    EXPECT_EQ(nullptr, PollSchedule::streamTarget(none));
+}
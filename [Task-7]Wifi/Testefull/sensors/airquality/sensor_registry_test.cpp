@@ -0,0 +1,230 @@
+// Testes do SensorRegistry: tabela handle -> índice, bitmask de ativos e o
+// fan-out de uma amostra para todos os sensores numa passada.
+
+#include "sensors/SensorRegistry.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+const int64_t kMsNs = 1000000LL;
+
+// Mesma tabela da SubHAL
+void addAll(SensorRegistry* registry) {
+    registry->add(5001, AirQualitySensor::SENSOR_PM25);
+    registry->add(5002, AirQualitySensor::SENSOR_PM10);
+    registry->add(5003, AirQualitySensor::SENSOR_CO);
+    registry->add(5004, AirQualitySensor::SENSOR_LPG);
+    registry->add(5005, AirQualitySensor::SENSOR_TEMP);
+    registry->add(5006, AirQualitySensor::SENSOR_HUMID);
+    registry->add(5099, AirQualitySensor::SENSOR_SOURCE);
+}
+
+AirData sample(int64_t timestamp) {
+    AirData data;
+    data.timestamp = timestamp;
+    data.pm25 = 12.5f;
+    data.co_ppm = 0.0f;  // Zero é leitura válida
+    data.humid_p = 55.0f;  // temp_c fica no padrão: sem leitura
+    data.source = "wifi";
+    data.valid = true;
+    return data;
+}
+
+}  // namespace
+
+TEST(SensorRegistryTest, MapsHandlesToIndices) {
+    SensorRegistry registry;
+    addAll(&registry);
+    ASSERT_EQ(7u, registry.size());
+
+    EXPECT_EQ(0, registry.indexOf(5001));
+    EXPECT_EQ(5, registry.indexOf(5006));
+    EXPECT_EQ(6, registry.indexOf(5099));
+    EXPECT_EQ(5099, registry.find(5099)->getSensorInfo().sensorHandle);
+
+    EXPECT_EQ(-1, registry.indexOf(5000));
+    EXPECT_EQ(-1, registry.indexOf(5007));
+    EXPECT_EQ(-1, registry.indexOf(-1));
+    EXPECT_EQ(-1, registry.indexOf(SensorRegistry::kHandleBase + SensorRegistry::kHandleRange));
+    EXPECT_EQ(nullptr, registry.find(4999));
+
+    // Repetido ou fora da faixa
+    EXPECT_EQ(-1, registry.add(5001, AirQualitySensor::SENSOR_PM25));
+    EXPECT_EQ(-1, registry.add(4000, AirQualitySensor::SENSOR_PM25));
+}
+
+TEST(SensorRegistryTest, TracksActiveMask) {
+    SensorRegistry registry;
+    addAll(&registry);
+    EXPECT_EQ(0u, registry.activeMask());
+
+    registry.setActive(registry.indexOf(5003), true);
+    registry.setActive(registry.indexOf(5099), true);
+    EXPECT_EQ((1u << 2) | (1u << 6), registry.activeMask());
+    EXPECT_TRUE(registry.find(5003)->isActive());
+
+    registry.setActive(registry.indexOf(5003), false);
+    EXPECT_EQ(1u << 6, registry.activeMask());
+    EXPECT_FALSE(registry.find(5003)->isActive());
+}
+
+TEST(SensorRegistryTest, FansOutOnlyValidReadings) {
+    SensorRegistry registry;
+    addAll(&registry);
+    for (size_t i = 0; i < registry.size(); i++) registry.setActive(i, true);
+
+    Event events[SensorRegistry::kMaxSensors];
+    size_t count = registry.fanOut(sample(1000), events);
+
+    // PM10 e LPG ausentes (-1), temperatura inválida
+    ASSERT_EQ(4u, count);
+    EXPECT_EQ(5001, events[0].sensorHandle);
+    EXPECT_EQ(12.5f, events[0].u.scalar);
+    EXPECT_EQ(5003, events[1].sensorHandle);
+    EXPECT_EQ(0.0f, events[1].u.scalar);
+    EXPECT_EQ(5006, events[2].sensorHandle);
+    EXPECT_EQ(SensorType::RELATIVE_HUMIDITY, events[2].sensorType);
+    EXPECT_EQ(5099, events[3].sensorHandle);
+    EXPECT_EQ(1.0f, events[3].u.scalar);  // Wi-Fi
+    for (size_t i = 0; i < count; i++) EXPECT_EQ(1000, events[i].timestamp);
+
+    AirData invalid = sample(2000);
+    invalid.valid = false;
+    EXPECT_EQ(0u, registry.fanOut(invalid, events));
+}
+
+TEST(SensorRegistryTest, PartialSamplesSkipMissingFields) {
+    SensorRegistry registry;
+    addAll(&registry);
+    for (size_t i = 0; i < registry.size(); i++) registry.setActive(i, true);
+    Event events[SensorRegistry::kMaxSensors];
+
+    AirData dht;
+    dht.timestamp = 1000;
+    dht.temp_c = 25.0f;
+    dht.humid_p = 50.0f;
+    dht.valid = true;
+    ASSERT_EQ(3u, registry.fanOut(dht, events));  // Temperatura, umidade e fonte
+
+    // Resposta do "GET DATA SDS011": só o PM, o resto com os padrões do AirData
+    AirData sds;
+    sds.timestamp = 2000 * kMsNs;
+    sds.pm25 = 12.0f;
+    sds.valid = true;
+    size_t count = registry.fanOut(sds, events);
+    ASSERT_EQ(1u, count);  // A fonte não mudou: on-change
+    EXPECT_EQ(5001, events[0].sensorHandle);
+
+    // A temperatura segue em 25: nenhum -273 no meio
+    dht.timestamp = 3000 * kMsNs;
+    dht.temp_c = 25.0f;
+    EXPECT_EQ(0u, registry.fanOut(dht, events));
+
+    // Só o canal direto lê sem decimação; o mesmo vale para ele
+    size_t read = registry.read(sds, registry.activeMask(), events);
+    for (size_t i = 0; i < read; i++) EXPECT_NE(5005, events[i].sensorHandle);
+}
+
+TEST(SensorRegistryTest, DecimatesPerSensor) {
+    SensorRegistry registry;
+    addAll(&registry);
+    int co = registry.indexOf(5003);
+    int pm25 = registry.indexOf(5001);
+    registry.batch(co, 100 * kMsNs, 0);
+    registry.batch(pm25, 100 * kMsNs, 0);  // Limitado ao minDelay de 1 s
+    registry.setActive(co, true);
+    registry.setActive(pm25, true);
+
+    Event events[SensorRegistry::kMaxSensors];
+    int coEvents = 0, pmEvents = 0;
+    for (int i = 0; i < 15; i++) {  // 10Hz por 1,5 s
+        size_t count = registry.fanOut(sample(1 + i * 100 * kMsNs), events);
+        for (size_t j = 0; j < count; j++) {
+            if (events[j].sensorHandle == 5003) coEvents++;
+            if (events[j].sensorHandle == 5001) pmEvents++;
+        }
+    }
+    EXPECT_EQ(15, coEvents);
+    EXPECT_EQ(2, pmEvents);
+
+    // Sem decimação e sem olhar ativação (canal direto)
+    uint64_t direct = uint64_t(1) << registry.indexOf(5006);
+    EXPECT_EQ(1u, registry.read(sample(1), direct, events));
+    EXPECT_EQ(1u, registry.read(sample(2), direct, events));
+}
+
+TEST(SensorRegistryTest, HistorySensorsCarryTheWindows) {
+    SensorRegistry registry;
+    addAll(&registry);
+    int pm25 = registry.add(5011, AirQualitySensor::SENSOR_PM25_HISTORY);
+    int temp = registry.add(5015, AirQualitySensor::SENSOR_TEMP_HISTORY);
+    ASSERT_GE(pm25, 0);
+    EXPECT_EQ(std::string("com.airstation.sensor.pm25.history"),
+              registry[pm25].getSensorInfo().typeAsString.c_str());
+    registry.setActive(pm25, true);
+    registry.setActive(temp, true);
+
+    // Sem histórico ligado não há o que entregar
+    Event events[SensorRegistry::kMaxSensors];
+    EXPECT_EQ(0u, registry.fanOut(sample(kMsNs), events));
+
+    AirHistory history;
+    registry.setHistory(&history);
+    AirData first = sample(2000 * kMsNs);
+    first.pm25 = 10.0f;
+    history.add(first);
+    AirData second = sample(3000 * kMsNs);
+    history.add(second);
+
+    // Temperatura inválida na amostra: só o de PM2.5
+    ASSERT_EQ(1u, registry.fanOut(second, events));
+    EXPECT_EQ(5011, events[0].sensorHandle);
+    for (int w = 0; w < AirHistory::kWindows; w++) {
+        const float* values = events[0].u.data + w * AirHistory::kValuesPerWindow;
+        EXPECT_FLOAT_EQ(11.25f, values[0]);  // Média
+        EXPECT_EQ(10.0f, values[1]);
+        EXPECT_EQ(12.5f, values[2]);
+    }
+    EXPECT_EQ(0.0f, events[0].u.data[AirHistory::kValues]);
+}
+
+TEST(SensorRegistryTest, IndexSensorsReportOnlyChanges) {
+    SensorRegistry registry;
+    addAll(&registry);
+    int epa = registry.add(5021, AirQualitySensor::SENSOR_AQI_US_EPA);
+    ASSERT_GE(epa, 0);
+    EXPECT_EQ(static_cast<uint32_t>(SensorFlagBits::ON_CHANGE_MODE),
+              registry[epa].getSensorInfo().flags & static_cast<uint32_t>(SensorFlagBits::MASK_REPORTING_MODE));
+    registry.setActive(epa, true);
+
+    AirHistory history;
+    registry.setHistory(&history);
+    Event events[SensorRegistry::kMaxSensors];
+    auto feed = [&](int64_t t, float pm25) {
+        AirData data = sample(t);
+        data.pm25 = pm25;
+        history.add(data);
+        return registry.fanOut(data, events);
+    };
+
+    // 12,5 ug/m3 -> 57; a mesma média não gera evento de novo
+    ASSERT_EQ(1u, feed(1000 * kMsNs, 12.5f));
+    EXPECT_EQ(5021, events[0].sensorHandle);
+    EXPECT_EQ(57.0f, events[0].u.data[0]);
+    EXPECT_EQ(static_cast<float>(AirQualityIndex::POLLUTANT_PM25), events[0].u.data[1]);
+    EXPECT_EQ(0u, feed(2000 * kMsNs, 12.5f));
+
+    // Média de 24 h sobe para 35,4 -> 100
+    EXPECT_EQ(1u, feed(3000 * kMsNs, 81.3f));
+    EXPECT_EQ(100.0f, events[0].u.data[0]);
+
+    // Religado, o índice atual sai mesmo sem mudar
+    registry.setActive(epa, false);
+    registry.setActive(epa, true);
+    AirData same = sample(4000 * kMsNs);
+    same.pm25 = -1.0f;  // Sem PM2.5 nesta amostra: a média não mexe
+    history.add(same);
+    ASSERT_EQ(1u, registry.fanOut(same, events));
+    EXPECT_EQ(100.0f, events[0].u.data[0]);
+}
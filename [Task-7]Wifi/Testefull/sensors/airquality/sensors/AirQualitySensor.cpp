@@ -3,6 +3,7 @@
 #include "AirQualitySensor.h"
 #include <log/log.h>
 #include <cmath> 
+#include <limits>
 
 // IDs internos para identificar tipos customizados
 static const int TYPE_CUST_PM25   = 0x10001; 
@@ -10,19 +11,47 @@ static const int TYPE_CUST_PM10   = 0x10002;
 static const int TYPE_CUST_CO     = 0x10003;
 static const int TYPE_CUST_LPG    = 0x10004;
 static const int TYPE_CUST_SOURCE = 0x10005; // <-- ADICIONADO: ID do sensor de Fonte
+static const int TYPE_CUST_HISTORY = 0x10011; // + canal (PM2.5 .. umidade)
+static const int TYPE_CUST_AQI     = 0x10021; // + escala (US EPA, IQAr)
+
+// Sensores de histórico: nome e tipo derivados do canal
+static const struct {
+    const char* name;
+    const char* typeAsString;
+    float maxRange;
+} kHistoryInfo[] = {
+    {"Historico PM2.5 (1min/1h/24h)", "com.airstation.sensor.pm25.history", 999.9f},
+    {"Historico PM10 (1min/1h/24h)", "com.airstation.sensor.pm10.history", 999.9f},
+    {"Historico CO (1min/1h/24h)", "com.airstation.sensor.co.history", 1000.0f},
+    {"Historico LPG (1min/1h/24h)", "com.airstation.sensor.lpg.history", 10000.0f},
+    {"Historico Temperatura (1min/1h/24h)", "com.airstation.sensor.temperature.history", 80.0f},
+    {"Historico Umidade (1min/1h/24h)", "com.airstation.sensor.humidity.history", 100.0f},
+};
+
+// Alvo da estação de cada canal do histórico (ordem do AirHistory)
+static const uint8_t kHistoryTargets[] = {
+    1 << TARGET_SDS011, 1 << TARGET_SDS011, 1 << TARGET_MQ7,
+    1 << TARGET_MQ2,    1 << TARGET_DHT,    1 << TARGET_DHT,
+};
 
 AirQualitySensor::AirQualitySensor(int32_t handle, Type type) 
-    : mType(type), mActive(false) {
+    : mType(type), mActive(false), mReportPolicy(REPORT_CONTINUOUS), mReportSteps(0), mTargets(0),
+      mSamplingPeriodNs(1000000000LL), mMaxReportLatencyNs(0),
+      mFifo(kFifoCapacity), mFifoHead(0), mFifoCount(0) {
     
     // Configuração Genérica
     mInfo.sensorHandle = handle;
     mInfo.vendor = "Projeto AirStation (ESP32)";
     mInfo.version = 1;
-    mInfo.fifoReservedEventCount = 0;
-    mInfo.fifoMaxEventCount = 0;
+    mInfo.fifoReservedEventCount = kFifoCapacity; // FIFO própria, não compartilhada
+    mInfo.fifoMaxEventCount = kFifoCapacity;
     mInfo.requiredPermission = "";
+    mInfo.minDelay = 1000000; // 1 segundo (SDS011 e DHT11 atualizam a 1Hz)
     mInfo.maxDelay = 1000000; // 1 segundo
-    mInfo.flags = 0; // SensorMode::OnChange
+    // Contínuo; também escreve direto num canal ashmem (taxa NORMAL, ver DirectChannel)
+    mInfo.flags = static_cast<uint32_t>(SensorFlagBits::DIRECT_CHANNEL_ASHMEM) |
+                  (static_cast<uint32_t>(RateLevel::NORMAL)
+                   << static_cast<uint8_t>(SensorFlagShift::DIRECT_REPORT));
 
     // Configuração Específica por Tipo
     switch (mType) {
@@ -33,6 +62,7 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 999.9f;
             mInfo.resolution = 0.1f;
             mInfo.power = 0.5f; 
+            mTargets = 1 << TARGET_SDS011;
             break;
 
         case SENSOR_PM10:
@@ -42,6 +72,7 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 999.9f;
             mInfo.resolution = 0.1f;
             mInfo.power = 0.5f;
+            mTargets = 1 << TARGET_SDS011;
             break;
 
         case SENSOR_CO:
@@ -51,6 +82,8 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 1000.0f;
             mInfo.resolution = 0.1f;
             mInfo.power = 0.8f; 
+            mInfo.minDelay = 100000; // MQ é analógico: com "STREAM ON" chega a 10Hz
+            mTargets = 1 << TARGET_MQ7;
             break;
 
         case SENSOR_LPG:
@@ -60,6 +93,8 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 10000.0f;
             mInfo.resolution = 1.0f;
             mInfo.power = 0.8f;
+            mInfo.minDelay = 100000; // MQ é analógico: com "STREAM ON" chega a 10Hz
+            mTargets = 1 << TARGET_MQ2;
             break;
 
         case SENSOR_TEMP:
@@ -69,6 +104,10 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 80.0f;
             mInfo.resolution = 0.1f;
             mInfo.power = 0.1f;
+            // On-change como no Android; o DHT repete o mesmo valor por vários segundos
+            mReportPolicy = REPORT_DELTA;
+            mReportSteps = 1;
+            mTargets = 1 << TARGET_DHT;
             break;
 
         case SENSOR_HUMID:
@@ -78,6 +117,9 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 100.0f;
             mInfo.resolution = 0.1f;
             mInfo.power = 0.1f;
+            mReportPolicy = REPORT_DELTA;
+            mReportSteps = 1;
+            mTargets = 1 << TARGET_DHT;
             break;
 
         // <-- ADICIONADO: Configuração do Sensor de Fonte
@@ -88,7 +130,53 @@ AirQualitySensor::AirQualitySensor(int32_t handle, Type type)
             mInfo.maxRange = 1.0f; // 0 = Serial, 1 = Wi-Fi
             mInfo.resolution = 1.0f;
             mInfo.power = 0.0f;
+            mReportPolicy = REPORT_ON_CHANGE; // Só na troca de enlace
+            // Qualquer resposta da estação serve: sem alvo próprio
             break;
+
+        case SENSOR_PM25_HISTORY:
+        case SENSOR_PM10_HISTORY:
+        case SENSOR_CO_HISTORY:
+        case SENSOR_LPG_HISTORY:
+        case SENSOR_TEMP_HISTORY:
+        case SENSOR_HUMID_HISTORY: {
+            int channel = mType - SENSOR_PM25_HISTORY;
+            mInfo.name = kHistoryInfo[channel].name;
+            mInfo.type = (SensorType)(TYPE_CUST_HISTORY + channel);
+            mInfo.typeAsString = kHistoryInfo[channel].typeAsString;
+            mInfo.maxRange = kHistoryInfo[channel].maxRange;
+            mInfo.resolution = 0.1f;
+            mInfo.power = 0.0f; // Calculado na HAL, sem custo na estação
+            mTargets = kHistoryTargets[channel];
+            break;
+        }
+
+        case SENSOR_AQI_US_EPA:
+            mInfo.name = "Indice de Qualidade do Ar (US EPA)";
+            mInfo.type = (SensorType)TYPE_CUST_AQI;
+            mInfo.typeAsString = "com.airstation.sensor.aqi.us_epa";
+            mInfo.maxRange = 500.0f;
+            mInfo.resolution = 1.0f;
+            mInfo.power = 0.0f;
+            mReportPolicy = REPORT_ON_CHANGE; // Só sai quando o índice muda
+            mTargets = (1 << TARGET_SDS011) | (1 << TARGET_MQ7);  // PM e CO
+            break;
+
+        case SENSOR_AQI_BR_IQAR:
+            mInfo.name = "Indice de Qualidade do Ar (IQAr CONAMA)";
+            mInfo.type = (SensorType)(TYPE_CUST_AQI + 1);
+            mInfo.typeAsString = "com.airstation.sensor.aqi.br_iqar";
+            mInfo.maxRange = 400.0f;
+            mInfo.resolution = 1.0f;
+            mInfo.power = 0.0f;
+            mReportPolicy = REPORT_ON_CHANGE;
+            mTargets = (1 << TARGET_SDS011) | (1 << TARGET_MQ7);
+            break;
+    }
+
+    // Canal direto só para os contínuos
+    if (mReportPolicy != REPORT_CONTINUOUS) {
+        mInfo.flags = static_cast<uint32_t>(SensorFlagBits::ON_CHANGE_MODE);
     }
 }
 
@@ -96,46 +184,58 @@ const SensorInfo& AirQualitySensor::getSensorInfo() const {
     return mInfo;
 }
 
+float AirQualitySensor::getReportThreshold() const {
+    // Meio passo de folga: 25.2f - 25.1f dá 0.0999 em float
+    return mReportPolicy == REPORT_DELTA ? (mReportSteps - 0.5f) * mInfo.resolution : 0.0f;
+}
+
+void AirQualitySensor::setDynamic(const std::string& deviceId) {
+    mInfo.flags |= static_cast<uint32_t>(SensorFlagBits::DYNAMIC_SENSOR);
+    mInfo.name = std::string(mInfo.name.c_str()) + " [" + deviceId + "]";
+}
+
 void AirQualitySensor::setActive(bool active) {
     if (mActive != active) {
         mActive = active;
+        // Desligando: o pendente é descartado
+        mFifoHead = 0;
+        mFifoCount = 0;
         ALOGD("Sensor %s (Handle %d) definido como: %s", 
               mInfo.name.c_str(), mInfo.sensorHandle, active ? "ATIVO" : "INATIVO");
     }
 }
 
-void AirQualitySensor::batch(int64_t /*samplingPeriodNs*/, int64_t /*maxReportLatencyNs*/) {
+void AirQualitySensor::batch(int64_t samplingPeriodNs, int64_t maxReportLatencyNs) {
+    int64_t minNs = static_cast<int64_t>(mInfo.minDelay) * 1000;
+    int64_t maxNs = static_cast<int64_t>(mInfo.maxDelay) * 1000;
+    if (samplingPeriodNs < minNs) samplingPeriodNs = minNs;
+    if (samplingPeriodNs > maxNs) samplingPeriodNs = maxNs;
+    mSamplingPeriodNs = samplingPeriodNs;
+    mMaxReportLatencyNs = maxReportLatencyNs > 0 ? maxReportLatencyNs : 0;
 }
 
-bool AirQualitySensor::processInput(const AirData& data, Event* outEvent) {
-    if (!mActive || !data.valid) return false;
-
-    float value = -1.0f;
-
-    switch (mType) {
-        case SENSOR_PM25: value = data.pm25; break;
-        case SENSOR_PM10: value = data.pm10; break;
-        case SENSOR_CO:   value = data.co_ppm; break;
-        case SENSOR_LPG:  value = data.lpg_ppm; break;
-        case SENSOR_TEMP: value = data.temp_c; break;
-        case SENSOR_HUMID:value = data.humid_p; break;
-        
-        // <-- ADICIONADO: Traduz a string de origem para valor numérico
-        case SENSOR_SOURCE: 
-            value = (data.source == "wifi") ? 1.0f : 0.0f; 
-            break;
+bool AirQualitySensor::pushEvent(const Event& event) {
+    bool fit = mFifoCount < kFifoCapacity;
+    if (fit) {
+        mFifo[(mFifoHead + mFifoCount) % kFifoCapacity] = event;
+        mFifoCount++;
+    } else {
+        ALOGW("FIFO do sensor %d cheia: descartando o evento mais antigo", mInfo.sensorHandle);
+        mFifo[mFifoHead] = event;
+        mFifoHead = (mFifoHead + 1) % kFifoCapacity;
     }
+    return fit;
+}
 
-    if (mType == SENSOR_TEMP) {
-        if (value < -273.0f) return false;
-    } else if (mType != SENSOR_SOURCE) { // O sensor de fonte pode ser 0.0f (Serial)
-        if (value < 0.0f) return false;
+void AirQualitySensor::drainFifo(std::vector<Event>* out) {
+    for (size_t i = 0; i < mFifoCount; i++) {
+        out->push_back(mFifo[(mFifoHead + i) % kFifoCapacity]);
     }
+    mFifoHead = 0;
+    mFifoCount = 0;
+}
 
-    outEvent->sensorHandle = mInfo.sensorHandle;
-    outEvent->sensorType = mInfo.type;
-    outEvent->timestamp = data.timestamp; 
-    outEvent->u.scalar = value;
-    
-    return true;
-}
\ No newline at end of file
+int64_t AirQualitySensor::fifoDeadlineNs() const {
+    if (mFifoCount == 0) return std::numeric_limits<int64_t>::max();
+    return mFifo[mFifoHead].timestamp + mMaxReportLatencyNs;
+}
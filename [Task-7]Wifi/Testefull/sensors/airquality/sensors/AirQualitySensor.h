@@ -8,12 +8,20 @@
 using android::hardware::sensors::V1_0::SensorInfo;
 using android::hardware::sensors::V1_0::SensorType;
 using android::hardware::sensors::V1_0::Event;
+using android::hardware::sensors::V1_0::RateLevel;
+using android::hardware::sensors::V1_0::SensorFlagBits;
+using android::hardware::sensors::V1_0::SensorFlagShift;
 
 /**
  * Representa um sensor individual (físico ou virtual) gerenciado pela HAL.
+ * A extração do valor a partir do AirData fica no SensorRegistry.
  */
 class AirQualitySensor {
 public:
+    // Eventos que cada sensor guarda enquanto espera o maxReportLatency
+    // (5 min a 1Hz, 30 s a 10Hz). Alocados uma vez no construtor.
+    static constexpr uint32_t kFifoCapacity = 300;
+
     // Enumeração interna para identificar qual dado este objeto processa
     enum Type {
         SENSOR_PM25,    // Customizado
@@ -22,7 +30,26 @@ public:
         SENSOR_LPG,     // Customizado
         SENSOR_TEMP,    // Oficial Android (AMBIENT_TEMPERATURE)
         SENSOR_HUMID,   // Oficial Android (RELATIVE_HUMIDITY)
-        SENSOR_SOURCE   // <-- ADICIONADO: Fonte de Dados (Wi-Fi ou Serial)
+        SENSOR_SOURCE,  // <-- ADICIONADO: Fonte de Dados (Wi-Fi ou Serial)
+        // Virtuais: média, mínimo, máximo e EWMA de 1 min, 1 h e 24 h de cada
+        // canal (AirHistory), nos 12 primeiros floats de Event::u.data
+        SENSOR_PM25_HISTORY,
+        SENSOR_PM10_HISTORY,
+        SENSOR_CO_HISTORY,
+        SENSOR_LPG_HISTORY,
+        SENSOR_TEMP_HISTORY,
+        SENSOR_HUMID_HISTORY,
+        // Virtuais on-change: índice de qualidade do ar (AirQualityIndex) em
+        // u.data[0] e o poluente dominante em u.data[1]
+        SENSOR_AQI_US_EPA,
+        SENSOR_AQI_BR_IQAR
+    };
+
+    // Quando uma amostra vira evento (fixo por tipo)
+    enum ReportPolicy {
+        REPORT_CONTINUOUS,  // Toda amostra (respeitando o samplingPeriod)
+        REPORT_ON_CHANGE,   // Só quando o valor muda
+        REPORT_DELTA        // Só quando muda pelo menos N x resolution desde o último entregue
     };
 
     /**
@@ -34,13 +61,44 @@ public:
     ~AirQualitySensor() = default;
 
     const SensorInfo& getSensorInfo() const;
-    bool processInput(const AirData& data, Event* outEvent);
+    /// Sensor de uma estação que vem e vai: DYNAMIC_SENSOR e o device_id no nome.
+    void setDynamic(const std::string& deviceId);
     void setActive(bool active);
     bool isActive() const { return mActive; }
     void batch(int64_t samplingPeriodNs, int64_t maxReportLatencyNs);
+    int64_t getSamplingPeriodNs() const { return mSamplingPeriodNs; }
+    int64_t getMaxReportLatencyNs() const { return mMaxReportLatencyNs; }
+    ReportPolicy getReportPolicy() const { return mReportPolicy; }
+    /// Variação mínima para um novo evento (0 em REPORT_ON_CHANGE: qualquer uma).
+    float getReportThreshold() const;
+    /// Máscara dos StationTarget de que o sensor depende (0 = qualquer resposta serve).
+    uint8_t getStationTargets() const { return mTargets; }
+
+    /**
+     * @name FIFO de batching
+     * Não é thread-safe: a SubHAL protege os sensores com o próprio lock.
+     * @{ */
+    /// Enfileira o evento. Retorna false (descartando o mais antigo) se estava cheia.
+    bool pushEvent(const Event& event);
+    /// Move os eventos pendentes, em ordem, para o fim de *out.
+    void drainFifo(std::vector<Event>* out);
+    bool fifoFull() const { return mFifoCount == kFifoCapacity; }
+    size_t fifoSize() const { return mFifoCount; }
+    /// Instante (elapsedRealtimeNano) em que o evento mais antigo vence; INT64_MAX se vazia.
+    int64_t fifoDeadlineNs() const;
+    /** @} */
 
 private:
     Type mType;         // Tipo do sensor
     bool mActive;       // Estado atual (Ligado/Desligado)
     SensorInfo mInfo;   // Estrutura de metadados do Android
+    ReportPolicy mReportPolicy; // Os não contínuos são anunciados ON_CHANGE_MODE
+    int mReportSteps;   // N de REPORT_DELTA
+    uint8_t mTargets;   // StationTarget que alimentam o sensor
+    int64_t mSamplingPeriodNs; // Último período pedido via batch() (limitado a min/maxDelay)
+    int64_t mMaxReportLatencyNs; // 0 = entregar cada amostra na hora
+
+    std::vector<Event> mFifo;  // Anel de kFifoCapacity posições
+    size_t mFifoHead;          // Posição do evento mais antigo
+    size_t mFifoCount;
 };
\ No newline at end of file
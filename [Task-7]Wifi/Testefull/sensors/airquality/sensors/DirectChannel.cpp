@@ -0,0 +1,81 @@
+#define LOG_TAG "AirQualityDirect"
+
+#include "DirectChannel.h"
+#include <log/log.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+using android::hardware::sensors::V1_0::SensorsEventFormatOffset;
+using android::hardware::sensors::V1_0::SharedMemFormat;
+using android::hardware::sensors::V1_0::SharedMemType;
+
+namespace {
+
+size_t offsetOf(SensorsEventFormatOffset field) {
+    return static_cast<size_t>(field);
+}
+
+const size_t kRecordSize = offsetOf(SensorsEventFormatOffset::TOTAL_LENGTH);
+const size_t kDataSize = offsetOf(SensorsEventFormatOffset::RESERVED) -
+                         offsetOf(SensorsEventFormatOffset::DATA);
+
+static_assert(sizeof(Event::u) == 16 * sizeof(float), "payload do Event != 16 floats");
+
+void put32(uint8_t* record, SensorsEventFormatOffset field, int32_t value) {
+    memcpy(record + offsetOf(field), &value, sizeof(value));
+}
+
+}  // namespace
+
+DirectChannel::DirectChannel(const SharedMemInfo& mem)
+    : mBase(nullptr), mSize(0), mSlots(0), mCounter(0) {
+    const native_handle_t* handle = mem.memoryHandle.getNativeHandle();
+    if (mem.type != SharedMemType::ASHMEM || mem.format != SharedMemFormat::SENSORS_EVENT ||
+        mem.size < kRecordSize || handle == nullptr || handle->numFds < 1) {
+        ALOGE("Canal direto recusado: tipo %d, formato %d, %u bytes",
+              static_cast<int>(mem.type), static_cast<int>(mem.format), mem.size);
+        return;
+    }
+
+    void* base = mmap(nullptr, mem.size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->data[0], 0);
+    if (base == MAP_FAILED) {
+        ALOGE("Canal direto: mmap de %u bytes falhou: %s", mem.size, strerror(errno));
+        return;
+    }
+    mBase = static_cast<uint8_t*>(base);
+    mSize = mem.size;
+    mSlots = mSize / kRecordSize;
+}
+
+DirectChannel::~DirectChannel() {
+    if (mBase != nullptr) munmap(mBase, mSize);
+}
+
+void DirectChannel::setRate(int32_t sensorHandle, RateLevel rate) {
+    if (rate == RateLevel::STOP) {
+        mRates.erase(sensorHandle);
+    } else {
+        mRates[sensorHandle] = rate;
+    }
+}
+
+void DirectChannel::write(const Event& event) {
+    uint8_t* record = mBase + (mCounter % mSlots) * kRecordSize;
+
+    put32(record, SensorsEventFormatOffset::SIZE_FIELD, static_cast<int32_t>(kRecordSize));
+    put32(record, SensorsEventFormatOffset::REPORT_TOKEN, event.sensorHandle);
+    put32(record, SensorsEventFormatOffset::SENSOR_TYPE, static_cast<int32_t>(event.sensorType));
+    memcpy(record + offsetOf(SensorsEventFormatOffset::TIMESTAMP), &event.timestamp,
+           sizeof(event.timestamp));
+    memcpy(record + offsetOf(SensorsEventFormatOffset::DATA), &event.u, kDataSize);
+    memset(record + offsetOf(SensorsEventFormatOffset::RESERVED), 0,
+           kRecordSize - offsetOf(SensorsEventFormatOffset::RESERVED));
+
+    // Contador por último: quem lê só confia no registro depois de vê-lo mudar
+    mCounter++;
+    if (mCounter == 0) mCounter = 1;
+    __atomic_store_n(reinterpret_cast<uint32_t*>(record + offsetOf(SensorsEventFormatOffset::ATOMIC_COUNTER)),
+                     mCounter, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <android/hardware/sensors/1.0/types.h>
+#include <map>
+#include <stdint.h>
+
+using android::hardware::sensors::V1_0::Event;
+using android::hardware::sensors::V1_0::RateLevel;
+using android::hardware::sensors::V1_0::SharedMemInfo;
+
+/**
+ * Canal de report direto: anel de registros sensors_event_t (104 bytes, ver
+ * SensorsEventFormatOffset) na memória compartilhada do cliente. Um daemon de
+ * log lê as amostras sem passar pelo postEvents/FMQ do SensorService.
+ *
+ * Só ASHMEM: o fd é mapeado no registro e a memória continua válida depois
+ * que o framework fecha o handle. Não é thread-safe (a SubHAL protege).
+ */
+class DirectChannel {
+public:
+    explicit DirectChannel(const SharedMemInfo& mem);
+    ~DirectChannel();
+
+    DirectChannel(const DirectChannel&) = delete;
+    DirectChannel& operator=(const DirectChannel&) = delete;
+
+    /// false se a memória não pôde ser mapeada (formato, tamanho ou fd inválidos).
+    bool isValid() const { return mBase != nullptr; }
+
+    /// RateLevel::STOP remove o sensor do canal.
+    void setRate(int32_t sensorHandle, RateLevel rate);
+    void stopAll() { mRates.clear(); }
+    bool isReporting(int32_t sensorHandle) const { return mRates.count(sensorHandle) != 0; }
+    const std::map<int32_t, RateLevel>& rates() const { return mRates; }
+
+    /**
+     * Escreve o evento no próximo registro do anel. O token é o próprio
+     * handle do sensor; o contador atômico (1, 2, ...) é gravado por último.
+     */
+    void write(const Event& event);
+
+private:
+    uint8_t* mBase;     // Início do mmap (nullptr = inválido)
+    size_t mSize;       // Bytes mapeados
+    size_t mSlots;      // Registros de 104 bytes que cabem no anel
+    uint32_t mCounter;  // Eventos escritos (nunca 0 depois do primeiro)
+    std::map<int32_t, RateLevel> mRates;
+};
@@ -0,0 +1,154 @@
+#define LOG_TAG "AirQualityRegistry"
+
+#include "SensorRegistry.h"
+#include <log/log.h>
+
+#include <math.h>
+#include <string.h>
+
+SensorRegistry::SensorRegistry() : mActiveMask(0), mWakeUpMask(0), mOnChangeMask(0), mHistory(nullptr) {
+    memset(mIndexByHandle, -1, sizeof(mIndexByHandle));
+    memset(mStationMask, 0, sizeof(mStationMask));
+    mSensors.reserve(kMaxSensors);
+}
+
+int SensorRegistry::add(int32_t handle, AirQualitySensor::Type type) {
+    uint32_t offset = static_cast<uint32_t>(handle - kHandleBase);
+    if (offset >= kHandleRange || mIndexByHandle[offset] >= 0 || mSensors.size() >= kMaxSensors) {
+        ALOGE("Handle %d fora da faixa, repetido ou tabela cheia", handle);
+        return -1;
+    }
+
+    size_t index = mSensors.size();
+    mSensors.emplace_back(handle, type);
+    mIndexByHandle[offset] = static_cast<int8_t>(index);
+
+    // O que antes era o switch do processInput(), resolvido uma vez aqui
+    float AirData::* field = nullptr;
+    Kind kind = KIND_SAMPLE;
+    int arg = 0;
+    switch (type) {
+        case AirQualitySensor::SENSOR_PM25:  field = &AirData::pm25; break;
+        case AirQualitySensor::SENSOR_PM10:  field = &AirData::pm10; break;
+        case AirQualitySensor::SENSOR_CO:    field = &AirData::co_ppm; break;
+        case AirQualitySensor::SENSOR_LPG:   field = &AirData::lpg_ppm; break;
+        case AirQualitySensor::SENSOR_TEMP:  field = &AirData::temp_c; break;
+        case AirQualitySensor::SENSOR_HUMID: field = &AirData::humid_p; break;
+        // O sensor de fonte (sem campo) sempre tem leitura, 0.0f é a serial
+        case AirQualitySensor::SENSOR_SOURCE: break;
+        case AirQualitySensor::SENSOR_PM25_HISTORY:
+        case AirQualitySensor::SENSOR_PM10_HISTORY:
+        case AirQualitySensor::SENSOR_CO_HISTORY:
+        case AirQualitySensor::SENSOR_LPG_HISTORY:
+        case AirQualitySensor::SENSOR_TEMP_HISTORY:
+        case AirQualitySensor::SENSOR_HUMID_HISTORY:
+            // O campo só decide se a amostra atualizou o canal
+            kind = KIND_HISTORY;
+            arg = type - AirQualitySensor::SENSOR_PM25_HISTORY;
+            field = AirHistory::field(arg);
+            break;
+        case AirQualitySensor::SENSOR_AQI_US_EPA:
+        case AirQualitySensor::SENSOR_AQI_BR_IQAR:
+            kind = KIND_INDEX;
+            arg = type - AirQualitySensor::SENSOR_AQI_US_EPA;
+            break;
+    }
+
+    const SensorInfo& info = mSensors[index].getSensorInfo();
+    mField[index] = field;
+    mHandle[index] = info.sensorHandle;
+    mType[index] = info.type;
+    mLastEventNs[index] = 0;
+    mKind[index] = kind;
+    mArg[index] = static_cast<int8_t>(arg);
+    mLastValue[index] = NAN;
+    mThreshold[index] = mSensors[index].getReportThreshold();
+    if (mSensors[index].getReportPolicy() != AirQualitySensor::REPORT_CONTINUOUS) {
+        mOnChangeMask |= uint64_t(1) << index;
+    }
+    int64_t periodNs = mSensors[index].getSamplingPeriodNs();
+    mMinGapNs[index] = periodNs - periodNs / 10;
+    if (info.flags & static_cast<uint32_t>(SensorFlagBits::WAKE_UP)) {
+        mWakeUpMask |= uint64_t(1) << index;
+    }
+    mStationMask[stationOf(handle)] |= uint64_t(1) << index;
+    return static_cast<int>(index);
+}
+
+void SensorRegistry::setActive(size_t index, bool active) {
+    mSensors[index].setActive(active);
+    uint64_t bit = uint64_t(1) << index;
+    mActiveMask = active ? (mActiveMask | bit) : (mActiveMask & ~bit);
+    mLastEventNs[index] = 0;  // Ligando: a primeira amostra passa direto,
+    mLastValue[index] = NAN;  // mesmo sem mudança de valor
+}
+
+void SensorRegistry::batch(size_t index, int64_t samplingPeriodNs, int64_t maxReportLatencyNs) {
+    mSensors[index].batch(samplingPeriodNs, maxReportLatencyNs);
+    int64_t periodNs = mSensors[index].getSamplingPeriodNs();
+    // Decimação com 10% de folga para o jitter da serial/Wi-Fi
+    mMinGapNs[index] = periodNs - periodNs / 10;
+}
+
+size_t SensorRegistry::fanOut(const AirData& data, Event* out) {
+    return fill<true>(data, mActiveMask, out);
+}
+
+size_t SensorRegistry::read(const AirData& data, uint64_t mask, Event* out) {
+    return fill<false>(data, mask, out);
+}
+
+template <bool kDecimate>
+size_t SensorRegistry::fill(const AirData& data, uint64_t mask, Event* out) {
+    mask &= stationMask(data.station);
+    if (!data.valid || mask == 0) return 0;
+
+    float sourceValue = (data.source == "wifi") ? 1.0f : 0.0f;
+    size_t count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        size_t i = static_cast<size_t>(__builtin_ctzll(mask));
+
+        float value = mField[i] ? data.*mField[i] : sourceValue;
+        // Campo que a amostra não trouxe (resposta de outro alvo)
+        if (mField[i] && !AirData::hasReading(mField[i], value)) continue;
+        if (mKind[i] != KIND_SAMPLE && mHistory == nullptr) continue;
+
+        AirQualityIndex::Result index = {-1, AirQualityIndex::POLLUTANT_PM25};
+        if (mKind[i] == KIND_INDEX) {
+            index = mHistory->index(static_cast<AirQualityIndex::Scale>(mArg[i]));
+            if (index.index < 0) continue;
+            value = static_cast<float>(index.index);
+        }
+
+        if (kDecimate) {
+            // Sem mudança (ou abaixo do limiar) desde o último entregue: nem sai do processo
+            if ((mOnChangeMask >> i) & 1) {
+                float last = mLastValue[i];
+                if (value == last || fabsf(value - last) < mThreshold[i]) continue;
+            }
+            if (mLastEventNs[i] != 0 && data.timestamp - mLastEventNs[i] < mMinGapNs[i]) continue;
+            mLastEventNs[i] = data.timestamp;
+            mLastValue[i] = value;
+        }
+
+        Event& event = out[count++];
+        event.sensorHandle = mHandle[i];
+        event.sensorType = mType[i];
+        event.timestamp = data.timestamp;
+        switch (mKind[i]) {
+            case KIND_SAMPLE:
+                event.u.scalar = value;
+                break;
+            case KIND_HISTORY:
+                memset(&event.u, 0, sizeof(event.u));
+                mHistory->summarize(mArg[i], event.u.data);
+                break;
+            case KIND_INDEX:
+                memset(&event.u, 0, sizeof(event.u));
+                event.u.data[0] = value;
+                event.u.data[1] = static_cast<float>(index.dominant);
+                break;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "AirQualitySensor.h"
+#include "../utils/AirHistory.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Tabela dos sensores da SubHAL.
+ *
+ * - handle -> índice em O(1): os handles ficam numa faixa densa a partir de
+ *   kHandleBase (5001..5006, 5099), então basta um vetor de índices;
+ * - cada estação tem a sua faixa de kStationStride handles (a estação s usa
+ *   kHandleBase + s * kStationStride + 1..99) e um mask dos seus sensores: uma
+ *   amostra só gera eventos para os sensores da estação que a mediu;
+ * - ativos num bitmask (bit i = sensor i), "algum ativo?" é mActiveMask != 0;
+ * - o caminho quente (fanOut) lê arrays paralelos (campo do AirData, piso de
+ *   validade, último timestamp...) em vez de um switch por sensor;
+ * - os sensores de histórico saem do AirHistory de setHistory() (12 floats
+ *   em u.data), quando a amostra traz leitura do canal deles; os de índice
+ *   de qualidade do ar também;
+ * - sensores on-change (AirQualitySensor::ReportPolicy) só geram evento
+ *   quando o valor muda além do limiar desde o último entregue.
+ *
+ * O AirQualitySensor continua dono do SensorInfo, do batch e da FIFO.
+ * Não é thread-safe: a SubHAL protege com mSensorsLock.
+ */
+class SensorRegistry {
+public:
+    static constexpr int32_t kHandleBase = 5000;
+    static constexpr size_t kMaxSensors = 64;  // Bits do mask
+    static constexpr int32_t kStationStride = 100;
+    // 8 x 7 sensores + os 6 de histórico e os 2 de índice da principal: o mask cheio
+    static constexpr size_t kMaxStations = 8;
+    static constexpr size_t kHandleRange = kStationStride * kMaxStations;
+
+    SensorRegistry();
+
+    /// Retorna o índice do novo sensor (handles fora da faixa são rejeitados com -1).
+    int add(int32_t handle, AirQualitySensor::Type type);
+
+    int indexOf(int32_t handle) const {
+        uint32_t offset = static_cast<uint32_t>(handle - kHandleBase);
+        return offset < kHandleRange ? mIndexByHandle[offset] : -1;
+    }
+    AirQualitySensor* find(int32_t handle) {
+        int index = indexOf(handle);
+        return index < 0 ? nullptr : &mSensors[index];
+    }
+
+    size_t size() const { return mSensors.size(); }
+    AirQualitySensor& operator[](size_t index) { return mSensors[index]; }
+    const AirQualitySensor& operator[](size_t index) const { return mSensors[index]; }
+    std::vector<AirQualitySensor>::iterator begin() { return mSensors.begin(); }
+    std::vector<AirQualitySensor>::iterator end() { return mSensors.end(); }
+    std::vector<AirQualitySensor>::const_iterator begin() const { return mSensors.begin(); }
+    std::vector<AirQualitySensor>::const_iterator end() const { return mSensors.end(); }
+
+    void setActive(size_t index, bool active);
+    void batch(size_t index, int64_t samplingPeriodNs, int64_t maxReportLatencyNs);
+    uint64_t activeMask() const { return mActiveMask; }
+    /// Sensores com SensorFlagBits::WAKE_UP (fixo depois do add()).
+    uint64_t wakeUpMask() const { return mWakeUpMask; }
+    /// Sensores da faixa de handles da estação (0 fora de [0, kMaxStations)).
+    uint64_t stationMask(int station) const {
+        return static_cast<uint32_t>(station) < kMaxStations ? mStationMask[station] : 0;
+    }
+    static int stationOf(int32_t handle) { return (handle - kHandleBase) / kStationStride; }
+
+    /// De onde os sensores de histórico leem (não é dono; nullptr = não geram eventos).
+    void setHistory(const AirHistory* history) { mHistory = history; }
+
+    /**
+     * Gera de uma vez os eventos dos sensores ativos para uma amostra, com
+     * decimação pelo samplingPeriod de cada um. Só os sensores da estação
+     * data.station entram. out precisa de kMaxSensors posições; retorna
+     * quantos eventos foram escritos (ordem dos índices).
+     */
+    size_t fanOut(const AirData& data, Event* out);
+
+    /// Igual, para os sensores de mask e sem decimação (canal direto).
+    size_t read(const AirData& data, uint64_t mask, Event* out);
+
+private:
+    // De onde sai o valor do evento
+    enum Kind : int8_t {
+        KIND_SAMPLE,   // Campo da amostra (ou a fonte)
+        KIND_HISTORY,  // AirHistory::summarize() do canal mArg
+        KIND_INDEX,    // AirHistory::index() da escala mArg
+    };
+
+    template <bool kDecimate>
+    size_t fill(const AirData& data, uint64_t mask, Event* out);
+
+    std::vector<AirQualitySensor> mSensors;
+    int8_t mIndexByHandle[kHandleRange];
+    uint64_t mActiveMask;
+    uint64_t mWakeUpMask;
+    uint64_t mStationMask[kMaxStations];
+    uint64_t mOnChangeMask;  // Política diferente de REPORT_CONTINUOUS
+    const AirHistory* mHistory;
+
+    // Arrays paralelos a mSensors, só o que fanOut() lê
+    float AirData::* mField[kMaxSensors];  // nullptr = sensor de fonte/índice (sempre lido)
+    int32_t mHandle[kMaxSensors];
+    SensorType mType[kMaxSensors];
+    int64_t mMinGapNs[kMaxSensors];        // samplingPeriod menos 10% de folga
+    int64_t mLastEventNs[kMaxSensors];
+    Kind mKind[kMaxSensors];
+    int8_t mArg[kMaxSensors];
+    float mThreshold[kMaxSensors];         // AirQualitySensor::getReportThreshold()
+    float mLastValue[kMaxSensors];         // Último valor entregue (NaN = nenhum)
+};
@@ -0,0 +1,139 @@
+#define LOG_TAG "AirStationSerialBench"
+
+// Benchmark de latência do SerialReader.
+// Um pseudo-terminal (openpty) faz o papel do ESP32: o lado master recebe os
+// "GET DATA" e escreve linhas JSON; o lado slave é aberto pelo SerialReader.
+// Mede o tempo entre a escrita do '\n' final de cada linha e a chamada de
+// onDataReceived() e imprime os percentis.
+//
+// Uso: airquality_serial_latency_bench [amostras] [intervalo_us]
+
+#include "io/SerialReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int64_t nowNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Registra o instante de chegada de cada amostra (identificada pelo pm25)
+class LatencyListener : public IAirDataListener {
+public:
+    explicit LatencyListener(size_t samples) : mRecvNs(samples, 0), mReceived(0) {}
+
+    void onDataReceived(const AirData& data) override {
+        int64_t t = nowNs();
+        size_t seq = static_cast<size_t>(data.pm25);
+        if (seq < mRecvNs.size()) mRecvNs[seq] = t;
+        mReceived++;
+    }
+
+    std::vector<int64_t> mRecvNs;
+    std::atomic<size_t> mReceived;
+};
+
+// Lê (e descarta) os comandos enviados pelo leitor; retorna true se houve algum
+static bool drainCommands(int master) {
+    char buf[256];
+    bool got = false;
+    ssize_t n;
+    while ((n = read(master, buf, sizeof(buf))) > 0) got = true;
+    return got;
+}
+
+static double percentileUs(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[idx] / 1000.0;
+}
+
+int main(int argc, char** argv) {
+    size_t samples = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+    long intervalUs = argc > 2 ? strtol(argv[2], nullptr, 10) : 2000;
+
+    int master = -1, slave = -1;
+    char slaveName[128];
+    if (openpty(&master, &slave, slaveName, nullptr, nullptr) < 0) {
+        printf("ERRO: openpty falhou: %s\n", strerror(errno));
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    LatencyListener listener(samples);
+    SerialReader reader(slaveName);
+    reader.setListener(&listener);
+    reader.setPollingActive(true);
+    reader.start();
+
+    // O primeiro "GET DATA" indica que o leitor abriu e configurou o PTY
+    int64_t deadline = nowNs() + 5000000000LL;
+    while (!drainCommands(master)) {
+        if (nowNs() > deadline) {
+            printf("ERRO: SerialReader não conectou em %s\n", slaveName);
+            return 1;
+        }
+        usleep(1000);
+    }
+
+    printf("=== SerialReader: latência linha -> onDataReceived (%zu amostras, %ld us) ===\n",
+           samples, intervalUs);
+
+    std::vector<int64_t> sentNs(samples, 0);
+    for (size_t i = 0; i < samples; i++) {
+        char line[192];
+        int len = snprintf(line, sizeof(line),
+                           "{\"type\":\"data\",\"src\":\"serial\",\"payload\":{\"pm25\":%zu,"
+                           "\"pm10\":18.5,\"lpg_ppm\":200,\"co_ppm\":1.02,\"temp_c\":26.1,"
+                           "\"humid_p\":60.2}}\r\n", i);
+
+        // Metade da linha primeiro: a linha parcial não pode atrasar a próxima
+        int half = len / 2;
+        if (write(master, line, half) != half) break;
+        usleep(100);
+        sentNs[i] = nowNs();
+        if (write(master, line + half, len - half) != len - half) break;
+
+        drainCommands(master);
+        usleep(intervalUs);
+    }
+
+    deadline = nowNs() + 2000000000LL;
+    while (listener.mReceived < samples && nowNs() < deadline) usleep(1000);
+
+    int64_t stopStart = nowNs();
+    reader.stop();
+    int64_t stopNs = nowNs() - stopStart;
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(samples);
+    for (size_t i = 0; i < samples; i++) {
+        if (listener.mRecvNs[i] > 0 && sentNs[i] > 0) {
+            latencies.push_back(listener.mRecvNs[i] - sentNs[i]);
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("recebidas: %zu/%zu\n", latencies.size(), samples);
+    printf("p50:   %9.1f us\n", percentileUs(latencies, 0.50));
+    printf("p90:   %9.1f us\n", percentileUs(latencies, 0.90));
+    printf("p99:   %9.1f us\n", percentileUs(latencies, 0.99));
+    printf("p99.9: %9.1f us\n", percentileUs(latencies, 0.999));
+    printf("max:   %9.1f us\n", latencies.empty() ? 0.0 : latencies.back() / 1000.0);
+    printf("stop(): %.1f us\n", stopNs / 1000.0);
+
+    close(slave);
+    close(master);
+    return latencies.size() == samples ? 0 : 1;
+}
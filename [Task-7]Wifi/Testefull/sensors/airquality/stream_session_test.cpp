@@ -0,0 +1,191 @@
+// Testes do modo push ("STREAM ON"): a máquina de estados do StreamSession e
+// o SerialReader contra um ESP32 falso num PTY, com e sem suporte a stream.
+
+#include "fake_station.h"
+#include "io/SerialReader.h"
+#include "io/StreamSession.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <unistd.h>
+
+TEST(StreamSessionTest, RequestsAndConfirms) {
+    StreamSession session;
+    std::string cmd;
+
+    ASSERT_TRUE(session.nextCommand(500, 0, &cmd));
+    EXPECT_EQ("STREAM ON 500\n", cmd);
+    EXPECT_FALSE(session.streaming());
+    EXPECT_FALSE(session.nextCommand(500, 10, &cmd));  // esperando o ack
+
+    session.onAck(true, 20);
+    EXPECT_TRUE(session.streaming());
+    EXPECT_FALSE(session.nextCommand(500, 30, &cmd));
+
+    // HAL pediu outro período
+    ASSERT_TRUE(session.nextCommand(200, 40, &cmd));
+    EXPECT_EQ("STREAM ON 200\n", cmd);
+
+    // Standby
+    ASSERT_TRUE(session.nextCommand(0, 50, &cmd));
+    EXPECT_EQ("STREAM OFF\n", cmd);
+    EXPECT_FALSE(session.streaming());
+    EXPECT_FALSE(session.nextCommand(0, 60, &cmd));
+}
+
+TEST(StreamSessionTest, FallsBackToPollingWithoutAck) {
+    StreamSession session;
+    std::string cmd;
+
+    ASSERT_TRUE(session.nextCommand(1000, 0, &cmd));
+    EXPECT_EQ(2000, session.wakeupMs());
+    EXPECT_FALSE(session.nextCommand(1000, 2000, &cmd));
+    EXPECT_FALSE(session.streaming());
+
+    // Firmware antigo: não insiste até a próxima conexão
+    EXPECT_FALSE(session.nextCommand(1000, 10000, &cmd));
+    session.reset();
+    EXPECT_TRUE(session.nextCommand(1000, 10001, &cmd));
+}
+
+TEST(StreamSessionTest, WatchdogRequestsAgainWhenDataStops) {
+    StreamSession session;
+    std::string cmd;
+
+    session.nextCommand(100, 0, &cmd);
+    session.onAck(true, 0);
+    session.onData(100);
+    session.onData(200);
+    EXPECT_FALSE(session.nextCommand(100, 1000, &cmd));
+
+    // 3 períodos + folga do ack sem nenhuma amostra
+    int64_t wakeup = session.wakeupMs();
+    EXPECT_GT(wakeup, 200 + 3 * 100);
+    ASSERT_TRUE(session.nextCommand(100, wakeup, &cmd));
+    EXPECT_EQ("STREAM ON 100\n", cmd);
+    EXPECT_FALSE(session.streaming());
+}
+
+TEST(StreamSessionTest, StreamsOnlyTheTargetInUse) {
+    StreamSession session;
+    std::string cmd;
+
+    ASSERT_TRUE(session.nextCommand(500, 0, &cmd, "SDS011"));
+    EXPECT_EQ("STREAM ON 500 SDS011\n", cmd);
+    session.onAck(true, 10);
+    EXPECT_FALSE(session.nextCommand(500, 20, &cmd, "SDS011"));
+
+    // Outro sensor ativado: volta a pedir tudo
+    ASSERT_TRUE(session.nextCommand(500, 30, &cmd));
+    EXPECT_EQ("STREAM ON 500\n", cmd);
+}
+
+TEST(StreamSessionTest, ClampsPeriod) {
+    EXPECT_EQ(StreamSession::kMinPeriodMs, StreamSession::clampPeriodMs(0));
+    EXPECT_EQ(250, StreamSession::clampPeriodMs(250));
+    EXPECT_EQ(StreamSession::kMaxPeriodMs, StreamSession::clampPeriodMs(1000000));
+}
+
+namespace {
+
+class SerialStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char name[128];
+        ASSERT_EQ(0, openpty(&mMaster, &mSlave, name, nullptr, nullptr));
+        fcntl(mMaster, F_SETFL, fcntl(mMaster, F_GETFL) | O_NONBLOCK);
+        mSlaveName = name;
+    }
+
+    void TearDown() override {
+        close(mMaster);
+        close(mSlave);
+    }
+
+    int mMaster = -1;
+    int mSlave = -1;
+    std::string mSlaveName;
+};
+
+}  // namespace
+
+TEST_F(SerialStreamTest, ListensOnlyWhileStreaming) {
+    FakeStation station(mMaster, {});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(200000000LL);  // 5Hz: só possível com stream
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 2; }, &station, 5000));
+    EXPECT_TRUE(station.streaming());
+    EXPECT_TRUE(station.binary());
+    EXPECT_EQ(200, station.streamPeriodMs());
+
+    // Em stream nenhum GET DATA novo é enviado
+    int requests = station.dataRequests();
+    size_t before = listener.count();
+    waitFor([] { return false; }, &station, 2000);
+    EXPECT_EQ(requests, station.dataRequests());
+    EXPECT_GE(listener.count() - before, 8u);  // ~10 amostras em 2s
+
+    // Standby desliga o stream na estação
+    reader.setPollingActive(false);
+    EXPECT_TRUE(waitFor([&] { return !station.streaming(); }, &station, 2000));
+    reader.stop();
+}
+
+TEST_F(SerialStreamTest, RenegotiatesAfterReboot) {
+    FakeStation station(mMaster, {});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(200000000LL);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return station.streaming(); }, &station, 5000));
+    station.reboot();
+    EXPECT_TRUE(waitFor([&] { return station.streaming() && station.binary(); }, &station, 5000));
+    reader.stop();
+}
+
+TEST_F(SerialStreamTest, OldFirmwareKeepsPolling) {
+    FakeStation station(mMaster, {false, false});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(200000000LL);
+    reader.setPollingActive(true);
+    reader.start();
+
+    // Sem ack do STREAM ON o leitor segue no GET DATA a 1Hz
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 4; }, &station, 6000));
+    EXPECT_FALSE(station.streaming());
+    EXPECT_GE(station.dataRequests(), 4);
+    reader.stop();
+}
+
+TEST_F(SerialStreamTest, PollsOnlyTheTargetsInUse) {
+    FakeStation station(mMaster, {false, false});
+    CollectingListener listener;
+    SerialReader reader(mSlaveName);
+    reader.setListener(&listener);
+    // Só PM a 1Hz: nem MQ nem DHT saem da estação
+    reader.setTargetPeriodsNs({1000000000LL, 0, 0, 0});
+    reader.setSamplingPeriodNs(1000000000LL);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(waitFor([&] { return listener.count() >= 2; }, &station, 6000));
+    for (const auto& target : station.dataTargets()) EXPECT_EQ("SDS011", target);
+    for (const auto& data : listener.readings()) {
+        EXPECT_GE(data.pm25, 0.0f);
+        EXPECT_EQ(-1.0f, data.co_ppm);
+        EXPECT_FALSE(AirData::hasReading(&AirData::temp_c, data.temp_c));  // Sem o DHT
+    }
+    reader.stop();
+}
@@ -3,14 +3,29 @@
 #include <stdint.h>
 #include <string>
 
+// Sub-sensores da estação, como o firmware os aceita em "GET DATA <alvo>" e
+// "STREAM ON <período> <alvo>" (a resposta só traz os campos do alvo).
+// Máscaras de alvos usam o bit 1 << StationTarget.
+enum StationTarget {
+    TARGET_SDS011,  // pm25, pm10
+    TARGET_MQ2,     // lpg_ppm
+    TARGET_MQ7,     // co_ppm
+    TARGET_DHT,     // temp_c, humid_p
+    kStationTargets
+};
+
 /**
  * Estrutura intermediária que representa uma leitura completa da estação.
  * Desacopla o formato JSON (ESP32) do formato Event (Android).
  */
 struct AirData {
-    // Timestamp do momento da recepção/parse (em nanosegundos, base de tempo do Android)
+    // Instante da amostra (ns, base de tempo do Android): chegada do primeiro
+    // byte da linha/quadro, ou o millis() da estação convertido pelo DeviceClock
     int64_t timestamp;
 
+    // millis() da estação quando mediu ("ms" no JSON); -1 se não veio
+    int64_t deviceMs;
+
     // Valores dos sensores (inicializados com -1.0 para indicar "sem leitura")
     float pm25;      // Partículas PM2.5 (ug/m3)
     float pm10;      // Partículas PM10 (ug/m3)
@@ -19,19 +34,39 @@ struct AirData {
     float temp_c;    // Temperatura (Celsius)
     float humid_p;   // Umidade (%)
 
+    // Contagem crua do ADC (0..4095) dos MQ, quando a estação não converte;
+    // o MqConversionStage do leitor preenche lpg_ppm/co_ppm com elas
+    float mq2_raw;
+    float mq7_raw;
+
     // Metadados
     std::string source; // "serial" ou "wifi"
+    int station;        // Faixa de handles da estação na SubHAL (0 = a principal)
     bool valid;         // Flag para indicar se o parse foi bem sucedido
 
+    // temp_c sem leitura: o zero absoluto nunca é medida. É o que sobra
+    // numa resposta de outro alvo ("GET DATA SDS011" não traz o DHT)
+    static constexpr float kNoTempC = -273.0f;
+
+    /// O campo traz leitura? Sem leitura: < 0 nos demais, <= kNoTempC em temp_c.
+    /// O único teste de presença: registro, histórico, taxa e conversão dos MQ.
+    static bool hasReading(float AirData::* field, float value) {
+        return field == &AirData::temp_c ? value > kNoTempC : value >= 0.0f;
+    }
+
     // Construtor para inicialização limpa
     AirData() : 
         timestamp(0),
+        deviceMs(-1),
         pm25(-1.0f), 
         pm10(-1.0f),
         co_ppm(-1.0f), 
         lpg_ppm(-1.0f), 
-        temp_c(-273.0f), // Zero absoluto como valor inválido para temp
+        temp_c(kNoTempC), // Zero absoluto como valor inválido para temp
         humid_p(-1.0f), 
+        mq2_raw(-1.0f),
+        mq7_raw(-1.0f),
+        station(0),
         valid(false) {}
 };
 
@@ -0,0 +1,175 @@
+#include "AirHistory.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+static const int64_t kSecondNs = 1000000000LL;
+
+// Baldes de cada janela: resolução da borda x memória (60 + 60 + 96 por canal)
+static const struct {
+    int64_t bucketNs;
+    size_t buckets;
+} kWindowShapes[AirHistory::kWindows] = {
+    {kSecondNs, 60},            // 1 min em baldes de 1 s
+    {60 * kSecondNs, 60},       // 1 h em baldes de 1 min
+    {15 * 60 * kSecondNs, 96},  // 24 h em baldes de 15 min
+};
+
+// Campo de cada canal; a presença é a de AirData::hasReading
+static float AirData::* const kChannelFields[AirHistory::kChannels] = {
+    &AirData::pm25,
+    &AirData::pm10,
+    &AirData::co_ppm,
+    &AirData::lpg_ppm,
+    &AirData::temp_c,
+    &AirData::humid_p,
+};
+
+SlidingWindow::MonotonicQueue::MonotonicQueue(size_t capacity, bool keepMin)
+    : mItems(capacity), mHead(0), mSize(0), mKeepMin(keepMin) {}
+
+void SlidingWindow::MonotonicQueue::push(int64_t number, float value) {
+    // Quem é superado pelo balde novo nunca mais vai ser o extremo
+    while (mSize > 0) {
+        float back = mItems[(mHead + mSize - 1) % mItems.size()].value;
+        if (mKeepMin ? back < value : back > value) break;
+        mSize--;
+    }
+    if (mSize == mItems.size()) {
+        mHead = (mHead + 1) % mItems.size();
+        mSize--;
+    }
+    mItems[(mHead + mSize) % mItems.size()] = {number, value};
+    mSize++;
+}
+
+void SlidingWindow::MonotonicQueue::expire(int64_t oldest) {
+    while (mSize > 0 && mItems[mHead].number < oldest) {
+        mHead = (mHead + 1) % mItems.size();
+        mSize--;
+    }
+}
+
+SlidingWindow::SlidingWindow(int64_t bucketNs, size_t buckets)
+    : mBucketNs(bucketNs),
+      mCapacity(buckets),
+      mClosed(buckets),
+      mHead(0),
+      mSize(0),
+      mOpen{std::numeric_limits<int64_t>::min(), 0.0, 0, 0.0f, 0.0f},
+      mSum(0.0),
+      mCount(0),
+      mMin(buckets, true),
+      mMax(buckets, false),
+      mEwma(NAN),
+      mLastNs(0) {}
+
+void SlidingWindow::advance(int64_t number) {
+    if (mOpen.count > 0) {
+        if (mSize == mCapacity) {
+            const Bucket& dropped = mClosed[mHead];
+            mSum -= dropped.sum;
+            mCount -= dropped.count;
+            mHead = (mHead + 1) % mCapacity;
+            mSize--;
+        }
+        mClosed[(mHead + mSize) % mCapacity] = mOpen;
+        mSize++;
+        mSum += mOpen.sum;
+        mCount += mOpen.count;
+        mMin.push(mOpen.number, mOpen.min);
+        mMax.push(mOpen.number, mOpen.max);
+    }
+    mOpen = {number, 0.0, 0, 0.0f, 0.0f};
+
+    // Sai da janela o que ficou mais de `buckets` baldes para trás
+    int64_t oldest = number - static_cast<int64_t>(mCapacity) + 1;
+    while (mSize > 0 && mClosed[mHead].number < oldest) {
+        mSum -= mClosed[mHead].sum;
+        mCount -= mClosed[mHead].count;
+        mHead = (mHead + 1) % mCapacity;
+        mSize--;
+    }
+    if (mSize == 0) mSum = 0.0;  // Zera o resíduo de arredondamento das subtrações
+    mMin.expire(oldest);
+    mMax.expire(oldest);
+}
+
+void SlidingWindow::add(int64_t timestampNs, float value) {
+    int64_t number = timestampNs / mBucketNs;
+    if (number > mOpen.number) advance(number);
+
+    if (mOpen.count == 0) {
+        mOpen.min = value;
+        mOpen.max = value;
+    } else {
+        mOpen.min = std::min(mOpen.min, value);
+        mOpen.max = std::max(mOpen.max, value);
+    }
+    mOpen.sum += value;
+    mOpen.count++;
+
+    if (mLastNs == 0) {
+        mEwma = value;
+    } else if (timestampNs > mLastNs) {
+        double alpha = 1.0 - exp(-static_cast<double>(timestampNs - mLastNs) / durationNs());
+        mEwma += static_cast<float>(alpha * (value - mEwma));
+    }
+    mLastNs = std::max(mLastNs, timestampNs);
+}
+
+float SlidingWindow::mean() const {
+    uint32_t n = count();
+    return n == 0 ? NAN : static_cast<float>((mSum + mOpen.sum) / n);
+}
+
+float SlidingWindow::min() const {
+    if (mOpen.count == 0) return mMin.empty() ? NAN : mMin.front();
+    return mMin.empty() ? mOpen.min : std::min(mMin.front(), mOpen.min);
+}
+
+float SlidingWindow::max() const {
+    if (mOpen.count == 0) return mMax.empty() ? NAN : mMax.front();
+    return mMax.empty() ? mOpen.max : std::max(mMax.front(), mOpen.max);
+}
+
+AirHistory::AirHistory() : mCo8h(5 * 60 * kSecondNs, 96) {
+    mWindows.reserve(kChannels * kWindows);
+    for (size_t channel = 0; channel < kChannels; channel++) {
+        for (const auto& shape : kWindowShapes) mWindows.emplace_back(shape.bucketNs, shape.buckets);
+    }
+    for (auto& index : mIndex) index = {-1, AirQualityIndex::POLLUTANT_PM25};
+}
+
+void AirHistory::add(const AirData& data) {
+    if (!data.valid) return;
+    for (size_t channel = 0; channel < kChannels; channel++) {
+        float value = data.*kChannelFields[channel];
+        if (!AirData::hasReading(kChannelFields[channel], value)) continue;
+        for (size_t w = 0; w < kWindows; w++) mWindows[channel * kWindows + w].add(data.timestamp, value);
+    }
+    if (data.co_ppm >= 0.0f) mCo8h.add(data.timestamp, data.co_ppm);
+
+    float pm25 = window(0, WINDOW_24H).mean();
+    float pm10 = window(1, WINDOW_24H).mean();
+    float co = mCo8h.mean();
+    for (int scale = 0; scale < AirQualityIndex::kScales; scale++) {
+        mIndex[scale] = AirQualityIndex::compute(static_cast<AirQualityIndex::Scale>(scale), pm25, pm10, co);
+    }
+}
+
+void AirHistory::summarize(size_t channel, float* out) const {
+    for (size_t w = 0; w < kWindows; w++) {
+        const SlidingWindow& window = mWindows[channel * kWindows + w];
+        *out++ = window.mean();
+        *out++ = window.min();
+        *out++ = window.max();
+        *out++ = window.ewma();
+    }
+}
+
+float AirData::* AirHistory::field(size_t channel) {
+    return kChannelFields[channel];
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "AirData.h"
+#include "AirQualityIndex.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Janela deslizante sobre uma série temporal, com memória fixa.
+ *
+ * As amostras são somadas em baldes de bucketNs; a janela são os `buckets`
+ * baldes mais recentes (o aberto incluso), então a borda anda de balde em
+ * balde. Soma e contagem são mantidas ao entrar e sair um balde, e mínimo e
+ * máximo vêm de filas monotônicas de baldes: tudo O(1) amortizado por
+ * amostra, sem reler o histórico. Um intervalo sem amostras só esvazia os
+ * baldes que ele atravessou.
+ *
+ * A EWMA usa a duração da janela como constante de tempo, corrigida pelo
+ * intervalo real entre amostras (alpha = 1 - exp(-dt/tau)).
+ *
+ * Os baldes e as filas são alocados uma vez no construtor.
+ */
+class SlidingWindow {
+public:
+    SlidingWindow(int64_t bucketNs, size_t buckets);
+
+    /// timestampNs não decrescente; uma amostra mais velha cai no balde aberto.
+    void add(int64_t timestampNs, float value);
+
+    /// A janela até a última amostra. Sem amostras: tudo NaN.
+    float mean() const;
+    float min() const;
+    float max() const;
+    float ewma() const { return mEwma; }
+    uint32_t count() const { return mCount + mOpen.count; }
+    int64_t durationNs() const { return mBucketNs * static_cast<int64_t>(mCapacity); }
+
+private:
+    struct Bucket {
+        int64_t number;  // timestamp / bucketNs
+        double sum;
+        uint32_t count;
+        float min;
+        float max;
+    };
+
+    // Fila de baldes fechados em que o valor só piora do começo para o fim:
+    // a frente é o extremo da janela
+    struct Extreme {
+        int64_t number;
+        float value;
+    };
+    class MonotonicQueue {
+    public:
+        MonotonicQueue(size_t capacity, bool keepMin);
+        void push(int64_t number, float value);
+        // Tira da frente os baldes anteriores a oldest
+        void expire(int64_t oldest);
+        bool empty() const { return mSize == 0; }
+        float front() const { return mItems[mHead].value; }
+
+    private:
+        std::vector<Extreme> mItems;
+        size_t mHead;
+        size_t mSize;
+        bool mKeepMin;
+    };
+
+    // Fecha o balde aberto e abre o de número `number`
+    void advance(int64_t number);
+
+    int64_t mBucketNs;
+    size_t mCapacity;
+
+    std::vector<Bucket> mClosed;  // Anel dos baldes fechados ainda na janela
+    size_t mHead;
+    size_t mSize;
+    Bucket mOpen;
+    double mSum;                  // Dos fechados na janela
+    uint32_t mCount;
+    MonotonicQueue mMin;
+    MonotonicQueue mMax;
+
+    float mEwma;
+    int64_t mLastNs;  // 0 = nenhuma amostra ainda
+};
+
+/**
+ * Histórico de cada canal do AirData em janelas de 1 min, 1 h e 24 h, para
+ * os sensores virtuais de histórico da SubHAL: o cliente recebe média,
+ * mínimo, máximo e EWMA prontos, em vez de guardar e varrer as amostras.
+ *
+ * Canais na ordem do AirData (PM2.5, PM10, CO, GLP, temperatura, umidade).
+ * Valores sem leitura (abaixo do piso de validade) não entram.
+ *
+ * A cada amostra os índices de qualidade do ar são refeitos com as médias de
+ * 24 h de PM e uma janela de 8 h de CO; com menos histórico que isso, vale a
+ * média do que houver.
+ * Não é thread-safe: a SubHAL protege com mSensorsLock.
+ */
+class AirHistory {
+public:
+    enum Window { WINDOW_1MIN, WINDOW_1H, WINDOW_24H, kWindows };
+    static constexpr size_t kChannels = 6;
+    // Por janela: média, mínimo, máximo e EWMA
+    static constexpr size_t kValuesPerWindow = 4;
+    static constexpr size_t kValues = kWindows * kValuesPerWindow;
+
+    AirHistory();
+
+    void add(const AirData& data);
+
+    /// Escreve kValues floats em out: para cada janela (1 min, 1 h, 24 h),
+    /// média, mínimo, máximo e EWMA.
+    void summarize(size_t channel, float* out) const;
+    const SlidingWindow& window(size_t channel, Window window) const {
+        return mWindows[channel * kWindows + window];
+    }
+    /// Índice da escala até a última amostra (index -1 = sem PM nem CO ainda).
+    AirQualityIndex::Result index(AirQualityIndex::Scale scale) const { return mIndex[scale]; }
+
+    /// Campo do AirData do canal (presença: AirData::hasReading).
+    static float AirData::* field(size_t channel);
+
+private:
+    std::vector<SlidingWindow> mWindows;  // kChannels x kWindows
+    SlidingWindow mCo8h;                  // Média de CO dos índices
+    AirQualityIndex::Result mIndex[AirQualityIndex::kScales];
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Faixa de uma tabela de índice: [cLo, cHi] vai para indexLo + slope * (c - cLo)
+struct AqiBreakpoint {
+    constexpr AqiBreakpoint(float lo, float hi, int iLo, int iHi)
+        : cLo(lo), cHi(hi), indexLo(iLo), slope((iHi - iLo) / (hi - lo)) {}
+    float cLo;
+    float cHi;
+    int indexLo;
+    float slope;  // Pontos de índice por unidade de concentração
+};
+
+struct AqiTable {
+    const AqiBreakpoint* bands;
+    size_t count;
+    float digits;  // Concentração truncada em 1/digits antes da busca (0 = nenhum)
+};
+
+/**
+ * Índice de qualidade do ar a partir das médias móveis de PM2.5, PM10 (24 h,
+ * ug/m3) e CO (8 h, ppm), em duas escalas:
+ *
+ * - US EPA (tabela de 2024): PM2.5 truncado em 0,1, PM10 em 1, CO em 0,1;
+ * - IQAr brasileiro (CONAMA 491/2018, faixas da CETESB).
+ *
+ * Cada poluente dá um subíndice por interpolação linear na faixa em que a
+ * concentração cai, e o índice é o maior deles. As tabelas são constexpr e
+ * já guardam a inclinação de cada faixa: um índice custa alguns compares e
+ * uma multiplicação por poluente. Acima da última faixa o índice satura.
+ */
+class AirQualityIndex {
+public:
+    enum Scale { SCALE_US_EPA, SCALE_BR_IQAR, kScales };
+    enum Pollutant { POLLUTANT_PM25, POLLUTANT_PM10, POLLUTANT_CO, kPollutants };
+
+    struct Result {
+        int index;           // -1 = nenhum poluente com dado
+        Pollutant dominant;  // Quem deu o maior subíndice
+    };
+
+    /// Subíndice de um poluente; -1 para concentração NaN ou negativa.
+    static constexpr int subIndex(const AqiTable& table, float concentration) {
+        if (!(concentration >= 0.0f)) return -1;
+        if (table.digits > 0.0f) {
+            // Folga para 9.1f * 10 não virar 90,99
+            concentration = static_cast<int64_t>(concentration * table.digits + 1e-3f) / table.digits;
+        }
+        for (size_t i = 0; i < table.count; i++) {
+            const AqiBreakpoint& band = table.bands[i];
+            if (concentration <= band.cHi) {
+                float c = concentration < band.cLo ? band.cLo : concentration;
+                return static_cast<int>(band.indexLo + band.slope * (c - band.cLo) + 0.5f);
+            }
+        }
+        const AqiBreakpoint& top = table.bands[table.count - 1];
+        return static_cast<int>(top.indexLo + top.slope * (top.cHi - top.cLo) + 0.5f);
+    }
+
+    static constexpr Result compute(Scale scale, float pm25, float pm10, float co) {
+        const AqiTable* tables = scale == SCALE_US_EPA ? kUsEpa : kBrIqar;
+        float concentrations[kPollutants] = {pm25, pm10, co};
+        Result result = {-1, POLLUTANT_PM25};
+        for (int p = 0; p < kPollutants; p++) {
+            int index = subIndex(tables[p], concentrations[p]);
+            if (index > result.index) result = {index, static_cast<Pollutant>(p)};
+        }
+        return result;
+    }
+
+private:
+    static constexpr AqiBreakpoint kEpaPm25[] = {
+        {0.0f, 9.0f, 0, 50},       {9.1f, 35.4f, 51, 100},    {35.5f, 55.4f, 101, 150},
+        {55.5f, 125.4f, 151, 200}, {125.5f, 225.4f, 201, 300}, {225.5f, 325.4f, 301, 500},
+    };
+    static constexpr AqiBreakpoint kEpaPm10[] = {
+        {0.0f, 54.0f, 0, 50},       {55.0f, 154.0f, 51, 100},  {155.0f, 254.0f, 101, 150},
+        {255.0f, 354.0f, 151, 200}, {355.0f, 424.0f, 201, 300}, {425.0f, 604.0f, 301, 500},
+    };
+    static constexpr AqiBreakpoint kEpaCo[] = {
+        {0.0f, 4.4f, 0, 50},      {4.5f, 9.4f, 51, 100},    {9.5f, 12.4f, 101, 150},
+        {12.5f, 15.4f, 151, 200}, {15.5f, 30.4f, 201, 300}, {30.5f, 50.4f, 301, 500},
+    };
+    // IQAr: N1 Boa .. N5 Péssima; cada faixa começa onde a anterior termina
+    static constexpr AqiBreakpoint kIqarPm25[] = {
+        {0.0f, 25.0f, 0, 40},     {25.0f, 50.0f, 41, 80},     {50.0f, 75.0f, 81, 120},
+        {75.0f, 125.0f, 121, 200}, {125.0f, 300.0f, 201, 400},
+    };
+    static constexpr AqiBreakpoint kIqarPm10[] = {
+        {0.0f, 50.0f, 0, 40},      {50.0f, 100.0f, 41, 80},    {100.0f, 150.0f, 81, 120},
+        {150.0f, 250.0f, 121, 200}, {250.0f, 600.0f, 201, 400},
+    };
+    static constexpr AqiBreakpoint kIqarCo[] = {
+        {0.0f, 9.0f, 0, 40},     {9.0f, 11.0f, 41, 80},  {11.0f, 13.0f, 81, 120},
+        {13.0f, 15.0f, 121, 200}, {15.0f, 50.0f, 201, 400},
+    };
+
+    // Na ordem de Pollutant
+    static constexpr AqiTable kUsEpa[kPollutants] = {
+        {kEpaPm25, sizeof(kEpaPm25) / sizeof(kEpaPm25[0]), 10.0f},
+        {kEpaPm10, sizeof(kEpaPm10) / sizeof(kEpaPm10[0]), 1.0f},
+        {kEpaCo, sizeof(kEpaCo) / sizeof(kEpaCo[0]), 10.0f},
+    };
+    static constexpr AqiTable kBrIqar[kPollutants] = {
+        {kIqarPm25, sizeof(kIqarPm25) / sizeof(kIqarPm25[0]), 0.0f},
+        {kIqarPm10, sizeof(kIqarPm10) / sizeof(kIqarPm10[0]), 0.0f},
+        {kIqarCo, sizeof(kIqarCo) / sizeof(kIqarCo[0]), 0.0f},
+    };
+};
+
+// Pontos conhecidos das tabelas, conferidos na compilação
+static_assert(AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, 9.0f, NAN, NAN).index == 50, "");
+static_assert(AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, 9.1f, NAN, NAN).index == 51, "");
+static_assert(AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, NAN, 154.0f, 9.5f).index == 101, "");
+static_assert(AirQualityIndex::compute(AirQualityIndex::SCALE_BR_IQAR, 25.0f, 50.0f, 9.0f).index == 40, "");
+static_assert(AirQualityIndex::compute(AirQualityIndex::SCALE_US_EPA, NAN, NAN, NAN).index == -1, "");
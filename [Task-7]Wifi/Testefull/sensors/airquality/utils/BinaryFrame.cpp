@@ -0,0 +1,237 @@
+#define LOG_TAG "AirQualityBinFrame"
+
+#include "BinaryFrame.h"
+#include <log/log.h>
+
+#include <string.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "BinaryFrame copia os campos direto do fio (little-endian)");
+
+namespace {
+
+// Ordem dos floats no quadro (bit i da máscara = kFrameFields[i])
+float AirData::* const kFrameFields[BinaryFrame::kFieldCount] = {
+    &AirData::pm25,
+    &AirData::pm10,
+    &AirData::co_ppm,
+    &AirData::lpg_ppm,
+    &AirData::temp_c,
+    &AirData::humid_p,
+};
+
+// Contagem crua que pode ocupar o slot de um ppm (bit do byte [7])
+struct RawSlot {
+    size_t field;
+    uint8_t flag;
+    float AirData::* member;
+};
+
+const RawSlot kRawSlots[] = {
+    {2, BinaryFrame::kRawMq7, &AirData::mq7_raw},
+    {3, BinaryFrame::kRawMq2, &AirData::mq2_raw},
+};
+
+const size_t kOffsetVersion = 2;
+const size_t kOffsetSource = 3;
+const size_t kOffsetSeq = 4;
+const size_t kOffsetMask = 6;
+const size_t kOffsetRaw = 7;
+const size_t kOffsetFields = 8;
+const size_t kOffsetDeviceMs = 32;
+const size_t kOffsetCrc = 36;
+const size_t kOffsetCrcV1 = 32;
+
+// Tabela do CRC16-CCITT (0x1021): um acesso por byte em vez de 8 iterações
+struct CrcTable {
+    uint16_t entries[256];
+
+    constexpr CrcTable() : entries() {
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (int b = 0; b < 8; b++) {
+                crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+            }
+            entries[i] = crc;
+        }
+    }
+
+    uint16_t operator[](size_t i) const { return entries[i]; }
+};
+
+constexpr CrcTable kCrcTable;
+
+uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+void writeU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v & 0xFF);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+uint32_t readU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+void writeU32(uint8_t* p, uint32_t v) {
+    writeU16(p, static_cast<uint16_t>(v & 0xFFFF));
+    writeU16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+}  // namespace
+
+uint16_t BinaryFrame::crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ kCrcTable[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+size_t BinaryFrame::frameSize(uint8_t version) {
+    switch (version) {
+        case kVersion:   return kFrameSize;
+        case kVersionV1: return kFrameSizeV1;
+        default:         return 0;
+    }
+}
+
+void BinaryFrame::encode(const AirData& data, uint16_t seq, uint8_t out[kFrameSize]) {
+    static const AirData kEmpty;
+
+    memset(out, 0, kFrameSize);
+    out[0] = kSync0;
+    out[1] = kSync1;
+    out[kOffsetVersion] = kVersion;
+    out[kOffsetSource] = data.source == "wifi" ? kSourceWifi : kSourceSerial;
+    writeU16(out + kOffsetSeq, seq);
+
+    uint8_t mask = 0;
+    for (size_t i = 0; i < kFieldCount; i++) {
+        float value = data.*kFrameFields[i];
+        if (value == kEmpty.*kFrameFields[i]) continue;
+        mask |= static_cast<uint8_t>(1u << i);
+        memcpy(out + kOffsetFields + i * sizeof(float), &value, sizeof(float));
+    }
+    uint8_t raw = 0;
+    for (const RawSlot& slot : kRawSlots) {
+        float value = data.*slot.member;
+        if (mask & (1u << slot.field) || value == kEmpty.*slot.member) continue;
+        mask |= static_cast<uint8_t>(1u << slot.field);
+        raw |= slot.flag;
+        memcpy(out + kOffsetFields + slot.field * sizeof(float), &value, sizeof(float));
+    }
+    // millis() é uint32 no ESP32; fora disso a amostra fica com a chegada
+    if (data.deviceMs >= 0 && data.deviceMs <= UINT32_MAX) {
+        mask |= kHasDeviceMs;
+        writeU32(out + kOffsetDeviceMs, static_cast<uint32_t>(data.deviceMs));
+    }
+    out[kOffsetMask] = mask;
+    out[kOffsetRaw] = raw;
+
+    writeU16(out + kOffsetCrc, crc16(out + kOffsetVersion, kOffsetCrc - kOffsetVersion));
+}
+
+bool BinaryFrame::decode(const uint8_t* frame, AirData* data, uint16_t* seq) {
+    static const AirData kEmpty;
+
+    if (frame[0] != kSync0 || frame[1] != kSync1) return false;
+    bool v1 = frame[kOffsetVersion] == kVersionV1;
+    if (!v1 && frame[kOffsetVersion] != kVersion) return false;
+    size_t crcAt = v1 ? kOffsetCrcV1 : kOffsetCrc;
+    if (crc16(frame + kOffsetVersion, crcAt - kOffsetVersion) != readU16(frame + crcAt)) {
+        return false;
+    }
+
+    *data = AirData();
+    uint8_t mask = frame[kOffsetMask];
+    for (size_t i = 0; i < kFieldCount; i++) {
+        if (!(mask & (1u << i))) continue;
+        memcpy(&(data->*kFrameFields[i]), frame + kOffsetFields + i * sizeof(float), sizeof(float));
+    }
+    for (const RawSlot& slot : kRawSlots) {
+        if (!(frame[kOffsetRaw] & slot.flag) || !(mask & (1u << slot.field))) continue;
+        data->*slot.member = data->*kFrameFields[slot.field];
+        data->*kFrameFields[slot.field] = kEmpty.*kFrameFields[slot.field];
+    }
+    if (!v1 && (mask & kHasDeviceMs)) data->deviceMs = readU32(frame + kOffsetDeviceMs);
+    data->source = frame[kOffsetSource] == kSourceWifi ? "wifi" : "serial";
+    data->valid = true;
+    *seq = readU16(frame + kOffsetSeq);
+    return true;
+}
+
+BinaryFrameDecoder::BinaryFrameDecoder()
+    : mHead(0), mTail(0), mHaveSeq(false), mLastSeq(0), mBadFrames(0), mLostFrames(0),
+      mHeadNs(0), mCommitNs(0) {}
+
+size_t BinaryFrameDecoder::feed(const char* data, size_t len, int64_t arrivalNs) {
+    size_t n = len < writable() ? len : writable();
+    memcpy(writePtr(), data, n);
+    commit(n, arrivalNs);
+    return n;
+}
+
+BinaryFrameDecoder::Result BinaryFrameDecoder::next(AirData* data, std::string_view* text,
+                                                    int64_t* arrivalNs) {
+    while (mHead < mTail) {
+        if (mBuf[mHead] != BinaryFrame::kSync0 ||
+            (mTail - mHead >= 2 && mBuf[mHead + 1] != BinaryFrame::kSync1)) {
+            // Texto até o próximo possível início de quadro
+            const void* sync = memchr(mBuf + mHead + 1, BinaryFrame::kSync0, mTail - mHead - 1);
+            size_t end = sync ? static_cast<const uint8_t*>(sync) - mBuf : mTail;
+            *text = textView(mHead, end);
+            if (arrivalNs) *arrivalNs = mHeadNs;
+            mHead = end;
+            mHeadNs = mCommitNs;
+            return kText;
+        }
+
+        // O tamanho depende da versão, logo depois do sync
+        if (mTail - mHead < 3) break;
+        size_t size = BinaryFrame::frameSize(mBuf[mHead + 2]);
+        if (size != 0 && mTail - mHead < size) break;
+
+        uint16_t seq;
+        if (size == 0 || !BinaryFrame::decode(mBuf + mHead, data, &seq)) {
+            // Quadro corrompido: pula o sync e ressincroniza no próximo 0xA5
+            mBadFrames++;
+            ALOGV("Quadro binário inválido descartado");
+            mHead += 2;
+            mHeadNs = mCommitNs;
+            continue;
+        }
+
+        if (mHaveSeq) {
+            uint16_t gap = static_cast<uint16_t>(seq - mLastSeq - 1);
+            mLostFrames += gap;
+        }
+        mHaveSeq = true;
+        mLastSeq = seq;
+
+        data->timestamp = mHeadNs;
+        if (arrivalNs) *arrivalNs = mHeadNs;
+        mHead += size;
+        mHeadNs = mCommitNs;
+        return kFrame;
+    }
+
+    // Só sobra (no máximo) um quadro parcial: move para o início se o fim encheu
+    if (mHead == mTail) {
+        mHead = mTail = 0;
+    } else if (writable() < BinaryFrame::kFrameSize) {
+        size_t pending = mTail - mHead;
+        memmove(mBuf, mBuf + mHead, pending);
+        mHead = 0;
+        mTail = pending;
+    }
+    return kNeedMore;
+}
+
+void BinaryFrameDecoder::reset() {
+    mHead = mTail = 0;
+    mHaveSeq = false;
+    mHeadNs = mCommitNs = 0;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include "AirData.h"
+
+/**
+ * Protocolo binário compacto entre o firmware e a HAL, negociado com o
+ * comando "SET FORMAT BIN" (o JSON continua sendo o formato padrão).
+ *
+ * Quadro de tamanho fixo por versão, little-endian (versão 2):
+ *   [0-1]   sync 0xA5 0x5A
+ *   [2]     versão (kVersion)
+ *   [3]     origem (0 = serial, 1 = wifi)
+ *   [4-5]   número de sequência (uint16, incrementa a cada quadro)
+ *   [6]     máscara de campos presentes (bit i = i-ésimo float abaixo;
+ *           kHasDeviceMs = millis() presente)
+ *   [7]     campos crus (kRawMq7: co_ppm traz mq7_raw; kRawMq2: lpg_ppm traz mq2_raw)
+ *   [8-31]  pm25, pm10, co_ppm, lpg_ppm, temp_c, humid_p (float32)
+ *   [32-35] millis() da estação na medição (uint32), o "ms" do JSON
+ *   [36-37] CRC16-CCITT (poly 0x1021, init 0xFFFF) dos bytes [2, 36)
+ *
+ * A versão 1 (firmware antigo) não tem o millis(): o CRC vai em [32-33] e o
+ * quadro tem kFrameSizeV1 bytes. Ela continua sendo aceita.
+ *
+ * Campos fora da máscara ficam com o valor padrão do AirData ("sem leitura"),
+ * igual a uma chave ausente no payload JSON. O byte [7] era reservado e o
+ * firmware antigo sempre o mandou zerado.
+ */
+class BinaryFrame {
+public:
+    static constexpr uint8_t kSync0 = 0xA5;
+    static constexpr uint8_t kSync1 = 0x5A;
+    static constexpr uint8_t kVersion = 2;
+    static constexpr uint8_t kVersionV1 = 1;
+    static constexpr size_t kFieldCount = 6;
+    static constexpr size_t kFrameSize = 38;    // Versão atual (e maior quadro)
+    static constexpr size_t kFrameSizeV1 = 34;
+
+    static constexpr uint8_t kHasDeviceMs = 1u << kFieldCount;
+
+    static constexpr uint8_t kSourceSerial = 0;
+    static constexpr uint8_t kSourceWifi = 1;
+
+    static constexpr uint8_t kRawMq7 = 1u << 0;
+    static constexpr uint8_t kRawMq2 = 1u << 1;
+
+    static uint16_t crc16(const uint8_t* data, size_t len);
+
+    /// Tamanho do quadro de uma versão; 0 se a versão não é conhecida.
+    static size_t frameSize(uint8_t version);
+
+    /// Serializa um AirData na versão atual (campos < 0 / temp <= -273 ficam
+    /// fora da máscara). Sem co_ppm/lpg_ppm, o slot leva mq7_raw/mq2_raw com
+    /// o bit cru. deviceMs < 0 fica fora (kHasDeviceMs).
+    static void encode(const AirData& data, uint16_t seq, uint8_t out[kFrameSize]);
+
+    /**
+     * Valida sync, versão e CRC de um quadro completo (frameSize(frame[2])
+     * bytes) e preenche *data. Não carimba timestamp. Retorna false se o
+     * quadro estiver corrompido.
+     */
+    static bool decode(const uint8_t* frame, AirData* data, uint16_t* seq);
+};
+
+/**
+ * Separa um fluxo misto em quadros binários e trechos de texto.
+ *
+ * Com o modo binário ativo o firmware ainda pode mandar texto (acks, boot
+ * após um reset), então tudo o que não for quadro é devolvido como texto
+ * para o LineFramer. O JSON da estação é ASCII, logo 0xA5 nunca aparece nele.
+ *
+ * Quadros saem carimbados com a chegada do seu primeiro byte, pela mesma
+ * regra de commit() do LineFramer.
+ *
+ * Uso (mesmo padrão do LineFramer):
+ *   ssize_t n = read(fd, decoder.writePtr(), decoder.writable());
+ *   decoder.commit(n, android::elapsedRealtimeNano());
+ *   while ((r = decoder.next(&data, &text, &arrivalNs)) != BinaryFrameDecoder::kNeedMore) { ... }
+ */
+class BinaryFrameDecoder {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    enum Result {
+        kNeedMore,  // nada completo no buffer
+        kFrame,     // *data preenchido e carimbado com a chegada
+        kText,      // *text aponta para bytes que não são quadro
+    };
+
+    BinaryFrameDecoder();
+
+    uint8_t* writePtr() { return mBuf + mTail; }
+    size_t writable() const { return kCapacity - mTail; }
+    /// arrivalNs: quando os n bytes chegaram (elapsedRealtimeNano logo após o read).
+    void commit(size_t n, int64_t arrivalNs = 0) {
+        if (mHead == mTail) mHeadNs = arrivalNs;
+        mCommitNs = arrivalNs;
+        mTail += n;
+    }
+
+    /// Copia bytes que já estão em outro buffer; retorna quantos couberam.
+    size_t feed(const char* data, size_t len, int64_t arrivalNs = 0);
+
+    /**
+     * *arrivalNs (opcional) recebe a chegada do primeiro byte do quadro ou do
+     * texto; em kFrame ele também vai para data->timestamp.
+     * As views de texto só valem até a chamada de next() que devolve kNeedMore.
+     */
+    Result next(AirData* data, std::string_view* text, int64_t* arrivalNs = nullptr);
+
+    void reset();
+
+    /// Quadros descartados por CRC/versão inválidos.
+    size_t badFrameCount() const { return mBadFrames; }
+    /// Quadros perdidos, deduzidos pelos saltos no número de sequência.
+    size_t lostFrameCount() const { return mLostFrames; }
+
+private:
+    std::string_view textView(size_t begin, size_t end) const {
+        return std::string_view(reinterpret_cast<const char*>(mBuf) + begin, end - begin);
+    }
+
+    uint8_t mBuf[kCapacity];
+    size_t mHead;
+    size_t mTail;
+    bool mHaveSeq;
+    uint16_t mLastSeq;
+    size_t mBadFrames;
+    size_t mLostFrames;
+    int64_t mHeadNs;    // chegada do byte em mHead
+    int64_t mCommitNs;  // chegada do último commit
+};
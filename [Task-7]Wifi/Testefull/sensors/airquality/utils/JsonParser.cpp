@@ -2,30 +2,416 @@
 
 #include "JsonParser.h"
 #include <json/json.h>          // libjsoncpp
-#include <utils/SystemClock.h>  // Para android::elapsedRealtimeNano()
 #include <log/log.h>            // Para ALOGE, ALOGD
 
-AirData JsonParser::parse(const std::string& jsonLine) {
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+
+namespace {
+
+// Campos do payload e o membro correspondente em AirData
+struct PayloadField {
+    std::string_view key;
+    float AirData::*member;
+};
+
+const PayloadField kPayloadFields[] = {
+    { "pm25",    &AirData::pm25 },
+    { "pm10",    &AirData::pm10 },
+    { "co_ppm",  &AirData::co_ppm },
+    { "lpg_ppm", &AirData::lpg_ppm },
+    { "temp_c",  &AirData::temp_c },
+    { "humid_p", &AirData::humid_p },
+    { "mq2_raw", &AirData::mq2_raw },
+    { "mq7_raw", &AirData::mq7_raw },
+};
+
+// Profundidade máxima de objetos/arrays ignorados antes de desistir do caminho rápido
+const int kMaxSkipDepth = 32;
+// Maior número que o caminho rápido converte (cópia na pilha para o strtod)
+const size_t kMaxNumberLength = 63;
+
+enum class ScanResult {
+    kValid,     // Leitura de dados completa
+    kInvalid,   // JSON estrito mas fora do protocolo (ack, status, tipos errados...)
+    kFallback,  // Fora do JSON estrito: decide o jsoncpp
+};
+
+/**
+ * Scanner de passada única para o esquema da estação.
+ * Só aceita JSON estrito; diante de qualquer construção que o jsoncpp aceite por
+ * leniência (comentários, vírgula final, zeros à esquerda, escapes...) devolve
+ * kFallback em vez de arriscar um resultado diferente.
+ */
+class SchemaScanner {
+public:
+    explicit SchemaScanner(std::string_view text)
+        : mCur(text.data()), mEnd(text.data() + text.size()) {}
+
+    ScanResult scan(AirData* out) {
+        skipWs();
+        if (mCur == mEnd) return ScanResult::kInvalid;
+        if (*mCur != '{') {
+            // Comentário ou BOM antes da raiz: só o jsoncpp sabe tratar.
+            // Qualquer outra raiz (texto solto, array, número...) nunca é "data".
+            unsigned char c = static_cast<unsigned char>(*mCur);
+            return (c == '/' || c == 0xEF) ? ScanResult::kFallback : ScanResult::kInvalid;
+        }
+        mCur++;
+
+        bool typeIsData = false;
+        bool hasPayload = false;
+        bool payloadOk = false;
+        std::string_view src;
+
+        skipWs();
+        if (mCur < mEnd && *mCur == '}') {
+            mCur++;
+            return ScanResult::kInvalid;
+        }
+
+        while (true) {
+            std::string_view key;
+            skipWs();
+            if (!readString(&key)) return ScanResult::kFallback;
+            skipWs();
+            if (mCur == mEnd || *mCur != ':') return ScanResult::kFallback;
+            mCur++;
+            skipWs();
+            if (mCur == mEnd) return ScanResult::kFallback;
+
+            if (key == "type") {
+                // Chaves repetidas: vale a última (igual ao jsoncpp)
+                typeIsData = false;
+                if (*mCur == '"') {
+                    std::string_view type;
+                    if (!readString(&type)) return ScanResult::kFallback;
+                    typeIsData = (type == "data");
+                } else if (!skipValue(0)) {
+                    return ScanResult::kFallback;
+                }
+            } else if (key == "payload") {
+                hasPayload = true;
+                resetPayload(out);
+                if (*mCur == '{') {
+                    ScanResult r = scanPayload(out);
+                    if (r == ScanResult::kFallback) return r;
+                    payloadOk = (r == ScanResult::kValid);
+                } else {
+                    bool isNull = (mEnd - mCur >= 4 && memcmp(mCur, "null", 4) == 0);
+                    if (!skipValue(0)) return ScanResult::kFallback;
+                    payloadOk = isNull; // payload nulo = leitura sem campos
+                }
+            } else if (key == "ms") {
+                // Só inteiro literal não negativo; o resto ("1e3", 5.0, texto...) o jsoncpp decide
+                if (!readDeviceMs(&out->deviceMs)) return ScanResult::kFallback;
+            } else if (key == "src") {
+                src = std::string_view();
+                if (*mCur == '"') {
+                    if (!readString(&src)) return ScanResult::kFallback;
+                } else if (!skipValue(0)) {
+                    return ScanResult::kFallback;
+                }
+            } else if (!skipValue(0)) {
+                return ScanResult::kFallback;
+            }
+
+            skipWs();
+            if (mCur == mEnd) return ScanResult::kFallback;
+            if (*mCur == ',') { mCur++; continue; }
+            if (*mCur == '}') { mCur++; break; }
+            return ScanResult::kFallback;
+        }
+
+        // O que vier depois da raiz é ignorado pelo jsoncpp (failIfExtra = false)
+        if (!typeIsData || !hasPayload || !payloadOk) return ScanResult::kInvalid;
+
+        out->source.assign(src.data(), src.size()); // "serial"/"wifi" cabem no SSO
+        return ScanResult::kValid;
+    }
+
+private:
+    void skipWs() {
+        while (mCur < mEnd && (*mCur == ' ' || *mCur == '\t' || *mCur == '\n' || *mCur == '\r')) mCur++;
+    }
+
+    static void resetPayload(AirData* out) {
+        const AirData defaults;
+        for (const PayloadField& field : kPayloadFields) {
+            out->*field.member = defaults.*field.member;
+        }
+    }
+
+    // String sem escapes; com '\' o jsoncpp decide (decodificação/validação de escapes)
+    bool readString(std::string_view* out) {
+        if (mCur == mEnd || *mCur != '"') return false;
+        const char* begin = ++mCur;
+        while (mCur < mEnd) {
+            char c = *mCur;
+            if (c == '"') {
+                *out = std::string_view(begin, mCur - begin);
+                mCur++;
+                return true;
+            }
+            if (c == '\\') return false;
+            mCur++;
+        }
+        return false;
+    }
+
+    bool matchLiteral(const char* literal, size_t len) {
+        if (static_cast<size_t>(mEnd - mCur) < len || memcmp(mCur, literal, len) != 0) return false;
+        mCur += len;
+        return true;
+    }
+
+    // Número no formato estrito do JSON, convertido exatamente como o jsoncpp faz
+    bool readNumber(float* out) {
+        const char* begin = mCur;
+        bool negative = false;
+        if (*mCur == '-') { negative = true; mCur++; }
+
+        if (mCur == mEnd) return false;
+        if (*mCur == '0') {
+            mCur++;
+            if (mCur < mEnd && *mCur >= '0' && *mCur <= '9') return false; // zero à esquerda
+        } else if (*mCur >= '1' && *mCur <= '9') {
+            while (mCur < mEnd && *mCur >= '0' && *mCur <= '9') mCur++;
+        } else {
+            return false;
+        }
+        const char* intEnd = mCur;
+
+        bool integral = true;
+        if (mCur < mEnd && *mCur == '.') {
+            integral = false;
+            mCur++;
+            if (mCur == mEnd || *mCur < '0' || *mCur > '9') return false;
+            while (mCur < mEnd && *mCur >= '0' && *mCur <= '9') mCur++;
+        }
+        if (mCur < mEnd && (*mCur == 'e' || *mCur == 'E')) {
+            integral = false;
+            mCur++;
+            if (mCur < mEnd && (*mCur == '+' || *mCur == '-')) mCur++;
+            if (mCur == mEnd || *mCur < '0' || *mCur > '9') return false;
+            while (mCur < mEnd && *mCur >= '0' && *mCur <= '9') mCur++;
+        }
+
+        if (integral) {
+            // jsoncpp guarda inteiros que cabem em Int64/UInt64 como inteiros
+            // e só depois converte para float (sem passar por double)
+            uint64_t magnitude = 0;
+            bool overflow = false;
+            for (const char* p = begin + (negative ? 1 : 0); p < intEnd; p++) {
+                uint64_t digit = static_cast<uint64_t>(*p - '0');
+                if (magnitude > (UINT64_MAX - digit) / 10) { overflow = true; break; }
+                magnitude = magnitude * 10 + digit;
+            }
+            if (negative && magnitude > (uint64_t(1) << 63)) overflow = true;
+
+            if (!overflow) {
+                if (magnitude == 0) *out = 0.0f; // "-0" vira inteiro 0
+                else *out = negative ? -static_cast<float>(magnitude) : static_cast<float>(magnitude);
+                return true;
+            }
+        }
+
+        // Caminho exato de Clinger: mantissa com até 15 dígitos e 10^|exp| <= 10^22
+        // são representáveis em double, e uma única multiplicação/divisão IEEE é
+        // corretamente arredondada - mesmo resultado do strtod.
+        static const double kPow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+        };
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        const char* p = begin + (negative ? 1 : 0);
+        for (; p < mCur && *p != 'e' && *p != 'E'; p++) {
+            if (*p == '.') {
+                for (const char* q = p + 1; q < mCur && *q != 'e' && *q != 'E'; q++) exponent--;
+                continue;
+            }
+            if (mantissa == 0 && *p == '0') continue;
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            if (++digits > 15) break;
+        }
+        if (digits <= 15 && p < mCur && mCur - p <= 5) {
+            // Expoente explícito curto (p aponta para o 'e')
+            bool expNegative = false;
+            int explicitExp = 0;
+            const char* q = p + 1;
+            if (*q == '+' || *q == '-') expNegative = (*q++ == '-');
+            for (; q < mCur; q++) explicitExp = explicitExp * 10 + (*q - '0');
+            exponent += expNegative ? -explicitExp : explicitExp;
+        } else if (p < mCur) {
+            digits = 16; // força o strtod
+        }
+        if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+            double value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+            *out = static_cast<float>(negative ? -value : value);
+            return true;
+        }
+
+        size_t len = static_cast<size_t>(mCur - begin);
+        if (len > kMaxNumberLength) return false;
+        char buf[kMaxNumberLength + 1];
+        memcpy(buf, begin, len);
+        buf[len] = '\0';
+
+        errno = 0;
+        double value = strtod(buf, nullptr);
+        // Overflow/underflow: a aceitação varia com a versão do jsoncpp e com a
+        // libc++/libstdc++ por baixo do istream. Deixa o jsoncpp decidir.
+        if (errno == ERANGE) return false;
+        *out = static_cast<float>(value);
+        return true;
+    }
+
+    // "ms": dígitos com '-' opcional. Negativo vale como ausente (igual ao parseDom)
+    bool readDeviceMs(int64_t* out) {
+        bool negative = mCur < mEnd && *mCur == '-';
+        const char* p = mCur + (negative ? 1 : 0);
+        if (p == mEnd || *p < '0' || *p > '9' || (*p == '0' && p + 1 < mEnd && p[1] >= '0' && p[1] <= '9')) {
+            return false;
+        }
+        int64_t value = 0;
+        for (; p < mEnd && *p >= '0' && *p <= '9'; p++) {
+            if (value > (INT64_MAX - 9) / 10) return false;  // Grande demais: jsoncpp vira double
+            value = value * 10 + (*p - '0');
+        }
+        if (p < mEnd && (*p == '.' || *p == 'e' || *p == 'E')) return false;
+        mCur = p;
+        *out = (negative && value != 0) ? -1 : value;
+        return true;
+    }
+
+    // Pula um valor qualquer validando a sintaxe estrita
+    bool skipValue(int depth) {
+        if (mCur == mEnd) return false;
+        switch (*mCur) {
+            case '"': {
+                std::string_view ignored;
+                return readString(&ignored);
+            }
+            case 't': return matchLiteral("true", 4);
+            case 'f': return matchLiteral("false", 5);
+            case 'n': return matchLiteral("null", 4);
+            case '{':
+            case '[': {
+                if (depth >= kMaxSkipDepth) return false;
+                bool isObject = (*mCur == '{');
+                char close = isObject ? '}' : ']';
+                mCur++;
+                skipWs();
+                if (mCur < mEnd && *mCur == close) { mCur++; return true; }
+                while (true) {
+                    skipWs();
+                    if (isObject) {
+                        std::string_view ignored;
+                        if (!readString(&ignored)) return false;
+                        skipWs();
+                        if (mCur == mEnd || *mCur != ':') return false;
+                        mCur++;
+                        skipWs();
+                    }
+                    if (!skipValue(depth + 1)) return false;
+                    skipWs();
+                    if (mCur == mEnd) return false;
+                    if (*mCur == ',') { mCur++; continue; }
+                    if (*mCur == close) { mCur++; return true; }
+                    return false;
+                }
+            }
+            default: {
+                float ignored;
+                return readNumber(&ignored);
+            }
+        }
+    }
+
+    // kValid: payload ok | kInvalid: algum campo conhecido com tipo errado | kFallback
+    ScanResult scanPayload(AirData* out) {
+        mCur++; // '{'
+        unsigned badFields = 0; // bit i = último valor do campo i tem tipo errado
+
+        skipWs();
+        if (mCur < mEnd && *mCur == '}') { mCur++; return ScanResult::kValid; }
+
+        while (true) {
+            std::string_view key;
+            skipWs();
+            if (!readString(&key)) return ScanResult::kFallback;
+            skipWs();
+            if (mCur == mEnd || *mCur != ':') return ScanResult::kFallback;
+            mCur++;
+            skipWs();
+            if (mCur == mEnd) return ScanResult::kFallback;
+
+            int index = -1;
+            for (size_t i = 0; i < sizeof(kPayloadFields) / sizeof(kPayloadFields[0]); i++) {
+                if (kPayloadFields[i].key == key) { index = static_cast<int>(i); break; }
+            }
+
+            char c = *mCur;
+            if (index < 0) {
+                if (!skipValue(0)) return ScanResult::kFallback;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                float value;
+                if (!readNumber(&value)) return ScanResult::kFallback;
+                out->*kPayloadFields[index].member = value;
+                badFields &= ~(1u << index);
+            } else if (c == 't' || c == 'f' || c == 'n') {
+                // Mesma conversão do Json::Value::asFloat(): true = 1, false/null = 0
+                if (!skipValue(0)) return ScanResult::kFallback;
+                out->*kPayloadFields[index].member = (c == 't') ? 1.0f : 0.0f;
+                badFields &= ~(1u << index);
+            } else {
+                // String/objeto/array: tipo incompatível (vale o último valor da chave)
+                if (!skipValue(0)) return ScanResult::kFallback;
+                badFields |= (1u << index);
+            }
+
+            skipWs();
+            if (mCur == mEnd) return ScanResult::kFallback;
+            if (*mCur == ',') { mCur++; continue; }
+            if (*mCur == '}') { mCur++; break; }
+            return ScanResult::kFallback;
+        }
+        return badFields == 0 ? ScanResult::kValid : ScanResult::kInvalid;
+    }
+
+    const char* mCur;
+    const char* mEnd;
+};
+
+}  // namespace
+
+// Leitor JSON reaproveitado (um por thread: SerialReader e WifiReader)
+static Json::CharReader* threadReader() {
+    static thread_local std::unique_ptr<Json::CharReader> reader(
+            Json::CharReaderBuilder().newCharReader());
+    return reader.get();
+}
+
+static AirData parseDom(std::string_view jsonLine, int64_t timestamp) {
     AirData data;
-    
-    // Carimbar o tempo IMEDIATAMENTE (Requisito do Android SensorService)
-    // Usa o relógio monotônico do kernel (boot time)
-    data.timestamp = android::elapsedRealtimeNano();
-
-    // Configuração do leitor JSON
-    Json::CharReaderBuilder builder;
-    Json::CharReader* reader = builder.newCharReader();
+    data.timestamp = timestamp;
+
     Json::Value root;
     std::string errors;
 
     // Tentar fazer o parse da string
-    bool parsingSuccessful = reader->parse(
-        jsonLine.c_str(), 
-        jsonLine.c_str() + jsonLine.size(), 
-        &root, 
+    bool parsingSuccessful = threadReader()->parse(
+        jsonLine.data(),
+        jsonLine.data() + jsonLine.size(),
+        &root,
         &errors
     );
-    delete reader;
 
     if (!parsingSuccessful) {
         ALOGE("Falha ao ler JSON: %s", errors.c_str());
@@ -35,7 +421,8 @@ AirData JsonParser::parse(const std::string& jsonLine) {
 
     // Validar o protocolo
     // Exemplo esperado: { "type": "data", "payload": { ... } }
-    if (!root.isMember("type") || root["type"].asString() != "data") {
+    if (!root.isObject() || !root.isMember("type") ||
+        !root["type"].isString() || root["type"].asString() != "data") {
         // Se for um "ack" ou outro comando, ignoramos silenciosamente aqui
         data.valid = false;
         return data;
@@ -46,27 +433,94 @@ AirData JsonParser::parse(const std::string& jsonLine) {
         return data;
     }
 
-    Json::Value payload = root["payload"];
+    // Referência (sem cópia do sub-objeto). "payload": null vale como leitura vazia.
+    const Json::Value& payload = root["payload"];
+    if (!payload.isObject() && !payload.isNull()) {
+        data.valid = false;
+        return data;
+    }
 
     // Extrair dados com segurança
-    // O método .get("key", default) evita crash se a chave não existir
-    
-    // PM2.5 e PM10 (SDS011)
-    if (payload.isMember("pm25")) data.pm25 = payload["pm25"].asFloat();
-    if (payload.isMember("pm10")) data.pm10 = payload["pm10"].asFloat();
-
-    // Gases (MQ2 / MQ7)
-    if (payload.isMember("co_ppm"))  data.co_ppm  = payload["co_ppm"].asFloat();
-    if (payload.isMember("lpg_ppm")) data.lpg_ppm = payload["lpg_ppm"].asFloat();
-
-    // Clima (DHT)
-    if (payload.isMember("temp_c"))  data.temp_c  = payload["temp_c"].asFloat();
-    if (payload.isMember("humid_p")) data.humid_p = payload["humid_p"].asFloat();
-    
-    // Fonte (Opcional)
-    if (root.isMember("src")) data.source = root["src"].asString();
+    // asFloat() só é chamado para número/bool/null (outros tipos abortariam)
+    // PM2.5 e PM10 (SDS011), Gases (MQ2 / MQ7), Clima (DHT)
+    for (const PayloadField& field : kPayloadFields) {
+        std::string key(field.key);
+        if (!payload.isMember(key)) continue;
+        const Json::Value& value = payload[key];
+        if (!value.isNumeric() && !value.isBool() && !value.isNull()) {
+            AirData invalid;
+            invalid.timestamp = timestamp;
+            return invalid;
+        }
+        data.*field.member = value.asFloat();
+    }
+
+    // Fonte e millis() da estação (opcionais)
+    if (root.isMember("src") && root["src"].isString()) data.source = root["src"].asString();
+    if (root.isMember("ms") && root["ms"].isInt64() && root["ms"].asInt64() >= 0) {
+        data.deviceMs = root["ms"].asInt64();
+    }
 
     data.valid = true;
     return data;
 }
 
+AirData JsonParser::parseWithJsoncpp(std::string_view jsonLine, int64_t timestamp) {
+    return parseDom(jsonLine, timestamp);
+}
+
+AirData JsonParser::parse(std::string_view jsonLine, int64_t timestamp) {
+    AirData data;
+    data.timestamp = timestamp;
+
+    switch (SchemaScanner(jsonLine).scan(&data)) {
+        case ScanResult::kValid:
+            data.valid = true;
+            return data;
+
+        case ScanResult::kInvalid: {
+            ALOGV("Linha ignorada (fora do protocolo de dados)");
+            AirData invalid;
+            invalid.timestamp = timestamp;
+            return invalid;
+        }
+
+        case ScanResult::kFallback:
+            break;
+    }
+    return parseDom(jsonLine, timestamp);
+}
+
+JsonParser::Control JsonParser::parseControl(std::string_view jsonLine, std::string* deviceId) {
+    Json::Value root;
+    std::string errors;
+    if (!threadReader()->parse(jsonLine.data(), jsonLine.data() + jsonLine.size(), &root, &errors) ||
+        !root.isObject() || !root["type"].isString()) {
+        return Control::kNone;
+    }
+
+    const std::string type = root["type"].asString();
+    if (type == "boot" || type == "settings") {
+        const Json::Value& id = root[type == "boot" ? "device" : "device_id"];
+        if (deviceId != nullptr && id.isString()) *deviceId = id.asString();
+        return type == "boot" ? Control::kBoot : Control::kSettings;
+    }
+
+    if (type != "ack" || !root["cmd"].isString()) return Control::kNone;
+    const std::string cmd = root["cmd"].asString();
+
+    // { "type": "ack", "cmd": "set_format", "format": "bin" | "json" }
+    if (cmd == "set_format" && root["format"].isString()) {
+        const std::string format = root["format"].asString();
+        if (format == "bin") return Control::kFormatBinary;
+        if (format == "json") return Control::kFormatJson;
+    }
+
+    // { "type": "ack", "cmd": "stream", "status": "on" | "off", ... }
+    if (cmd == "stream" && root["status"].isString()) {
+        const std::string status = root["status"].asString();
+        if (status == "on") return Control::kStreamOn;
+        if (status == "off") return Control::kStreamOff;
+    }
+    return Control::kNone;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <string>
+#include <stdint.h>
+#include <string_view>
 #include "AirData.h"
 
 class JsonParser {
@@ -8,7 +9,43 @@ public:
     /**
      * Recebe uma linha de texto (JSON) e converte para AirData.
      * Retorna uma struct com .valid = false se o JSON for inválido.
+     *
+     * O parser não lê relógio: timestamp é o instante em que o primeiro byte
+     * da linha chegou (LineFramer::nextLine), copiado para AirData::timestamp.
+     * O "ms" opcional da raiz (millis() da estação) vai para AirData::deviceMs.
+     *
+     * Caminho rápido: scanner de passada única especializado no esquema da
+     * estação (type, src, ms, payload.{pm25,pm10,co_ppm,lpg_ppm,temp_c,humid_p,
+     * mq2_raw,mq7_raw}),
+     * sem DOM e sem alocação. Qualquer coisa fora do JSON estrito (comentários,
+     * vírgula sobrando, escapes, números não canônicos...) é repassada para
+     * parseWithJsoncpp(), então o resultado é sempre idêntico ao do jsoncpp.
      */
-    static AirData parse(const std::string& jsonLine);
-};
+    static AirData parse(std::string_view jsonLine, int64_t timestamp);
+
+    /**
+     * Caminho de referência via jsoncpp (DOM), usado como fallback de parse()
+     * e como oráculo do teste diferencial. O CharReader é reaproveitado por thread.
+     * Valores com tipo incompatível (ex.: "pm25":"abc") invalidam a leitura.
+     */
+    static AirData parseWithJsoncpp(std::string_view jsonLine, int64_t timestamp);
 
+    /// Mensagens de controle do firmware usadas na negociação do formato e do stream.
+    enum class Control {
+        kNone,
+        kBoot,          // {"type":"boot",...}: o firmware reiniciou (volta ao JSON)
+        kSettings,      // resposta de "GET SETTINGS"
+        kFormatBinary,  // ack de "SET FORMAT BIN"
+        kFormatJson,    // ack de "SET FORMAT JSON"
+        kStreamOn,      // ack de "STREAM ON <period_ms>"
+        kStreamOff,     // ack de "STREAM OFF"
+    };
+
+    /**
+     * Identifica mensagens de controle. Só deve ser chamado para linhas que
+     * parse() rejeitou (é o caminho jsoncpp, sem pressa).
+     * deviceId (opcional) recebe a identificação da estação quando a mensagem
+     * traz uma: "device" do boot ou "device_id" do settings.
+     */
+    static Control parseControl(std::string_view jsonLine, std::string* deviceId = nullptr);
+};
@@ -0,0 +1,143 @@
+#include "MqConverter.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace {
+
+struct Model {
+    float loadKohm;  // RL do módulo
+    float r0Kohm;    // R0 padrão, sem calibração
+    float a;         // ppm = a * (Rs/R0)^b
+    float b;
+    float maxPpm;    // Teto: maxRange do sensor da HAL
+};
+
+// Curvas do datasheet ajustadas em lei de potência (LPG do MQ-2, CO do MQ-7)
+const Model kModels[MqConverter::kGases] = {
+    {10.0f, 10.0f, 574.25f, -2.222f, 10000.0f},
+    {10.0f, 10.0f, 99.042f, -1.518f, 1000.0f},
+};
+
+// Grade da compensação: -10..50 C de 1 em 1, 0..100% de 5 em 5
+const float kTempMinC = -10.0f;
+const float kTempStepC = 1.0f;
+const int kTempSteps = 61;
+const float kHumidStepP = 5.0f;
+const int kHumidSteps = 21;
+
+inline float clampf(float x, float lo, float hi) {
+    // NaN cai em lo
+    return x > lo ? (x < hi ? x : hi) : lo;
+}
+
+// Rs(t, h) / Rs(20 C, 33%), já limitado à faixa da grade
+double compensation(float tempC, float humidP) {
+    double t = clampf(tempC, kTempMinC, kTempMinC + (kTempSteps - 1) * kTempStepC);
+    double h = clampf(humidP, 0.0f, (kHumidSteps - 1) * kHumidStepP);
+    auto fit = [](double t, double h) {
+        return 0.00035 * t * t - 0.02718 * t + 1.39538 - (h - 33.0) * 0.0018;
+    };
+    return fit(t, h) / fit(MqConverter::kRefTempC, MqConverter::kRefHumidP);
+}
+
+// Rs (kOhm) na contagem raw; infinito em raw <= 0
+double loadResistanceKohm(const Model& model, double raw) {
+    double v = raw * MqConverter::kVrefV / MqConverter::kAdcMax;
+    if (v <= 0.0) return INFINITY;
+    return model.loadKohm * (MqConverter::kSupplyV - v) / v;
+}
+
+}  // namespace
+
+struct MqConverter::Tables {
+    // a * Rs^b por contagem, com uma entrada a mais para interpolar em kAdcMax
+    float raw[kAdcMax + 2];
+    // CF^-b, linha = temperatura, coluna = umidade
+    float comp[kTempSteps * kHumidSteps];
+    float maxPpm;
+
+    explicit Tables(const Model& model) : maxPpm(model.maxPpm) {
+        for (int i = 0; i <= kAdcMax; i++) {
+            double rs = loadResistanceKohm(model, i);
+            raw[i] = isinf(rs) ? 0.0f : static_cast<float>(model.a * pow(rs, model.b));
+        }
+        raw[kAdcMax + 1] = raw[kAdcMax];
+        for (int t = 0; t < kTempSteps; t++) {
+            for (int h = 0; h < kHumidSteps; h++) {
+                double cf = compensation(kTempMinC + t * kTempStepC, h * kHumidStepP);
+                comp[t * kHumidSteps + h] = static_cast<float>(pow(cf, -model.b));
+            }
+        }
+    }
+};
+
+const MqConverter::Tables& MqConverter::tables(Gas gas) {
+    static const Tables kTables[kGases] = {Tables(kModels[GAS_LPG_MQ2]), Tables(kModels[GAS_CO_MQ7])};
+    return kTables[gas];
+}
+
+float MqConverter::defaultR0Kohm(Gas gas) {
+    return kModels[gas].r0Kohm;
+}
+
+MqConverter::MqConverter(Gas gas, float r0Kohm)
+    : mTables(tables(gas)),
+      mScale(static_cast<float>(pow(r0Kohm > 0.0f ? r0Kohm : kModels[gas].r0Kohm, -kModels[gas].b))) {}
+
+void MqConverter::convert(const float* __restrict raw, const float* __restrict tempC,
+                          const float* __restrict humidP, float* __restrict ppm, size_t n) const {
+    const float* rawTable = mTables.raw;
+    const float* comp = mTables.comp;
+    const float scale = mScale;
+    const float maxPpm = mTables.maxPpm;
+    for (size_t i = 0; i < n; i++) {
+        float x = clampf(raw[i], 0.0f, static_cast<float>(kAdcMax));
+        int k = static_cast<int>(x);
+        float base = rawTable[k] + (x - k) * (rawTable[k + 1] - rawTable[k]);
+
+        float t = clampf((tempC[i] - kTempMinC) / kTempStepC, 0.0f, kTempSteps - 1.0f);
+        float h = clampf(humidP[i] / kHumidStepP, 0.0f, kHumidSteps - 1.0f);
+        int ti = std::min(static_cast<int>(t), kTempSteps - 2);
+        int hi = std::min(static_cast<int>(h), kHumidSteps - 2);
+        float ft = t - ti;
+        float fh = h - hi;
+        const float* row0 = comp + ti * kHumidSteps + hi;
+        const float* row1 = row0 + kHumidSteps;
+        float c0 = row0[0] + fh * (row0[1] - row0[0]);
+        float c1 = row1[0] + fh * (row1[1] - row1[0]);
+
+        ppm[i] = std::min(base * scale * (c0 + ft * (c1 - c0)), maxPpm);
+    }
+}
+
+float MqConverter::reference(Gas gas, float r0Kohm, float raw, float tempC, float humidP) {
+    const Model& model = kModels[gas];
+    double rs = loadResistanceKohm(model, clampf(raw, 0.0f, static_cast<float>(kAdcMax)));
+    if (isinf(rs)) return 0.0f;
+    double r0 = r0Kohm > 0.0f ? r0Kohm : model.r0Kohm;
+    double ppm = model.a * pow(rs / r0 / compensation(tempC, humidP), model.b);
+    return static_cast<float>(std::min<double>(ppm, model.maxPpm));
+}
+
+MqConversionStage::MqConversionStage()
+    : mLpg(MqConverter::GAS_LPG_MQ2), mCo(MqConverter::GAS_CO_MQ7) {
+    reset();
+}
+
+void MqConversionStage::reset() {
+    mTempC = MqConverter::kRefTempC;
+    mHumidP = MqConverter::kRefHumidP;
+}
+
+void MqConversionStage::apply(AirData* data) {
+    if (AirData::hasReading(&AirData::temp_c, data->temp_c)) mTempC = data->temp_c;
+    if (AirData::hasReading(&AirData::humid_p, data->humid_p)) mHumidP = data->humid_p;
+    if (data->mq2_raw >= 0.0f && data->lpg_ppm < 0.0f) {
+        data->lpg_ppm = mLpg.convert(data->mq2_raw, mTempC, mHumidP);
+    }
+    if (data->mq7_raw >= 0.0f && data->co_ppm < 0.0f) {
+        data->co_ppm = mCo.convert(data->mq7_raw, mTempC, mHumidP);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "AirData.h"
+
+#include <stddef.h>
+
+/**
+ * Contagem crua do ADC de um sensor MQ (12 bits do ESP32, ADC_11db) para ppm,
+ * pela curva log-log do datasheet:
+ *
+ *   Vout = raw * kVrefV / kAdcMax
+ *   Rs   = RL * (kSupplyV - Vout) / Vout
+ *   ppm  = a * (Rs / R0 / CF(t, h))^b
+ *
+ * CF é a dependência de Rs/R0 com temperatura e umidade (figura de 33% e 85%
+ * UR dos datasheets da família MQ), no ajuste quadrático usual, normalizado
+ * para 1 em 20 C / 33% UR; fora de -10..50 C e 0..100% vale a borda.
+ *
+ * Nada de pow/log por amostra: como (Rs/R0)^b = Rs^b * R0^-b, uma tabela por
+ * gás guarda a * Rs^b para cada contagem do ADC (interpolada entre contagens)
+ * e outra, de temperatura x umidade, guarda CF^-b (interpolação bilinear).
+ * As tabelas são montadas uma vez e compartilhadas; R0 vira um fator por
+ * instância. O laço de convert() não tem desvios e trabalha sobre arrays
+ * contíguos, para o compilador vetorizar lotes (histórico, várias estações).
+ */
+class MqConverter {
+public:
+    enum Gas {
+        GAS_LPG_MQ2,  // lpg_ppm a partir de mq2_raw
+        GAS_CO_MQ7,   // co_ppm a partir de mq7_raw
+        kGases
+    };
+
+    static constexpr int kAdcMax = 4095;
+    static constexpr float kVrefV = 3.3f;
+    static constexpr float kSupplyV = 5.0f;  // Divisor RL/Rs alimentado em 5 V
+    // Condição de referência da curva (CF = 1); também o padrão sem DHT
+    static constexpr float kRefTempC = 20.0f;
+    static constexpr float kRefHumidP = 33.0f;
+
+    /// r0Kohm: Rs do sensor no gás de referência da curva (0 = o padrão do modelo).
+    explicit MqConverter(Gas gas, float r0Kohm = 0.0f);
+
+    float convert(float raw, float tempC, float humidP) const {
+        float ppm;
+        convert(&raw, &tempC, &humidP, &ppm, 1);
+        return ppm;
+    }
+
+    /// n amostras de uma vez; temperatura e umidade já válidas (sem "sem leitura").
+    void convert(const float* raw, const float* tempC, const float* humidP, float* ppm,
+                 size_t n) const;
+
+    /// A fórmula acima com pow() em double, para testes e para montar as tabelas.
+    static float reference(Gas gas, float r0Kohm, float raw, float tempC, float humidP);
+
+    static float defaultR0Kohm(Gas gas);
+
+private:
+    struct Tables;
+    static const Tables& tables(Gas gas);
+
+    const Tables& mTables;
+    float mScale;  // R0^-b
+};
+
+/**
+ * O estágio de conversão de um leitor: preenche co_ppm/lpg_ppm a partir de
+ * mq7_raw/mq2_raw quando a estação mandou só a contagem do ADC (o ppm que já
+ * veio pronto fica). Amostras parciais (GET DATA MQ7) usam a última
+ * temperatura e umidade da mesma estação; sem nenhuma, a de referência.
+ * Só a thread do leitor usa.
+ */
+class MqConversionStage {
+public:
+    MqConversionStage();
+
+    /// Nova conexão: esquece temperatura e umidade.
+    void reset();
+
+    void apply(AirData* data);
+
+private:
+    MqConverter mLpg;
+    MqConverter mCo;
+    float mTempC;
+    float mHumidP;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+/**
+ * Fila circular lock-free de um produtor e um consumidor (SPSC), capacidade fixa.
+ *
+ * push() só pode ser chamado por uma thread e pop() por outra. Nenhuma das duas
+ * bloqueia: com a fila cheia o push() falha na hora e o descarte é contado.
+ * Os slots são alocados uma vez; push/pop só fazem cópia/move no slot.
+ *
+ * highWater() é a maior ocupação já vista (após um push), útil para dimensionar
+ * Capacity: se encostar nela, o consumidor não está dando conta.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing precisa de capacidade potência de 2");
+
+    SpscRing() : mHead(0), mTail(0), mDrops(0), mHighWater(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /// Produtor. Retorna false (e conta o descarte) se a fila está cheia.
+    bool push(const T& item) {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t head = mHead.load(std::memory_order_acquire);
+        if (tail - head == Capacity) {
+            mDrops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        mSlots[tail & kMask] = item;
+        mTail.store(tail + 1, std::memory_order_release);
+
+        size_t used = tail + 1 - head;
+        if (used > mHighWater.load(std::memory_order_relaxed)) {
+            mHighWater.store(used, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /// Consumidor. Retorna false se a fila está vazia.
+    bool pop(T* out) {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) return false;
+        *out = std::move(mSlots[head & kMask]);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Ocupação aproximada (exata só vista de um dos dois lados).
+    size_t size() const {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+    uint64_t drops() const { return mDrops.load(std::memory_order_relaxed); }
+    size_t highWater() const { return mHighWater.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    // Linhas de cache separadas: o produtor escreve mTail, o consumidor mHead
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+    alignas(64) std::atomic<uint64_t> mDrops;
+    std::atomic<size_t> mHighWater;
+    T mSlots[Capacity];
+};
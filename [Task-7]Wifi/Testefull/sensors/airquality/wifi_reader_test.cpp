@@ -0,0 +1,239 @@
+// Testes do WifiReader contra uma estação TCP local: o mesmo ESP32 falso dos
+// testes seriais (fake_station.h) atendendo num socket de 127.0.0.1.
+// Conexão não bloqueante, backoff, reconexão, warm standby e stop() rápido.
+
+#include "fake_station.h"
+#include "io/WifiReader.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t elapsedMs(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+// Servidor de um cliente por vez em 127.0.0.1 (porta efêmera)
+class TcpStation {
+public:
+    explicit TcpStation(FakeStation::Features features, int backlog = 1) : mFeatures(features) {
+        mListenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(mListenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        listen(mListenFd, backlog);
+        socklen_t len = sizeof(addr);
+        getsockname(mListenFd, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        mPort = ntohs(addr.sin_port);
+    }
+
+    ~TcpStation() {
+        dropClient();
+        close(mListenFd);
+    }
+
+    int port() const { return mPort; }
+    int listenFd() const { return mListenFd; }
+    int accepted() const { return mAccepted; }
+    FakeStation* station() { return mStation.get(); }
+
+    // Aceita o cliente pendente e atende a estação
+    void serve() {
+        int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            dropClient();
+            mClientFd = fd;
+            mStation.reset(new FakeStation(fd, mFeatures));
+            mAccepted++;
+        }
+        if (mStation) mStation->serve();
+    }
+
+    // Estação desligada/reiniciada: derruba a conexão atual
+    void dropClient() {
+        mStation.reset();
+        if (mClientFd >= 0) close(mClientFd);
+        mClientFd = -1;
+    }
+
+    template <typename Pred>
+    bool waitFor(Pred pred, int timeoutMs) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (Clock::now() < deadline) {
+            serve();
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return false;
+    }
+
+private:
+    FakeStation::Features mFeatures;
+    int mListenFd = -1;
+    int mClientFd = -1;
+    int mPort = 0;
+    int mAccepted = 0;
+    std::unique_ptr<FakeStation> mStation;
+};
+
+class WifiReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // A estação falsa escreve num socket que o leitor pode ter fechado
+        signal(SIGPIPE, SIG_IGN);
+    }
+};
+
+}  // namespace
+
+TEST(WifiReaderBackoffTest, GrowsWithJitterUpToTheCap) {
+    EXPECT_EQ(0, WifiReader::reconnectDelayMs(0, 12345));
+    for (uint32_t random : {0u, 1u, 77u, 0xFFFFFFFFu}) {
+        int64_t ceiling = WifiReader::kBackoffBaseMs;
+        for (int failures = 1; failures <= 40; failures++) {
+            int64_t delay = WifiReader::reconnectDelayMs(failures, random);
+            EXPECT_GE(delay, ceiling / 2) << failures;
+            EXPECT_LE(delay, ceiling) << failures;
+            ceiling = std::min(ceiling * 2, WifiReader::kBackoffMaxMs);
+        }
+    }
+    EXPECT_EQ(WifiReader::kBackoffMaxMs / 2, WifiReader::reconnectDelayMs(1000, 0));
+}
+
+TEST_F(WifiReaderTest, PollsOldFirmware) {
+    TcpStation server({false, false});
+    CollectingListener listener;
+    WifiReader reader("127.0.0.1", server.port());
+    reader.setListener(&listener);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(server.waitFor([&] { return listener.count() >= 2; }, 5000));
+    EXPECT_EQ("serial", listener.readings()[0].source);  // o payload da estação falsa
+
+    WifiReader::Stats stats = reader.stats();
+    EXPECT_TRUE(stats.connected);
+    EXPECT_EQ(1u, stats.connects);
+    EXPECT_EQ(0u, stats.connectFailures);
+    EXPECT_GE(stats.lastReconnectMs, 0);
+    EXPECT_LT(stats.lastReconnectMs, 1000);
+    reader.stop();
+}
+
+TEST_F(WifiReaderTest, ReconnectsAfterStationDrops) {
+    TcpStation server({false, true});
+    CollectingListener listener;
+    WifiReader reader("127.0.0.1", server.port());
+    reader.setListener(&listener);
+    reader.setSamplingPeriodNs(100000000LL);  // 10Hz em stream
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(server.waitFor([&] { return listener.count() >= 3; }, 5000));
+    ASSERT_TRUE(server.station()->streaming());
+
+    server.dropClient();
+    size_t before = listener.count();
+    ASSERT_TRUE(server.waitFor([&] { return listener.count() >= before + 3; }, 5000));
+    EXPECT_TRUE(server.station()->streaming());  // stream renegociado na conexão nova
+
+    WifiReader::Stats stats = reader.stats();
+    EXPECT_EQ(2, server.accepted());
+    EXPECT_EQ(2u, stats.connects);
+    EXPECT_EQ(1u, stats.disconnects);
+    // A conexão derrubada tinha entregado dados: reconecta sem esperar backoff
+    EXPECT_LT(stats.lastReconnectMs, 1000);
+    reader.stop();
+}
+
+TEST_F(WifiReaderTest, BacksOffWhileStationIsDown) {
+    int port;
+    {
+        TcpStation closed({});
+        port = closed.port();
+    }  // porta livre, ninguém escutando: connect() recusado na hora
+
+    WifiReader reader("127.0.0.1", port);
+    reader.setPollingActive(true);
+    reader.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+    // Tentativas em 0, ~125-250, ~250-500 e ~500-1000 ms a mais: nunca um laço apertado
+    WifiReader::Stats stats = reader.stats();
+    EXPECT_FALSE(stats.connected);
+    EXPECT_GE(stats.connectFailures, 2u);
+    EXPECT_LE(stats.connectFailures, 5u);
+    EXPECT_EQ(-1, stats.lastReconnectMs);
+
+    // stop() no meio do backoff volta na hora
+    auto start = Clock::now();
+    reader.stop();
+    EXPECT_LT(elapsedMs(start), 200);
+}
+
+TEST_F(WifiReaderTest, StopInterruptsPendingConnect) {
+    // Backlog cheio: o kernel descarta o SYN e o connect() fica pendente
+    TcpStation server({}, 0);
+    int filler = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(server.port());
+    ASSERT_EQ(0, connect(filler, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)));
+
+    WifiReader reader("127.0.0.1", server.port());
+    reader.setPollingActive(true);
+    reader.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_FALSE(reader.stats().connected);
+
+    auto start = Clock::now();
+    reader.stop();
+    EXPECT_LT(elapsedMs(start), 200);
+    EXPECT_EQ(0u, reader.stats().connectFailures);  // interrompido, não falhou
+    close(filler);
+}
+
+TEST_F(WifiReaderTest, WarmStandbyKeepsTheConnection) {
+    TcpStation server({false, true});
+    CollectingListener listener;
+    WifiReader reader("127.0.0.1", server.port());
+    reader.setListener(&listener);
+    reader.setWarmStandby(true);
+    reader.setSamplingPeriodNs(100000000LL);
+    reader.setPollingActive(true);
+    reader.start();
+
+    ASSERT_TRUE(server.waitFor([&] { return listener.count() >= 2; }, 5000));
+    reader.setPollingActive(false);
+    ASSERT_TRUE(server.waitFor([&] { return !server.station()->streaming(); }, 2000));
+    EXPECT_TRUE(reader.stats().connected);
+
+    size_t before = listener.count();
+    reader.setPollingActive(true);
+    ASSERT_TRUE(server.waitFor([&] { return listener.count() >= before + 2; }, 5000));
+    EXPECT_EQ(1, server.accepted());
+    EXPECT_EQ(1u, reader.stats().connects);
+
+    // Sem warm standby a conexão fecha e a reativação conecta de novo
+    reader.setWarmStandby(false);
+    reader.setPollingActive(false);
+    ASSERT_TRUE(server.waitFor([&] { return !reader.stats().connected; }, 2000));
+    reader.setPollingActive(true);
+    ASSERT_TRUE(server.waitFor([&] { return server.accepted() == 2 && reader.stats().connected; }, 5000));
+    EXPECT_EQ(2u, reader.stats().connects);
+    reader.stop();
+}
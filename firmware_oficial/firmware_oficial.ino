@@ -12,6 +12,10 @@
 
 #define SENSOR_UPDATE_INTERVAL 1000
 
+// Limites do modo push ("STREAM ON <period_ms>"), iguais aos da HAL
+#define STREAM_MIN_PERIOD 100
+#define STREAM_MAX_PERIOD 60000
+
 /* ===================== OBJETOS ===================== */
 
 DHT dht(DHT_SENSOR, DHTTYPE);
@@ -30,6 +34,15 @@ float pm10 = 0;
 float temperature = 0;
 float humidity = 0;
 
+// Formato das respostas de dados ("SET FORMAT BIN|JSON"); JSON após o boot
+bool binaryFormat = false;
+uint16_t frameSeq = 0;
+
+// Modo push: envia dados a cada leitura dos sensores, sem esperar "GET DATA"
+bool streamActive = false;
+unsigned long streamPeriod = SENSOR_UPDATE_INTERVAL;
+String streamTarget = "ALL";
+
 // Fatores de calibração
 float calib_sds = 1.0;
 float calib_mq2 = 1.0;
@@ -62,14 +75,160 @@ void updateSensors() {
   }
 }
 
+/* ===================== QUADRO BINÁRIO ===================== */
+// Layout (little-endian, 38 bytes) - mesmo da HAL (utils/BinaryFrame.h):
+//   A5 5A | versão | origem | seq u16 | máscara | crus | 6 x float | ms u32 | CRC16
+// Máscara: bit0 pm25, bit1 pm10, bit2 co_ppm, bit3 lpg_ppm, bit4 temp_c, bit5 humid_p,
+//          bit6 ms (millis() da leitura, o "ms" do JSON)
+// Crus: bit0 = o campo co_ppm traz mq7_raw, bit1 = lpg_ppm traz mq2_raw (a HAL converte)
+// CRC16-CCITT (poly 0x1021, init 0xFFFF) dos bytes 2..35
+
+#define FRAME_SIZE 38
+#define FRAME_VERSION 2
+#define FRAME_HAS_MS 0x40
+#define FRAME_RAW_MQ7 0x01
+#define FRAME_RAW_MQ2 0x02
+
+uint16_t crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+void putField(uint8_t* frame, uint8_t& mask, int index, float value) {
+  memcpy(frame + 8 + index * 4, &value, 4);  // ESP32 já é little-endian
+  mask |= 1 << index;
+}
+
+void sendSensorFrame(String target) {
+  uint8_t frame[FRAME_SIZE] = {0};
+  uint8_t mask = 0;
+  uint8_t raw = 0;
+
+  frame[0] = 0xA5;
+  frame[1] = 0x5A;
+  frame[2] = FRAME_VERSION;
+  frame[3] = 0;  // origem: serial
+  frame[4] = frameSeq & 0xFF;
+  frame[5] = frameSeq >> 8;
+  frameSeq++;
+
+  if (target == "ALL" || target == "SDS011") {
+    putField(frame, mask, 0, round(pm25 * 10) / 10.0);
+    putField(frame, mask, 1, round(pm10 * 10) / 10.0);
+  }
+
+  if (target == "ALL" || target == "MQ7") {
+    putField(frame, mask, 2, mq7_raw);
+    raw |= FRAME_RAW_MQ7;
+  }
+
+  if (target == "ALL" || target == "MQ2") {
+    putField(frame, mask, 3, mq2_raw);
+    raw |= FRAME_RAW_MQ2;
+  }
+
+  if (target == "ALL" || target == "DHT") {
+    putField(frame, mask, 4, round(temperature * 10) / 10.0);
+    putField(frame, mask, 5, round(humidity * 10) / 10.0);
+  }
+
+  uint32_t ms = lastUpdate;  // millis() da leitura: a HAL corrige o atraso do fio
+  memcpy(frame + 32, &ms, 4);
+  mask |= FRAME_HAS_MS;
+
+  frame[6] = mask;
+  frame[7] = raw;
+
+  uint16_t crc = crc16(frame + 2, 34);
+  frame[36] = crc & 0xFF;
+  frame[37] = crc >> 8;
+
+  Serial.write(frame, FRAME_SIZE);
+}
+
+void handleFormat(String cmd) {
+
+  // Esperado: SET FORMAT BIN | SET FORMAT JSON
+  String format = cmd.substring(String("SET FORMAT ").length());
+
+  if (format == "BIN") binaryFormat = true;
+  else if (format == "JSON") binaryFormat = false;
+  else return;
+
+  // O ack sai sempre em JSON; os próximos dados já seguem o novo formato
+  JsonDocument doc;
+  doc["type"] = "ack";
+  doc["cmd"] = "set_format";
+  doc["format"] = binaryFormat ? "bin" : "json";
+
+  serializeJson(doc, Serial);
+  Serial.println();
+}
+
+/* ===================== STREAM ===================== */
+
+void handleStream(String cmd) {
+
+  // Esperado: STREAM ON [period_ms] [ALL|SDS011|MQ2|MQ7|DHT] | STREAM OFF
+  if (cmd == "STREAM OFF") {
+    streamActive = false;
+  } else {
+    String args = cmd.substring(String("STREAM ON").length());
+    args.trim();
+
+    int space = args.indexOf(' ');
+    String periodStr = (space == -1) ? args : args.substring(0, space);
+    String target = (space == -1) ? "ALL" : args.substring(space + 1);
+    target.trim();
+
+    if (target != "ALL" && target != "SDS011" && target != "MQ2" &&
+        target != "MQ7" && target != "DHT")
+      return;
+
+    long period = periodStr.length() > 0 ? periodStr.toInt() : SENSOR_UPDATE_INTERVAL;
+    if (period < STREAM_MIN_PERIOD) period = STREAM_MIN_PERIOD;
+    if (period > STREAM_MAX_PERIOD) period = STREAM_MAX_PERIOD;
+
+    streamActive = true;
+    streamPeriod = period;
+    streamTarget = target;
+  }
+
+  JsonDocument doc;
+  doc["type"] = "ack";
+  doc["cmd"] = "stream";
+  doc["status"] = streamActive ? "on" : "off";
+
+  if (streamActive) {
+    String target = streamTarget;
+    target.toLowerCase();
+    doc["period_ms"] = streamPeriod;
+    doc["target"] = target;
+  }
+
+  serializeJson(doc, Serial);
+  Serial.println();
+}
+
 /* ===================== JSON RESPONSES ===================== */
 
 void sendSensorData(String target) {
 
+  if (binaryFormat) {
+    sendSensorFrame(target);
+    return;
+  }
+
   JsonDocument doc;
 
   doc["type"] = "data";
   doc["src"] = "serial";
+  doc["ms"] = lastUpdate;  // millis() da leitura: a HAL corrige o atraso do fio
 
   JsonObject payload = doc["payload"].to<JsonObject>();
 
@@ -79,11 +238,11 @@ void sendSensorData(String target) {
   }
 
   if (target == "ALL" || target == "MQ2") {
-    payload["lpg_ppm"] = mq2_raw;
+    payload["mq2_raw"] = mq2_raw;
   }
 
   if (target == "ALL" || target == "MQ7") {
-    payload["co_ppm"] = mq7_raw;
+    payload["mq7_raw"] = mq7_raw;
   }
 
   if (target == "ALL" || target == "DHT") {
@@ -95,10 +254,18 @@ void sendSensorData(String target) {
   Serial.println();
 }
 
+// Identificação única da placa (MAC de fábrica): com várias estações no mesmo
+// gateway a HAL dá a cada device_id a sua faixa de sensores
+String deviceId() {
+  char id[32];
+  snprintf(id, sizeof(id), "AIR_STATION_%012llX", (unsigned long long)ESP.getEfuseMac());
+  return String(id);
+}
+
 void sendSettings() {
   JsonDocument doc;
   doc["type"] = "settings";
-  doc["device_id"] = "AIR_STATION_REAL";
+  doc["device_id"] = deviceId();
 
   JsonObject calib = doc["calib"].to<JsonObject>();
   calib["sds_factor"] = calib_sds;
@@ -217,6 +384,12 @@ void processCommand(String cmd) {
   else if (cmd.startsWith("SET CALIB "))
     handleCalibration(cmd);
 
+  else if (cmd.startsWith("SET FORMAT "))
+    handleFormat(cmd);
+
+  else if (cmd == "STREAM OFF" || cmd.startsWith("STREAM ON"))
+    handleStream(cmd);
+
   else if (cmd == "GET STATUS")
     sendStatus();
 
@@ -237,7 +410,7 @@ void setup() {
 
   analogSetAttenuation(ADC_11db);
 
-  Serial.println("{\"type\":\"boot\",\"device\":\"AIR_STATION_REAL\"}");
+  Serial.println("{\"type\":\"boot\",\"device\":\"" + deviceId() + "\"}");
 }
 
 /* ===================== LOOP ===================== */
@@ -257,8 +430,15 @@ void loop() {
   }
 
   // ===== ATUALIZA SENSORES =====
-  if (millis() - lastUpdate > SENSOR_UPDATE_INTERVAL) {
+  unsigned long interval = streamActive ? streamPeriod : SENSOR_UPDATE_INTERVAL;
+
+  if (millis() - lastUpdate >= interval) {
     updateSensors();
     lastUpdate = millis();
+
+    // ===== MODO PUSH =====
+    // Amostra sai logo após a leitura, sem o ida-e-volta do "GET DATA"
+    if (streamActive)
+      sendSensorData(streamTarget);
   }
 }
\ No newline at end of file